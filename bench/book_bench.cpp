@@ -0,0 +1,259 @@
+// OrderBook / LadderOrderBook hot paths: add_order that rests vs. add_order
+// that crosses, across book depths, cancel_order by queue position, and a
+// mixed add / cancel flow per call vs. through apply().
+//
+// Each benchmark times batches of operations against a book whose shape is
+// restored between batches with the timer paused, so every batch sees the
+// same depth. Books draw from a SizeClassPool (as with --arena pool) so
+// repeated rebuilds recycle memory instead of growing an arena.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "msim/order_book.hpp"
+#include "msim/pmr_utils.hpp"
+#include "msim/rng.hpp"
+
+namespace {
+
+using msim::BookKind;
+using msim::Order;
+using msim::Side;
+
+constexpr double kTick = 0.01;
+constexpr int32_t kMidTick = 10000;  // 100.00, the ladder's default centre
+constexpr size_t kBatch = 1024;      // timed ops between paused restores
+
+struct BookFixture {
+  std::vector<std::byte> buf;
+  msim::SizeClassPool pool;
+  std::unique_ptr<msim::IOrderBook> book;
+  uint64_t next_id = 1;
+
+  explicit BookFixture(BookKind kind)
+      : buf(size_t(64) << 20),
+        pool(buf.data(), buf.size(), std::pmr::new_delete_resource()),
+        book(msim::make_order_book(kind, "BENCH", &pool, kTick)) {}
+
+  uint64_t rest(Side side, int32_t tick, int qty = 1) {
+    const uint64_t id = next_id++;
+    int32_t tp = 0;
+    book->add_order(Order{id, tick, qty, side, 0}, tp);
+    return id;
+  }
+};
+
+BookKind kind_of(const benchmark::State& state) {
+  return static_cast<BookKind>(state.range(0));
+}
+
+// Adds that rest inside an existing bid ladder of `depth` levels.
+void BM_AddResting(benchmark::State& state) {
+  BookFixture f(kind_of(state));
+  const int32_t depth = static_cast<int32_t>(state.range(1));
+  for (int32_t i = 0; i < depth; ++i) {
+    f.rest(Side::BUY, kMidTick - 1 - i);
+    f.rest(Side::SELL, kMidTick + 1 + i);
+  }
+
+  std::vector<uint64_t> added;
+  added.reserve(kBatch);
+  int32_t level = 0;
+  for (auto _ : state) {
+    added.push_back(f.rest(Side::BUY, kMidTick - 1 - level));
+    if (++level == depth) level = 0;
+    if (added.size() == kBatch) {
+      state.PauseTiming();
+      for (uint64_t id : added) f.book->cancel_order(id);
+      added.clear();
+      state.ResumeTiming();
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Marketable buys (qty 1) that take the front ask of a `depth`-level book.
+// Levels hold enough orders that a batch never empties the book; the
+// consumed orders are always the first kBatch in price-time order, so the
+// restore re-adds the same prices.
+void BM_AddCrossing(benchmark::State& state) {
+  BookFixture f(kind_of(state));
+  const int32_t depth = static_cast<int32_t>(state.range(1));
+  const size_t per_level = kBatch / size_t(depth) + 1;
+
+  std::vector<int32_t> ask_ticks;  // price-time order
+  for (int32_t i = 0; i < depth; ++i) {
+    f.rest(Side::BUY, kMidTick - 1 - i);
+    for (size_t k = 0; k < per_level; ++k) {
+      f.rest(Side::SELL, kMidTick + 1 + i);
+      ask_ticks.push_back(kMidTick + 1 + i);
+    }
+  }
+
+  const int32_t limit = kMidTick + depth;
+  size_t taken = 0;
+  int64_t matched = 0;
+  for (auto _ : state) {
+    int32_t tp = 0;
+    matched += f.book->add_order(Order{f.next_id++, limit, 1, Side::BUY, 0},
+                                 tp);
+    if (++taken == kBatch) {
+      state.PauseTiming();
+      for (size_t i = 0; i < taken; ++i) f.rest(Side::SELL, ask_ticks[i]);
+      taken = 0;
+      state.ResumeTiming();
+    }
+  }
+  benchmark::DoNotOptimize(matched);
+  state.SetItemsProcessed(state.iterations());
+}
+
+enum Position : int64_t { Front = 0, Middle = 1, Back = 2 };
+
+// For a FIFO of n orders (index 0 = front), the indices to cancel so each
+// cancel hits the current front / middle / back of what remains.
+std::vector<size_t> victim_order(size_t n, size_t cancels, Position pos) {
+  std::vector<size_t> queue(n);
+  for (size_t i = 0; i < n; ++i) queue[i] = i;
+  std::vector<size_t> out;
+  out.reserve(cancels);
+  for (size_t c = 0; c < cancels; ++c) {
+    const size_t at = pos == Front    ? 0
+                      : pos == Back   ? queue.size() - 1
+                                      : queue.size() / 2;
+    out.push_back(queue[at]);
+    queue.erase(queue.begin() + static_cast<std::ptrdiff_t>(at));
+  }
+  return out;
+}
+
+// cancel_order() at the front, middle or back of levels `queue_len` orders
+// deep. Half of each level is cancelled per batch so levels never empty
+// inside the timed region.
+void BM_Cancel(benchmark::State& state) {
+  BookFixture f(kind_of(state));
+  const size_t queue_len = static_cast<size_t>(state.range(1));
+  const auto pos = static_cast<Position>(state.range(2));
+  const size_t levels = queue_len >= 4096 ? 1 : 4096 / queue_len;
+  const size_t per_level = queue_len / 2;
+  const std::vector<size_t> victims = victim_order(queue_len, per_level, pos);
+
+  std::vector<std::vector<uint64_t>> ids(levels);
+  auto fill = [&] {
+    for (size_t l = 0; l < levels; ++l) {
+      ids[l].clear();
+      for (size_t k = 0; k < queue_len; ++k)
+        ids[l].push_back(
+            f.rest(Side::BUY, kMidTick - 1 - static_cast<int32_t>(l)));
+    }
+  };
+  fill();
+
+  std::vector<uint64_t> batch;  // interleaved across levels
+  batch.reserve(levels * per_level);
+  for (size_t v : victims)
+    for (size_t l = 0; l < levels; ++l) batch.push_back(ids[l][v]);
+
+  size_t next = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f.book->cancel_order(batch[next]));
+    if (++next == batch.size()) {
+      state.PauseTiming();
+      for (auto& level : ids)
+        for (uint64_t id : level) f.book->cancel_order(id);
+      fill();
+      batch.clear();
+      for (size_t v : victims)
+        for (size_t l = 0; l < levels; ++l) batch.push_back(ids[l][v]);
+      next = 0;
+      state.ResumeTiming();
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// kBatch commands: adds resting on both sides of a `depth`-level book,
+// then cancels of the same ids in shuffled order, so the book is back to
+// its starting shape after every round and nothing is paused. batch = 1
+// issues them one add_order / cancel_order at a time; otherwise through
+// apply() `batch` commands per call.
+void BM_ApplyMixed(benchmark::State& state) {
+  BookFixture f(kind_of(state));
+  const int32_t depth = static_cast<int32_t>(state.range(1));
+  const size_t batch = static_cast<size_t>(state.range(2));
+  for (int32_t i = 0; i < depth; ++i) {
+    f.rest(Side::BUY, kMidTick - 1 - i);
+    f.rest(Side::SELL, kMidTick + 1 + i);
+  }
+
+  Xoroshiro128Plus rng(3);
+  std::vector<msim::BookCommand> cmds;
+  std::vector<uint64_t> ids;
+  cmds.reserve(kBatch);
+  for (size_t k = 0; k < kBatch / 2; ++k) {
+    const bool buy = rand_bool(rng, 0.5);
+    const int32_t off = rand_int(rng, 0, depth - 1);
+    const uint64_t id = f.next_id++;
+    cmds.push_back(msim::BookCommand::add(
+        Order{id, buy ? kMidTick - 1 - off : kMidTick + 1 + off, 1,
+              buy ? Side::BUY : Side::SELL, 0}));
+    ids.push_back(id);
+  }
+  for (size_t k = ids.size(); k > 1; --k)
+    std::swap(ids[k - 1], ids[rand_index(rng, k)]);
+  for (uint64_t id : ids) cmds.push_back(msim::BookCommand::cancel(id));
+
+  std::vector<msim::Fill> fills;
+  std::vector<int32_t> results(kBatch);
+  for (auto _ : state) {
+    if (batch == 1) {
+      for (const msim::BookCommand& c : cmds) {
+        int32_t tp = 0;
+        benchmark::DoNotOptimize(
+            c.op == msim::BookOp::Cancel
+                ? int(f.book->cancel_order(c.order.id))
+                : f.book->add_order(c.order, tp, c.type));
+      }
+    } else {
+      for (size_t i = 0; i < cmds.size(); i += batch)
+        f.book->apply(cmds.data() + i, std::min(batch, cmds.size() - i),
+                      fills, results.data() + i);
+      benchmark::DoNotOptimize(results.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * int64_t(cmds.size()));
+}
+
+void book_depths(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"book", "depth"});
+  for (int64_t kind : {0, 1})
+    for (int64_t depth : {1, 16, 256, 1024}) b->Args({kind, depth});
+}
+
+void cancel_args(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"book", "queue", "pos"});
+  for (int64_t kind : {0, 1})
+    for (int64_t len : {16, 256, 4096})
+      for (int64_t pos : {Front, Middle, Back}) b->Args({kind, len, pos});
+}
+
+void apply_args(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"book", "depth", "batch"});
+  for (int64_t kind : {0, 1})
+    for (int64_t depth : {16, 1024})
+      for (int64_t batch : {1, 32, 256}) b->Args({kind, depth, batch});
+}
+
+}  // namespace
+
+// book: 0 = hash (OrderBook), 1 = ladder; pos: 0 = front, 1 = middle, 2 = back
+BENCHMARK(BM_AddResting)->Apply(book_depths);
+BENCHMARK(BM_AddCrossing)->Apply(book_depths);
+BENCHMARK(BM_Cancel)->Apply(cancel_args);
+BENCHMARK(BM_ApplyMixed)->Apply(apply_args);
@@ -0,0 +1,72 @@
+// Event wire format: serialize() (allocates a vector) vs. serialize_to()
+// (caller's buffer), and deserialize() (owning Event) vs. EventView::parse()
+// (zero-copy view, what the LMDB reader and replay use).
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "msim/event.hpp"
+
+namespace {
+
+using msim::Event;
+using msim::EventType;
+using msim::EventView;
+using msim::Side;
+
+Event sample_event() {
+  return Event{1700000000123456789ull, EventType::ORDER_ADD, "SYM1", 100.37, 42,
+               Side::BUY, 123456789ull};
+}
+
+void BM_EventSerialize(benchmark::State& state) {
+  const Event e = sample_event();
+  for (auto _ : state) {
+    auto bytes = e.serialize();
+    benchmark::DoNotOptimize(bytes.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          int64_t(e.serialized_size()));
+}
+
+void BM_EventSerializeTo(benchmark::State& state) {
+  const Event e = sample_event();
+  std::vector<uint8_t> buf(e.serialized_size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Event::serialize_to(buf.data(), e.ts_ns, e.type,
+                                                 e.symbol, e.price, e.qty,
+                                                 e.side, e.order_id));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * int64_t(buf.size()));
+}
+
+void BM_EventDeserialize(benchmark::State& state) {
+  const auto bytes = sample_event().serialize();
+  for (auto _ : state) {
+    size_t consumed = 0;
+    auto e = Event::deserialize(bytes.data(), bytes.size(), consumed);
+    benchmark::DoNotOptimize(e);
+  }
+  state.SetBytesProcessed(state.iterations() * int64_t(bytes.size()));
+}
+
+void BM_EventViewParse(benchmark::State& state) {
+  const auto bytes = sample_event().serialize();
+  for (auto _ : state) {
+    size_t consumed = 0;
+    auto v = EventView::parse(bytes.data(), bytes.size(), consumed);
+    benchmark::DoNotOptimize(v);
+  }
+  state.SetBytesProcessed(state.iterations() * int64_t(bytes.size()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_EventSerialize);
+BENCHMARK(BM_EventSerializeTo);
+BENCHMARK(BM_EventDeserialize);
+BENCHMARK(BM_EventViewParse);
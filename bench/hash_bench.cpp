@@ -0,0 +1,111 @@
+// FlatHashMap vs. SwissHashMap on the order-id index workload: find hits
+// and misses at a given load, and erase+insert churn that keeps the load
+// fixed while leaving tombstones behind.
+//
+// Both maps are fixed-capacity here (allow_grow=false), so churn is paid
+// for by tombstone compaction: FlatHashMap's rehash_same_capacity() and
+// SwissHashMap's in-place rehash. The "compactions" counter is how often
+// that happened per op.
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "msim/flat_hash.hpp"
+#include "msim/rng.hpp"
+#include "msim/swiss_hash.hpp"
+
+namespace {
+
+using Flat = msim::FlatHashMap<uint64_t, uint32_t>;
+using Swiss = msim::SwissHashMap<uint64_t, uint32_t>;
+
+constexpr size_t kCapacity = size_t(1) << 16;
+
+size_t live_keys(const benchmark::State& state) {
+  return kCapacity * static_cast<size_t>(state.range(0)) / 100;
+}
+
+// Order ids are dense and increasing, like the simulator's.
+template <typename Map>
+void fill(Map& m, uint64_t first, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    m.insert(first + i, static_cast<uint32_t>(i));
+}
+
+template <typename Map>
+void BM_MapFindHit(benchmark::State& state) {
+  Map m(std::pmr::new_delete_resource(), kCapacity);
+  const size_t n = live_keys(state);
+  fill(m, 1, n);
+
+  SplitMix64 rng(7);
+  std::vector<uint64_t> probes(4096);
+  for (auto& k : probes) k = 1 + rng.next() % n;
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.find_ptr(probes[i]));
+    i = (i + 1) & (probes.size() - 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Map>
+void BM_MapFindMiss(benchmark::State& state) {
+  Map m(std::pmr::new_delete_resource(), kCapacity);
+  const size_t n = live_keys(state);
+  fill(m, 1, n);
+
+  SplitMix64 rng(7);
+  std::vector<uint64_t> probes(4096);
+  for (auto& k : probes) k = n + 1 + rng.next() % (n + 1);
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.find_ptr(probes[i]));
+    i = (i + 1) & (probes.size() - 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Sliding window of live ids: erase the oldest, insert the next. The live
+// count never changes but every erase leaves a tombstone.
+template <typename Map>
+void BM_MapChurn(benchmark::State& state) {
+  Map m(std::pmr::new_delete_resource(), kCapacity);
+  const size_t n = live_keys(state);
+  fill(m, 1, n);
+
+  uint64_t oldest = 1;
+  uint64_t next = 1 + n;
+  size_t prev_tombs = m.tombs();
+  int64_t compactions = 0;
+  for (auto _ : state) {
+    m.erase(oldest++);
+    m.insert(next++, 0u);
+    const size_t t = m.tombs();
+    compactions += t < prev_tombs;
+    prev_tombs = t;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["compactions"] = benchmark::Counter(
+      double(compactions), benchmark::Counter::kAvgIterations);
+}
+
+void loads(benchmark::internal::Benchmark* b) {
+  b->ArgName("load%");
+  for (int64_t pct : {25, 50, 65}) b->Arg(pct);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_MapFindHit, Flat)->Apply(loads);
+BENCHMARK_TEMPLATE(BM_MapFindHit, Swiss)->Apply(loads);
+BENCHMARK_TEMPLATE(BM_MapFindMiss, Flat)->Apply(loads);
+BENCHMARK_TEMPLATE(BM_MapFindMiss, Swiss)->Apply(loads);
+BENCHMARK_TEMPLATE(BM_MapChurn, Flat)->Apply(loads);
+BENCHMARK_TEMPLATE(BM_MapChurn, Swiss)->Apply(loads);
@@ -0,0 +1,118 @@
+// SpscRing across two cores: a ping-pong round trip (latency of handing one
+// element over and back) and a one-way stream consumed with try_pop or
+// try_pop_bulk (throughput; the --async-log producer -> writer shape).
+//
+// The benchmark thread is pinned to kCoreA and its peer to kCoreB. On a
+// single-CPU box nothing is pinned and the spin loops fall back to yielding,
+// so numbers there measure the scheduler rather than the ring.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "msim/spsc_ring.hpp"
+#include "msim/thread_utils.hpp"
+
+namespace {
+
+constexpr size_t kCoreA = 0;
+constexpr size_t kCoreB = 1;
+constexpr size_t kRingCap = 1024;
+
+using Ring = msim::SpscRing<uint64_t, kRingCap>;
+
+void pin(size_t core) {
+  if (std::thread::hardware_concurrency() > kCoreB) msim::bind_to_core(core);
+}
+
+// Spins, then yields, so a peer sharing our CPU still gets to run.
+struct Backoff {
+  unsigned spins = 0;
+  void pause() {
+    if (++spins > 1024) std::this_thread::yield();
+  }
+};
+
+void BM_SpscPingPong(benchmark::State& state) {
+  pin(kCoreA);
+  Ring ping, pong;
+  std::atomic<bool> stop{false};
+
+  std::thread echo([&] {
+    pin(kCoreB);
+    uint64_t v = 0;
+    Backoff b;
+    while (!stop.load(std::memory_order_relaxed)) {
+      if (!ping.try_pop(v)) {
+        b.pause();
+        continue;
+      }
+      while (!pong.try_push(v)) b.pause();
+      b.spins = 0;
+    }
+  });
+
+  uint64_t seq = 0, back = 0;
+  for (auto _ : state) {
+    while (!ping.try_push(seq)) {
+    }
+    Backoff b;
+    while (!pong.try_pop(back)) b.pause();
+    ++seq;
+  }
+  stop.store(true, std::memory_order_relaxed);
+  echo.join();
+  if (back + 1 != seq) state.SkipWithError("ping-pong lost an element");
+  state.SetItemsProcessed(state.iterations());
+}
+
+// One producer streams increasing values; each iteration consumes one
+// element (range(0) == 1) or one try_pop_bulk of up to range(0).
+void BM_SpscStream(benchmark::State& state) {
+  pin(kCoreA);
+  const size_t bulk = static_cast<size_t>(state.range(0));
+  Ring ring;
+  std::atomic<bool> stop{false};
+
+  std::thread producer([&] {
+    pin(kCoreB);
+    uint64_t v = 0;
+    Backoff b;
+    while (!stop.load(std::memory_order_relaxed)) {
+      if (ring.try_push(v)) {
+        ++v;
+        b.spins = 0;
+      } else {
+        b.pause();
+      }
+    }
+  });
+
+  uint64_t out[kRingCap];
+  uint64_t expect = 0;
+  int64_t items = 0;
+  bool in_order = true;
+  for (auto _ : state) {
+    size_t n = 0;
+    Backoff b;
+    while ((n = bulk == 1 ? size_t(ring.try_pop(out[0]))
+                          : ring.try_pop_bulk(out, bulk)) == 0)
+      b.pause();
+    in_order &= out[0] == expect && out[n - 1] == expect + n - 1;
+    expect += n;
+    items += static_cast<int64_t>(n);
+  }
+  stop.store(true, std::memory_order_relaxed);
+  producer.join();
+  if (!in_order) state.SkipWithError("stream delivered out of order");
+  state.SetItemsProcessed(items);
+}
+
+}  // namespace
+
+BENCHMARK(BM_SpscPingPong)->UseRealTime();
+BENCHMARK(BM_SpscStream)->ArgName("bulk")->Arg(1)->Arg(16)->Arg(256)
+    ->UseRealTime();
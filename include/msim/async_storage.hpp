@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "doorbell.hpp"
+#include "event.hpp"
+#include "event_batch.hpp"
+#include "spsc_ring.hpp"
+#include "storage.hpp"
+
+namespace msim {
+
+/**
+ * Asynchronous persistence pipeline.
+ * - One SpscRing of CompactEvent per producer (simulation worker); push()
+ *   never locks and never allocates
+ * - One dedicated writer thread per sink; producer p is drained by writer
+ *   p % sinks.size(), so every ring has exactly one consumer
+ * - Writers pop in bulk into a columnar EventBatch (source = producer) and
+ *   hand it to IStorage::write_batch()
+ * - An idle writer spins briefly, then parks on its Doorbell, which its
+ *   producers' push() and close() ring
+ *
+ * A sink is only ever touched by its writer thread (including the final
+ * flush), which keeps thread-affine backends such as LMDB safe.
+ */
+class AsyncStorage {
+ public:
+  static constexpr std::size_t kRingCapacity = 16384;  // events per producer
+  static constexpr std::size_t kDrainBatch = EventBatch::kCapacity;
+
+  AsyncStorage(std::vector<std::unique_ptr<IStorage>> sinks,
+               std::size_t n_producers, const SymbolTable* symbols);
+  ~AsyncStorage();
+
+  AsyncStorage(const AsyncStorage&) = delete;
+  AsyncStorage& operator=(const AsyncStorage&) = delete;
+
+  // Producer side. Each `producer` index must be driven by a single thread.
+  // Spins (yielding) while the ring is full, so logging stays lossless.
+  void push(std::size_t producer, const CompactEvent& e) {
+    Producer& p = *producers_[producer];
+    while (!p.ring.try_push(e)) {
+      ++p.stalls;
+      std::this_thread::yield();
+    }
+    bells_[producer % bells_.size()]->ring();
+  }
+
+  // Waits for the writers to drain every ring, flushes and releases the
+  // sinks. Must be called after all producers have stopped pushing.
+  void close();
+
+  std::size_t producers() const noexcept { return producers_.size(); }
+  std::size_t writers() const noexcept { return sinks_.size(); }
+  uint64_t written() const noexcept {
+    return written_.load(std::memory_order_relaxed);
+  }
+  // Number of times a producer found its ring full (only valid after close).
+  uint64_t stalls() const noexcept;
+
+ private:
+  using Ring = SpscRing<CompactEvent, kRingCapacity>;
+
+  struct Producer {
+    Ring ring;
+    uint64_t stalls = 0;  // written by the producer only
+  };
+
+  void writer_loop(std::size_t w);
+  bool any_pending(std::size_t w) const noexcept;
+
+  std::vector<std::unique_ptr<IStorage>> sinks_;
+  const SymbolTable* symbols_;
+  std::vector<std::unique_ptr<Producer>> producers_;
+  std::vector<std::unique_ptr<Doorbell>> bells_;  // one per writer
+  std::vector<std::thread> threads_;
+  std::atomic<bool> closing_{false};
+  std::atomic<uint64_t> written_{0};
+  bool closed_ = false;
+};
+
+}  // namespace msim
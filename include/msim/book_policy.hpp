@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "msim/event.hpp"
+
+namespace msim {
+
+/**
+ * Compile-time side policy for the book cores: price comparisons for an
+ * order resting on / arriving at side S, so the matching loop for each
+ * side is its own straight-line code.
+ */
+template <Side S>
+struct SidePolicy;
+
+template <>
+struct SidePolicy<Side::BUY> {
+  static constexpr Side kOpp = Side::SELL;
+  // A market buy's limit: takes any ask.
+  static constexpr int32_t kAny = std::numeric_limits<int32_t>::max();
+
+  // Bid a ranks ahead of bid b.
+  static constexpr bool better(int32_t a, int32_t b) noexcept { return a > b; }
+  // A buy limited at `limit` trades with an ask resting at `resting`.
+  static constexpr bool reaches(int32_t limit, int32_t resting) noexcept {
+    return resting <= limit;
+  }
+};
+
+template <>
+struct SidePolicy<Side::SELL> {
+  static constexpr Side kOpp = Side::BUY;
+  static constexpr int32_t kAny = std::numeric_limits<int32_t>::min();
+
+  static constexpr bool better(int32_t a, int32_t b) noexcept { return a < b; }
+  static constexpr bool reaches(int32_t limit, int32_t resting) noexcept {
+    return resting >= limit;
+  }
+};
+
+}  // namespace msim
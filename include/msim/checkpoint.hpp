@@ -0,0 +1,176 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "order_book.hpp"
+#include "order_gen.hpp"
+
+namespace msim {
+
+/**
+ * Simulator checkpoint (".mckp"): everything a run needs to carry on from
+ * step N instead of from empty books.
+ *
+ *   [FileHeader 64B]
+ *   [WorkerRec x n_workers]    counters, ids, ts state, generator state
+ *   [SymbolRec x n_symbols]    workers' symbols back to back, in order
+ *   [OrderRec ...]             each symbol's resting orders, BookDigest order
+ *   [u64 ...]                  each symbol's live id list, in list order
+ *   [names]                    symbol names, 8-byte padded
+ *
+ * Offsets are absolute and 8-byte aligned, so a reader maps the file and
+ * points straight into it; native little-endian, like the column log.
+ * Orders are re-added to empty books in file order on restore, which
+ * rebuilds every level and FIFO queue for either book engine.
+ */
+namespace ckpt {
+
+constexpr char kMagic[8] = {'M', 'S', 'I', 'M', 'C', 'K', 'P', '1'};
+constexpr uint32_t kVersion = 2;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t n_workers;
+  uint32_t n_symbols;
+  uint8_t realtime_ts;  // ts state is realtime (last_ts) vs synthetic (seq)
+  uint8_t reserved0[3];
+  uint64_t seed;
+  uint64_t events_done;  // steps run by all workers together
+  uint64_t file_bytes;   // catches truncated files
+  uint8_t reserved[16];
+};
+static_assert(sizeof(FileHeader) == 64, "FileHeader layout changed");
+
+struct WorkerRec {
+  uint64_t step;     // next step to run
+  uint64_t next_id;  // next order id counter
+  uint64_t seq;      // make_ts state
+  uint64_t last_ts;
+  // Generator state before it drew the intent batch that starts at step -
+  // batch_row; restore draws that batch again and skips batch_row rows.
+  OrderGenerator::State gen;
+  uint32_t first_symbol;  // index of its first SymbolRec
+  uint32_t n_symbols;
+  uint32_t batch_row;
+  uint32_t reserved;
+};
+static_assert(sizeof(WorkerRec) == 128, "WorkerRec layout changed");
+
+struct SymbolRec {
+  uint64_t name_off;
+  uint64_t orders_off;
+  uint64_t live_off;
+  uint64_t n_orders;
+  uint64_t n_live;
+  double mid_tick;
+  uint32_t name_len;
+  uint32_t worker;
+};
+static_assert(sizeof(SymbolRec) == 56, "SymbolRec layout changed");
+
+struct OrderRec {
+  uint64_t id;
+  uint64_t ts_ns;
+  int32_t tick;
+  int32_t qty;
+  uint8_t side;  // Side
+  uint8_t reserved[7];
+};
+static_assert(sizeof(OrderRec) == 32, "OrderRec layout changed");
+
+}  // namespace ckpt
+
+// One symbol as a worker saw it: book contents plus the worker's mid and
+// live-id list (which may hold stale ids, as in the run).
+struct CheckpointSymbol {
+  std::string name;
+  double mid_tick = 0.0;
+  std::vector<Order> orders;
+  std::vector<uint64_t> live;
+};
+
+struct CheckpointWorker {
+  uint64_t step = 0;
+  uint64_t next_id = 0;
+  uint64_t seq = 0;
+  uint64_t last_ts = 0;
+  OrderGenerator::State gen{};  // as ckpt::WorkerRec
+  uint32_t batch_row = 0;
+  std::vector<CheckpointSymbol> symbols;
+};
+
+// One symbol's book (named by its symbol()), mid and live list.
+CheckpointSymbol capture_symbol(const IOrderBook& book, double mid_tick,
+                                const uint64_t* live, std::size_t n_live);
+
+// Writes `path` (via a temporary file renamed over it, so a crash never
+// leaves half a checkpoint). Throws std::runtime_error on I/O failure.
+void write_checkpoint(const std::string& path, uint64_t seed,
+                      bool realtime_ts,
+                      const std::vector<CheckpointWorker>& workers);
+
+// Periodic checkpoints of a multi-worker run. Each worker hands in its part
+// at the same step and waits; the last to arrive runs `write` on the full
+// set, then all carry on. One stop-the-world pause per snapshot, so the
+// file is a consistent cut across workers.
+class CheckpointGate {
+ public:
+  using Writer = std::function<void(const std::vector<CheckpointWorker>&)>;
+  CheckpointGate(std::size_t n_workers, Writer write);
+
+  void arrive(std::size_t worker, CheckpointWorker part);
+  // For a worker with nothing to run (no symbols): `part` stands in for it
+  // in every snapshot from now on, and it never arrives.
+  void leave(std::size_t worker, CheckpointWorker part);
+  uint64_t written() const;  // snapshots taken
+
+ private:
+  void write_locked();  // all expected parts are in; wakes the waiters
+
+  Writer write_;
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<CheckpointWorker> parts_;
+  std::size_t expected_;  // workers that still arrive
+  std::size_t arrived_ = 0;
+  uint64_t generation_ = 0;
+};
+
+// Memory-mapped, validated view of a checkpoint. Throws std::runtime_error
+// on a missing, truncated or inconsistent file, including a book that is
+// out of order or crossed, so restore_book() can't trade.
+class CheckpointReader {
+ public:
+  explicit CheckpointReader(const std::string& path);
+
+  const ckpt::FileHeader& header() const noexcept { return *header_; }
+  std::size_t workers() const noexcept { return header_->n_workers; }
+  const ckpt::WorkerRec& worker(std::size_t w) const { return workers_[w]; }
+  // w's symbols are symbol(first_symbol) .. symbol(first_symbol + n - 1).
+  const ckpt::SymbolRec& symbol(std::size_t s) const { return symbols_[s]; }
+
+  std::string_view name(const ckpt::SymbolRec& s) const;
+  const ckpt::OrderRec* orders(const ckpt::SymbolRec& s) const;
+  const uint64_t* live(const ckpt::SymbolRec& s) const;
+
+  // Re-adds s's resting orders to `book` (expected empty) in file order.
+  void restore_book(const ckpt::SymbolRec& s, IOrderBook& book) const;
+
+ private:
+  void validate(const std::string& path) const;
+
+  MappedFile file_;
+  const ckpt::FileHeader* header_;
+  const ckpt::WorkerRec* workers_;
+  const ckpt::SymbolRec* symbols_;
+};
+
+}  // namespace msim
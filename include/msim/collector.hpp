@@ -0,0 +1,129 @@
+#pragma once
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event.hpp"
+#include "latency_hist.hpp"
+#include "market.grpc.pb.h"
+#include "storage.hpp"
+
+namespace msim {
+
+// Knobs for Collector (collector_server flags).
+struct CollectorOptions {
+  std::string address = "0.0.0.0:50051";
+  std::size_t threads = 2;                   // completion queues, one
+                                             // polling thread each
+  std::chrono::milliseconds stats_every{1000};  // 0: no periodic report
+  std::ostream* log = nullptr;               // reports; nullptr = silent
+  // Forward decoded events to make_storage(sink_path) (binlog / .mdb /
+  // .mcol); empty = count only.
+  std::string sink_path;
+  StorageOptions storage;
+  std::size_t sink_queue = 64;  // decoded batches waiting for the writer
+};
+
+/**
+ * Telemetry collector: the server side of MarketStream (--grpc).
+ * - Async server on `threads` completion queues; any number of concurrent
+ *   Publish / PublishPacked streams are spread over them, so one collector
+ *   can take a fleet of simulator nodes
+ * - Per-stream counters and a batch service-time histogram (decode + sink
+ *   hand-off), reported every `stats_every` with the interval's rates, and
+ *   a final "Received ..." line per stream
+ * - With a sink, decoded batches go through a bounded queue to one writer
+ *   thread that owns the IStorage (thread-affine backends stay safe). A
+ *   full queue holds the reading thread, which backpressures the stream
+ */
+class Collector {
+ public:
+  // Binds and starts serving; throws std::runtime_error if the address
+  // can't be bound or the sink can't be opened.
+  explicit Collector(CollectorOptions opt);
+  ~Collector();
+
+  Collector(const Collector&) = delete;
+  Collector& operator=(const Collector&) = delete;
+
+  int port() const noexcept { return port_; }  // resolved ":0"
+
+  // Cancels open streams, drains the queues and flushes the sink.
+  // Idempotent.
+  void shutdown();
+
+  struct Totals {
+    uint64_t streams = 0;  // finished, probes excluded
+    uint64_t events = 0;
+    uint64_t batches = 0;
+    uint64_t bytes = 0;         // encoded batch bytes
+    uint64_t rejected = 0;      // malformed batches
+    uint64_t sink_written = 0;  // events handed to the sink's IStorage
+    uint64_t sink_stalls = 0;   // reader waits on a full sink queue
+  };
+  Totals totals() const;
+
+ private:
+  class Sink;
+  class CallBase;
+  template <typename Msg>
+  class Call;
+
+  // One live stream's counters; written by whichever CQ thread runs the
+  // call, read by the reporter.
+  struct StreamStats {
+    uint64_t id = 0;
+    std::string peer;
+    const char* format = "";
+    std::chrono::steady_clock::time_point start;
+
+    std::mutex mu;
+    uint64_t events = 0, batches = 0, bytes = 0;
+    uint64_t last_events = 0, last_bytes = 0;  // at the previous report
+    LatencyHistogram interval_ns;  // batch service time since last report
+  };
+
+  void serve(std::size_t q);
+  void report_loop();
+  void report(std::ostream& os, double secs);
+  std::shared_ptr<StreamStats> open_stream(const std::string& peer,
+                                           const char* format);
+  void close_stream(const std::shared_ptr<StreamStats>& s, bool probe);
+  void forward(std::vector<Event>&& events);  // to the sink, if any
+
+  CollectorOptions opt_;
+  rpc::MarketStream::AsyncService service_;
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> cqs_;
+  std::unique_ptr<grpc::Server> server_;
+  std::unique_ptr<Sink> sink_;
+  std::vector<std::thread> threads_;
+  std::vector<std::mutex> cq_mu_;  // per CQ: proceed() vs. Shutdown()
+  bool draining_ = false;          // set under every cq_mu_
+  int port_ = 0;
+  std::atomic<uint64_t> rejected_{0};
+
+  mutable std::mutex streams_mu_;
+  std::map<uint64_t, std::shared_ptr<StreamStats>> live_;
+  uint64_t next_id_ = 1;
+  Totals done_;  // finished streams, under streams_mu_
+  uint64_t closed_since_report_ = 0;  // their events since the last report
+  std::mutex log_mu_;                 // one writer of *opt_.log at a time
+
+  std::thread reporter_;
+  std::mutex stop_mu_;
+  std::condition_variable stop_cv_;
+  bool stopping_ = false;
+  bool shut_down_ = false;
+};
+
+}  // namespace msim
@@ -0,0 +1,230 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "event.hpp"
+#include "event_batch.hpp"
+#include "mapped_file.hpp"
+#include "storage.hpp"
+#include "symbol_table.hpp"
+
+namespace msim {
+
+/**
+ * Columnar event log (".mcol").
+ *
+ *   [FileHeader 64B]
+ *   [block 0][block 1]...      fixed block_bytes each, native little-endian
+ *   [FooterHeader 64B]         footer: totals + symbol count
+ *   [BlockIndex x n_blocks]    copy of every block header + its offset
+ *   [symbol table]             per symbol: f64 tick, u64 events, u16 len, name
+ *   [Trailer 16B]              footer offset + end magic
+ *
+ * A block is a BlockHeader followed by the event columns sized for
+ * block_events rows (ts u64, order_id u64, price_tick i32, qty i32,
+ * symbol_id u16, type u8, side u8); partial blocks are zero padded so every block starts
+ * at header + i * block_bytes and every column is naturally aligned.
+ *
+ * The symbol bitmap has kBitmapBits bits; symbol id s sets bit
+ * s % kBitmapBits, so a clear bit proves the block has no rows for s.
+ */
+namespace mcol {
+
+constexpr char kFileMagic[8] = {'M', 'S', 'I', 'M', 'C', 'O', 'L', '1'};
+constexpr char kBlockMagic[8] = {'M', 'S', 'I', 'M', 'B', 'L', 'K', '1'};
+constexpr char kFooterMagic[8] = {'M', 'S', 'I', 'M', 'I', 'D', 'X', '1'};
+constexpr char kEndMagic[8] = {'M', 'S', 'I', 'M', 'E', 'N', 'D', '1'};
+constexpr uint32_t kVersion = 2;  // 2: order_id column
+constexpr uint32_t kDefaultBlockEvents = 4096;
+constexpr uint32_t kBitmapWords = 4;
+constexpr uint32_t kBitmapBits = kBitmapWords * 64;
+
+// Bytes per row across all columns.
+constexpr size_t kRowBytes = sizeof(uint64_t) + sizeof(uint64_t) +
+                             sizeof(int32_t) +
+                             sizeof(int32_t) + sizeof(uint16_t) +
+                             sizeof(EventType) + sizeof(Side);
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t block_events;
+  uint64_t block_bytes;
+  uint8_t reserved[40];
+};
+static_assert(sizeof(FileHeader) == 64, "FileHeader layout changed");
+
+struct BlockHeader {
+  char magic[8];
+  uint32_t count;
+  uint32_t reserved;
+  uint64_t min_ts;
+  uint64_t max_ts;
+  uint64_t symbols[kBitmapWords];
+
+  bool may_contain(uint16_t symbol_id) const noexcept {
+    const uint32_t b = symbol_id % kBitmapBits;
+    return (symbols[b >> 6] >> (b & 63)) & 1u;
+  }
+  bool overlaps(uint64_t ts_from, uint64_t ts_to) const noexcept {
+    return count != 0 && min_ts <= ts_to && max_ts >= ts_from;
+  }
+};
+static_assert(sizeof(BlockHeader) == 64, "BlockHeader layout changed");
+
+struct BlockIndex {
+  uint64_t offset;  // file offset of the block
+  BlockHeader header;
+};
+
+struct FooterHeader {
+  char magic[8];
+  uint64_t n_blocks;
+  uint64_t n_events;
+  uint64_t min_ts;
+  uint64_t max_ts;
+  uint32_t n_symbols;
+  uint8_t reserved[20];
+};
+static_assert(sizeof(FooterHeader) == 64, "FooterHeader layout changed");
+
+struct Trailer {
+  uint64_t footer_offset;  // start of the FooterHeader
+  char magic[8];
+};
+static_assert(sizeof(Trailer) == 16, "Trailer layout changed");
+
+constexpr uint64_t block_bytes(uint32_t block_events) noexcept {
+  // Keep blocks (and so every column start) 64-byte aligned.
+  return (sizeof(BlockHeader) + uint64_t(block_events) * kRowBytes + 63) &
+         ~uint64_t(63);
+}
+
+}  // namespace mcol
+
+// Writer. Rows are appended to an in-memory block which is written with a
+// single fwrite once full; the footer is written on destruction, so a log
+// is only readable after its storage has been destroyed.
+class ColumnLogStorage : public IStorage {
+ public:
+  explicit ColumnLogStorage(const std::string& path,
+                            uint32_t block_events = mcol::kDefaultBlockEvents);
+  ~ColumnLogStorage();
+
+  void write(const Event& e) override;
+  void write_batch(const EventBatch& b) override;
+  // Seals the open (partial) block and flushes the file.
+  void flush() override;
+
+ private:
+  void append(uint16_t sym, uint64_t ts, int32_t px, int32_t qty,
+              EventType type, Side side, uint64_t order_id);
+  uint16_t map_symbol(const SymbolTable& syms, uint16_t id);
+  void seal_block();
+  void write_footer();
+
+  std::FILE* fp_{nullptr};
+  std::mutex mtx_;
+
+  uint32_t block_events_;
+  uint64_t block_bytes_;
+  std::vector<uint8_t> block_;  // staged block, block_bytes_ long
+  mcol::BlockHeader* hdr_{nullptr};
+  uint64_t* ts_{nullptr};
+  uint64_t* oid_{nullptr};
+  int32_t* px_{nullptr};
+  int32_t* qty_{nullptr};
+  uint16_t* sym_{nullptr};
+  EventType* type_{nullptr};
+  Side* side_{nullptr};
+
+  uint64_t offset_{0};  // file offset of the next block
+  std::vector<mcol::BlockIndex> index_;
+  SymbolTable symbols_;              // log-local ids
+  std::vector<uint64_t> sym_events_;  // rows per log-local id
+
+  // batch SymbolTable id -> log-local id (kUnmapped = not seen yet)
+  static constexpr uint32_t kUnmapped = std::numeric_limits<uint32_t>::max();
+  const SymbolTable* mapped_table_{nullptr};
+  std::vector<uint32_t> id_map_;
+};
+
+// Zero-copy view of one block; column pointers point into the mapping.
+struct ColumnBlockView {
+  const mcol::BlockHeader* header;
+  size_t n;
+  const uint64_t* ts_ns;
+  const uint64_t* order_id;
+  const int32_t* price_tick;
+  const int32_t* qty;
+  const uint16_t* symbol_id;
+  const EventType* type;
+  const Side* side;
+};
+
+// Which blocks/rows a scan should visit.
+struct ColumnQuery {
+  uint64_t ts_from = 0;
+  uint64_t ts_to = std::numeric_limits<uint64_t>::max();
+  std::optional<uint16_t> symbol;  // id in ColumnLogReader::symbols()
+};
+
+// Memory-mapped reader. Block selection only touches the footer index, so
+// blocks outside a time window / without a symbol are never paged in.
+class ColumnLogReader {
+ public:
+  // Returns true to keep reading, false to stop early.
+  using BlockSink = std::function<bool(const ColumnBlockView&)>;
+  using BatchSink = std::function<bool(const EventBatch&)>;
+
+  explicit ColumnLogReader(const std::string& path);
+  ~ColumnLogReader();
+
+  ColumnLogReader(const ColumnLogReader&) = delete;
+  ColumnLogReader& operator=(const ColumnLogReader&) = delete;
+
+  const SymbolTable& symbols() const noexcept { return symbols_; }
+  uint64_t events() const noexcept { return footer_->n_events; }
+  uint64_t events(uint16_t symbol_id) const { return sym_events_[symbol_id]; }
+  uint64_t min_ts() const noexcept { return footer_->min_ts; }
+  uint64_t max_ts() const noexcept { return footer_->max_ts; }
+
+  size_t blocks() const noexcept { return n_blocks_; }
+  const mcol::BlockHeader& block_header(size_t i) const {
+    return index_[i].header;
+  }
+  ColumnBlockView block(size_t i) const;
+
+  // Calls `sink` for every block that may hold rows matching `q`, in file
+  // order. Rows inside a block are not filtered. Returns blocks visited.
+  size_t scan_blocks(const ColumnQuery& q, const BlockSink& sink) const;
+
+  // Copies the rows matching `q` into `batch` (reused; its SymbolTable must
+  // be symbols()), calling `sink` whenever it fills and once for the tail.
+  // Returns the number of events delivered.
+  size_t read_batches(const ColumnQuery& q, EventBatch& batch,
+                      const BatchSink& sink) const;
+
+ private:
+  void parse_footer();
+
+  MappedFile file_;
+  const uint8_t* base_;  // file_.data()
+  size_t size_;
+
+  uint32_t block_events_{0};
+  const mcol::FooterHeader* footer_{nullptr};
+  const mcol::BlockIndex* index_{nullptr};
+  size_t n_blocks_{0};
+  SymbolTable symbols_;
+  std::vector<uint64_t> sym_events_;
+};
+
+}  // namespace msim
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "event.hpp"
+#include "order_book.hpp"
+
+namespace msim {
+
+/**
+ * Top-N aggregated depth (L2) for one book, as level deltas (--depth).
+ * - Attaches a DepthUpdate log to the book; the book appends each level it
+ *   touches, with the level's running qty / order count, so nothing is
+ *   summed from the queues
+ * - update() folds that log into per-side views of the best `levels`
+ *   ticks and reports only the changes inside them: levels that changed,
+ *   left (orders == 0) or were pushed out by a better price, and levels
+ *   that moved up after a removal (one IOrderBook::depth() refill)
+ * - Every `snapshot_every` updates (0 = never) it asks for a full
+ *   snapshot, so a consumer can join mid-stream
+ * - One feed per book, same thread as the book
+ */
+class DepthFeed {
+ public:
+  DepthFeed(IOrderBook& book, std::size_t levels, uint64_t snapshot_every);
+  ~DepthFeed();  // detaches from the book
+
+  DepthFeed(const DepthFeed&) = delete;
+  DepthFeed& operator=(const DepthFeed&) = delete;
+
+  // Call after each add_order / cancel_order. Appends the top-N deltas it
+  // caused to `out`; returns true when a snapshot is due.
+  bool update(std::vector<DepthUpdate>& out);
+
+  // Current top-N view: bids best -> worst, then asks best -> worst.
+  void snapshot(std::vector<DepthUpdate>& out) const;
+
+  std::size_t levels() const noexcept { return levels_; }
+
+  // Wire form (CompactEvent): price_tick = level tick, qty = level qty
+  // (saturated to int32), order_id = order count (0 = level removed).
+  // A snapshot is a DEPTH_SNAPSHOT header whose qty is the number of
+  // DEPTH_SNAPSHOT level records that follow.
+  static CompactEvent to_event(uint64_t ts, uint16_t symbol, EventType type,
+                               const DepthUpdate& u) noexcept {
+    const int64_t q = u.level.qty;
+    const int32_t qty = q > std::numeric_limits<int32_t>::max()
+                            ? std::numeric_limits<int32_t>::max()
+                            : static_cast<int32_t>(q);
+    return CompactEvent{ts, u.level.tick, qty, symbol, type, u.side,
+                        u.level.orders};
+  }
+  static CompactEvent snapshot_header(uint64_t ts, uint16_t symbol,
+                                      std::size_t n_levels) noexcept {
+    return CompactEvent{ts, 0, static_cast<int32_t>(n_levels), symbol,
+                        EventType::DEPTH_SNAPSHOT, Side::BUY, 0};
+  }
+
+ private:
+  std::vector<DepthLevel>& view(Side s) noexcept {
+    return s == Side::BUY ? bids_ : asks_;
+  }
+  static bool better(Side s, int32_t a, int32_t b) noexcept {
+    return s == Side::BUY ? a > b : a < b;
+  }
+
+  void apply(const DepthUpdate& u, std::vector<DepthUpdate>& out);
+  void refill(Side s, std::vector<DepthUpdate>& out);
+
+  IOrderBook& book_;
+  std::size_t levels_;
+  uint64_t snapshot_every_;
+  uint64_t since_snapshot_ = 0;
+
+  std::vector<DepthUpdate> log_;   // filled by the book
+  std::vector<DepthLevel> bids_;   // best -> worst, at most levels_
+  std::vector<DepthLevel> asks_;
+  std::vector<DepthLevel> scratch_;
+  bool refill_bid_ = false, refill_ask_ = false;
+};
+
+}  // namespace msim
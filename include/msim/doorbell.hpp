@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace msim {
+
+/**
+ * Where an idle ring consumer waits for its producers.
+ * - wait(ready): re-checks `ready` for kSpins yielding passes, then parks
+ *   on a condition variable until a ring() makes it true
+ * - ring(): producers call it after publishing (push, finish, close); costs
+ *   a fence and a load while the consumer is awake
+ *
+ * Dekker handshake: the consumer sets `parked_` then re-checks `ready`, a
+ * producer publishes then checks `parked_`, with a seq_cst fence between
+ * on either side, so at least one of them sees the other and no wakeup is
+ * lost. `ready` runs under the mutex and must not block.
+ */
+class Doorbell {
+ public:
+  static constexpr int kSpins = 64;
+
+  template <typename Ready>
+  void wait(Ready&& ready) {
+    for (int i = 0; i < kSpins; ++i) {
+      if (ready()) return;
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lk(mu_);
+    parked_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!ready()) cv_.wait(lk);
+    parked_.store(false, std::memory_order_relaxed);
+  }
+
+  void ring() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!parked_.load(std::memory_order_relaxed)) return;
+    // Taking mu_ orders us after the consumer's check-then-wait.
+    { std::lock_guard<std::mutex> lk(mu_); }
+    cv_.notify_one();
+  }
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::atomic<bool> parked_{false};
+};
+
+}  // namespace msim
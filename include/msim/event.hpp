@@ -1,15 +1,159 @@
 #pragma once
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace msim {
 
-enum class EventType : uint8_t { ORDER_ADD = 1, ORDER_CANCEL = 2, TRADE = 3 };
+enum class EventType : uint8_t {
+  ORDER_ADD = 1,
+  ORDER_CANCEL = 2,
+  TRADE = 3,
+  DEPTH_UPDATE = 4,    // --depth: one aggregated level changed
+  DEPTH_SNAPSHOT = 5,  // --depth: full top-N view (header + levels)
+  // ORDER_ADD variants for the non-limit OrderTypes (same fields)
+  ORDER_IOC = 6,
+  ORDER_FOK = 7,
+  ORDER_MARKET = 8,
+  ORDER_POST_ONLY = 9,
+};
 enum class Side : uint8_t { BUY = 1, SELL = 2 };
 
+// How an incoming order meets the book (IOrderBook::add_order).
+enum class OrderType : uint8_t {
+  Limit = 0,     // match up to the limit, rest the remainder
+  IOC = 1,       // match up to the limit, drop the remainder
+  FOK = 2,       // fill in full up to the limit, or do nothing
+  Market = 3,    // match at any price, drop the remainder
+  PostOnly = 4,  // rest without matching; do nothing if it would cross
+};
+
+// Price -> tick rounding: half away from zero, like std::llround, without
+// the libm call (|x| < 2^31). Used wherever a decimal price enters.
+inline int32_t round_tick(double x) noexcept {
+  return static_cast<int32_t>(x >= 0.0 ? x + 0.5 : x - 0.5);
+}
+
+inline bool rests(OrderType t) noexcept {
+  return t == OrderType::Limit || t == OrderType::PostOnly;
+}
+
+// The ADD record an order of type `t` is logged as, and back.
+inline EventType add_event(OrderType t) noexcept {
+  return t == OrderType::Limit ? EventType::ORDER_ADD
+                               : EventType(uint8_t(EventType::ORDER_IOC) +
+                                           uint8_t(t) - 1);
+}
+inline bool is_order_add(EventType e) noexcept {
+  return e == EventType::ORDER_ADD ||
+         (e >= EventType::ORDER_IOC && e <= EventType::ORDER_POST_ONLY);
+}
+inline OrderType order_type(EventType e) noexcept {  // is_order_add(e)
+  return e == EventType::ORDER_ADD
+             ? OrderType::Limit
+             : OrderType(uint8_t(e) - uint8_t(EventType::ORDER_IOC) + 1);
+}
+
+// Compact POD event used on the hot path. The symbol is an id into a
+// SymbolTable and the price is in integer ticks of that symbol.
+//
+// Every incoming order is logged as ORDER_ADD (its limit price and full
+// qty); if it matched, a TRADE (fill price, filled qty) follows with the
+// same order_id. ORDER_CANCEL carries the cancelled id. Replaying the
+// ADD/CANCEL stream into an empty book reproduces the run. IOC / FOK /
+// market / post-only orders log as their ORDER_* variant of ORDER_ADD.
+// DEPTH_* records are derived L2 (see DepthFeed) and are skipped by replay.
+struct CompactEvent {
+  uint64_t ts_ns;
+  int32_t price_tick;
+  int32_t qty;
+  uint16_t symbol_id;
+  EventType type;
+  Side side;
+  uint64_t order_id;
+};
+static_assert(sizeof(CompactEvent) == 32, "CompactEvent layout changed");
+
+struct Event;
+
+// Non-owning view of one serialized event record; `symbol` points into the
+// source buffer (e.g. an LMDB page), so parsing never allocates.
+//
+// Two record forms share the layout up to the price: decimal records carry
+// a double price, tick records (type byte | kTickPriced) an int32 tick of
+// the symbol's tick size, 4 bytes less. Writers of CompactEvent streams
+// emit tick records; resolve() fills in the field a record did not carry.
+struct EventView {
+  uint64_t ts_ns{};
+  EventType type{};
+  std::string_view symbol;
+  double price{};
+  int32_t price_tick{};
+  bool tick_priced{};   // record carried price_tick, not price
+  int32_t qty{};
+  Side side{};
+  uint64_t order_id{};  // 0 for records written before ids were logged
+
+  static constexpr uint8_t kTickPriced = 0x80;  // flag in the type byte
+
+  // Records without the trailing order id (older stores) still parse.
+  static constexpr size_t kLegacyFixedBytes =
+      sizeof(uint64_t) + 1 + sizeof(double) + sizeof(int32_t) + 1;
+  static constexpr size_t kFixedBytes = kLegacyFixedBytes + sizeof(uint64_t);
+  static constexpr size_t kTickFixedBytes =
+      sizeof(uint64_t) + 1 + sizeof(int32_t) + sizeof(int32_t) + 1 +
+      sizeof(uint64_t);
+
+  static std::optional<EventView> parse(const uint8_t* data, size_t len,
+                                        size_t& consumed) noexcept {
+    if (len < 2) return std::nullopt;
+    const uint16_t sl = data[0] | (uint16_t(data[1]) << 8);
+    if (len < 2 + size_t(sl) + kLegacyFixedBytes) return std::nullopt;
+
+    EventView v;
+    size_t off = 2;
+    v.symbol = std::string_view(reinterpret_cast<const char*>(data + off), sl);
+    off += sl;
+    std::memcpy(&v.ts_ns, data + off, sizeof(v.ts_ns));
+    off += sizeof(v.ts_ns);
+    const uint8_t type = data[off++];
+    v.type = static_cast<EventType>(type & ~kTickPriced);
+    v.tick_priced = (type & kTickPriced) != 0;
+    if (v.tick_priced) {
+      if (len < 2 + size_t(sl) + kTickFixedBytes) return std::nullopt;
+      std::memcpy(&v.price_tick, data + off, sizeof(v.price_tick));
+      off += sizeof(v.price_tick);
+    } else {
+      std::memcpy(&v.price, data + off, sizeof(v.price));
+      off += sizeof(v.price);
+    }
+    std::memcpy(&v.qty, data + off, sizeof(v.qty));
+    off += sizeof(v.qty);
+    v.side = static_cast<Side>(data[off++]);
+    if (len >= off + sizeof(v.order_id)) {
+      std::memcpy(&v.order_id, data + off, sizeof(v.order_id));
+      off += sizeof(v.order_id);
+    }
+    consumed = off;
+    return v;
+  }
+
+  // Derives price from price_tick (tick records) or price_tick from price
+  // (decimal records) for a symbol of `tick_size`.
+  void resolve(double tick_size) noexcept {
+    if (tick_priced)
+      price = double(price_tick) * tick_size;
+    else
+      price_tick = round_tick(price * (1.0 / tick_size));
+  }
+
+  inline Event to_event() const;
+};
+
 struct Event {
   uint64_t ts_ns{};
   EventType type{};
@@ -17,47 +161,98 @@ struct Event {
   double price{};
   int32_t qty{};
   Side side{};  // BUY or SELL
+  uint64_t order_id{};
 
   std::string to_string() const {
-    char buf[128];
-    snprintf(buf, sizeof(buf), "[%s] %s %.2f x %d (%c) t=%llu",
+    char buf[160];
+    snprintf(buf, sizeof(buf), "[%s] %s %.2f x %d (%c) id=%llu t=%llu",
              (type == EventType::ORDER_ADD      ? "ADD"
               : type == EventType::ORDER_CANCEL ? "CXL"
-                                                : "TRD"),
-             symbol.c_str(), price, qty, side, (unsigned long long)ts_ns);
+              : type == EventType::TRADE        ? "TRD"
+              : type == EventType::DEPTH_UPDATE ? "DEP"
+              : type == EventType::DEPTH_SNAPSHOT ? "SNP"
+              : type == EventType::ORDER_IOC      ? "IOC"
+              : type == EventType::ORDER_FOK      ? "FOK"
+              : type == EventType::ORDER_MARKET   ? "MKT"
+                                                  : "PST"),
+             symbol.c_str(), price, qty, side == Side::SELL ? 'S' : 'B',
+             (unsigned long long)order_id, (unsigned long long)ts_ns);
     return buf;
   }
 
-  size_t serialized_size() const noexcept {
+  static constexpr size_t serialized_size(size_t symbol_len) noexcept {
     // symbol length (2) + symbol bytes + ts + eventType + price + qty + side
-    return 2 + symbol.size() + sizeof(ts_ns) + sizeof(EventType) +
-           sizeof(price) + sizeof(qty) + sizeof(side);
+    // + order id
+    return 2 + symbol_len + EventView::kFixedBytes;
+  }
+  size_t serialized_size() const noexcept {
+    return serialized_size(symbol.size());
   }
 
-  std::vector<uint8_t> serialize() const {
-    /** serialize() data between its C++ in-memory representation and a compact,
-     * linear array of bytes. This process is called serialization. */
-    uint16_t sl = static_cast<uint16_t>(symbol.size());
-    std::vector<uint8_t> out;
-    out.reserve(serialized_size());
+  // Writes one record into `out` (which must hold serialized_size() bytes)
+  // and returns the number of bytes written. No allocation.
+  static size_t serialize_to(uint8_t* out, uint64_t ts_ns, EventType type,
+                             std::string_view symbol, double price,
+                             int32_t qty, Side side,
+                             uint64_t order_id) noexcept {
+    const uint16_t sl = static_cast<uint16_t>(symbol.size());
+    size_t off = 0;
 
     // 1. symbol length (2 bytes)
-    out.push_back(static_cast<uint8_t>(sl & 0xFF));
-    out.push_back(static_cast<uint8_t>((sl >> 8) & 0xFF));
+    out[off++] = static_cast<uint8_t>(sl & 0xFF);
+    out[off++] = static_cast<uint8_t>((sl >> 8) & 0xFF);
 
     // 2. symbol bytes
-    out.insert(out.end(), symbol.begin(), symbol.end());
+    std::memcpy(out + off, symbol.data(), sl);
+    off += sl;
 
     // 3. remaining fields
     auto put = [&](auto v) {
-      const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
-      out.insert(out.end(), p, p + sizeof(v));
+      std::memcpy(out + off, &v, sizeof(v));
+      off += sizeof(v);
     };
     put(ts_ns);
-    out.push_back(static_cast<uint8_t>(type));  // 1 byte
+    out[off++] = static_cast<uint8_t>(type);  // 1 byte
     put(price);
     put(qty);
-    out.push_back(static_cast<uint8_t>(side));  // 1 byte
+    out[off++] = static_cast<uint8_t>(side);  // 1 byte
+    put(order_id);
+    return off;
+  }
+
+  // Tick record: as serialize_to() with the price as `price_tick` ticks.
+  static constexpr size_t tick_serialized_size(size_t symbol_len) noexcept {
+    return 2 + symbol_len + EventView::kTickFixedBytes;
+  }
+  static size_t serialize_tick_to(uint8_t* out, uint64_t ts_ns,
+                                  EventType type, std::string_view symbol,
+                                  int32_t price_tick, int32_t qty, Side side,
+                                  uint64_t order_id) noexcept {
+    const uint16_t sl = static_cast<uint16_t>(symbol.size());
+    size_t off = 0;
+    out[off++] = static_cast<uint8_t>(sl & 0xFF);
+    out[off++] = static_cast<uint8_t>((sl >> 8) & 0xFF);
+    std::memcpy(out + off, symbol.data(), sl);
+    off += sl;
+
+    auto put = [&](auto v) {
+      std::memcpy(out + off, &v, sizeof(v));
+      off += sizeof(v);
+    };
+    put(ts_ns);
+    out[off++] = static_cast<uint8_t>(type) | EventView::kTickPriced;
+    put(price_tick);
+    put(qty);
+    out[off++] = static_cast<uint8_t>(side);
+    put(order_id);
+    return off;
+  }
+
+  std::vector<uint8_t> serialize() const {
+    /** serialize() data between its C++ in-memory representation and a compact,
+     * linear array of bytes. This process is called serialization. */
+    std::vector<uint8_t> out(serialized_size());
+    serialize_to(out.data(), ts_ns, type, symbol, price, qty, side, order_id);
     return out;
   }
 
@@ -65,29 +260,14 @@ struct Event {
                                           size_t& consumed) {
     /** deserialize() a compact linear array of bytes, into its C++ in-memory
      * representation. This process is called deserialization. */
-    if (len < 2) return std::nullopt;
-    uint16_t sl = data[0] | (uint16_t(data[1]) << 8);
-    if (len <
-        2 + sl + sizeof(uint64_t) + 1 + sizeof(double) + sizeof(int32_t) + 1)
-      return std::nullopt;
-    size_t off = 2;
-    std::string sym(reinterpret_cast<const char*>(data + off), sl);
-    off += sl;
-    uint64_t ts;
-    std::memcpy(&ts, data + off, sizeof(ts));
-    off += sizeof(ts);
-    uint8_t t = data[off++];
-    double price;
-    std::memcpy(&price, data + off, sizeof(price));
-    off += sizeof(price);
-    int32_t qty;
-    std::memcpy(&qty, data + off, sizeof(qty));
-    off += sizeof(qty);
-    Side side = static_cast<Side>(data[off++]);
-    consumed = off;
-    return Event{ts,  static_cast<EventType>(t), std::move(sym), price, qty,
-                 side};
+    auto v = EventView::parse(data, len, consumed);
+    if (!v) return std::nullopt;
+    return v->to_event();
   }
 };
 
+inline Event EventView::to_event() const {
+  return Event{ts_ns, type, std::string(symbol), price, qty, side, order_id};
+}
+
 }  // namespace msim
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "event.hpp"
+#include "symbol_table.hpp"
+
+namespace msim {
+
+/**
+ * Columnar (struct-of-arrays) buffer of events.
+ * - Fixed capacity, columns stored inline: no heap allocation after the
+ *   batch itself is created, so appending on the emit path is a few stores
+ * - `symbols` resolves symbol_id -> name / tick size for consumers
+ * - `source` identifies the producing worker (used for routing/sharding)
+ */
+struct EventBatch {
+  static constexpr std::size_t kCapacity = 1024;
+
+  const SymbolTable* symbols = nullptr;
+  uint32_t source = 0;
+  std::size_t n = 0;
+
+  uint64_t ts_ns[kCapacity];
+  int32_t price_tick[kCapacity];
+  int32_t qty[kCapacity];
+  uint16_t symbol_id[kCapacity];
+  EventType type[kCapacity];
+  Side side[kCapacity];
+  uint64_t order_id[kCapacity];
+
+  explicit EventBatch(const SymbolTable* syms = nullptr, uint32_t src = 0)
+      : symbols(syms), source(src) {}
+
+  std::size_t size() const noexcept { return n; }
+  bool empty() const noexcept { return n == 0; }
+  bool full() const noexcept { return n == kCapacity; }
+  void clear() noexcept { n = 0; }
+
+  // Caller checks full() first.
+  void push(const CompactEvent& e) noexcept {
+    ts_ns[n] = e.ts_ns;
+    price_tick[n] = e.price_tick;
+    qty[n] = e.qty;
+    symbol_id[n] = e.symbol_id;
+    type[n] = e.type;
+    side[n] = e.side;
+    order_id[n] = e.order_id;
+    ++n;
+  }
+
+  CompactEvent row(std::size_t i) const noexcept {
+    return CompactEvent{ts_ns[i],     price_tick[i], qty[i],     symbol_id[i],
+                        type[i],      side[i],       order_id[i]};
+  }
+
+  double price(std::size_t i) const {
+    return symbols->to_price(symbol_id[i], price_tick[i]);
+  }
+  const std::string& symbol(std::size_t i) const {
+    return symbols->name(symbol_id[i]);
+  }
+
+  // Materializes row i (allocates the symbol string; display/export only).
+  Event to_event(std::size_t i) const {
+    return Event{ts_ns[i], type[i], symbol(i), price(i),
+                 qty[i],   side[i], order_id[i]};
+  }
+};
+
+}  // namespace msim
@@ -1,5 +1,12 @@
 #pragma once
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <cstdint>
+#include <vector>
+
 #include "event.hpp"
+#include "event_batch.hpp"
 #include "market.pb.h"
 
 namespace msim {
@@ -13,13 +20,138 @@ struct EventConvert {
     dst->set_price(src.price);
     dst->set_qty(src.qty);
     dst->set_side(static_cast<msim::rpc::Side>(src.side));
+    dst->set_order_id(src.order_id);
+  }
+
+  // Row i of a columnar batch, straight from the columns (no Event temp).
+  static void to_proto(const EventBatch& b, size_t i, msim::rpc::Event* dst) {
+    dst->set_ts_ns(b.ts_ns[i]);
+    dst->set_type(static_cast<msim::rpc::EventType>(b.type[i]));
+    dst->set_symbol(b.symbol(i));
+    dst->set_price(b.price(i));
+    dst->set_qty(b.qty[i]);
+    dst->set_side(static_cast<msim::rpc::Side>(b.side[i]));
+    dst->set_order_id(b.order_id[i]);
+  }
+
+  // A ring record; `syms` resolves its symbol id and price tick.
+  static void to_proto(const CompactEvent& e, const SymbolTable& syms,
+                       msim::rpc::Event* dst) {
+    dst->set_ts_ns(e.ts_ns);
+    dst->set_type(static_cast<msim::rpc::EventType>(e.type));
+    dst->set_symbol(syms.name(e.symbol_id));
+    dst->set_price(syms.to_price(e.symbol_id, e.price_tick));
+    dst->set_qty(e.qty);
+    dst->set_side(static_cast<msim::rpc::Side>(e.side));
+    dst->set_order_id(e.order_id);
   }
 
   static Event from_proto(const msim::rpc::Event& p) {
     return Event{p.ts_ns(),  static_cast<EventType>(p.type()),
                  p.symbol(), p.price(),
-                 p.qty(),    static_cast<Side>(p.side())};
+                 p.qty(),    static_cast<Side>(p.side()),
+                 p.order_id()};
   }
+
+  // Decodes a PackedBatch, appending to `out`. Returns false (leaving `out`
+  // partially filled) if the columns disagree in length or a symbol_ref is
+  // outside the dictionary.
+  static bool from_packed(const msim::rpc::PackedBatch& p,
+                          std::vector<Event>& out) {
+    const int n = p.type_size();
+    if (p.ts_delta_size() != n || p.symbol_ref_size() != n ||
+        p.price_tick_size() != n || p.qty_size() != n ||
+        p.side_size() != n || p.order_id_delta_size() != n ||
+        p.tick_sizes_size() != p.symbols_size())
+      return false;
+
+    uint64_t ts = p.ts_base();
+    uint64_t id = 0;
+    out.reserve(out.size() + size_t(n));
+    for (int i = 0; i < n; ++i) {
+      const uint32_t ref = p.symbol_ref(i);
+      if (ref >= uint32_t(p.symbols_size())) return false;
+      ts += uint64_t(p.ts_delta(i));
+      id += uint64_t(p.order_id_delta(i));
+      out.push_back(Event{ts, static_cast<EventType>(p.type(i)),
+                          p.symbols(int(ref)),
+                          double(p.price_tick(i)) * p.tick_sizes(int(ref)),
+                          p.qty(i), static_cast<Side>(p.side(i)), id});
+    }
+    return true;
+  }
+};
+
+// Appends ring records to a PackedBatch: builds the per-batch symbol
+// dictionary and the delta columns, and tracks the encoded size as it goes
+// so callers can cut batches by bytes without re-serializing.
+class PackedBatchBuilder {
+ public:
+  explicit PackedBatchBuilder(const SymbolTable* syms) : syms_(syms) {}
+
+  // Starts a new batch in `out` (cleared).
+  void reset(msim::rpc::PackedBatch* out) {
+    for (uint16_t id : used_) slot_[id] = 0;
+    used_.clear();
+    out_ = out;
+    out_->Clear();
+    bytes_ = 0;
+    last_ts_ = 0;
+    last_id_ = 0;
+  }
+
+  void add(const CompactEvent& e) {
+    using google::protobuf::internal::WireFormatLite;
+    using Coded = google::protobuf::io::CodedOutputStream;
+
+    if (e.symbol_id >= slot_.size()) slot_.resize(size_t(e.symbol_id) + 1);
+    uint32_t& slot = slot_[e.symbol_id];
+    if (slot == 0) {
+      const std::string& name = syms_->name(e.symbol_id);
+      out_->add_symbols(name);
+      out_->add_tick_sizes(syms_->tick_size(e.symbol_id));
+      used_.push_back(e.symbol_id);
+      slot = uint32_t(used_.size());
+      bytes_ += 2 + name.size() + 9;  // tagged string + tagged double
+    }
+
+    if (out_->type_size() == 0) {
+      out_->set_ts_base(e.ts_ns);
+      last_ts_ = e.ts_ns;
+      bytes_ += 1 + Coded::VarintSize64(e.ts_ns);
+    }
+    const int64_t dts = int64_t(e.ts_ns - last_ts_);
+    const int64_t did = int64_t(e.order_id - last_id_);
+    last_ts_ = e.ts_ns;
+    last_id_ = e.order_id;
+
+    out_->add_ts_delta(dts);
+    out_->add_type(static_cast<msim::rpc::EventType>(e.type));
+    out_->add_symbol_ref(slot - 1);
+    out_->add_price_tick(e.price_tick);
+    out_->add_qty(e.qty);
+    out_->add_side(static_cast<msim::rpc::Side>(e.side));
+    out_->add_order_id_delta(did);
+
+    const uint32_t ztick = WireFormatLite::ZigZagEncode32(e.price_tick);
+    bytes_ += Coded::VarintSize64(WireFormatLite::ZigZagEncode64(dts)) +
+              1 /* type */ + Coded::VarintSize32(slot - 1) +
+              Coded::VarintSize32(ztick) +
+              Coded::VarintSize32SignExtended(e.qty) + 1 /* side */ +
+              Coded::VarintSize64(WireFormatLite::ZigZagEncode64(did));
+  }
+
+  // Encoded size so far, plus ~3 bytes of tag/length per non-empty column.
+  size_t bytes() const noexcept { return bytes_ + (bytes_ ? 7 * 3 : 0); }
+
+ private:
+  const SymbolTable* syms_;
+  msim::rpc::PackedBatch* out_ = nullptr;
+  std::vector<uint32_t> slot_;  // symbol id -> dictionary index + 1
+  std::vector<uint16_t> used_;  // ids with a slot in this batch
+  size_t bytes_ = 0;
+  uint64_t last_ts_ = 0;
+  uint64_t last_id_ = 0;
 };
 
 }  // namespace msim
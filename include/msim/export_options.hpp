@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace msim {
+
+// What the telemetry exporter does when the collector can't keep up.
+enum class OverflowPolicy : uint8_t {
+  Block = 0,       // lossless: exporter waits for the streams, producers wait
+                   // on their rings (matching threads stall)
+  DropOldest = 1,  // discard the oldest queued batch to make room
+  Sample = 2,      // under pressure keep 1 event in `sample_every`; drop the
+                   // new batch if the streams are completely full
+};
+
+// Batch encoding on the wire (see market.proto).
+enum class WireFormat : uint8_t {
+  Auto = 0,    // Packed where the collector supports it, else Rows
+  Rows = 1,    // EventBatch: one Event message per event (Publish)
+  Packed = 2,  // PackedBatch: symbol dictionary + delta columns (PublishPacked)
+};
+
+// Knobs for GrpcExporter (--grpc-*). Plain data so SimConfig can carry it in
+// builds without MSIM_WITH_GRPC.
+struct ExportOptions {
+  std::size_t streams = 1;                 // gRPC channels, one stream each
+  std::size_t batch_events = 512;          // flush a batch at this many events
+  std::size_t batch_bytes = 256 << 10;     // ... or this many encoded bytes
+  std::size_t max_queued = 8;              // batches in flight + waiting,
+                                           // per stream
+  OverflowPolicy overflow = OverflowPolicy::Block;
+  uint32_t sample_every = 8;               // OverflowPolicy::Sample ratio
+  WireFormat format = WireFormat::Auto;
+};
+
+}  // namespace msim
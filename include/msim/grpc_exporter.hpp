@@ -0,0 +1,209 @@
+#pragma once
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "doorbell.hpp"
+#include "event_batch.hpp"
+#include "event_convert.hpp"
+#include "export_options.hpp"
+#include "market.grpc.pb.h"
+#include "spsc_ring.hpp"
+#include "symbol_table.hpp"
+
+namespace msim {
+
+/**
+ * Asynchronous telemetry export to the collector (--grpc).
+ * - One SpscRing of CompactEvent per producer (simulation worker), as in
+ *   AsyncStorage: push() never locks and never allocates
+ * - One exporter thread drains the rings and builds batches of up to
+ *   batch_events / batch_bytes, as rpc::PackedBatch when every stream's
+ *   collector accepts PublishPacked (WireFormat::Auto), else rpc::EventBatch
+ * - Batches go to `streams` gRPC channels, each carrying one Publish (or
+ *   PublishPacked) call driven through the callback API: writes complete on
+ *   gRPC's threads, so the exporter never blocks on the network
+ * - When every stream queue is full, ExportOptions::overflow decides
+ *   between backpressure and dropping; a producer whose ring is full drops
+ *   the event unless the policy is Block
+ * - An idle exporter spins briefly, then parks on a Doorbell that push()
+ *   and close() ring
+ */
+class GrpcExporter {
+ public:
+  static constexpr std::size_t kRingCapacity = 16384;  // events per producer
+  static constexpr std::size_t kDrainBatch = EventBatch::kCapacity;
+
+  // Connects every channel up front; throws std::runtime_error if the
+  // collector is unreachable.
+  GrpcExporter(const std::string& target, std::size_t n_producers,
+               const SymbolTable* symbols, ExportOptions opt = {});
+  ~GrpcExporter();
+
+  GrpcExporter(const GrpcExporter&) = delete;
+  GrpcExporter& operator=(const GrpcExporter&) = delete;
+
+  // Producer side. Each `producer` index must be driven by a single thread.
+  void push(std::size_t producer, const CompactEvent& e) {
+    Producer& p = *producers_[producer];
+    if (!p.ring.try_push(e)) {
+      if (opt_.overflow != OverflowPolicy::Block) {
+        ++p.ring_drops;
+        return;
+      }
+      while (!p.ring.try_push(e)) {
+        ++p.stalls;
+        std::this_thread::yield();
+      }
+    }
+    bell_.ring();
+  }
+
+  // Drains the rings, finishes every stream and collects the collector's
+  // acks. Must be called after all producers have stopped pushing. Returns
+  // false if any stream ended with an error.
+  bool close();
+  const std::string& error() const noexcept { return error_; }  // first one
+
+  std::size_t streams() const noexcept { return streams_.size(); }
+  WireFormat format() const noexcept { return format_; }
+
+  // Counters; sent/acked are complete only after close().
+  uint64_t sent() const noexcept;     // events whose Write() completed
+  uint64_t acked() const noexcept;    // events the collector acknowledged
+  uint64_t batches() const noexcept;  // batch messages written
+  uint64_t bytes() const noexcept;    // their encoded size
+  uint64_t dropped() const noexcept;  // ring + queue + sampled + failed
+  uint64_t ring_drops() const noexcept;
+  uint64_t queue_drops() const noexcept {
+    return queue_drops_.load(std::memory_order_relaxed);
+  }
+  uint64_t sampled_out() const noexcept { return sampled_out_; }
+  uint64_t stalls() const noexcept;  // producer waits on a full ring
+
+ private:
+  using Ring = SpscRing<CompactEvent, kRingCapacity>;
+
+  struct Producer {
+    Ring ring;
+    uint64_t stalls = 0;      // written by the producer only
+    uint64_t ring_drops = 0;  // ditto
+  };
+
+  struct Pending {
+    rpc::EventBatch rows;     // WireFormat::Rows
+    rpc::PackedBatch packed;  // WireFormat::Packed
+    std::size_t events = 0;
+    std::size_t bytes = 0;
+  };
+
+  // One channel + one client-streaming call. The exporter thread enqueues;
+  // gRPC's threads complete writes and start the next one. The call itself
+  // (Publish or PublishPacked) lives in the Stream<Msg> reactor.
+  class StreamBase {
+   public:
+    StreamBase(GrpcExporter& owner, std::shared_ptr<grpc::Channel> channel);
+    virtual ~StreamBase() = default;
+
+    virtual void start() = 0;
+    bool offer(Pending&& b);    // false (b untouched) if the stream failed
+    std::size_t drop_oldest();  // events discarded (0 if nothing waiting)
+    std::size_t outstanding() const;  // batches in flight or waiting
+    bool healthy() const;
+    // Half-closes once the queue is drained and waits for the final status.
+    bool finish();
+    const grpc::Status& status() const noexcept { return status_; }
+
+    uint64_t sent() const noexcept {
+      return sent_.load(std::memory_order_relaxed);
+    }
+    uint64_t batches() const noexcept {
+      return batches_.load(std::memory_order_relaxed);
+    }
+    uint64_t bytes() const noexcept {
+      return bytes_.load(std::memory_order_relaxed);
+    }
+    uint64_t acked() const noexcept { return ack_.count(); }
+
+   protected:
+    // Reactor hooks, implemented by Stream<Msg>.
+    virtual void write(Pending& b) = 0;
+    virtual void writes_done() = 0;
+    virtual void remove_hold() = 0;
+
+    // Called from Stream<Msg>'s OnWriteDone / OnDone.
+    void on_write_done(bool ok);
+    void on_done(const grpc::Status& status);
+
+    GrpcExporter& owner_;
+    std::shared_ptr<grpc::Channel> channel_;
+    std::unique_ptr<rpc::MarketStream::Stub> stub_;
+    grpc::ClientContext context_;
+    rpc::Ack ack_;
+
+   private:
+    // Moves the oldest queued batch into `current_`; caller holds mu_.
+    void take_next_locked();
+
+    mutable std::mutex mu_;
+    std::condition_variable done_cv_;
+    std::deque<Pending> queue_;
+    Pending current_;            // owned by the in-flight write
+    bool writing_ = false;
+    bool finishing_ = false;     // close(): half-close once drained
+    bool writes_done_ = false;   // writes_done() issued
+    bool failed_ = false;
+    bool done_ = false;
+    grpc::Status status_;
+
+    std::atomic<uint64_t> sent_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> bytes_{0};
+  };
+  template <typename Msg>
+  class Stream;  // grpc_exporter.cpp
+
+  // Probes PublishPacked on `channel` with an empty stream.
+  static bool supports_packed(
+      const std::shared_ptr<grpc::Channel>& channel);
+
+  void export_loop();
+  bool any_pending() const noexcept;
+  void begin(Pending& cur);
+  void append(const CompactEvent& e, Pending& cur);
+  void submit(Pending&& b);
+  StreamBase* least_loaded(std::size_t& outstanding);
+  void notify_room();
+
+  ExportOptions opt_;
+  const SymbolTable* symbols_;
+  std::vector<std::unique_ptr<Producer>> producers_;
+  std::vector<std::unique_ptr<StreamBase>> streams_;
+  WireFormat format_ = WireFormat::Rows;  // negotiated: Rows or Packed
+  PackedBatchBuilder packer_;
+  Doorbell bell_;  // a producer pushed, or close() began
+  std::thread thread_;
+
+  std::mutex room_mu_;
+  std::condition_variable room_cv_;  // a stream queue shrank or failed
+
+  std::atomic<bool> closing_{false};
+  std::atomic<uint64_t> queue_drops_{0};  // also bumped by failed streams
+  uint64_t sampled_out_ = 0;              // exporter thread only
+  uint64_t sample_seq_ = 0;
+  bool sampling_ = false;
+  std::size_t rr_ = 0;  // least_loaded() tie-break start
+  bool closed_ = false;
+  bool ok_ = true;
+  std::string error_;
+};
+
+}  // namespace msim
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "msim/event.hpp"
+#include "msim/swiss_hash.hpp"
+#include "msim/order_book.hpp"
+#include "msim/order_pool.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace msim {
+
+namespace detail {
+
+inline unsigned ctz64(uint64_t x) noexcept {  // x != 0
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanForward64(&i, x);
+  return static_cast<unsigned>(i);
+#else
+  return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+}
+
+inline unsigned msb64(uint64_t x) noexcept {  // x != 0; index of highest set bit
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanReverse64(&i, x);
+  return static_cast<unsigned>(i);
+#else
+  return 63u - static_cast<unsigned>(__builtin_clzll(x));
+#endif
+}
+
+}  // namespace detail
+
+/**
+ * Array-indexed price ladder.
+ * - Levels live in a contiguous window of kSlots ticks starting at base_tick_
+ * - Bids and asks share the window (a tick can't rest on both sides at once)
+ * - A two-level occupancy bitset per side turns "next best level" into two
+ *   find-first-set ops, so best price after a sweep is O(1), not O(levels)
+ * - The window re-centres (O(kSlots), rare) when a resting price falls
+ *   outside it; a remainder whose price can't fit with the live book is
+ *   dropped and its add returns add_rejected(filled)
+ */
+class LadderOrderBook final : public IOrderBook {
+ public:
+  static constexpr uint32_t kSlots = 4096;  // 64 words x 64 bits
+
+  LadderOrderBook(std::string symbol, std::pmr::memory_resource* mr,
+                  double tick_size = 0.01, double ref_price = 100.0);
+  ~LadderOrderBook() override;  // returns levels to mr
+
+  int add_order(const Order& o, int32_t& trade_tick,
+                OrderType type = OrderType::Limit) override;
+  bool cancel_order(uint64_t order_id) override;
+  void apply(const BookCommand* cmds, std::size_t n, std::vector<Fill>& fills,
+             int32_t* results = nullptr) override;
+
+  std::optional<int32_t> best_bid_tick() const override {
+    return best_bid_tick_;
+  }
+  std::optional<int32_t> best_ask_tick() const override {
+    return best_ask_tick_;
+  }
+  std::optional<double> best_bid() const override;
+  std::optional<double> best_ask() const override;
+
+  const std::string& symbol() const override { return symbol_; }
+  std::size_t index_size() const noexcept override { return index_.size(); }
+  // Orders whose remainder could not rest inside the ladder window.
+  uint64_t rejected() const noexcept override { return rejected_; }
+  uint64_t state_checksum() const override;
+  void resting_orders(std::vector<Order>& out) const override;
+  void depth(Side side, std::size_t n,
+             std::vector<DepthLevel>& out) const override;
+
+  int32_t base_tick() const noexcept { return base_tick_; }
+
+ private:
+  struct Level : OrderQueue {
+    int32_t tick{0};
+
+    explicit Level(int32_t t) : tick(t) {}
+
+    void reset(int32_t t) { tick = t; }  // only empty levels are recycled
+  };
+
+  struct Occupancy {
+    static constexpr uint32_t kWords = kSlots / 64;
+    static_assert(kWords <= 64, "summary word covers at most 64 words");
+
+    uint64_t summary = 0;
+    uint64_t words[kWords] = {};
+
+    bool empty() const noexcept { return summary == 0; }
+    bool test(uint32_t i) const noexcept {
+      return (words[i >> 6] >> (i & 63)) & 1u;
+    }
+
+    void set(uint32_t i) noexcept {
+      words[i >> 6] |= 1ull << (i & 63);
+      summary |= 1ull << (i >> 6);
+    }
+    void clear(uint32_t i) noexcept {
+      uint64_t& w = words[i >> 6];
+      w &= ~(1ull << (i & 63));
+      if (!w) summary &= ~(1ull << (i >> 6));
+    }
+    uint32_t lowest() const noexcept {  // requires !empty()
+      const uint32_t wi = detail::ctz64(summary);
+      return (wi << 6) | detail::ctz64(words[wi]);
+    }
+    uint32_t highest() const noexcept {  // requires !empty()
+      const uint32_t wi = detail::msb64(summary);
+      return (wi << 6) | detail::msb64(words[wi]);
+    }
+  };
+
+  int32_t price_to_tick(double px) const noexcept;
+  double tick_to_price(int32_t t) const noexcept { return double(t) * tick_size_; }
+
+  bool in_window(int32_t tick) const noexcept {
+    return static_cast<uint32_t>(tick - base_tick_) < kSlots;
+  }
+  uint32_t slot_of(int32_t tick) const noexcept {
+    return static_cast<uint32_t>(tick - base_tick_);
+  }
+
+  Occupancy& bits(Side side) noexcept {
+    return side == Side::BUY ? bid_bits_ : ask_bits_;
+  }
+
+  // add_order(); on_fill(maker, tick, qty) runs once per resting order
+  // traded.
+  template <class OnFill>
+  int add_impl(const Order& o, int32_t& trade_tick, OrderType type,
+               OnFill&& on_fill);
+  // Consumes resting liquidity on the side opposite to `aggressor` up to
+  // `limit`; returns the remaining quantity.
+  template <class OnFill>
+  int match(Side aggressor, int32_t limit, int remaining, int32_t& trade_tick,
+            OnFill&& on_fill);
+  bool rest(const Order& o, int32_t tick, int remaining);
+  // Resting qty a `taker` order limited at `limit` could fill, counted up
+  // to `need` (FOK check); walks levels best-first.
+  int64_t fillable(Side taker, int32_t limit, int64_t need) const;
+  void release_level(Side side, uint32_t slot, Level* lvl);
+  void refresh_best(Side side) noexcept;
+  bool recentre(int32_t tick);
+
+  std::pmr::vector<Level*> slots_;  // kSlots entries, nullptr = empty tick
+  Occupancy bid_bits_;
+  Occupancy ask_bits_;
+  SwissHashMap<uint64_t, OrderNode*> index_;  // order id -> resting node
+  OrderPool pool_;
+  std::pmr::vector<Level*> free_levels_;
+
+  std::optional<int32_t> best_bid_tick_;
+  std::optional<int32_t> best_ask_tick_;
+  int32_t base_tick_{0};
+  uint64_t rejected_{0};
+
+  std::string symbol_;
+  std::pmr::memory_resource* mr_{nullptr};
+
+  double tick_size_{0.01};
+  double inv_tick_{100.0};
+};
+
+}  // namespace msim
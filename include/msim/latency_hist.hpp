@@ -0,0 +1,113 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define MSIM_HAVE_RDTSC 1
+#endif
+
+namespace msim {
+
+/**
+ * Cheap per-op timestamp source for --latency: rdtsc where available,
+ * steady_clock ns elsewhere. Ticks are converted to ns once, at report
+ * time, from a steady_clock pair taken around the run (see ns_per_tick).
+ */
+struct LatencyClock {
+  static uint64_t now() noexcept {
+#ifdef MSIM_HAVE_RDTSC
+    return __rdtsc();
+#else
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+#endif
+  }
+
+  // Taken at the start of a run; ns_per_tick() measures against it.
+  struct Calibration {
+    uint64_t tick0 = now();
+    std::chrono::steady_clock::time_point t0 =
+        std::chrono::steady_clock::now();
+    double ns_per_tick() const noexcept;
+  };
+};
+
+/**
+ * Fixed-bucket log-linear histogram (HDR-style) of tick counts.
+ * - Values below 2^kSubBits get exact buckets; above, each power of two is
+ *   split into 2^kSubBits sub-buckets, so a reported value is within 1/32
+ *   (~3%) of the true one
+ * - record() is a clz, a shift and an increment on a flat array: no
+ *   allocation, no sharing; keep one per thread and merge() at the end
+ */
+class LatencyHistogram {
+ public:
+  static constexpr unsigned kSubBits = 5;
+  static constexpr size_t kSub = size_t(1) << kSubBits;
+  static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSub;
+
+  void record(uint64_t v) noexcept {
+    ++counts_[bucket_of(v)];
+    ++count_;
+    if (v > max_) max_ = v;
+  }
+  void merge(const LatencyHistogram& other) noexcept;
+
+  uint64_t count() const noexcept { return count_; }
+  uint64_t max() const noexcept { return max_; }
+  // Upper edge of the bucket holding the q-quantile (q in [0,1]), capped
+  // at max(); 0 when empty.
+  uint64_t quantile(double q) const noexcept;
+
+  static size_t bucket_of(uint64_t v) noexcept {
+    if (v < kSub) return size_t(v);
+    const unsigned msb = 63u - unsigned(clz64(v));
+    const unsigned shift = msb - kSubBits;
+    return (size_t(shift) + 1) * kSub + size_t((v >> shift) & (kSub - 1));
+  }
+  static uint64_t bucket_high(size_t b) noexcept;
+
+ private:
+  static int clz64(uint64_t v) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanReverse64(&i, v);
+    return 63 - int(i);
+#else
+    return __builtin_clzll(v);
+#endif
+  }
+
+  uint64_t counts_[kBuckets] = {};
+  uint64_t count_ = 0;
+  uint64_t max_ = 0;
+};
+
+// Book operations timed by --latency: an ADD that rests untouched, an ADD
+// that crossed and swept levels (the TRADE path), and a cancel.
+struct OpLatency {
+  LatencyHistogram add;
+  LatencyHistogram fill;
+  LatencyHistogram cancel;
+
+  void merge(const OpLatency& other) noexcept {
+    add.merge(other.add);
+    fill.merge(other.fill);
+    cancel.merge(other.cancel);
+  }
+
+  // One "Latency <op>: count=N p50=.. p99=.. p99.9=.. max=.. (ns)" line per
+  // op; bench.sh parses these.
+  void print(std::ostream& os, double ns_per_tick) const;
+};
+
+}  // namespace msim
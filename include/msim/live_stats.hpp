@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace msim {
+
+inline constexpr std::size_t kCacheLine = 64;
+
+/**
+ * Per-worker progress counters a monitor can sample mid-run.
+ * - One cache line per worker, so workers never false-share with each
+ *   other and a reader only ever touches lines it is sampling
+ * - Single writer: publish() is plain relaxed stores (no locked RMW), made
+ *   once per intent batch rather than per event, so sampling costs the
+ *   worker at most one line transfer per batch
+ * - Each counter is monotone; a sample may mix adjacent publishes
+ */
+struct alignas(kCacheLine) LiveStats {
+  struct Snapshot {
+    uint64_t events = 0;  // generator steps run
+    uint64_t adds = 0;
+    uint64_t cancels = 0;
+    uint64_t trades = 0;
+  };
+
+  void publish(const Snapshot& s) noexcept {
+    events_.store(s.events, std::memory_order_relaxed);
+    adds_.store(s.adds, std::memory_order_relaxed);
+    cancels_.store(s.cancels, std::memory_order_relaxed);
+    trades_.store(s.trades, std::memory_order_relaxed);
+  }
+
+  Snapshot sample() const noexcept {
+    return {events_.load(std::memory_order_relaxed),
+            adds_.load(std::memory_order_relaxed),
+            cancels_.load(std::memory_order_relaxed),
+            trades_.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  std::atomic<uint64_t> events_{0};
+  std::atomic<uint64_t> adds_{0};
+  std::atomic<uint64_t> cancels_{0};
+  std::atomic<uint64_t> trades_{0};
+};
+static_assert(sizeof(LiveStats) == kCacheLine, "LiveStats spans one line");
+
+/**
+ * Live progress reporting (--progress MS): a thread that sums the workers'
+ * LiveStats every `period` and prints one line (events done, interval
+ * ev/s, adds / cancels / trades). Reads only; workers never wait on it.
+ */
+class LiveMonitor {
+ public:
+  LiveMonitor(const std::vector<LiveStats>& stats, uint64_t total_events,
+              std::chrono::milliseconds period, std::ostream& out);
+  ~LiveMonitor();
+
+  LiveMonitor(const LiveMonitor&) = delete;
+  LiveMonitor& operator=(const LiveMonitor&) = delete;
+
+  // Sum over all workers right now.
+  LiveStats::Snapshot total() const noexcept;
+
+  void stop();  // idempotent; joins the thread
+
+ private:
+  void loop();
+
+  const std::vector<LiveStats>& stats_;
+  uint64_t total_events_;
+  std::chrono::milliseconds period_;
+  std::ostream& out_;
+
+  std::thread thread_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+};
+
+}  // namespace msim
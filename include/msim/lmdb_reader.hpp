@@ -1,24 +1,107 @@
 #pragma once
 #include <lmdb.h>
 
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <string>
 #include <vector>
 
 #include "msim/event.hpp"
+#include "msim/event_batch.hpp"
+#include "msim/symbol_table.hpp"
 
 namespace msim {
 
+/**
+ * Read side of LMDBStorage / ShardedLMDBStorage. A directory holding a
+ * `shards` manifest is opened as one logical store: symbols and counts are
+ * unioned across shards and scans merge the shards' cursors by ts (ties go
+ * to the lower shard), so callers never see the sharding.
+ */
 class LMDBReader {
  public:
+  // Sinks return true to keep reading, false to stop early.
+  using BatchSink = std::function<bool(const EventBatch&)>;
+  // The view (and its symbol) points into the LMDB map and stays valid for
+  // the reader's lifetime; copy fields out if they must outlive it.
+  using ViewSink = std::function<bool(const EventView&)>;
+  // for_each_parallel(): `symbol` indexes the symbols passed in.
+  using IndexedViewSink =
+      std::function<bool(size_t symbol, const EventView&)>;
+
+  static constexpr uint64_t kMaxTs = std::numeric_limits<uint64_t>::max();
+
   explicit LMDBReader(const std::string& path);
   ~LMDBReader();
 
+  LMDBReader(const LMDBReader&) = delete;
+  LMDBReader& operator=(const LMDBReader&) = delete;
+
+  // Materializes the whole DBI (one std::string per event). Prefer
+  // for_each()/read_batches() for anything larger than a test store.
   std::vector<Event> read_all(const std::string& symbol);
+  // Sorted, each symbol once even if several shards hold it.
   std::vector<std::string> list_symbols();
 
+  // Number of records stored for `symbol` (mdb_stat per shard; no scan).
+  size_t count(const std::string& symbol);
+
+  // Visits the records of `symbol` with ts in [ts_from, ts_to] in key
+  // order, without copying or allocating. Integer-keyed stores seek with
+  // MDB_SET_RANGE and stop at ts_to; legacy stores (byte-ordered keys) are
+  // scanned and filtered. Returns the number of views delivered.
+  size_t for_each(const std::string& symbol, const ViewSink& sink,
+                  uint64_t ts_from = 0, uint64_t ts_to = kMaxTs);
+
+  // Same, but one ts-ordered stream over several symbols (ties go to the
+  // lower shard, then the earlier symbol in `symbols`).
+  size_t for_each_merged(const std::vector<std::string>& symbols,
+                         const ViewSink& sink, uint64_t ts_from = 0,
+                         uint64_t ts_to = kMaxTs);
+
+  // for_each() over every symbol in `symbols` (each visited once), on up to
+  // `n_threads` threads. Each thread opens its own read txn per shard and
+  // takes the next unscanned symbol until none are left, so a symbol's
+  // views reach `sink` in order on one thread while different symbols run
+  // concurrently; sink(i, v) must be safe to call that way. `sink`
+  // returning false stops that symbol only. Views stay valid for the
+  // reader's lifetime, as with for_each(). Returns the number of views
+  // delivered; rethrows the first worker error after all have stopped.
+  size_t for_each_parallel(const std::vector<std::string>& symbols,
+                           size_t n_threads, const IndexedViewSink& sink,
+                           uint64_t ts_from = 0, uint64_t ts_to = kMaxTs);
+
+  // Streams `symbol` into `batch` (reused; its SymbolTable must be
+  // symbols()), calling `sink` whenever it fills and once for the tail.
+  // Memory use is bounded by the batch, not the store. Returns the number
+  // of events delivered.
+  size_t read_batches(const std::string& symbol, EventBatch& batch,
+                      const BatchSink& sink, uint64_t ts_from = 0,
+                      uint64_t ts_to = kMaxTs);
+
+  // Symbols seen by list_symbols(), with stable ids for EventBatch use.
+  const SymbolTable& symbols() const noexcept { return symbols_; }
+  // 1 for a plain LMDBStorage env.
+  size_t shards() const noexcept { return shards_.size(); }
+
  private:
-  MDB_env* env_ = nullptr;
-  MDB_txn* txn_ = nullptr;
+  struct Shard {
+    MDB_env* env = nullptr;
+    MDB_txn* txn = nullptr;
+  };
+  struct Scan;  // one cursor over one (shard, symbol) DBI
+
+  static Shard open_shard(const std::string& path);
+  // False if the shard has no DBI for `symbol`.
+  static bool open_dbi(const Shard& sh, const std::string& symbol,
+                       MDB_dbi& dbi);
+  void add_scans(const std::string& symbol, std::vector<Scan>& scans);
+  static size_t merge(std::vector<Scan>& scans, const ViewSink& sink,
+                      uint64_t ts_from, uint64_t ts_to);
+
+  std::vector<Shard> shards_;
+  SymbolTable symbols_;
 };
 
 }  // namespace msim
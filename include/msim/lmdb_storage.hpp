@@ -1,35 +1,98 @@
 #pragma once
 #include <lmdb.h>
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "event.hpp"
 #include "storage.hpp"
 
 namespace msim {
 
+/**
+ * One DBI per symbol, key = ts_ns (MDB_INTEGERKEY), value = event record.
+ * - Keys arrive in increasing order per symbol (make_ts() is monotonic per
+ *   thread and a symbol belongs to one thread), so puts use MDB_APPEND
+ *   through a per-DBI cursor: no key search and no B-tree page splits.
+ *   Out-of-order keys fall back to a normal put and are counted.
+ * - write_batch() groups a batch's rows by symbol so each DBI gets one run.
+ * - Txns commit by staged bytes (StorageOptions::lmdb_txn_bytes).
+ */
 class LMDBStorage final : public IStorage {
   MDB_env* env_ = nullptr;
   MDB_txn* txn_ = nullptr;
   std::unordered_map<std::string, MDB_dbi> dbis_;
+  // Batch path: symbol_id -> dbi, valid for `dbi_table_` only.
+  std::vector<MDB_dbi> dbi_by_id_;
+  std::vector<bool> dbi_by_id_set_;
+  const SymbolTable* dbi_table_ = nullptr;
+  std::vector<MDB_cursor*> cursors_;  // by dbi, open in txn_ only
+  std::vector<uint8_t> scratch_;      // reused serialization buffer
+  std::vector<uint32_t> group_;       // batch rows grouped by symbol
+  std::vector<uint32_t> group_start_;
   std::string path_;
-  size_t batch_count_ = 0;
-  const size_t batch_limit_ = 10000;  // commit every 10k writes
+  StorageOptions opts_;
+  size_t txn_bytes_ = 0;
+  uint64_t append_fallbacks_ = 0;
 
  public:
   explicit LMDBStorage(const std::string& path,
                        size_t map_size_bytes = (1ull << 30));
+  LMDBStorage(const std::string& path, const StorageOptions& opts);
   ~LMDBStorage() override;
 
   void write(const Event& e) override;
+  void write_batch(const EventBatch& b) override;
+  // Commits the open txn on the calling (writing) thread; the one env has
+  // one writer at a time, so `source` does not matter here.
+  void flush_source(uint32_t source) override;
   void flush() override;
 
+  // Puts that could not use MDB_APPEND (key not above the DBI's last key).
+  uint64_t append_fallbacks() const noexcept { return append_fallbacks_; }
+
  private:
   MDB_dbi dbi_for_symbol(const std::string& sym);
+  MDB_dbi dbi_for_id(const SymbolTable& syms, uint16_t id);
+  MDB_cursor* cursor_for(MDB_dbi dbi);
+  void put(MDB_dbi dbi, uint64_t ts_ns, const uint8_t* data, size_t len);
+  void begin_txn();
   void commit_txn();
 };
 
-std::unique_ptr<IStorage> make_lmdb_storage(const std::string& path);
+/**
+ * One LMDB env per producer, so run_mt() workers can log without sharing a
+ * write txn (LMDB allows one per env, bound to the thread that began it):
+ *   PATH/shards                shard count (text), written first
+ *   PATH/shard-000/ ...        one LMDBStorage env per shard
+ * write_batch() routes on EventBatch::source, so a worker's batches always
+ * land in the same shard; each worker must call flush_source() before it
+ * exits so its last txn is committed on its own thread. LMDBReader opens
+ * the directory as one store and merges the shards by ts.
+ */
+class ShardedLMDBStorage final : public IStorage {
+ public:
+  // opts.lmdb_shards envs, each with opts' map size / durability.
+  ShardedLMDBStorage(const std::string& path, const StorageOptions& opts);
+
+  // Row path (single-threaded callers): shard 0.
+  void write(const Event& e) override;
+  void write_batch(const EventBatch& b) override;
+  void flush_source(uint32_t source) override;
+  // Syncs every shard; shards must have no open txn from another thread.
+  void flush() override;
+
+  size_t shards() const noexcept { return shards_.size(); }
+  static std::string shard_dir(const std::string& path, size_t shard);
+
+ private:
+  std::vector<std::unique_ptr<LMDBStorage>> shards_;
+};
+
+std::unique_ptr<IStorage> make_lmdb_storage(const std::string& path,
+                                            const StorageOptions& opts = {});
 
 }  // namespace msim
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace msim {
+
+// Read-only map of a whole file (mmap / a Win32 file mapping). Pages load
+// on first touch, so readers only pay for the parts they look at.
+class MappedFile {
+ public:
+  // Throws std::runtime_error if the file is missing, empty or can't be
+  // mapped; messages name it as `what` (e.g. "column log").
+  MappedFile(const std::string& path, const char* what);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* data() const noexcept { return base_; }
+  std::size_t size() const noexcept { return size_; }
+
+ private:
+  const uint8_t* base_{nullptr};
+  std::size_t size_{0};
+#ifdef _WIN32
+  void* file_{nullptr};
+  void* mapping_{nullptr};
+#endif
+};
+
+}  // namespace msim
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace msim {
+
+enum class HugePages : uint8_t {
+  Off = 0,          // regular pages
+  Transparent = 1,  // 2 MiB-aligned mapping + madvise(MADV_HUGEPAGE)
+  Explicit = 2,     // MAP_HUGETLB / MEM_LARGE_PAGES; falls back to THP
+};
+
+/**
+ * Page-backed arena storage placed on one NUMA node.
+ * - Mapped directly (mmap / VirtualAlloc), so it does not inherit the
+ *   placement of whatever heap page malloc hands out
+ * - node >= 0 binds the range to that node before any page is touched
+ *   (mbind MPOL_PREFERRED / VirtualAllocExNuma); -1 = the calling thread's
+ *   node by first touch
+ * - Every page is touched by the constructing thread, so construct it on
+ *   the worker after bind_to_core()
+ * - node() reports where the first page actually landed (get_mempolicy on
+ *   Linux), for --print-arena
+ */
+class NodeBuffer {
+ public:
+  explicit NodeBuffer(size_t bytes, int node = -1,
+                      HugePages huge = HugePages::Off);
+  ~NodeBuffer();
+  NodeBuffer(const NodeBuffer&) = delete;
+  NodeBuffer& operator=(const NodeBuffer&) = delete;
+
+  std::byte* data() noexcept { return data_; }
+  size_t size() const noexcept { return size_; }
+
+  int node() const noexcept { return node_; }  // -1 = unknown
+  HugePages huge_pages() const noexcept { return huge_; }  // as obtained
+
+  static const char* huge_name(HugePages h) noexcept;
+
+ private:
+  std::byte* data_ = nullptr;
+  size_t size_ = 0;
+  void* map_ = nullptr;  // whole mapping (may extend past data_ + size_)
+  size_t map_bytes_ = 0;
+  int node_ = -1;
+  HugePages huge_ = HugePages::Off;
+};
+
+}  // namespace msim
@@ -1,91 +1,325 @@
 #pragma once
 
 #include <cstdint>
-#include <deque>
+#include <memory>
 #include <memory_resource>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include "msim/book_policy.hpp"
 #include "msim/event.hpp"
-#include "msim/flat_hash.hpp"
+#include "msim/swiss_hash.hpp"
+#include "msim/order_pool.hpp"
 
 namespace msim {
 
-struct Order {
-  uint64_t id;
-  double price;
-  int qty;
-  Side side;     // BUY or SELL
-  uint64_t ts_ns;
+// One aggregated price level: total resting qty and order count at `tick`.
+struct DepthLevel {
+  int32_t tick;
+  int64_t qty;
+  uint32_t orders;
 };
 
-class OrderBook {
+// A level whose aggregate changed; orders == 0 means the level is gone.
+struct DepthUpdate {
+  Side side;
+  DepthLevel level;
+};
+
+enum class BookOp : uint8_t { Add = 0, Cancel = 1 };
+
+// One input of IOrderBook::apply(). A Cancel only reads order.id.
+struct BookCommand {
+  Order order{};
+  BookOp op = BookOp::Add;
+  OrderType type = OrderType::Limit;
+
+  static BookCommand add(const Order& o,
+                         OrderType type = OrderType::Limit) noexcept {
+    return {o, BookOp::Add, type};
+  }
+  static BookCommand cancel(uint64_t order_id) noexcept {
+    return {Order{order_id, 0, 0, Side::BUY, 0}, BookOp::Cancel,
+            OrderType::Limit};
+  }
+};
+
+// One execution: `qty` of the command at index `cmd` traded against the
+// resting order `maker_id`, at the maker's tick.
+struct Fill {
+  uint64_t taker_id;
+  uint64_t maker_id;
+  int32_t tick;
+  int32_t qty;
+  uint32_t cmd;
+  Side taker_side;
+};
+
+// add_order() / apply() result for an add whose remainder the book could
+// not rest and dropped: the complement of the filled qty, so it is always
+// negative. Only LadderOrderBook rejects (price outside its window).
+constexpr int add_rejected(int filled) noexcept { return ~filled; }
+constexpr bool is_rejected(int result) noexcept { return result < 0; }
+constexpr int filled_qty(int result) noexcept {
+  return result < 0 ? ~result : result;
+}
+
+// Shared by both engines' apply() / add_order() paths.
+namespace detail {
+// apply(): commands ahead of the current one whose slots get prefetched.
+inline constexpr std::size_t kPrefetchAhead = 8;
+
+// Fill sink for add_order(), which has no use for per-fill detail.
+struct NoFill {
+  void operator()(const Order&, int32_t, int) const noexcept {}
+};
+}  // namespace detail
+
+// Book engine interface so the simulator can pick an implementation at
+// runtime (--book). Concrete books are `final`; the simulator's step loops
+// are instantiated per engine and call them directly, not through here.
+class IOrderBook {
  public:
-  // tick_size defaults to 0.01. Keep default so existing call sites don't change.
-  OrderBook(std::string symbol, std::pmr::memory_resource* mr, double tick_size = 0.01);
+  virtual ~IOrderBook() = default;
 
-  int add_order(const Order& o, double& trade_price);
-  bool cancel_order(uint64_t order_id);
+  // Matches `o` against the opposite side as `type` allows (see OrderType),
+  // rests any remainder a Limit / PostOnly order keeps and returns the
+  // filled quantity. trade_tick receives the last fill's tick. A killed FOK
+  // or a crossing PostOnly leaves the book untouched and returns 0. A
+  // remainder the engine can't rest is dropped and reported as
+  // add_rejected(filled). Prices are ticks throughout; a Market order's
+  // o.tick is ignored.
+  virtual int add_order(const Order& o, int32_t& trade_tick,
+                        OrderType type = OrderType::Limit) = 0;
+  virtual bool cancel_order(uint64_t order_id) = 0;
 
-  std::optional<double> best_bid() const;
-  std::optional<double> best_ask() const;
+  // Runs cmds[0, n) in order with the same effect as the single calls.
+  // Appends one Fill per resting order an add trades against (best level
+  // first, FIFO within it) to `fills`, and stores each command's result in
+  // results[i] if given: an add's add_order() result, a cancel's 1 / 0.
+  // Upcoming commands' index and level slots are prefetched; the hash book
+  // also rescans for a best price once per run of cancels, not per emptied
+  // best level (the ladder's come from its bitsets in O(1)).
+  virtual void apply(const BookCommand* cmds, std::size_t n,
+                     std::vector<Fill>& fills,
+                     int32_t* results = nullptr) = 0;
 
-  const std::string& symbol() const { return symbol_; }
+  virtual std::optional<int32_t> best_bid_tick() const = 0;
+  virtual std::optional<int32_t> best_ask_tick() const = 0;
+
+  // Decimal prices of the above, for display.
+  virtual std::optional<double> best_bid() const = 0;
+  virtual std::optional<double> best_ask() const = 0;
+
+  virtual const std::string& symbol() const = 0;
 
   // Debug / test hook (helps validate index cleanup & invariants).
+  virtual std::size_t index_size() const noexcept = 0;
+
+  // Adds whose remainder was dropped (see add_order); 0 for the hash book.
+  virtual uint64_t rejected() const noexcept = 0;
+
+  // Digest of the resting book (see BookDigest); equal books give equal
+  // values regardless of engine. O(levels + orders), not for the hot path.
+  virtual uint64_t state_checksum() const = 0;
+
+  // Appends every resting order to `out` in BookDigest order (bids best ->
+  // worst, then asks, each level FIFO). Adding them back in that order to
+  // an empty book of either engine rebuilds the same queues (checkpoints).
+  virtual void resting_orders(std::vector<Order>& out) const = 0;
+
+  // Top `n` levels of `side`, best -> worst, into `out` (cleared first).
+  // O(levels) on the hash book, O(n + scanned words) on the ladder.
+  virtual void depth(Side side, std::size_t n,
+                     std::vector<DepthLevel>& out) const = 0;
+
+  // While set, add_order / cancel_order append one DepthUpdate per level
+  // they change (after the change) to *log; see DepthFeed. The caller
+  // drains it. nullptr (the default) turns the hook off.
+  void set_depth_log(std::vector<DepthUpdate>* log) noexcept {
+    depth_log_ = log;
+  }
+
+ protected:
+  void note_level(Side side, int32_t tick, const OrderQueue& q) {
+    if (depth_log_) depth_log_->push_back({side, {tick, q.qty, q.count}});
+  }
+
+  std::vector<DepthUpdate>* depth_log_ = nullptr;
+};
+
+// Folds a book in canonical order: bids best -> worst, then asks best ->
+// worst, each level's orders in FIFO (time priority) order.
+class BookDigest {
+ public:
+  void level(Side side, int32_t tick) noexcept {
+    mix(0x4C45564C00000000ull | (uint64_t(side) << 32) | uint32_t(tick));
+  }
+  void order(uint64_t id, int qty) noexcept {
+    mix(id);
+    mix(uint32_t(qty));
+  }
+  uint64_t value() const noexcept { return h_; }
+
+ private:
+  void mix(uint64_t x) noexcept {  // FNV-1a over a splitmix64-scrambled word
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    h_ = (h_ ^ (x ^ (x >> 31))) * 0x100000001B3ull;
+  }
+
+  uint64_t h_ = 0xCBF29CE484222325ull;
+};
+
+enum class BookKind : uint8_t {
+  Hash = 0,    // OrderBook: hashed price levels
+  Ladder = 1,  // LadderOrderBook: tick-indexed array + occupancy bitset
+};
+
+std::unique_ptr<IOrderBook> make_order_book(BookKind kind, std::string symbol,
+                                            std::pmr::memory_resource* mr,
+                                            double tick_size = 0.01,
+                                            double ref_price = 100.0);
+
+// Hashed price-level book. Side work is instantiated per SidePolicy (see
+// book_policy.hpp), so level-map selection and price comparisons are
+// resolved at compile time. Orders arrive in ticks; tick_size only scales
+// best_bid() / best_ask() for display.
+class HashBookCore {
+ public:
+  using DepthLog = std::vector<DepthUpdate>;
+
+  HashBookCore(std::pmr::memory_resource* mr, double tick_size);
+  ~HashBookCore();  // returns levels to mr (matters for pool arenas)
+
+  HashBookCore(const HashBookCore&) = delete;
+  HashBookCore& operator=(const HashBookCore&) = delete;
+
+  // As IOrderBook; `log` is the book's depth log (may be null).
+  int add_order(const Order& o, int32_t& trade_tick, OrderType type,
+                DepthLog* log);
+  bool cancel_order(uint64_t order_id, DepthLog* log);
+  void apply(const BookCommand* cmds, std::size_t n, std::vector<Fill>& fills,
+             int32_t* results, DepthLog* log);
+
+  std::optional<int32_t> best_bid_tick() const { return bids_.best; }
+  std::optional<int32_t> best_ask_tick() const { return asks_.best; }
+  std::optional<double> best_bid() const;
+  std::optional<double> best_ask() const;
   std::size_t index_size() const noexcept { return index_.size(); }
+  uint64_t state_checksum() const;
+  void resting_orders(std::vector<Order>& out) const;
+  void depth(Side side, std::size_t n, std::vector<DepthLevel>& out) const;
 
  private:
-  struct OrderRef {
-    Side side;
-    int32_t tick;
+  // Level queue is an intrusive list of pooled OrderNodes; node->queue leads
+  // back to the Level, so cancel never walks the queue.
+  struct Level : OrderQueue {
+    int32_t tick{0};
+
+    explicit Level(int32_t t) : tick(t) {}
+
+    void reset(int32_t t) { tick = t; }  // only empty levels are recycled
   };
 
-  struct Level {
-    int32_t tick{0};
-    std::pmr::deque<Order> q;
+  // One side's price levels, the ticks that have one, and the best tick.
+  struct SideLevels {
+    SideLevels(std::pmr::memory_resource* mr, std::size_t cap);
 
-    Level(int32_t t, std::pmr::memory_resource* mr) : tick(t), q(mr) {}
+    SwissHashMap<int32_t, Level*> levels;
+    std::pmr::vector<int32_t> ticks;
+    std::optional<int32_t> best;
+    bool stale = false;  // apply(): best's level went; recompute before use
 
-    void reset(int32_t t) {
-      tick = t;
-      q.clear();
+    Level* find(int32_t tick) const noexcept {
+      auto p = levels.find_ptr(tick);
+      return p ? *p : nullptr;
     }
   };
 
-  // Price -> tick conversions (positive price assumption is fine for this sim)
-  int32_t price_to_tick(double px) const noexcept;
-  double tick_to_price(int32_t t) const noexcept { return double(t) * tick_size_; }
+  static Level* level_of(const OrderNode* n) noexcept {
+    return static_cast<Level*>(n->queue);
+  }
 
-  Level* get_or_create_level(Side side, int32_t tick);
-  Level* get_level(Side side, int32_t tick) noexcept;
-  const Level* get_level(Side side, int32_t tick) const noexcept;
+  template <Side S>
+  SideLevels& side() noexcept {
+    if constexpr (S == Side::BUY) return bids_;
+    else return asks_;
+  }
+  template <Side S>
+  const SideLevels& side() const noexcept {
+    if constexpr (S == Side::BUY) return bids_;
+    else return asks_;
+  }
 
-  void remove_level_if_empty(Side side, int32_t tick, Level* lvl);
+  // on_fill(maker, tick, qty) runs once per resting order traded.
+  template <Side S, class OnFill>
+  int add_side(const Order& o, int32_t& trade_tick, OrderType type,
+               DepthLog* log, OnFill&& on_fill);
+  // defer_best: mark the side stale instead of rescanning for a new best.
+  bool cancel(uint64_t order_id, DepthLog* log, bool defer_best);
 
-  void add_active_tick(Side side, int32_t tick);
-  void remove_active_tick(Side side, int32_t tick);
-  void recompute_best(Side side);
+  template <Side S>
+  Level* get_or_create_level(int32_t tick);
+  template <Side S>
+  void remove_level_if_empty(int32_t tick, Level* lvl,
+                             bool defer_best = false);
+  template <Side S>
+  void recompute_best();
 
-  // Fixed-capacity maps to avoid pmr monotonic rehash leaks.
-  // Tune caps as needed.
-  FlatHashMap<int32_t, Level*> bid_levels_;
-  FlatHashMap<int32_t, Level*> ask_levels_;
-  FlatHashMap<uint64_t, OrderRef> index_;
+  // Resting qty an order on side S limited at `limit` could fill, counted
+  // up to `need` (FOK check). O(levels), off the Limit path.
+  template <Side S>
+  int64_t fillable(int32_t limit, int64_t need) const;
 
-  std::pmr::vector<int32_t> bid_ticks_;
-  std::pmr::vector<int32_t> ask_ticks_;
-  std::pmr::vector<Level*> free_levels_;
+  template <Side S>
+  void depth_side(std::size_t n, std::vector<DepthLevel>& out) const;
 
-  std::optional<int32_t> best_bid_tick_;
-  std::optional<int32_t> best_ask_tick_;
+  Level* new_level(int32_t tick);
+
+  // Tables start at fixed capacities and double past them (deep books).
+  SideLevels bids_;
+  SideLevels asks_;
+  SwissHashMap<uint64_t, OrderNode*> index_;  // order id -> resting node
+  OrderPool pool_;
+  std::pmr::vector<Level*> free_levels_;
 
-  std::string symbol_;
   std::pmr::memory_resource* mr_{nullptr};
+  double tick_size_;
+};
+
+class OrderBook final : public IOrderBook {
+ public:
+  // tick_size defaults to 0.01. Keep default so existing call sites don't change.
+  OrderBook(std::string symbol, std::pmr::memory_resource* mr, double tick_size = 0.01);
 
-  double tick_size_{0.01};
-  double inv_tick_{100.0};
+  int add_order(const Order& o, int32_t& trade_tick,
+                OrderType type = OrderType::Limit) override;
+  bool cancel_order(uint64_t order_id) override;
+  void apply(const BookCommand* cmds, std::size_t n, std::vector<Fill>& fills,
+             int32_t* results = nullptr) override;
+
+  std::optional<int32_t> best_bid_tick() const override;
+  std::optional<int32_t> best_ask_tick() const override;
+  std::optional<double> best_bid() const override;
+  std::optional<double> best_ask() const override;
+
+  const std::string& symbol() const override { return symbol_; }
+
+  // Debug / test hook (helps validate index cleanup & invariants).
+  std::size_t index_size() const noexcept override;
+  uint64_t rejected() const noexcept override { return 0; }
+
+  uint64_t state_checksum() const override;
+  void resting_orders(std::vector<Order>& out) const override;
+  void depth(Side side, std::size_t n,
+             std::vector<DepthLevel>& out) const override;
+
+ private:
+  std::string symbol_;
+  HashBookCore core_;
 };
 
 }  // namespace msim
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "event.hpp"
+#include "rng.hpp"
+#include "scenario.hpp"
+#include "ziggurat.hpp"
+
+namespace msim {
+
+/**
+ * Pre-drawn order intents, one per simulation step (SoA).
+ * Everything that doesn't depend on book state is drawn up front; the
+ * matching loop resolves the rest:
+ *   price  = mid + mid * move[i]     (move = sigma(i) * N(0,1), drift applied)
+ *   victim = live[pick[i] * live.size()]
+ * A row is an ADD when add[i] is set or the symbol has nothing live.
+ */
+struct IntentBatch {
+  static constexpr size_t kCapacity = 1024;
+
+  size_t n = 0;
+  alignas(64) uint32_t sym[kCapacity];  // index into the worker's symbols
+  alignas(64) uint8_t add[kCapacity];
+  alignas(64) Side side[kCapacity];
+  alignas(64) int32_t qty[kCapacity];  // Scenario qty range (x burst mult)
+  alignas(64) OrderType type[kCapacity];  // Limit unless the scenario mixes
+  alignas(64) double move[kCapacity];  // fractional price move
+  alignas(64) double pick[kCapacity];  // [0,1)
+};
+
+/**
+ * Generator stage: fills IntentBatches from a 4-lane xoroshiro128+ and a
+ * ziggurat normal kernel, a whole batch at a time, so the matching loop
+ * only reads arrays. One generator per worker; output depends only on the
+ * seed, the scenario and the event index range, so runs are reproducible
+ * per --seed. A non-default Scenario costs one extra draw per step for
+ * the add / order-type mix (and a pow() per step for Pareto sizes).
+ */
+class OrderGenerator {
+ public:
+  OrderGenerator(uint64_t seed, size_t n_symbols, double sigma,
+                 double drift_ampl = 0.0, uint64_t drift_period = 0,
+                 const Scenario& scenario = Scenario{});
+
+  // Fills `b` with the intents for steps [first_step, first_step + n);
+  // n <= IntentBatch::kCapacity.
+  void fill(IntentBatch& b, uint64_t first_step, size_t n);
+
+  // Everything fill() advances: the lane streams and the ziggurat's tail
+  // stream. restore(state()) at a batch boundary resumes the same output.
+  struct State {
+    uint64_t lane_s0[Xoroshiro128PlusX4::kLanes];
+    uint64_t lane_s1[Xoroshiro128PlusX4::kLanes];
+    uint64_t tail_s0;
+    uint64_t tail_s1;
+  };
+  State state() const noexcept;
+  void restore(const State& s) noexcept;
+
+ private:
+  static constexpr size_t kWords = IntentBatch::kCapacity;
+
+  int32_t qty_of(uint64_t bits30) const;
+
+  Xoroshiro128PlusX4 rng_;
+  ZigguratNormal normal_;
+  uint32_t n_symbols_;
+  double sigma_;
+  double drift_ampl_;
+  uint64_t drift_period_;
+
+  // Scenario, pre-scaled to 2^32 thresholds for the integer draws.
+  Scenario sc_;
+  bool mix_ = false;                // draws mix_words_ (add / type / burst)
+  uint64_t add_cut_ = 0;            // step adds when low word >= add_cut_
+  uint64_t type_cut_[4] = {};       // cumulative IOC, FOK, Market, PostOnly
+  uint64_t burst_market_cut_ = 0;
+  std::vector<uint64_t> sym_cut_;   // cumulative Zipf weights; empty = uniform
+
+  alignas(64) uint64_t fields_[kWords];      // sym | qty | side | add
+  alignas(64) uint64_t mix_words_[kWords];   // add | type (non-default mix)
+  alignas(64) uint64_t picks_[kWords];
+  alignas(64) uint64_t normals_[kWords / 2];  // two 32-bit draws each
+};
+
+}  // namespace msim
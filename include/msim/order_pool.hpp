@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+#include "msim/event.hpp"
+
+namespace msim {
+
+struct Order {
+  uint64_t id;
+  int32_t tick;  // limit price in ticks of the book's tick size
+  int qty;
+  Side side;     // BUY or SELL
+  uint64_t ts_ns;
+};
+
+struct OrderQueue;
+
+// Resting order + intrusive links into its level's FIFO.
+struct OrderNode {
+  Order o;
+  OrderNode* prev = nullptr;
+  OrderNode* next = nullptr;
+  OrderQueue* queue = nullptr;  // owning level queue (for O(1) cancel)
+};
+
+// Intrusive doubly linked FIFO of resting orders for one price level.
+// Books derive their Level from this so node->queue leads back to the level.
+// `qty` is the level's resting total, kept current by push_back / erase /
+// fill so depth never walks the queue.
+struct OrderQueue {
+  OrderNode* head = nullptr;
+  OrderNode* tail = nullptr;
+  uint32_t count = 0;
+  int64_t qty = 0;
+
+  bool empty() const noexcept { return head == nullptr; }
+  OrderNode* front() const noexcept { return head; }
+
+  void push_back(OrderNode* n) noexcept {
+    n->queue = this;
+    n->next = nullptr;
+    n->prev = tail;
+    if (tail)
+      tail->next = n;
+    else
+      head = n;
+    tail = n;
+    ++count;
+    qty += n->o.qty;
+  }
+
+  // Partial (or full) fill of a queued order; the order stays linked.
+  void fill(OrderNode* n, int traded) noexcept {
+    n->o.qty -= traded;
+    qty -= traded;
+  }
+
+  // Unlinks `n` (which must belong to this queue) in O(1).
+  void erase(OrderNode* n) noexcept {
+    if (n->prev)
+      n->prev->next = n->next;
+    else
+      head = n->next;
+    if (n->next)
+      n->next->prev = n->prev;
+    else
+      tail = n->prev;
+    n->prev = n->next = nullptr;
+    n->queue = nullptr;
+    --count;
+    qty -= n->o.qty;
+  }
+
+  void pop_front() noexcept { erase(head); }
+};
+
+/**
+ * Per-book free-list of OrderNodes.
+ * - Nodes are carved from the book's memory resource in fixed-size chunks
+ * - Released nodes go on an intrusive free list and are reused LIFO, so
+ *   steady-state add/cancel churn never touches the allocator
+ * - Not thread-safe (one book = one thread)
+ */
+class OrderPool {
+ public:
+  explicit OrderPool(std::pmr::memory_resource* mr,
+                     std::size_t nodes_per_chunk = 256)
+      : mr_(mr), per_chunk_(nodes_per_chunk ? nodes_per_chunk : 1), chunks_(mr) {}
+
+  ~OrderPool() {
+    for (OrderNode* c : chunks_)
+      mr_->deallocate(c, per_chunk_ * sizeof(OrderNode), alignof(OrderNode));
+  }
+
+  OrderPool(const OrderPool&) = delete;
+  OrderPool& operator=(const OrderPool&) = delete;
+
+  OrderNode* acquire(const Order& o) {
+    if (!free_) grow();
+    OrderNode* n = free_;
+    free_ = n->next;
+    n->o = o;
+    n->prev = n->next = nullptr;
+    n->queue = nullptr;
+    ++live_;
+    return n;
+  }
+
+  void release(OrderNode* n) noexcept {
+    n->next = free_;
+    free_ = n;
+    --live_;
+  }
+
+  std::size_t live() const noexcept { return live_; }
+  std::size_t capacity() const noexcept { return chunks_.size() * per_chunk_; }
+
+ private:
+  void grow() {
+    void* raw = mr_->allocate(per_chunk_ * sizeof(OrderNode), alignof(OrderNode));
+    OrderNode* chunk = static_cast<OrderNode*>(raw);
+    chunks_.push_back(chunk);
+    // Thread the new chunk onto the free list in address order.
+    for (std::size_t i = per_chunk_; i-- > 0;) {
+      OrderNode* n = ::new (static_cast<void*>(chunk + i)) OrderNode{};
+      n->next = free_;
+      free_ = n;
+    }
+  }
+
+  std::pmr::memory_resource* mr_;
+  std::size_t per_chunk_;
+  std::pmr::vector<OrderNode*> chunks_;
+  OrderNode* free_ = nullptr;
+  std::size_t live_ = 0;
+};
+
+}  // namespace msim
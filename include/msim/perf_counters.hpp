@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace msim {
+
+// Hardware events counted by --perf, in report order.
+enum class PerfEvent : uint8_t {
+  Cycles = 0,
+  Instructions,
+  L1dMisses,     // L1 data-cache read misses
+  LlcMisses,     // last-level cache misses (the kernel's "cache-misses")
+  BranchMisses,
+  DtlbMisses,    // data-TLB read misses
+};
+inline constexpr std::size_t kPerfEvents = 6;
+
+// Short name used on the console and as the JSON key: "cycles", ...
+const char* perf_event_name(PerfEvent e) noexcept;
+
+/**
+ * Counter totals for one thread (or a merge of several).
+ * - `valid` has bit e set when event e was counted: a PMU or VM may lack
+ *   some events, and a merge keeps only what every merged thread had
+ * - Values are scaled by time enabled / time running, so they stay
+ *   comparable when the kernel multiplexes more events than counters
+ */
+struct PerfCounts {
+  std::array<uint64_t, kPerfEvents> value{};
+  uint32_t valid = 0;    // bit per PerfEvent
+  uint32_t threads = 0;  // threads merged in (1 for a single thread)
+
+  bool has(PerfEvent e) const noexcept { return valid >> unsigned(e) & 1u; }
+  uint64_t operator[](PerfEvent e) const noexcept {
+    return value[std::size_t(e)];
+  }
+  bool any() const noexcept { return valid != 0; }
+
+  // Instructions per cycle; 0 unless both were counted.
+  double ipc() const noexcept;
+  // value / events; 0 if e wasn't counted or events == 0.
+  double per_event(PerfEvent e, uint64_t events) const noexcept;
+
+  void merge(const PerfCounts& other) noexcept;
+
+  // One "Perf <label>: ipc=.. cycles/ev=.. ... (N events)" line; n/a for
+  // events that weren't counted. bench tooling parses these.
+  void print(std::ostream& os, const char* label, uint64_t events) const;
+};
+
+/**
+ * Per-thread hardware counters (--perf) for the calling thread: one
+ * perf_event_open fd per PerfEvent, user space only, opened disabled.
+ * - Construct, start() and stop() on the thread being measured; the
+ *   counters follow that thread across CPUs and count nothing else
+ * - start() / stop() are a few ioctls / reads each, so wrap whole worker
+ *   loops, not individual ops
+ * - Events the kernel refuses are skipped; if none open (no PMU access,
+ *   perf_event_paranoid, or a non-Linux build) the object is inert and
+ *   counts() stays empty
+ */
+class PerfCounters {
+ public:
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // Compiled with perf_event_open support (Linux).
+  static bool supported() noexcept;
+
+  bool available() const noexcept { return open_ != 0; }
+  // Why nothing opened, for the one-time warning; "" when available().
+  const char* error() const noexcept { return error_; }
+
+  void start() noexcept;  // resets, then enables every open counter
+  void stop() noexcept;   // disables and adds the span to counts()
+
+  const PerfCounts& counts() const noexcept { return counts_; }
+
+ private:
+  std::array<int, kPerfEvents> fd_;
+  uint32_t open_ = 0;  // bit per PerfEvent with a live fd
+  const char* error_ = "";
+  PerfCounts counts_;
+};
+
+}  // namespace msim
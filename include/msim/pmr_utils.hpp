@@ -1,7 +1,10 @@
 #pragma once
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory_resource>
+#include <utility>
+#include <vector>
 
 namespace msim {
 
@@ -33,4 +36,67 @@ class CountingResource : public std::pmr::memory_resource {
   std::atomic<size_t> allocated_{0};
 };
 
+enum class ArenaKind : uint8_t {
+  Monotonic = 0,  // std::pmr::monotonic_buffer_resource: frees are no-ops
+  Pool = 1,       // SizeClassPool: freed blocks are recycled
+};
+
+/**
+ * Size-class pool over a caller-owned buffer (the arena's NodeBuffer).
+ * - Requests round up to a power-of-two class (kMinClass..kMaxClass); a
+ *   freed block goes on its class's intrusive free list and is handed out
+ *   again LIFO, so alloc/free churn (table rehashes, books torn down and
+ *   rebuilt) settles at a fixed footprint instead of growing with run
+ *   length like a monotonic arena
+ * - New blocks are carved from the buffer, then from upstream chunks of
+ *   kChunkBytes (spill); blocks above kMaxClass (or aligned past a page)
+ *   go straight to upstream and back
+ * - Not thread-safe (one pool per thread or per book, like the arenas);
+ *   chunks go back upstream only when the pool is destroyed
+ */
+class SizeClassPool : public std::pmr::memory_resource {
+ public:
+  static constexpr size_t kMinClass = 16;
+  static constexpr size_t kMaxClass = size_t(64) << 20;
+  static constexpr size_t kChunkBytes = size_t(256) << 10;
+
+  SizeClassPool(void* buffer, size_t bytes,
+                std::pmr::memory_resource* upstream);
+  ~SizeClassPool() override;
+  SizeClassPool(const SizeClassPool&) = delete;
+  SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+  // Class-rounded bytes handed out and not yet freed, and their peak.
+  size_t live_bytes() const noexcept { return live_; }
+  size_t high_water() const noexcept { return high_; }
+
+ protected:
+  void* do_allocate(size_t bytes, size_t align) override;
+  void do_deallocate(void* p, size_t bytes, size_t align) override;
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+ private:
+  static constexpr size_t kClasses = 23;  // 16 B .. 64 MiB
+  static constexpr size_t kMaxAlign = 4096;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  // Class index for a request, or kClasses if it bypasses the pool.
+  static size_t class_of(size_t bytes, size_t align) noexcept;
+  void* carve(size_t size);
+
+  std::byte* cur_;
+  std::byte* end_;
+  FreeBlock* free_[kClasses] = {};
+  std::vector<std::pair<void*, size_t>> chunks_;  // upstream refills
+  std::pmr::memory_resource* upstream_;
+  size_t live_ = 0;
+  size_t high_ = 0;
+};
+
 }  // namespace msim
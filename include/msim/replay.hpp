@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "event.hpp"
+#include "node_buffer.hpp"
+#include "order_book.hpp"
+
+namespace msim {
+
+struct ReplayConfig {
+  std::string path;                      // LMDB store written with --log
+  std::vector<std::string> symbol_list;  // empty = every symbol in the store
+  int num_threads = 0;                   // 0 = one worker per symbol
+  BookKind book_kind = BookKind::Hash;
+  size_t arena_bytes = (1 << 20);  // per-worker arena
+  HugePages huge_pages = HugePages::Off;
+  std::vector<size_t> cpu_list;  // worker t on cpu_list[t % n]; empty = cpu t
+};
+
+// One logged event, reduced to what re-driving a book needs.
+struct ReplayOp {
+  uint64_t order_id;
+  int32_t price_tick;
+  int32_t qty;
+  EventType type;
+  Side side;
+};
+
+struct SymbolReplayStats {
+  std::string symbol;
+  uint32_t worker = 0;
+  uint64_t ops = 0;  // ADD + CANCEL applied
+  uint64_t adds = 0;
+  uint64_t cancels = 0;
+  uint64_t cancel_misses = 0;  // logged cancel of an id the book doesn't hold
+  uint64_t fills = 0;          // ADDs that matched (logged as TRADE)
+  uint64_t rejected = 0;       // ADDs whose remainder the book dropped
+  uint64_t logged_trades = 0;
+  uint64_t trade_mismatches = 0;  // logged TRADE != replayed fill
+  double elapsed_ms = 0.0;
+
+  // Final book state
+  uint64_t checksum = 0;
+  size_t resting = 0;
+  std::optional<double> best_bid;
+  std::optional<double> best_ask;
+};
+
+/**
+ * Deterministic replay of a recorded run.
+ * - load() reads each symbol's ADD/CANCEL/TRADE stream from the store into
+ *   memory (ts order), so run() measures matching, not LMDB or the generator
+ * - run() gives each worker a contiguous share of the symbols (same split as
+ *   Simulator::run_mt), pins it with bind_to_core(), builds fresh books in
+ *   a per-worker arena and applies the streams
+ * - Logged TRADEs are not applied; they are checked against the fills the
+ *   replayed book produces
+ */
+class ReplayEngine {
+ public:
+  explicit ReplayEngine(ReplayConfig cfg);
+
+  // Throws std::runtime_error if the store has no order ids (recorded
+  // before ids were logged) or a requested symbol is missing.
+  void load();
+  std::vector<SymbolReplayStats> run();
+
+  size_t loaded_ops() const noexcept;
+  double load_ms() const noexcept { return load_ms_; }
+
+  static void print_report(const std::vector<SymbolReplayStats>& stats,
+                           size_t n_workers);
+  size_t workers() const noexcept { return n_workers_; }
+
+ private:
+  struct Stream {
+    std::string symbol;
+    double tick_size = 0.01;
+    std::vector<ReplayOp> ops;
+  };
+
+  static void replay_stream(const Stream& s, IOrderBook& book,
+                            SymbolReplayStats& st);
+
+  ReplayConfig cfg_;
+  std::vector<Stream> streams_;
+  size_t n_workers_ = 0;
+  double load_ms_ = 0.0;
+};
+
+}  // namespace msim
@@ -1,6 +1,7 @@
 // rng.hpp
 #pragma once
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 struct SplitMix64 {
@@ -37,6 +38,51 @@ struct Xoroshiro128Plus {
   }
 };
 
+// Four independent xoroshiro128+ streams stepped in lock-step. fill() works
+// on local copies of the lane state so the compiler can keep all four lanes
+// in vector registers (64-bit add/xor/shift exist on SSE2, AVX2 and NEON).
+// Lane 0 is the same stream as Xoroshiro128Plus(seed).
+struct Xoroshiro128PlusX4 {
+  static constexpr size_t kLanes = 4;
+  alignas(32) uint64_t s0[kLanes];
+  alignas(32) uint64_t s1[kLanes];
+
+  explicit Xoroshiro128PlusX4(uint64_t seed = 1) {
+    SplitMix64 sm(seed);
+    for (size_t k = 0; k < kLanes; ++k) {
+      s0[k] = sm.next();
+      s1[k] = sm.next();
+    }
+  }
+
+  // Writes n outputs, interleaved by lane; n must be a multiple of kLanes.
+  void fill(uint64_t* out, size_t n) {
+    alignas(32) uint64_t a[kLanes], b[kLanes];
+    for (size_t k = 0; k < kLanes; ++k) {
+      a[k] = s0[k];
+      b[k] = s1[k];
+    }
+    for (size_t i = 0; i < n; i += kLanes) {
+      for (size_t k = 0; k < kLanes; ++k) {
+        const uint64_t x = a[k];
+        const uint64_t y = b[k] ^ x;
+        out[i + k] = x + b[k];
+        a[k] = ((x << 55) | (x >> 9)) ^ y ^ (y << 14);
+        b[k] = (y << 36) | (y >> 28);
+      }
+    }
+    for (size_t k = 0; k < kLanes; ++k) {
+      s0[k] = a[k];
+      s1[k] = b[k];
+    }
+  }
+};
+
+// 53 high bits -> [0,1); same mapping as Xoroshiro128Plus::next_uniform01.
+inline double to_uniform01(uint64_t bits) {
+  return (bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
 inline bool rand_bool(Xoroshiro128Plus& rng, double p = 0.5) {
   return rng.next_uniform01() < p;
 }
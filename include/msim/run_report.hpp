@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "latency_hist.hpp"
+#include "perf_counters.hpp"
+
+namespace msim {
+
+// One --print-arena line: upstream spill plus where the pages ended up.
+struct ArenaReport {
+  std::string label;
+  uint64_t upstream_bytes = 0;
+  std::optional<uint64_t> live_bytes;  // --arena pool only
+  std::optional<uint64_t> high_water;
+  int node = -1;       // node holding the pages; -1 unknown
+  int want_node = -1;  // node of the thread using it; -1 unknown
+  std::string pages;   // NodeBuffer::huge_name()
+};
+
+// One "Latency <op>:" line, in ns.
+struct LatencyReport {
+  std::string op;  // add | fill | cancel
+  uint64_t count = 0;
+  uint64_t p50_ns = 0;
+  uint64_t p99_ns = 0;
+  uint64_t p999_ns = 0;
+  uint64_t max_ns = 0;
+};
+
+struct ThreadReport {
+  uint32_t thread = 0;
+  std::size_t cpu = 0;
+  int node = -1;
+  std::size_t symbols = 0;  // run() / run_mt(): symbols it owns
+  uint64_t steps = 0;
+  uint64_t adds = 0;
+  uint64_t cancels = 0;
+  uint64_t trades = 0;
+  uint64_t rejected = 0;  // adds whose remainder the book dropped
+  uint64_t quanta = 0;  // run_tasks() only
+  uint64_t steals = 0;
+  double elapsed_ms = 0.0;
+  double gen_ms = 0.0;
+  PerfCounts perf;  // --perf; threads == 0 if not counted
+};
+
+struct BookReport {
+  std::string symbol;
+  std::size_t resting = 0;
+  uint64_t checksum = 0;
+  uint64_t rejected = 0;  // IOrderBook::rejected(), --resume restore included
+};
+
+/**
+ * Machine-readable results of one simulator run (--json PATH): the config
+ * that shaped it and the numbers the console report prints, so a harness
+ * can compare runs without scraping text.
+ * - Filled by Simulator next to its console output; rates use the same
+ *   time bases as the printed ones
+ * - Checksums are written as 16-digit hex strings (JSON numbers lose
+ *   64-bit precision in most readers)
+ */
+struct RunReport {
+  static constexpr int kSchema = 1;  // bump when a field changes meaning
+
+  // Config
+  std::string mode;  // run | run_mt | pinned | steal
+  std::string scenario;
+  std::string book;   // hash | ladder
+  std::string arena;  // monotonic | pool
+  uint64_t seed = 0;
+  uint64_t total_events = 0;
+  std::size_t n_symbols = 0;
+  std::size_t n_threads = 0;
+  std::size_t arena_bytes = 0;
+  std::string log_path;
+  bool latency = false;
+  bool perf = false;
+  uint64_t resumed_at = 0;  // events already done by --resume's snapshot
+
+  // Totals
+  uint64_t adds = 0;
+  uint64_t cancels = 0;
+  uint64_t trades = 0;
+  uint64_t rejected = 0;  // ladder only; the run warns when non-zero
+  uint64_t depth_records = 0;
+  uint64_t migrations = 0;  // run_tasks() only
+  double wall_ms = 0.0;
+  double elapsed_max_ms = 0.0;  // slowest thread (run(): == wall_ms)
+  double generator_ms = 0.0;    // slowest thread's generator time
+  double imbalance = 1.0;       // max / mean thread time
+  double throughput_ev_s = 0.0;
+  double steps_per_s = 0.0;
+  double book_ops_per_s = 0.0;
+  double match_ops_per_s = 0.0;  // excluding generator time
+
+  std::vector<ThreadReport> threads;
+  std::vector<LatencyReport> latency_ns;  // --latency only
+  PerfCounts perf_counts;  // --perf: merge of the threads' counters
+  std::vector<ArenaReport> arenas;
+  std::vector<BookReport> books;
+
+  // Appends one LatencyReport per op of `lat`.
+  void add_latency(const OpLatency& lat, double ns_per_tick);
+};
+
+// Pretty-printed, one JSON object.
+void write_json(std::ostream& os, const RunReport& r);
+// Throws std::runtime_error if `path` can't be written.
+void write_json_file(const std::string& path, const RunReport& r);
+
+}  // namespace msim
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace msim {
+
+enum class QtyDist : uint8_t {
+  Uniform = 0,  // qty_min..qty_max
+  Pareto = 1,   // qty_min * U^(-1/qty_alpha), capped at qty_max
+};
+
+/**
+ * Workload shape for the order generator (--scenario).
+ * - Event mix: share of cancels, and of IOC / FOK / market / post-only
+ *   among adds (limit gets what is left)
+ * - Order sizes: uniform or heavy-tailed (Pareto)
+ * - Symbol activity: Zipf skew over a worker's symbols (run() / run_mt());
+ *   run_tasks() uses it for per-symbol budgets when --zipf is unset
+ * - Bursts: every `burst_every` steps, `burst_len` one-sided adds (buy and
+ *   sell bursts alternate) of `burst_qty_mult` x the normal size, of which
+ *   a `burst_market` share are market orders that sweep levels
+ * The defaults are the historic flow (50/50 add/cancel, limit only, qty
+ * 1..100 uniform, no skew, no bursts) and draw exactly the same stream.
+ */
+struct Scenario {
+  std::string name = "default";
+
+  double cancel_ratio = 0.5;  // of steps, when the symbol has live orders
+  double ioc = 0.0;           // shares of adds
+  double fok = 0.0;
+  double market = 0.0;
+  double post_only = 0.0;
+
+  QtyDist qty_dist = QtyDist::Uniform;
+  int32_t qty_min = 1;
+  int32_t qty_max = 100;
+  double qty_alpha = 1.5;
+
+  double symbol_skew = 0.0;  // Zipf exponent; 0 = uniform
+
+  uint64_t burst_every = 0;  // 0 = no bursts
+  uint64_t burst_len = 0;
+  double burst_market = 1.0;
+  int32_t burst_qty_mult = 10;
+
+  // True when the generator can take the historic fast path.
+  bool is_default() const;
+
+  // Checks ranges; throws std::runtime_error naming the bad field.
+  void validate() const;
+
+  // Built-in shapes: default, balanced, sweep, maker, taker, skewed.
+  static std::vector<std::string> presets();
+  static Scenario preset(const std::string& name);  // throws if unknown
+
+  // `key = value` lines ('#' comments) over the fields above; an optional
+  // `preset = NAME` line starts from that preset. Throws
+  // std::runtime_error with path:line on any error.
+  static Scenario load(const std::string& path);
+
+  // A preset name, else a file path.
+  static Scenario resolve(const std::string& name_or_path);
+};
+
+}  // namespace msim
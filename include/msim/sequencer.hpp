@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "doorbell.hpp"
+#include "event.hpp"
+#include "event_batch.hpp"
+#include "spsc_ring.hpp"
+#include "storage.hpp"
+
+namespace msim {
+
+/**
+ * Cross-worker sequencer (--sequence): one globally ordered event tape.
+ * - Each producer (run_mt() worker) pushes events stamped with a logical
+ *   key into its own SpscRing; keys must not decrease within a producer
+ * - One merger thread k-way merges the rings by (key, producer) and writes
+ *   the merged stream to a single sink, keeping producer FIFO order for
+ *   equal keys
+ * - A producer's last pushed key is its watermark: every later event from
+ *   it has key >= watermark, so the merger may release an event once no
+ *   other producer can still send a smaller one
+ * - Output ts is the merge key, bumped where needed so the tape is strictly
+ *   increasing (stores key records by ts)
+ *
+ * An idle merger spins briefly, then parks on a Doorbell that push() and
+ * finish() ring.
+ *
+ * The reorder window is bounded by the rings: a producer that runs more
+ * than kRingCapacity events ahead of what the merger can release stalls
+ * until the slower producers catch up. Memory stays fixed and the order
+ * stays exact; there is no late-event dropping.
+ */
+class Sequencer {
+ public:
+  static constexpr std::size_t kRingCapacity = 16384;  // events per producer
+  static constexpr std::size_t kDrainBatch = EventBatch::kCapacity;
+
+  // Called on the merger thread with each output batch before it goes to
+  // the sink (e.g. to feed an exporter the same ordered stream).
+  using Tap = std::function<void(const EventBatch&)>;
+
+  Sequencer(std::unique_ptr<IStorage> sink, std::size_t n_producers,
+            const SymbolTable* symbols, Tap tap = {});
+  ~Sequencer();
+
+  Sequencer(const Sequencer&) = delete;
+  Sequencer& operator=(const Sequencer&) = delete;
+
+  // Producer side. Each `producer` index must be driven by a single thread.
+  // Spins (yielding) while the ring is full, so the tape stays lossless.
+  void push(std::size_t producer, uint64_t key, const CompactEvent& e) {
+    Producer& p = *producers_[producer];
+    // Watermark before the event: the merger reads it first, then the ring.
+    p.watermark.store(key, std::memory_order_release);
+    while (!p.ring.try_push(Stamped{key, e})) {
+      ++p.stalls;
+      std::this_thread::yield();
+    }
+    bell_.ring();
+  }
+
+  // The producer will push nothing more. Call it as soon as a producer is
+  // done; until then the merger holds back anything past its watermark.
+  void finish(std::size_t producer) {
+    producers_[producer]->watermark.store(kDone, std::memory_order_release);
+    bell_.ring();
+  }
+
+  // Finishes any producer that has not, waits for the merger to drain every
+  // ring, flushes and releases the sink. Call after producers have stopped.
+  void close();
+
+  std::size_t producers() const noexcept { return producers_.size(); }
+  uint64_t written() const noexcept {
+    return written_.load(std::memory_order_relaxed);
+  }
+  // Only valid after close():
+  uint64_t stalls() const noexcept;  // pushes that found their ring full
+  // Merger passes that could release nothing (waiting on a ring or a
+  // watermark).
+  uint64_t waits() const noexcept { return waits_; }
+
+ private:
+  static constexpr uint64_t kDone = std::numeric_limits<uint64_t>::max();
+
+  struct Stamped {
+    uint64_t key;
+    CompactEvent e;
+  };
+  using Ring = SpscRing<Stamped, kRingCapacity>;
+
+  struct Producer {
+    Ring ring;
+    alignas(64) std::atomic<uint64_t> watermark{0};
+    alignas(64) uint64_t stalls = 0;  // written by the producer only
+  };
+
+  // Merger-side view of one producer: popped but not yet released rows.
+  struct Cursor {
+    std::vector<Stamped> buf;
+    std::size_t r = 0, n = 0;
+    bool done = false;  // finished and drained
+  };
+
+  void merger_loop();
+  // Refills an empty cursor; returns the key bounding what `p` can still
+  // send (its head key, else its watermark), or kDone once it is drained.
+  uint64_t bound(std::size_t p, Cursor& c);
+  // Parks until a producer whose cursor is empty pushes or moves its
+  // watermark off `lim`.
+  void wait(const std::vector<Cursor>& cur, const std::vector<uint64_t>& lim);
+  void emit(const Stamped& s);
+  void flush_out();
+
+  std::unique_ptr<IStorage> sink_;
+  Tap tap_;
+  std::vector<std::unique_ptr<Producer>> producers_;
+  std::unique_ptr<EventBatch> out_;
+  uint64_t last_ts_ = 0;
+  bool any_out_ = false;
+  uint64_t waits_ = 0;
+  bool failed_ = false;  // sink threw: keep draining so producers never
+                         // spin on a full ring forever
+  Doorbell bell_;
+  std::thread thread_;
+  std::atomic<uint64_t> written_{0};
+  bool closed_ = false;
+};
+
+}  // namespace msim
@@ -1,37 +1,78 @@
 #pragma once
 #include <chrono>
 #include <memory_resource>
+#include <optional>
 #include <random>
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
-#include "box_muller.hpp"
+#include "async_storage.hpp"
+#include "checkpoint.hpp"
+#include "depth_feed.hpp"
+#include "event_batch.hpp"
+#include "export_options.hpp"
+#include "node_buffer.hpp"
 #ifdef MSIM_WITH_GRPC
-#include "msim/grpc_storage.hpp"
+#include "grpc_exporter.hpp"
 #endif
+#include "latency_hist.hpp"
+#include "live_stats.hpp"
 #include "order_book.hpp"
+#include "order_gen.hpp"
+#include "perf_counters.hpp"
 #include "pmr_utils.hpp"
 #include "rng.hpp"
+#include "run_report.hpp"
+#include "scenario.hpp"
+#include "sequencer.hpp"
 #include "storage.hpp"
+#include "symbol_table.hpp"
 
 namespace msim {
-#ifdef MSIM_WITH_GRPC
-class GrpcStorage;  // fwd declare incase MSIM_WTIH_GRPC off
-#endif
+
+enum class SchedMode : uint8_t {
+  Static = 0,  // run_mt(): contiguous symbol chunks, events split per thread
+  Pinned = 1,  // run_tasks(): per-symbol budgets, no stealing
+  Steal = 2,   // run_tasks(): idle workers steal symbol quanta
+};
 
 struct SimConfig {
   uint64_t total_events = 100000;
   uint64_t seed = 42;
   std::vector<std::string> symbol_list;  // if empty, auto-pick N=3
   size_t arena_bytes = (1 << 20);        // per-symbol arena
+  HugePages huge_pages = HugePages::Off;  // --huge-pages off|thp|hugetlb
+  ArenaKind arena_kind = ArenaKind::Monotonic;  // --arena monotonic|pool
+  std::vector<size_t> cpu_list;  // --cpus: worker t on cpu_list[t % n]
+  Scenario scenario;  // --scenario NAME|PATH: event mix, sizes, skew, bursts
   double sigma = 0.001;                  // base fractional sigma (0.1% of mid)
   double drift_ampl = 0.0;               // 0.0 = off
   uint64_t drift_period = 10000;
   std::string log_path;
+  bool async_log = false;  // per-thread SPSC rings + dedicated writer thread
+  bool sequence = false;   // --sequence: run_mt() merges its workers into one
+                           // time-ordered tape for storage / export
+  StorageOptions storage;  // backend knobs (--lmdb-durability, --lmdb-txn-mb)
   bool print_arena = false;
+  bool latency = false;  // --latency: per-op cost histograms (adds rdtsc calls)
+  bool perf = false;     // --perf: hardware counters around each worker loop
   int dump_n = 0;
   int num_threads = 1;
+  BookKind book_kind = BookKind::Hash;  // --book hash|ladder
+  SchedMode sched = SchedMode::Static;  // --sched static|pinned|steal
+  double zipf = 0.0;                    // run_tasks() activity skew; 0 = uniform
+  uint64_t steal_quantum = 4096;        // events per scheduled symbol slice
   std::string grpc_target;  // "" = disabled
+  ExportOptions grpc;       // --grpc-* (needs an MSIM_WITH_GRPC build)
+  size_t depth_levels = 0;  // --depth N: L2 deltas for the top N; 0 = off
+  uint64_t depth_snapshot_every = 10000;  // --depth-snapshot K (book ops)
+  uint64_t progress_ms = 0;  // --progress MS: live progress line; 0 = off
+  std::string checkpoint_path;    // --checkpoint PATH: snapshot at the end
+  uint64_t checkpoint_every = 0;  // --checkpoint-every N events, as well
+  std::string resume_path;        // --resume PATH: start from a snapshot
+  std::string json_path;  // --json PATH: machine-readable results (RunReport)
 
   // Benchmark / determinism:
   // false => deterministic synthetic timestamps (fast)
@@ -44,57 +85,130 @@ class Simulator {
   explicit Simulator(SimConfig cfg);
   void run();
   void run_mt();  // multithreaded / NUMA-aware version
-#ifdef MSIM_WITH_GRPC
-  void set_grpc_sink(GrpcStorage* sink) { grpc_sink_ = sink; }
-#else
-  void set_grpc_sink(void*) {}  // no-op
-#endif
+  void run_tasks();  // per-symbol tasks on work-stealing deques (--sched)
+
+  // (symbol, book checksum) in SymbolTable id order, for the books run()
+  // and run_tasks() drive; run_mt() builds its own.
+  std::vector<std::pair<std::string, uint64_t>> book_checksums() const;
+
  private:
-#ifdef MSIM_WITH_GRPC
-  GrpcStorage* grpc_sink_ = nullptr;
-#endif
-  static void bind_to_core(
-      size_t cord_id);  // Pins the calling thread to `core_id` to ensure
-                        // NUMA-local allocations.
+  static constexpr double kStartPrice = 100.0;  // every symbol's first mid
 
   SimConfig cfg_;
   std::mt19937_64 rng_;
 
+  // Build on the thread that will use it (see NodeBuffer): the buffer is
+  // first-touched, and bound to `node` if given, during construction.
   struct ArenaBundle {
-    std::vector<std::byte> buffer;
-    CountingResource counter;
-    std::pmr::monotonic_buffer_resource arena;
-    explicit ArenaBundle(size_t bytes)
-        : buffer(bytes),
-          counter(std::pmr::new_delete_resource()),
-          arena(buffer.data(), buffer.size(), &counter) {}
+    NodeBuffer buffer;
+    CountingResource counter;  // upstream: spill past `buffer`
+    std::unique_ptr<std::pmr::memory_resource> res;
+    SizeClassPool* pool = nullptr;  // == res for ArenaKind::Pool
+    ArenaBundle(size_t bytes, int node, HugePages huge, ArenaKind kind)
+        : buffer(bytes, node, huge), counter(std::pmr::new_delete_resource()) {
+      if (kind == ArenaKind::Pool) {
+        auto p = std::make_unique<SizeClassPool>(buffer.data(), buffer.size(),
+                                                 &counter);
+        pool = p.get();
+        res = std::move(p);
+      } else {
+        res = std::make_unique<std::pmr::monotonic_buffer_resource>(
+            buffer.data(), buffer.size(), &counter);
+      }
+    }
+    std::pmr::memory_resource* resource() noexcept { return res.get(); }
   };
 
   struct SymState {
     std::unique_ptr<ArenaBundle> mem;
-    std::unique_ptr<OrderBook> book;
-    double mid = 100.0;
+    std::unique_ptr<IOrderBook> book;
+    std::unique_ptr<DepthFeed> depth;  // --depth; declared after book so it
+                                       // detaches before the book goes
+    double mid_tick = 0.0;  // in ticks; kStartPrice at the start
+    uint16_t id = 0;  // SymbolTable id
   };
 
-  struct ThreadContext {
+  // One per worker, each its own allocation built on the worker after it
+  // is pinned (so first-touched on its node), and line-aligned so no two
+  // workers' hot fields share a cache line.
+  struct alignas(kCacheLine) ThreadContext {
     std::vector<std::string> symbols;               // local symbol names
+    std::vector<uint16_t> sym_ids;                  // same order as symbols
     std::unique_ptr<ArenaBundle> arena;             // per-thread arena
-    std::vector<std::unique_ptr<OrderBook>> books;  // same order as symbols
-    std::vector<double> mid;                        // same order as symbols
-    std::vector<std::vector<uint64_t>> live;        // live order ids per symbol
+    std::vector<std::unique_ptr<IOrderBook>> books;  // same order as symbols
+    std::vector<double> mid_tick;                   // in ticks, as symbols
+    // Live order ids per symbol, in `arena` (declared after it, so freed
+    // first)
+    std::vector<std::pmr::vector<uint64_t>> live;
+    std::vector<std::unique_ptr<DepthFeed>> depth;  // --depth, as books
+    std::vector<DepthUpdate> depth_out;             // publish_depth scratch
+
+    // Per-thread generator stage (no shared RNG); intents are drawn a
+    // batch ahead of matching
+    std::unique_ptr<OrderGenerator> gen;
+    std::unique_ptr<IntentBatch> intents;
+    uint64_t batch_step = 0;            // first step of *intents
+    OrderGenerator::State batch_gen{};  // gen's state before drawing it
 
-    // local RNG avoids cache contention on a shared generator
-    Xoroshiro128Plus rng;
-    NormalBM normal;  // box-muller transform
+    uint32_t thread_id = 0;
+    size_t cpu = 0;  // worker_cpu(cfg.cpu_list, thread_id)
+    int node = -1;   // NUMA node after bind_to_core(); -1 unknown
+    std::unique_ptr<EventBatch> batch;  // per-thread emit buffer
+    uint64_t seq = 0;      // next synthetic ts (see make_ts)
+    uint64_t last_ts = 0;  // last realtime ts handed out
+    uint64_t seq_key = 0;  // --sequence merge key of the current step
 
     uint64_t adds = 0;
     uint64_t cancels = 0;
     uint64_t trades = 0;
+    uint64_t rejected = 0;  // adds whose remainder the book dropped
+    uint64_t quanta = 0;  // run_tasks(): symbol slices run
+    uint64_t steals = 0;  // run_tasks(): slices taken from another deque
+    uint64_t depth_records = 0;  // DEPTH_* events emitted
+    uint64_t steps = 0;          // events run, as published to `stats`
+    LiveStats* stats = nullptr;  // --progress: this worker's line
     double elapsed_ms = 0.0;  // timing for this thread
+    double gen_ms = 0.0;      // part of elapsed_ms spent in gen->fill()
+    std::unique_ptr<OpLatency> lat;  // --latency only; this thread's alone
+    PerfCounts perf;                 // --perf: its worker loop's counters
   };
 
+  // One symbol as a run_tasks() unit of work. Owned by whichever worker
+  // popped or stole it, so only one thread touches the book at a time.
+  // Generator, intent cursor, ids and timestamps live here rather than in
+  // the worker, so a symbol's stream is the same whoever runs each slice.
+  struct SymTask {
+    SymState* st = nullptr;
+    // In st->mem, once the first slice has rebuilt that arena
+    std::optional<std::pmr::vector<uint64_t>> live;
+    std::unique_ptr<OrderGenerator> gen;    // created on first slice, so it
+    std::unique_ptr<IntentBatch> intents;   // lands on that worker's node
+    size_t r = 0;                           // next row of *intents
+
+    uint64_t budget = 0;  // events this symbol runs
+    uint64_t done = 0;
+    uint64_t ts_base = 0;  // symbol id in the high bits (see make_ts)
+    uint64_t seq = 0;
+    uint64_t last_ts = 0;
+    uint64_t next_id = 0;
+
+    uint32_t first_worker = 0;  // built its arena (see run_quantum)
+    uint32_t last_worker = UINT32_MAX;
+    uint64_t migrations = 0;  // slices run on a different worker than the last
+  };
+
+  SymbolTable symbols_;
   std::unordered_map<std::string, SymState> syms_;
   std::unique_ptr<IStorage> storage_;
+  std::unique_ptr<AsyncStorage> async_storage_;  // set while --async-log runs
+  std::unique_ptr<Sequencer> sequencer_;         // set while --sequence runs
+  std::vector<LiveStats> live_stats_;            // --progress: one per worker
+  std::unique_ptr<LiveMonitor> monitor_;         // set while --progress runs
+  std::unique_ptr<CheckpointReader> resume_;     // --resume
+  std::unique_ptr<CheckpointGate> ckpt_gate_;    // run_mt() --checkpoint
+#ifdef MSIM_WITH_GRPC
+  std::unique_ptr<GrpcExporter> grpc_export_;  // set while --grpc runs
+#endif
 
   // std::uniform_int_distribution<int> qty_dist_{1, 100};
   // std::bernoulli_distribution side_dist_{0.5};
@@ -103,12 +217,116 @@ class Simulator {
   uint64_t next_order_id_ = 1;
 
   uint64_t now_ns() const;
-  uint64_t make_ts(uint64_t i_event, uint32_t thread_id) const;
+  uint64_t make_ts(ThreadContext& ctx) const;
+  uint64_t make_ts(uint64_t base, uint64_t& seq, uint64_t& last_ts) const;
+
+  std::unique_ptr<OrderGenerator> make_generator(uint64_t seed,
+                                                 size_t n_symbols) const;
+  // Refills ctx.intents with steps [first_step, first_step + kCapacity),
+  // noting where it starts for save_worker(); returns the count. Batches
+  // are always whole, even past the end of the run, so a stream is cut
+  // into the same batches however many runs it is split over.
+  size_t next_intents(ThreadContext& ctx, uint64_t first_step);
+  size_t next_intents(ThreadContext& ctx, OrderGenerator& gen, IntentBatch& b,
+                      uint64_t first_step);
+  // Runs the next `n` events of `task` on the calling worker.
+  void run_quantum(ThreadContext& ctx, SymTask& task, uint64_t n);
+  // Appends to the thread's EventBatch (or its async ring); no allocation.
+  void emit(ThreadContext& ctx, const CompactEvent& e);
+  void flush_events(ThreadContext& ctx);
+  // --depth: folds the book op just made into `feed` and emits its deltas
+  // (and a snapshot when due), one ts() per record.
+  template <typename TsFn>
+  void publish_depth(ThreadContext& ctx, DepthFeed& feed, uint16_t sym,
+                     TsFn&& ts);
+
+  // One symbol as step() sees it; run(), run_mt() and run_tasks() each
+  // keep these in their own containers.
+  struct StepSym {
+    IOrderBook& book;
+    double& mid_tick;                  // in ticks
+    std::pmr::vector<uint64_t>& live;  // resting ids (may hold stale ones)
+    DepthFeed* depth;                  // --depth, else null
+    uint16_t id;                       // SymbolTable id
+  };
+  // Runs row `r` of `in` on `sym`: an add (or, with live ids, maybe a
+  // cancel of a random one), its events, the mid update and any depth
+  // records, counted in ctx. next_id() hands out the add's order id and
+  // ts() every timestamp: the loops' only differences. sym.book must be a
+  // Book (see with_book_type), which step() calls directly.
+  template <class Book, typename IdFn, typename TsFn>
+  void step(ThreadContext& ctx, const IntentBatch& in, size_t r,
+            const StepSym& sym, IdFn&& next_id, TsFn&& ts);
+
+  // Worker-side half of --progress: copies ctx's counters to its line.
+  static void publish_stats(ThreadContext& ctx) {
+    if (ctx.stats)
+      ctx.stats->publish({ctx.steps, ctx.adds, ctx.cancels, ctx.trades});
+  }
+  // --progress: one LiveStats line per worker plus the monitor thread.
+  void start_monitor(size_t n_workers);
+  void stop_monitor();
+
+  // --checkpoint-every as steps per worker: the event count split over
+  // `n_workers` (at least one). 0 = no periodic snapshots.
+  uint64_t checkpoint_steps(size_t n_workers) const;
+  // Worker-level state of a snapshot before `step` runs; the caller adds
+  // its symbols. Mid-batch, the generator state is the batch's start.
+  static CheckpointWorker save_worker(const ThreadContext& ctx, uint64_t step,
+                                      uint64_t next_id);
+  // Inverse of save_worker() for ctx's ts state and generator; mid-batch
+  // it draws that batch again. Returns the row of ctx.intents to run at
+  // w.step (0 with nothing drawn: the loop refills first).
+  size_t restore_worker(const ckpt::WorkerRec& w, ThreadContext& ctx);
+  // --resume: throws unless the snapshot has these workers with these
+  // symbols, in order.
+  void check_resume(const std::vector<std::vector<std::string>>& want) const;
+  // Writes cfg_.checkpoint_path; failures are reported, not thrown, so a
+  // long run isn't lost to a full disk.
+  void save_checkpoint(const std::vector<CheckpointWorker>& parts) const;
 
-  double draw_price(double mid, uint64_t i_event, ThreadContext& ctx);
-  void emit_event(const Event& e);
+  // Moves storage_ behind an AsyncStorage with one ring per worker thread.
+  void start_async_storage(size_t n_producers);
+  void stop_async_storage();
+  // --sequence: moves storage_ behind a Sequencer with one ring per worker;
+  // the merger also feeds the gRPC exporter (as its only producer).
+  void start_sequencer(size_t n_producers);
+  void stop_sequencer();
+  // Same shape for --grpc: one exporter ring per worker thread. No-ops in
+  // builds without MSIM_WITH_GRPC.
+  void start_grpc_export(size_t n_producers);
+  void stop_grpc_export();
 
   static std::vector<std::string> default_symbols();
+  static void print_checksum(const IOrderBook& book);
+  // Upstream spill of `a` plus where its pages live relative to
+  // `want_node` (the node of the thread that uses it).
+  static ArenaReport arena_report(const std::string& label,
+                                  const ArenaBundle& a, int want_node);
+  // --print-arena line for `a`.
+  static void print_arena(const ArenaReport& a);
+  static ThreadReport thread_report(const ThreadContext& c);
+  using Contexts = std::vector<std::unique_ptr<ThreadContext>>;
+  // Merges the workers' --latency histograms, prints them and adds them
+  // to `rep`.
+  static void print_latency(const Contexts& contexts,
+                            const LatencyClock::Calibration& cal,
+                            RunReport& rep);
+  // --perf: counters for the calling worker, or null (warning once per
+  // process) when none can be opened.
+  static std::unique_ptr<PerfCounters> open_perf();
+  // "Perf" lines for every worker that counted, then their merge, which
+  // goes into `rep`.
+  static void print_perf(const Contexts& contexts, RunReport& rep);
+  // Totals block shared by run_mt() and run_tasks(); fills rep's totals.
+  void print_mt_totals(const Contexts& contexts, double wall_ms,
+                       RunReport& rep) const;
+  // The config half of a run's report.
+  RunReport make_report(const char* mode, size_t n_threads) const;
+  // --json: adds the final books to `rep` and writes it. Throws
+  // std::runtime_error if the file can't be written.
+  void write_report(RunReport& rep,
+                    const std::vector<const IOrderBook*>& books) const;
 };
 
 }  // namespace msim
@@ -52,6 +52,25 @@ class SpscRing {
     return true;
   }
 
+  // Pops up to `max_n` elements into out[0..n) with a single acquire of head
+  // and a single release of tail. Returns the number of elements popped.
+  std::size_t try_pop_bulk(T* out, std::size_t max_n) noexcept(
+      std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>) {
+    const std::size_t tail = tail_.v.load(std::memory_order_relaxed);
+    const std::size_t head = head_.v.load(std::memory_order_acquire);
+    std::size_t n = head - tail;
+    if (n > max_n) n = max_n;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      T* ptr = ptr_at(tail + i);
+      out[i] = std::move(*ptr);
+      ptr->~T();
+    }
+
+    if (n) tail_.v.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
   bool empty() const noexcept {
     const std::size_t tail = tail_.v.load(std::memory_order_acquire);
     const std::size_t head = head_.v.load(std::memory_order_acquire);
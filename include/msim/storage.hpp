@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <memory>
 #include <mutex>
@@ -7,17 +9,49 @@
 #include <vector>
 
 #include "event.hpp"
+#include "event_batch.hpp"
 
 namespace msim {
 
+// How hard LMDB commits push data to disk (--lmdb-durability).
+enum class LmdbDurability : uint8_t {
+  Sync = 0,      // fsync on every commit (LMDB default)
+  NoSync = 1,    // MDB_NOSYNC: commits skip fsync, flush() syncs; an OS
+                 // crash can lose the last txns but not corrupt the store
+  WriteMap = 2,  // + MDB_WRITEMAP: write through the map (no copy); an OS
+                 // crash can corrupt the store. Fastest; scratch runs only
+};
+
+// Backend knobs forwarded by make_storage(). Unused by backends they don't
+// apply to.
+struct StorageOptions {
+  LmdbDurability lmdb_durability = LmdbDurability::Sync;
+  size_t lmdb_txn_bytes = size_t(8) << 20;  // commit every ~8 MiB of records
+  size_t lmdb_map_bytes = size_t(1) << 30;  // per env (per shard)
+  // > 1: one LMDB env per producer (ShardedLMDBStorage). Set by the
+  // simulator to its run_mt() worker count; not a user knob.
+  size_t lmdb_shards = 1;
+};
+
 struct IStorage {
   virtual ~IStorage() = default;
   virtual void write(const Event& e) = 0;
+  // Columnar batch path used by the simulator. The default materializes
+  // rows one at a time; backends override it to serialize straight from the
+  // columns and amortize locking / syscalls across the batch.
+  virtual void write_batch(const EventBatch& b) {
+    for (size_t i = 0; i < b.size(); ++i) write(b.to_event(i));
+  }
   virtual void flush() = 0;
+  // Called on a producer's thread once it has written its last batch
+  // (EventBatch::source == source). Thread-affine backends commit that
+  // producer's pending work here; flush() may run on another thread.
+  virtual void flush_source(uint32_t /*source*/) {}
 };
 
 struct NullStorage : IStorage {
   void write(const Event&) override {}
+  void write_batch(const EventBatch&) override {}
   void flush() override {}
 };
 
@@ -27,15 +61,23 @@ class BinaryLogStorage : public IStorage {
   ~BinaryLogStorage();
 
   void write(const Event& e) override;
+  void write_batch(const EventBatch& b) override;
   void flush() override;
 
  private:
   std::FILE* fp_{nullptr};
   std::mutex mtx_;
-  std::vector<char> buf_;
-  size_t batch_bytes_;
+  std::vector<uint8_t> buf_;  // reused record staging buffer (under mtx_)
 };
 
-std::unique_ptr<IStorage> make_storage(const std::string& path);
+std::unique_ptr<IStorage> make_storage(const std::string& path,
+                                       const StorageOptions& opts = {});
+
+// Consumer-thread teardown for a sink: flushes it (unless `flush` is false,
+// e.g. after a write error) and destroys it on the calling thread, which
+// must be the one that wrote to it (LMDB txns are thread-affine). A flush
+// error is reported on stderr prefixed with `who`.
+void release_sink(std::unique_ptr<IStorage>& sink, bool flush,
+                  const std::string& who);
 
 }  // namespace msim
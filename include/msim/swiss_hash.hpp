@@ -0,0 +1,386 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MSIM_SWISS_SSE2 1
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MSIM_SWISS_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace msim {
+
+namespace detail {
+
+// Read hint for a line needed a few operations from now; never faults.
+inline void prefetch(const void* p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p);
+#elif defined(_M_X64) || defined(_M_IX86)
+  _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+  (void)p;
+#endif
+}
+
+}  // namespace detail
+
+// Swiss-table style open-addressing map for integral keys.
+// - One control byte per slot, kept apart from the slots: kEmpty, kDeleted
+//   or the low 7 hash bits (H2) of the key stored there. Slots are plain
+//   {key, value} pairs with no state byte, so {uint64_t, T*} is 16 bytes
+// - Lookups compare a whole 16-slot group of control bytes at once
+//   (SSE2 / NEON, scalar fallback) and only touch slots whose H2 matches;
+//   groups are probed in triangular order, which visits all of them
+// - erase() only leaves a tombstone when the slot's group is full; a group
+//   with an empty byte already ends every probe that reaches it
+// - Grows by doubling; the new table comes from the same memory_resource
+//   and nothing else is kept around (no scratch table). With
+//   allow_grow=false it rehashes away tombstones and aborts when full,
+//   like FlatHashMap
+template <typename K, typename V>
+class SwissHashMap {
+  static_assert(std::is_integral_v<K>, "SwissHashMap requires integral keys");
+
+ public:
+  static constexpr std::size_t kGroupWidth = 16;
+
+  SwissHashMap(std::pmr::memory_resource* mr, std::size_t capacity_pow2,
+               bool allow_grow = false)
+      : allow_grow_(allow_grow), ctrl_(mr), slots_(mr) {
+    init(round_capacity(capacity_pow2));
+  }
+
+  std::size_t size() const noexcept { return size_; }
+  std::size_t tombs() const noexcept { return tombs_; }
+  std::size_t capacity() const noexcept { return slots_.size(); }
+
+  V* find_ptr(K key) noexcept {
+    const std::size_t idx = find_index(key);
+    return idx == npos ? nullptr : &slots_[idx].value;
+  }
+  const V* find_ptr(K key) const noexcept {
+    const std::size_t idx = find_index(key);
+    return idx == npos ? nullptr : &slots_[idx].value;
+  }
+
+  bool contains(K key) const noexcept { return find_index(key) != npos; }
+
+  // Starts loading `key`'s first probe group (its control bytes and first
+  // slots), so a find / insert / erase of it shortly after mostly hits L1.
+  void prefetch(K key) const noexcept {
+    const std::size_t base =
+        (h1(hash_key(key)) & group_mask_) * kGroupWidth;
+    detail::prefetch(&ctrl_[base]);
+    detail::prefetch(&slots_[base]);
+  }
+
+  bool insert(K key, const V& value) {
+    bool inserted = false;
+    emplace_impl(key, value, inserted);
+    return inserted;
+  }
+  bool insert(K key, V&& value) {
+    bool inserted = false;
+    emplace_impl(key, std::move(value), inserted);
+    return inserted;
+  }
+
+  V* find_or_insert(K key, const V& value) {
+    bool inserted = false;
+    return &slots_[emplace_impl(key, value, inserted)].value;
+  }
+  V* find_or_insert(K key, V&& value) {
+    bool inserted = false;
+    return &slots_[emplace_impl(key, std::move(value), inserted)].value;
+  }
+
+  bool erase(K key) noexcept {
+    const std::size_t idx = find_index(key);
+    if (idx == npos) return false;
+    const std::size_t g = idx & ~(kGroupWidth - 1);
+    if (Group(&ctrl_[g]).match_empty()) {
+      ctrl_[idx] = kEmpty;
+      ++growth_left_;
+    } else {
+      ctrl_[idx] = kDeleted;
+      ++tombs_;
+    }
+    --size_;
+    return true;
+  }
+
+  // Visits every live entry in slot order (not insertion order).
+  template <typename Fn>
+  void for_each(Fn&& fn) const {
+    for (std::size_t i = 0; i < slots_.size(); ++i)
+      if (ctrl_[i] >= 0) fn(slots_[i].key, slots_[i].value);
+  }
+
+ private:
+  static constexpr int8_t kEmpty = -128;   // 0b1000'0000
+  static constexpr int8_t kDeleted = -2;   // 0b1111'1110
+  static constexpr std::size_t npos = ~std::size_t(0);
+
+  struct Slot {
+    K key{};
+    V value{};
+  };
+
+  // Set bits of `bits` mark matching slots; each slot owns kShift bits.
+  struct BitMask {
+#if MSIM_SWISS_NEON
+    static constexpr int kShift = 2;  // 4 bits per slot (vshrn narrowing)
+#else
+    static constexpr int kShift = 0;
+#endif
+    uint64_t bits;
+
+    explicit operator bool() const noexcept { return bits != 0; }
+    std::size_t lowest() const noexcept { return ctz(bits) >> kShift; }
+    void clear_lowest() noexcept { bits &= bits - 1; }
+  };
+
+  // The 16 control bytes of one group.
+  struct Group {
+#if MSIM_SWISS_SSE2
+    __m128i ctrl;
+    explicit Group(const int8_t* p) noexcept
+        : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+    BitMask match(int8_t h2) const noexcept {
+      return {uint64_t(uint32_t(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)))))};
+    }
+    BitMask match_empty() const noexcept { return match(kEmpty); }
+    // Empty and deleted are the only negative control bytes.
+    BitMask match_free() const noexcept {
+      return {uint64_t(uint32_t(_mm_movemask_epi8(ctrl)))};
+    }
+#elif MSIM_SWISS_NEON
+    int8x16_t ctrl;
+    explicit Group(const int8_t* p) noexcept : ctrl(vld1q_s8(p)) {}
+    static BitMask to_mask(uint8x16_t eq) noexcept {
+      const uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+      return {vget_lane_u64(vreinterpret_u64_u8(n), 0) &
+              0x8888888888888888ULL};
+    }
+    BitMask match(int8_t h2) const noexcept {
+      return to_mask(vceqq_s8(ctrl, vdupq_n_s8(h2)));
+    }
+    BitMask match_empty() const noexcept { return match(kEmpty); }
+    BitMask match_free() const noexcept {
+      return to_mask(vcltq_s8(ctrl, vdupq_n_s8(0)));
+    }
+#else
+    int8_t ctrl[kGroupWidth];
+    explicit Group(const int8_t* p) noexcept {
+      std::memcpy(ctrl, p, kGroupWidth);
+    }
+    BitMask match(int8_t h2) const noexcept {
+      uint64_t m = 0;
+      for (std::size_t i = 0; i < kGroupWidth; ++i)
+        m |= uint64_t(ctrl[i] == h2) << i;
+      return {m};
+    }
+    BitMask match_empty() const noexcept { return match(kEmpty); }
+    BitMask match_free() const noexcept {
+      uint64_t m = 0;
+      for (std::size_t i = 0; i < kGroupWidth; ++i)
+        m |= uint64_t(ctrl[i] < 0) << i;
+      return {m};
+    }
+#endif
+  };
+
+  bool allow_grow_;
+  std::size_t group_mask_ = 0;  // n_groups - 1
+  std::size_t size_ = 0;
+  std::size_t tombs_ = 0;
+  std::size_t growth_left_ = 0;  // inserts into empty slots before rehash
+  std::pmr::vector<int8_t> ctrl_;
+  std::pmr::vector<Slot> slots_;
+
+  static int ctz(uint64_t x) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return int(i);
+#else
+    return __builtin_ctzll(x);
+#endif
+  }
+
+  static std::size_t round_capacity(std::size_t x) {
+    std::size_t cap = kGroupWidth;
+    while (cap < x) cap <<= 1;
+    return cap;
+  }
+
+  // 7/8 max load, counting tombstones (they lengthen probes like entries).
+  static std::size_t max_load(std::size_t cap) noexcept {
+    return cap - cap / 8;
+  }
+
+  // Same mixers as FlatHashMap.
+  static std::size_t hash_key(K key) noexcept {
+    if constexpr (sizeof(K) == 8) {
+      uint64_t x = static_cast<uint64_t>(key);
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdULL;
+      x ^= x >> 33;
+      x *= 0xc4ceb9fe1a85ec53ULL;
+      x ^= x >> 33;
+      return static_cast<std::size_t>(x);
+    } else {
+      uint32_t x = static_cast<uint32_t>(key);
+      x ^= x >> 16;
+      x *= 0x7feb352dU;
+      x ^= x >> 15;
+      x *= 0x846ca68bU;
+      x ^= x >> 16;
+      return static_cast<std::size_t>(x);
+    }
+  }
+  // H1 picks the first group, H2 is what the control byte stores.
+  static std::size_t h1(std::size_t h) noexcept { return h >> 7; }
+  static int8_t h2(std::size_t h) noexcept { return int8_t(h & 0x7f); }
+
+  void init(std::size_t cap) {
+    ctrl_.assign(cap, kEmpty);
+    slots_.assign(cap, Slot{});
+    group_mask_ = cap / kGroupWidth - 1;
+    size_ = 0;
+    tombs_ = 0;
+    growth_left_ = max_load(cap);
+  }
+
+  std::size_t find_index(K key) const noexcept {
+    const std::size_t h = hash_key(key);
+    const int8_t tag = h2(h);
+    std::size_t g = h1(h) & group_mask_;
+    for (std::size_t step = 1;; ++step) {
+      const std::size_t base = g * kGroupWidth;
+      const Group grp(&ctrl_[base]);
+      for (BitMask m = grp.match(tag); m; m.clear_lowest()) {
+        const std::size_t i = base + m.lowest();
+        if (slots_[i].key == key) return i;
+      }
+      if (grp.match_empty()) return npos;
+      g = (g + step) & group_mask_;  // triangular: covers every group
+    }
+  }
+
+  // First empty or deleted slot on `key`'s probe sequence.
+  std::size_t find_free(std::size_t h) const noexcept {
+    std::size_t g = h1(h) & group_mask_;
+    for (std::size_t step = 1;; ++step) {
+      const std::size_t base = g * kGroupWidth;
+      const BitMask m = Group(&ctrl_[base]).match_free();
+      if (m) return base + m.lowest();
+      g = (g + step) & group_mask_;
+    }
+  }
+
+  static void die_capacity(std::size_t size, std::size_t tombs,
+                           std::size_t cap) {
+    std::fprintf(stderr,
+                 "SwissHashMap capacity exceeded (fixed-size).\n"
+                 "  size=%zu tombs=%zu cap=%zu (threshold=87.5%%)\n"
+                 "  Suggestion: increase capacity_pow2 or enable growth.\n",
+                 size, tombs, cap);
+    std::fflush(stderr);
+    std::abort();
+  }
+
+  // Out of empty slots: drop tombstones, doubling if growth is allowed and
+  // the live entries alone would still fill over half the table.
+  // Deterministic: depends only on counts.
+  void rehash_for_insert() {
+    const std::size_t cap = capacity();
+    if (allow_grow_ && size_ * 2 >= max_load(cap)) {
+      rehash(cap * 2);
+      return;
+    }
+    if (tombs_ == 0) die_capacity(size_, tombs_, cap);
+    rehash(cap);
+  }
+
+  void rehash(std::size_t new_cap) {
+    std::pmr::vector<int8_t> prev_ctrl(ctrl_.get_allocator());
+    std::pmr::vector<Slot> prev_slots(slots_.get_allocator());
+    prev_ctrl.swap(ctrl_);
+    prev_slots.swap(slots_);
+    ctrl_.assign(new_cap, kEmpty);
+    slots_.assign(new_cap, Slot{});
+    group_mask_ = new_cap / kGroupWidth - 1;
+
+    const std::size_t live = size_;
+    for (std::size_t i = 0; i < prev_slots.size(); ++i) {
+      if (prev_ctrl[i] < 0) continue;
+      const std::size_t h = hash_key(prev_slots[i].key);
+      const std::size_t dst = find_free(h);
+      ctrl_[dst] = h2(h);
+      slots_[dst] = std::move(prev_slots[i]);
+    }
+    tombs_ = 0;
+    growth_left_ = max_load(new_cap) - live;
+  }
+
+  // One probe: returns the key's slot, or inserts at the first free slot
+  // the probe passed (the slot find_free() would pick).
+  template <typename VV>
+  std::size_t emplace_impl(K key, VV&& value, bool& inserted) {
+    const std::size_t h = hash_key(key);
+    const int8_t tag = h2(h);
+    std::size_t idx = npos;
+    std::size_t g = h1(h) & group_mask_;
+    for (std::size_t step = 1;; ++step) {
+      const std::size_t base = g * kGroupWidth;
+      const Group grp(&ctrl_[base]);
+      for (BitMask m = grp.match(tag); m; m.clear_lowest()) {
+        const std::size_t i = base + m.lowest();
+        if (slots_[i].key == key) return i;
+      }
+      if (idx == npos) {
+        const BitMask f = grp.match_free();
+        if (f) idx = base + f.lowest();
+      }
+      if (grp.match_empty()) break;
+      g = (g + step) & group_mask_;
+    }
+
+    // Reusing a tombstone doesn't consume an empty slot.
+    if (ctrl_[idx] == kEmpty) {
+      if (growth_left_ == 0) {
+        rehash_for_insert();
+        idx = find_free(h);
+      }
+      if (ctrl_[idx] == kEmpty) --growth_left_;
+    }
+    if (ctrl_[idx] == kDeleted) --tombs_;
+
+    ctrl_[idx] = tag;
+    slots_[idx].key = key;
+    slots_[idx].value = std::forward<VV>(value);
+    ++size_;
+    inserted = true;
+    return idx;
+  }
+};
+
+}  // namespace msim
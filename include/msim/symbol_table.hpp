@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "msim/event.hpp"
+
+namespace msim {
+
+// Dense symbol id <-> name mapping, built once before a run. Hot paths carry
+// the uint16_t id; names (and tick sizes) are only looked up at the edges
+// (storage keys, export, display).
+class SymbolTable {
+ public:
+  static constexpr std::size_t kMaxSymbols =
+      std::numeric_limits<uint16_t>::max();
+
+  // Returns the existing id for `name`, or assigns the next one.
+  uint16_t intern(const std::string& name, double tick_size = 0.01) {
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+    if (names_.size() >= kMaxSymbols)
+      throw std::length_error("SymbolTable: too many symbols");
+
+    const uint16_t id = static_cast<uint16_t>(names_.size());
+    names_.push_back(name);
+    tick_size_.push_back(tick_size);
+    inv_tick_.push_back(1.0 / tick_size);
+    ids_.emplace(name, id);
+    return id;
+  }
+
+  std::optional<uint16_t> find(const std::string& name) const {
+    auto it = ids_.find(name);
+    if (it == ids_.end()) return std::nullopt;
+    return it->second;
+  }
+
+  const std::string& name(uint16_t id) const { return names_[id]; }
+  double tick_size(uint16_t id) const { return tick_size_[id]; }
+  std::size_t size() const noexcept { return names_.size(); }
+
+  double to_price(uint16_t id, int32_t tick) const {
+    return double(tick) * tick_size_[id];
+  }
+  int32_t to_tick(uint16_t id, double price) const {
+    return round_tick(price * inv_tick_[id]);
+  }
+
+ private:
+  std::vector<std::string> names_;
+  std::vector<double> tick_size_;
+  std::vector<double> inv_tick_;
+  std::unordered_map<std::string, uint16_t> ids_;
+};
+
+}  // namespace msim
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace msim {
+
+// Pins the calling thread to `core_id` so its caches (and first-touch NUMA
+// allocations such as its PMR arena) stay local. Best-effort: warns on
+// failure and carries on. Returns the NUMA node it now runs on (-1 unknown).
+int bind_to_core(size_t core_id);
+
+// NUMA node of the CPU the calling thread is running on; -1 if unknown.
+int current_numa_node();
+
+// Parses a CPU list such as "0-7,16-23" (--cpus). Throws
+// std::runtime_error on malformed input.
+std::vector<size_t> parse_cpu_list(const std::string& spec);
+
+// CPU for worker `worker`: cpus[worker % cpus.size()], or `worker` itself
+// when no list is given.
+size_t worker_cpu(const std::vector<size_t>& cpus, size_t worker);
+
+// Worker count used by the multi-threaded drivers: `requested` if > 0, else
+// one per item capped at hardware_concurrency; never more than `n_items`.
+size_t worker_count(int requested, size_t n_items);
+
+// Splits [0, n_items) into `n_workers` contiguous [begin, end) chunks of
+// ceil(n_items / n_workers); trailing chunks may be empty.
+std::vector<std::pair<size_t, size_t>> partition_range(size_t n_items,
+                                                       size_t n_workers);
+
+}  // namespace msim
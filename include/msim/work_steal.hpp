@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace msim {
+
+/**
+ * One deque of task ids per worker.
+ * - The owner pushes and pops at the back (LIFO: it keeps running the task
+ *   whose book is hot in its cache)
+ * - Thieves take from the front of a victim's deque (the task the owner
+ *   touched least recently), scanning victims from thief + 1 round-robin
+ * - A task popped or stolen belongs to that thread until it is pushed
+ *   again, so no task is ever run by two threads at once
+ *
+ * Tasks are scheduling quanta of thousands of events, so a mutex per deque
+ * costs nothing measurable; each deque sits on its own cache line.
+ */
+class WorkQueues {
+ public:
+  explicit WorkQueues(size_t n_workers);
+
+  size_t workers() const noexcept { return queues_.size(); }
+
+  void push(size_t worker, uint32_t task);
+  bool pop(size_t worker, uint32_t& task);
+  bool steal(size_t thief, uint32_t& task);
+
+ private:
+  struct alignas(64) Queue {
+    std::mutex mtx;
+    std::deque<uint32_t> tasks;
+  };
+  std::vector<std::unique_ptr<Queue>> queues_;
+};
+
+}  // namespace msim
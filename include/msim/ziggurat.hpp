@@ -0,0 +1,113 @@
+// ziggurat.hpp
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "rng.hpp"
+
+namespace msim {
+
+/**
+ * Marsaglia-Tsang ziggurat for N(0,1), 128 layers, driven by 32-bit draws.
+ * - fast path: one table lookup, compare and multiply per draw (~98.8% of
+ *   draws); no log/sqrt and no rejection loop, unlike NormalBM
+ * - the rare slow path (wedges, tail) is out of line and pulls extra
+ *   uniforms from its own scalar stream, in row order, so a batch depends
+ *   only on its input bits and that stream (deterministic)
+ */
+class ZigguratNormal {
+ public:
+  explicit ZigguratNormal(uint64_t seed)
+      : tail_(seed ^ 0x5A166A7E00000001ull) {
+    static const Tables t = make_tables();
+    t_ = &t;
+  }
+
+  // out[i] = N(0,1) for i < n, two draws per 64-bit word of `bits`
+  // (bits needs (n + 1) / 2 words).
+  void fill(double* out, const uint64_t* bits, size_t n) {
+    const Tables& t = *t_;
+    for (size_t i = 0; i < n; ++i) {
+      const int32_t hz = draw(bits, i);
+      // ~98.8% taken, so the branch predicts well; slow() is out of line.
+      out[i] = in_rect(t, hz) ? hz * t.wn[hz & 127] : slow(hz);
+    }
+  }
+
+  // Slow-path stream, for checkpoints (the tables are fixed).
+  const Xoroshiro128Plus& tail_state() const noexcept { return tail_; }
+  void set_tail_state(const Xoroshiro128Plus& s) noexcept { tail_ = s; }
+
+ private:
+  struct Tables {
+    uint32_t kn[128];
+    double wn[128];
+    double fn[128];
+  };
+
+  static constexpr double kR = 3.442619855899;
+
+  static Tables make_tables() {
+    Tables t{};
+    const double m1 = 2147483648.0;
+    const double vn = 9.91256303526217e-3;
+    double dn = kR, tn = dn;
+    const double q = vn / std::exp(-0.5 * dn * dn);
+    t.kn[0] = uint32_t((dn / q) * m1);
+    t.kn[1] = 0;
+    t.wn[0] = q / m1;
+    t.wn[127] = dn / m1;
+    t.fn[0] = 1.0;
+    t.fn[127] = std::exp(-0.5 * dn * dn);
+    for (int i = 126; i >= 1; --i) {
+      dn = std::sqrt(-2.0 * std::log(vn / dn + std::exp(-0.5 * dn * dn)));
+      t.kn[i + 1] = uint32_t((dn / tn) * m1);
+      tn = dn;
+      t.fn[i] = std::exp(-0.5 * dn * dn);
+      t.wn[i] = dn / m1;
+    }
+    return t;
+  }
+
+  static int32_t draw(const uint64_t* bits, size_t i) {
+    return int32_t(uint32_t(bits[i >> 1] >> ((i & 1) * 32)));
+  }
+  static bool in_rect(const Tables& t, int32_t hz) {
+    return uint32_t(std::abs(int64_t(hz))) < t.kn[hz & 127];
+  }
+
+  int32_t next_hz() { return int32_t(uint32_t(tail_.next_u64() >> 32)); }
+
+#if defined(_MSC_VER)
+  __declspec(noinline)
+#elif defined(__GNUC__)
+  __attribute__((noinline))
+#endif
+  double slow(int32_t hz) {
+    const Tables& t = *t_;
+    for (;;) {
+      const uint32_t iz = uint32_t(hz) & 127;
+      if (in_rect(t, hz)) return hz * t.wn[iz];
+      const double x = hz * t.wn[iz];
+      if (iz == 0) {  // base strip: sample the tail beyond kR
+        double xt, y;
+        do {
+          xt = -std::log(1.0 - tail_.next_uniform01()) / kR;
+          y = -std::log(1.0 - tail_.next_uniform01());
+        } while (y + y < xt * xt);
+        return hz > 0 ? kR + xt : -kR - xt;
+      }
+      if (t.fn[iz] + tail_.next_uniform01() * (t.fn[iz - 1] - t.fn[iz]) <
+          std::exp(-0.5 * x * x))
+        return x;
+      hz = next_hz();
+    }
+  }
+
+  const Tables* t_;
+  Xoroshiro128Plus tail_;
+};
+
+}  // namespace msim
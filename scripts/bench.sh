@@ -5,9 +5,9 @@ ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
 
 # ---------------- Build knobs ----------------
 WITH_GRPC="${WITH_GRPC:-OFF}"              # ON/OFF (controls CMake option MSIM_WITH_GRPC)
-CONFIG="${CONFIG:-Release}"                # VS config
-GENERATOR="${GENERATOR:-Visual Studio 17 2022}"
-PLATFORM="${PLATFORM:-x64}"
+CONFIG="${CONFIG:-Release}"                # build type / multi-config config
+GENERATOR="${GENERATOR:-}"                 # empty = CMake's default for the host
+PLATFORM="${PLATFORM:-}"                   # -A, e.g. x64 (Visual Studio only)
 JOBS="${JOBS:-16}"
 BUILD_TESTS="${BUILD_TESTS:-OFF}"
 
@@ -19,7 +19,7 @@ BUILD_DIR="${BUILD_DIR}"
 
 # ---------------- Bench knobs ----------------
 MODE="${MODE:-no_log}"                     # no_log | binlog | lmdb | grpc | binlog_grpc | lmdb_grpc
-SCENARIO="${SCENARIO:-}"
+SCENARIO="${SCENARIO:-}"                   # --scenario preset or file; empty = default flow
 SYMBOLS="${SYMBOLS:-AAPL,MSFT,GOOG,AMZN,NVDA,TSLA}"
 EVENTS="${EVENTS:-2000000}"
 THREADS="${THREADS:-6}"
@@ -27,7 +27,10 @@ SIGMA="${SIGMA:-0.001}"
 ARENA_BYTES="${ARENA_BYTES:-1048576}"
 REPS="${REPS:-5}"
 WARMUP_EVENTS="${WARMUP_EVENTS:-200000}"
+WARM_START="${WARM_START:-0}"              # 1 = reps --resume from the warmup's --checkpoint (deep books)
 GRPC_TARGET="${GRPC_TARGET:-127.0.0.1:50051}"
+LMDB_DURABILITY="${LMDB_DURABILITY:-sync}" # sync | nosync | writemap (lmdb modes)
+LATENCY="${LATENCY:-0}"                    # 1 = --latency (per-op p50/p99/p99.9/max columns)
 
 # Output
 OUTDIR="${OUTDIR:-$ROOT/benchmarks/$(date +%Y%m%d_%H%M%S)}"
@@ -41,28 +44,41 @@ case "$MODE" in
 esac
 
 # ---------------- Configure & build ----------------
+CMAKE_ARGS=(-S "$ROOT" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE="$CONFIG"
+            -DMSIM_WITH_GRPC="$WITH_GRPC" -DMSIM_BUILD_TESTS="$BUILD_TESTS")
+if [[ -n "$GENERATOR" ]]; then CMAKE_ARGS+=(-G "$GENERATOR"); fi
+if [[ -n "$PLATFORM" ]]; then CMAKE_ARGS+=(-A "$PLATFORM"); fi
 if [[ ! -f "$BUILD_DIR/CMakeCache.txt" ]]; then
   echo "[bench] configuring into $BUILD_DIR (WITH_GRPC=$WITH_GRPC)"
-  cmake -S "$ROOT" -B "$BUILD_DIR" -G "$GENERATOR" -A "$PLATFORM" \
-    -DMSIM_WITH_GRPC="$WITH_GRPC" -DMSIM_BUILD_TESTS="$BUILD_TESTS"
+  cmake "${CMAKE_ARGS[@]}"
 else
   # if cache exists, still ensure option matches (cheap reconfigure)
-  cmake -S "$ROOT" -B "$BUILD_DIR" -G "$GENERATOR" -A "$PLATFORM" \
-    -DMSIM_WITH_GRPC="$WITH_GRPC" -DMSIM_BUILD_TESTS="$BUILD_TESTS" >/dev/null
+  cmake "${CMAKE_ARGS[@]}" >/dev/null
 fi
 
 echo "[bench] building ($CONFIG)"
 cmake --build "$BUILD_DIR" --config "$CONFIG" -j "$JOBS"
 
-BIN="$BUILD_DIR/$CONFIG/market_sim.exe"
-if [[ ! -f "$BIN" ]]; then
-  echo "ERROR: market_sim not found at $BIN" >&2
+# Single-config generators put binaries in $BUILD_DIR, multi-config ones
+# (Visual Studio, Xcode) in $BUILD_DIR/$CONFIG; .exe on Windows.
+find_bin() {
+  local name="$1" dir ext
+  for dir in "$BUILD_DIR/$CONFIG" "$BUILD_DIR"; do
+    for ext in .exe ""; do
+      if [[ -f "$dir/$name$ext" ]]; then echo "$dir/$name$ext"; return; fi
+    done
+  done
+}
+
+BIN="$(find_bin market_sim)"
+if [[ -z "$BIN" ]]; then
+  echo "ERROR: market_sim not found under $BUILD_DIR" >&2
   exit 1
 fi
 
-COLLECTOR="$BUILD_DIR/$CONFIG/collector_server.exe"
+COLLECTOR="$(find_bin collector_server)"
 HAS_COLLECTOR=0
-if [[ -f "$COLLECTOR" ]]; then HAS_COLLECTOR=1; fi
+if [[ -n "$COLLECTOR" ]]; then HAS_COLLECTOR=1; fi
 
 # ---------------- Helpers ----------------
 strip_cr() { tr -d '\r'; }
@@ -94,12 +110,24 @@ extract_float() {
   extract_last_num "$1" "$2" '^[0-9]+([.][0-9]+)?$'
 }
 
+extract_latency() {
+  # $1: full text, $2: op (add|fill|cancel), $3: field (p50|p99|p99.9|max)
+  # from "Latency <op>: count=N p50=.. p99=.. p99.9=.. max=.. (ns)"
+  echo "$1" | strip_cr | awk -v op="Latency $2:" -v f="$3=" '
+    index($0, op) == 1 {
+      for (i = 1; i <= NF; ++i)
+        if (index($i, f) == 1) { v = substr($i, length(f) + 1) }
+    }
+    END { if (v != "") print v; }
+  ' | tail -n 1
+}
+
 start_collector() {
   local addr="$1"
   local log="$2"
 
   if [[ "$HAS_COLLECTOR" != "1" ]]; then
-    echo "ERROR: collector_server.exe not built (need WITH_GRPC=ON build)" >&2
+    echo "ERROR: collector_server not built (need WITH_GRPC=ON build)" >&2
     return 1
   fi
 
@@ -126,39 +154,44 @@ stop_collector() {
 # ---------------- Scenario naming ----------------
 sym_count="$(echo "$SYMBOLS" | awk -F',' '{print NF}')"
 if [[ -z "$SCENARIO" ]]; then
-  SCENARIO="${MODE}_t${THREADS}_s${sym_count}_e${EVENTS}"
+  LABEL="${MODE}_t${THREADS}_s${sym_count}_e${EVENTS}"
+else
+  scn_name="$(basename "$SCENARIO")"
+  LABEL="${MODE}_${scn_name%.*}_t${THREADS}_s${sym_count}_e${EVENTS}"
 fi
 
 # log path per mode
 LOG_PATH=""
 ARGS=(--symbols "$SYMBOLS" --events "$EVENTS" --threads "$THREADS" --sigma "$SIGMA" --arena-bytes "$ARENA_BYTES")
+if [[ "$LATENCY" == "1" ]]; then ARGS+=(--latency); fi
+if [[ -n "$SCENARIO" ]]; then ARGS+=(--scenario "$SCENARIO"); fi
 
 case "$MODE" in
   no_log)
     ARGS+=(--no-log)
     ;;
   binlog)
-    LOG_PATH="$OUTDIR/${SCENARIO}.bin"
+    LOG_PATH="$OUTDIR/${LABEL}.bin"
     rm -f "$LOG_PATH" || true
     ARGS+=(--log "$LOG_PATH")
     ;;
   lmdb)
-    LOG_PATH="$OUTDIR/${SCENARIO}.mdb"
+    LOG_PATH="$OUTDIR/${LABEL}.mdb"
     rm -rf "$LOG_PATH" || true
-    ARGS+=(--log "$LOG_PATH")
+    ARGS+=(--log "$LOG_PATH" --lmdb-durability "$LMDB_DURABILITY")
     ;;
   grpc)
     ARGS+=(--no-log --grpc "$GRPC_TARGET")
     ;;
   binlog_grpc)
-    LOG_PATH="$OUTDIR/${SCENARIO}.bin"
+    LOG_PATH="$OUTDIR/${LABEL}.bin"
     rm -f "$LOG_PATH" || true
     ARGS+=(--log "$LOG_PATH" --grpc "$GRPC_TARGET")
     ;;
   lmdb_grpc)
-    LOG_PATH="$OUTDIR/${SCENARIO}.mdb"
+    LOG_PATH="$OUTDIR/${LABEL}.mdb"
     rm -rf "$LOG_PATH" || true
-    ARGS+=(--log "$LOG_PATH" --grpc "$GRPC_TARGET")
+    ARGS+=(--log "$LOG_PATH" --lmdb-durability "$LMDB_DURABILITY" --grpc "$GRPC_TARGET")
     ;;
   *)
     echo "ERROR: unknown MODE=$MODE" >&2
@@ -169,17 +202,20 @@ esac
 # CSV
 CSV="$OUTDIR/results.csv"
 if [[ ! -f "$CSV" ]]; then
-  echo "ts,scenario,mode,threads,symbols,events,rep,throughput_ev_s,steps_per_s,book_ops_per_s,adds,cancels,trades,action_ratio,elapsed_max_ms,collector_ev_s,log_path,grpc_target,build_dir,with_grpc" > "$CSV"
+  echo "ts,scenario,mode,threads,symbols,events,rep,throughput_ev_s,steps_per_s,book_ops_per_s,adds,cancels,trades,action_ratio,elapsed_max_ms,collector_ev_s,log_path,grpc_target,build_dir,with_grpc,add_p50_ns,add_p99_ns,add_p999_ns,add_max_ns,fill_p50_ns,fill_p99_ns,fill_p999_ns,fill_max_ns,cancel_p50_ns,cancel_p99_ns,cancel_p999_ns,cancel_max_ns" > "$CSV"
 fi
 
 echo "[bench] BIN:      $BIN"
 echo "[bench] MODE:     $MODE"
-echo "[bench] SCENARIO: $SCENARIO"
+echo "[bench] LABEL:    $LABEL"
+echo "[bench] SCENARIO: ${SCENARIO:-default}"
 echo "[bench] OUTDIR:   $OUTDIR"
 echo
 
 # Warmup
 WARGS=(--symbols "$SYMBOLS" --events "$WARMUP_EVENTS" --threads "$THREADS" --sigma "$SIGMA" --arena-bytes "$ARENA_BYTES")
+if [[ -n "$SCENARIO" ]]; then WARGS+=(--scenario "$SCENARIO"); fi
+if [[ "$WARM_START" == "1" ]]; then WARGS+=(--checkpoint "$OUTDIR/_warmup.mckp"); fi
 case "$MODE" in
   no_log|grpc) WARGS+=(--no-log) ;;
   binlog|binlog_grpc) WARGS+=(--log "$OUTDIR/_warmup.bin") ;;
@@ -189,14 +225,15 @@ case "$MODE" in
   grpc|binlog_grpc|lmdb_grpc) WARGS+=(--grpc "$GRPC_TARGET") ;;
 esac
 "$BIN" "${WARGS[@]}" >/dev/null 2>&1 || true
+if [[ "$WARM_START" == "1" ]]; then ARGS+=(--resume "$OUTDIR/_warmup.mckp"); fi
 
 best_t=0;   sum_t=0
 best_steps=0; sum_steps=0
 best_ops=0; sum_ops=0
 
 for rep in $(seq 1 "$REPS"); do
-  raw_log="$OUTDIR/${SCENARIO}_rep${rep}.log"
-  collector_log="$OUTDIR/${SCENARIO}_rep${rep}_collector.log"
+  raw_log="$OUTDIR/${LABEL}_rep${rep}.log"
+  collector_log="$OUTDIR/${LABEL}_rep${rep}_collector.log"
   collector_rate=""
 
   collector_pid=""
@@ -204,7 +241,9 @@ for rep in $(seq 1 "$REPS"); do
     collector_pid="$(start_collector "$GRPC_TARGET" "$collector_log")"
   fi
 
-  OUT="$("$BIN" "${ARGS[@]}" 2>&1 | strip_cr)"
+  # Per-rep JSON results next to the console log (bench_regress.py reads
+  # these; the CSV below is still scraped from the console).
+  OUT="$("$BIN" "${ARGS[@]}" --json "$OUTDIR/${LABEL}_rep${rep}.json" 2>&1 | strip_cr)"
   echo "$OUT" | filter_affinity | tee "$raw_log" >/dev/null
 
   if [[ -n "$collector_pid" ]]; then
@@ -245,8 +284,16 @@ for rep in $(seq 1 "$REPS"); do
   fi
 
 
+  # Empty unless LATENCY=1.
+  lat_cols=""
+  for op in add fill cancel; do
+    for f in p50 p99 p99.9 max; do
+      lat_cols="$lat_cols,$(extract_latency "$OUT" "$op" "$f")"
+    done
+  done
+
   ts="$(date +%Y-%m-%dT%H:%M:%S%z)"
-  echo "$ts,$SCENARIO,$MODE,$THREADS,$sym_count,$EVENTS,$rep,$throughput,$steps_s,$book_ops_s,$adds,$cancels,$trades,$action_ratio,$elapsed_max_ms,${collector_rate:-},${LOG_PATH:-},${GRPC_TARGET:-},$BUILD_DIR,$WITH_GRPC" >> "$CSV"
+  echo "$ts,$LABEL,$MODE,$THREADS,$sym_count,$EVENTS,$rep,$throughput,$steps_s,$book_ops_s,$adds,$cancels,$trades,$action_ratio,$elapsed_max_ms,${collector_rate:-},${LOG_PATH:-},${GRPC_TARGET:-},$BUILD_DIR,$WITH_GRPC$lat_cols" >> "$CSV"
 
   echo
   echo "[bench] rep $rep:"
@@ -257,6 +304,11 @@ for rep in $(seq 1 "$REPS"); do
   if [[ -n "${collector_rate:-}" ]]; then
     echo "  collector:    $collector_rate ev/s"
   fi
+  if [[ "$LATENCY" == "1" ]]; then
+    echo "  add p99:      $(extract_latency "$OUT" add p99) ns"
+    echo "  fill p99:     $(extract_latency "$OUT" fill p99) ns"
+    echo "  cancel p99:   $(extract_latency "$OUT" cancel p99) ns"
+  fi
   echo
 
   sum_t=$((sum_t + throughput))
@@ -51,6 +51,12 @@ OUTDIR="$OUTDIR" MODE="lmdb" SCENARIO="lmdb_st" WITH_GRPC="OFF" \
   SIGMA="$SIGMA" ARENA_BYTES="$ARENA_BYTES" REPS="$REPS" QUIET_AFFINITY="$QUIET_AFFINITY" \
   ./scripts/bench.sh
 
+echo "[bench_all] --- LMDB logging (multi-thread, one env per worker) ---"
+OUTDIR="$OUTDIR" MODE="lmdb" SCENARIO="lmdb_mt" WITH_GRPC="OFF" \
+  THREADS="$THREADS_MT" SYMBOLS="$SYMBOLS_MT" EVENTS="$EVENTS_MT" \
+  SIGMA="$SIGMA" ARENA_BYTES="$ARENA_BYTES" REPS="$REPS" QUIET_AFFINITY="$QUIET_AFFINITY" \
+  ./scripts/bench.sh
+
 if [[ "$RUN_GRPC" == "1" ]]; then
   echo "[bench_all] --- gRPC streaming (multi-thread, no-log) ---"
   set +e
@@ -0,0 +1,392 @@
+#!/usr/bin/env python3
+
+"""Benchmark regression harness: run a scenario matrix, keep baselines, and
+flag statistically significant changes.
+
+Every run of market_sim writes its results with --json; the harness reads
+those instead of scraping console text. For each scenario and metric it
+keeps the REPS samples, their mean and a Student-t confidence interval, and
+against a baseline it reports the relative change with a Welch confidence
+interval. A change is flagged only when that interval excludes zero *and*
+the point estimate moves by at least --threshold percent, so noise alone
+doesn't trip it and small-but-real shifts don't either.
+
+Usage:
+  # build (cmake, host default generator), run the matrix, save a baseline
+  python3 scripts/bench_regress.py run --reps 5 --save-baseline base.json
+
+  # later: same matrix, compared to it; exit status 1 on any regression
+  python3 scripts/bench_regress.py run --reps 5 --baseline base.json
+
+  # compare two saved summaries without running anything
+  python3 scripts/bench_regress.py compare base.json current.json
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import os
+import platform
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+from datetime import datetime
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_MATRIX = os.path.join(ROOT, "scripts", "bench_matrix.json")
+
+# (metric, path into the JSON report, True if higher is better). Metrics a
+# run doesn't report (null: no --latency, no --perf or no PMU) are skipped.
+METRICS = (
+    ("throughput_ev_s", ("totals", "throughput_ev_s"), True),
+    ("book_ops_per_s", ("totals", "book_ops_per_s"), True),
+    ("match_ops_per_s", ("totals", "match_ops_per_s"), True),
+    ("add_p99_ns", ("latency_ns", "add", "p99"), False),
+    ("fill_p99_ns", ("latency_ns", "fill", "p99"), False),
+    ("cancel_p99_ns", ("latency_ns", "cancel", "p99"), False),
+    ("ipc", ("perf", "ipc"), True),
+    ("l1d_misses_per_ev", ("perf", "per_event", "l1d_misses"), False),
+    ("llc_misses_per_ev", ("perf", "per_event", "llc_misses"), False),
+)
+HIGHER_IS_BETTER = {name: hib for name, _, hib in METRICS}
+
+
+# ---------------- Student t ----------------
+
+def _betacf(a: float, b: float, x: float) -> float:
+    # Continued fraction for the incomplete beta (Numerical Recipes, betacf).
+    tiny = 1e-300
+    qab, qap, qam = a + b, a + 1.0, a - 1.0
+    c, d = 1.0, 1.0 - qab * x / qap
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((qam + m2) * (a + m2))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > tiny else tiny)
+        c = 1.0 + aa / c
+        c = c if abs(c) > tiny else tiny
+        h *= d * c
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > tiny else tiny)
+        c = 1.0 + aa / c
+        c = c if abs(c) > tiny else tiny
+        de = d * c
+        h *= de
+        if abs(de - 1.0) < 1e-12:
+            break
+    return h
+
+
+def _betai(a: float, b: float, x: float) -> float:
+    # Regularized incomplete beta I_x(a, b).
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    lbt = (math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+           + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return math.exp(lbt) * _betacf(a, b, x) / a
+    return 1.0 - math.exp(lbt) * _betacf(b, a, 1.0 - x) / b
+
+
+def t_cdf(t: float, df: float) -> float:
+    x = df / (df + t * t)
+    tail = 0.5 * _betai(df / 2.0, 0.5, x)
+    return 1.0 - tail if t >= 0 else tail
+
+
+def t_crit(confidence: float, df: float) -> float:
+    """Two-sided critical value: P(|T| <= t) = confidence."""
+    if df <= 0 or not math.isfinite(df):
+        return float("nan")
+    want = 0.5 + confidence / 2.0
+    lo, hi = 0.0, 1.0
+    while t_cdf(hi, df) < want:
+        hi *= 2.0
+    for _ in range(100):
+        mid = (lo + hi) / 2.0
+        if t_cdf(mid, df) < want:
+            lo = mid
+        else:
+            hi = mid
+    return (lo + hi) / 2.0
+
+
+# ---------------- Stats ----------------
+
+def describe(samples: list[float], confidence: float) -> dict:
+    n = len(samples)
+    mean = statistics.fmean(samples)
+    sd = statistics.stdev(samples) if n > 1 else 0.0
+    half = t_crit(confidence, n - 1) * sd / math.sqrt(n) if n > 1 else 0.0
+    return {"samples": samples, "n": n, "mean": mean, "stdev": sd,
+            "ci": [mean - half, mean + half]}
+
+
+def welch(base: dict, cur: dict, confidence: float) -> dict:
+    """Relative change cur vs base with a Welch CI (fractions of base)."""
+    mb, mc = base["mean"], cur["mean"]
+    vb = base["stdev"] ** 2 / base["n"]
+    vc = cur["stdev"] ** 2 / cur["n"]
+    se = math.sqrt(vb + vc)
+    if se > 0:
+        df = (vb + vc) ** 2 / (
+            (vb * vb / (base["n"] - 1) if base["n"] > 1 else 0.0)
+            + (vc * vc / (cur["n"] - 1) if cur["n"] > 1 else 0.0))
+        half = t_crit(confidence, df) * se
+    else:
+        df, half = float("inf"), 0.0
+    if mb == 0:
+        return {"delta": 0.0, "ci": [0.0, 0.0], "df": df}
+    d = mc - mb
+    return {"delta": d / mb, "ci": [(d - half) / mb, (d + half) / mb],
+            "df": df}
+
+
+def verdict(metric: str, change: dict, threshold: float) -> str:
+    lo, hi = change["ci"]
+    if math.isnan(lo) or math.isnan(hi):
+        return "n/a"
+    higher = HIGHER_IS_BETTER.get(metric, True)
+    worse = hi < 0 if higher else lo > 0
+    better = lo > 0 if higher else hi < 0
+    big = abs(change["delta"]) >= threshold
+    if worse and big:
+        return "REGRESSION"
+    if better and big:
+        return "improved"
+    return "ok"
+
+
+# ---------------- Running ----------------
+
+def find_bin(build_dir: str, config: str) -> str | None:
+    for d in (os.path.join(build_dir, config), build_dir):
+        for name in ("market_sim.exe", "market_sim"):
+            p = os.path.join(d, name)
+            if os.path.isfile(p):
+                return p
+    return None
+
+
+def build(build_dir: str, config: str, jobs: int, generator: str) -> str:
+    cfg = ["cmake", "-S", ROOT, "-B", build_dir,
+           "-DCMAKE_BUILD_TYPE=" + config, "-DMSIM_BUILD_TESTS=OFF"]
+    if generator:
+        cfg += ["-G", generator]
+    subprocess.run(cfg, check=True, stdout=subprocess.DEVNULL)
+    subprocess.run(["cmake", "--build", build_dir, "--config", config,
+                    "-j", str(jobs)], check=True)
+    path = find_bin(build_dir, config)
+    if not path:
+        sys.exit(f"market_sim not found under {build_dir}")
+    return path
+
+
+def pick(report: dict, path: tuple) -> float | None:
+    v = report
+    for k in path:
+        if not isinstance(v, dict) or k not in v:
+            return None
+        v = v[k]
+    return float(v) if isinstance(v, (int, float)) else None
+
+
+def warmup_args(args: list[str], events: int) -> list[str]:
+    out = list(args)
+    if "--events" in out:
+        out[out.index("--events") + 1] = str(events)
+    else:
+        out += ["--events", str(events)]
+    return out
+
+
+def run_matrix(bin_path: str, matrix: dict, reps: int, warmup_events: int,
+               outdir: str, name_filter: str | None,
+               confidence: float) -> dict:
+    common = matrix.get("common_args", [])
+    scenarios = {}
+    for scn in matrix["scenarios"]:
+        name = scn["name"]
+        if name_filter and not re.search(name_filter, name):
+            continue
+        args = common + scn.get("args", [])
+        if warmup_events > 0:
+            subprocess.run([bin_path] + warmup_args(args, warmup_events),
+                           stdout=subprocess.DEVNULL,
+                           stderr=subprocess.DEVNULL)
+        samples: dict[str, list[float]] = {}
+        for rep in range(1, reps + 1):
+            out_json = os.path.join(outdir, f"{name}_rep{rep}.json")
+            log = os.path.join(outdir, f"{name}_rep{rep}.log")
+            with open(log, "w") as f:
+                rc = subprocess.run([bin_path] + args + ["--json", out_json],
+                                    stdout=f, stderr=subprocess.STDOUT)
+            if rc.returncode != 0:
+                sys.exit(f"{name} rep {rep} failed (exit {rc.returncode}); "
+                         f"see {log}")
+            with open(out_json) as f:
+                report = json.load(f)
+            for metric, path, _ in METRICS:
+                v = pick(report, path)
+                if v is not None:
+                    samples.setdefault(metric, []).append(v)
+        scenarios[name] = {
+            "args": args,
+            "metrics": {m: describe(v, confidence) for m, v in samples.items()
+                        if len(v) == reps},
+        }
+        tp = scenarios[name]["metrics"].get("throughput_ev_s")
+        if tp:
+            print(f"[regress] {name}: {tp['mean']:,.0f} ev/s "
+                  f"(+/- {(tp['ci'][1] - tp['mean']):,.0f}, n={tp['n']})")
+    return {
+        "schema": 1,
+        "created": datetime.now().isoformat(timespec="seconds"),
+        "host": {"system": platform.system(), "machine": platform.machine(),
+                 "node": platform.node(), "cpus": os.cpu_count()},
+        "binary": bin_path,
+        "reps": reps,
+        "confidence": confidence,
+        "scenarios": scenarios,
+    }
+
+
+# ---------------- Reporting ----------------
+
+def fmt(v: float) -> str:
+    # Rates as whole numbers; IPC and per-event counts keep their fraction.
+    return f"{v:,.0f}" if abs(v) >= 1000 else f"{v:.4g}"
+
+
+def compare(base: dict, cur: dict, confidence: float,
+            threshold: float) -> tuple[list[list[str]], int]:
+    rows, regressions = [], 0
+    for name, c in cur["scenarios"].items():
+        b = base["scenarios"].get(name)
+        if not b:
+            continue
+        if b.get("args") != c.get("args"):
+            print(f"[regress] warning: {name} args differ from the baseline",
+                  file=sys.stderr)
+        for metric, cm in c["metrics"].items():
+            bm = b["metrics"].get(metric)
+            if not bm:
+                continue
+            ch = welch(bm, cm, confidence)
+            v = verdict(metric, ch, threshold)
+            regressions += v == "REGRESSION"
+            rows.append([name, metric, fmt(bm["mean"]), fmt(cm["mean"]),
+                         f"{100 * ch['delta']:+.1f}%",
+                         f"[{100 * ch['ci'][0]:+.1f}%, "
+                         f"{100 * ch['ci'][1]:+.1f}%]", v])
+    return rows, regressions
+
+
+def print_table(rows: list[list[str]], confidence: float) -> None:
+    head = ["scenario", "metric", "baseline", "current", "delta",
+            f"{100 * confidence:.0f}% CI", "verdict"]
+    widths = [max(len(r[i]) for r in rows + [head]) for i in range(len(head))]
+    line = lambda r: "| " + " | ".join(c.ljust(w) for c, w in
+                                       zip(r, widths)) + " |"
+    print(line(head))
+    print("|" + "|".join("-" * (w + 2) for w in widths) + "|")
+    for r in rows:
+        print(line(r))
+
+
+def cmd_run(a: argparse.Namespace) -> int:
+    bin_path = a.bin or build(a.build_dir, a.config, a.jobs, a.generator)
+    with open(a.matrix) as f:
+        matrix = json.load(f)
+    outdir = a.out or os.path.join(
+        ROOT, "benchmarks", "regress_" + datetime.now().strftime(
+            "%Y%m%d_%H%M%S"))
+    os.makedirs(outdir, exist_ok=True)
+
+    summary = run_matrix(bin_path, matrix, a.reps, a.warmup_events, outdir,
+                         a.filter, a.confidence)
+    summary_path = os.path.join(outdir, "summary.json")
+    with open(summary_path, "w") as f:
+        json.dump(summary, f, indent=2)
+    print(f"[regress] summary: {summary_path}")
+    if a.save_baseline:
+        shutil.copyfile(summary_path, a.save_baseline)
+        print(f"[regress] baseline saved: {a.save_baseline}")
+    if not a.baseline:
+        return 0
+    with open(a.baseline) as f:
+        base = json.load(f)
+    return report(base, summary, a.confidence, a.threshold / 100.0)
+
+
+def cmd_compare(a: argparse.Namespace) -> int:
+    with open(a.base) as f:
+        base = json.load(f)
+    with open(a.current) as f:
+        cur = json.load(f)
+    return report(base, cur, a.confidence, a.threshold / 100.0)
+
+
+def report(base: dict, cur: dict, confidence: float, threshold: float) -> int:
+    rows, regressions = compare(base, cur, confidence, threshold)
+    if not rows:
+        print("[regress] no scenarios in common with the baseline")
+        return 0
+    print_table(rows, confidence)
+    if regressions:
+        print(f"[regress] {regressions} regression(s)")
+        return 1
+    print("[regress] no regressions")
+    return 0
+
+
+def main() -> int:
+    p = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    sub = p.add_subparsers(dest="cmd", required=True)
+
+    def stat_args(sp: argparse.ArgumentParser) -> None:
+        sp.add_argument("--confidence", type=float, default=0.95)
+        sp.add_argument("--threshold", type=float, default=2.0,
+                        help="minimum change to flag, percent (default 2)")
+
+    r = sub.add_parser("run", help="run the scenario matrix")
+    r.add_argument("--bin", help="market_sim to run (default: build one)")
+    r.add_argument("--build-dir", default=os.path.join(ROOT, "build"))
+    r.add_argument("--config", default="Release")
+    r.add_argument("--generator", default="",
+                   help="CMake generator (default: host default)")
+    r.add_argument("--jobs", type=int, default=os.cpu_count() or 4)
+    r.add_argument("--matrix", default=DEFAULT_MATRIX)
+    r.add_argument("--filter", help="regex on scenario names")
+    r.add_argument("--reps", type=int, default=5)
+    r.add_argument("--warmup-events", type=int, default=200000,
+                   help="untimed run per scenario first; 0 = none")
+    r.add_argument("--out", help="output dir (default benchmarks/regress_*)")
+    r.add_argument("--baseline", help="summary.json to compare against")
+    r.add_argument("--save-baseline", help="copy this run's summary here")
+    stat_args(r)
+    r.set_defaults(fn=cmd_run)
+
+    c = sub.add_parser("compare", help="compare two summary.json files")
+    c.add_argument("base")
+    c.add_argument("current")
+    stat_args(c)
+    c.set_defaults(fn=cmd_compare)
+
+    a = p.parse_args()
+    if a.cmd == "run" and a.reps < 2:
+        p.error("--reps must be at least 2 for a confidence interval")
+    return a.fn(a)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
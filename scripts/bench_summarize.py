@@ -35,6 +35,11 @@ class Row:
     elapsed_ms: float
     wall_ms: float
     with_grpc: str
+    latency: dict[str, float]  # e.g. "add_p99_ns" -> ns; empty without --latency
+
+
+LAT_OPS = ("add", "fill", "cancel")
+LAT_FIELDS = ("p50", "p99", "p999", "max")
 
 
 def _as_int(s: str) -> int:
@@ -60,8 +65,8 @@ def load_rows(path: str) -> list[Row]:
                     threads=_as_int(r["threads"]),
                     symbols=_as_int(r["symbols"]),
                     events=_as_int(r["events"]),
-                    sigma=_as_float(r["sigma"]),
-                    arena_bytes=_as_int(r["arena_bytes"]),
+                    sigma=_as_float(r.get("sigma", "nan")),
+                    arena_bytes=_as_int(r.get("arena_bytes") or 0),
                     rep=_as_int(r["rep"]),
                     throughput=_as_int(r["throughput_ev_s"]),
                     steps_s=_as_int(r["steps_per_s"]),
@@ -70,6 +75,12 @@ def load_rows(path: str) -> list[Row]:
                     elapsed_ms=_as_float(r.get("elapsed_ms", "nan")),
                     wall_ms=_as_float(r.get("wall_ms", "nan")),
                     with_grpc=r.get("with_grpc", ""),
+                    latency={
+                        k: _as_float(r[k])
+                        for op in LAT_OPS
+                        for f in LAT_FIELDS
+                        if r.get(k := f"{op}_{f}_ns")
+                    },
                 )
             )
     return rows
@@ -130,6 +141,28 @@ def summarize(rows: list[Row]) -> str:
             f"| {scenario} | {mode} | {threads} | {symbols} | {fmt_int(events)} | {fmt_int(best_t)} | {fmt_int(avg_t)} | {fmt_int(best_o)} | {fmt_int(avg_o)} | {fmt_float(avg_ratio, 3)} |"
         )
 
+    lat_scenarios = [s for s in sorted(by_scenario) if any(r.latency for r in by_scenario[s])]
+    if lat_scenarios:
+        lines.append("")
+        lines.append("## Latency (ns, `--latency`)")
+        lines.append("")
+        lines.append("Avg over reps for percentiles; worst rep for max.")
+        lines.append("")
+        lines.append(
+            "| Scenario | Op | p50 | p99 | p99.9 | max |"
+        )
+        lines.append("|---|---|---:|---:|---:|---:|")
+        for scenario in lat_scenarios:
+            rs = [r for r in by_scenario[scenario] if r.latency]
+            for op in LAT_OPS:
+                def col(f: str, agg=statistics.mean) -> str:
+                    vals = [r.latency[f"{op}_{f}_ns"] for r in rs if f"{op}_{f}_ns" in r.latency]
+                    return fmt_int(agg(vals)) if vals else "-"
+
+                lines.append(
+                    f"| {scenario} | {op} | {col('p50')} | {col('p99')} | {col('p999')} | {col('max', max)} |"
+                )
+
     lines.append("")
     lines.append("## Notes")
     lines.append("")
@@ -0,0 +1,109 @@
+#include "msim/async_storage.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace msim {
+
+AsyncStorage::AsyncStorage(std::vector<std::unique_ptr<IStorage>> sinks,
+                           std::size_t n_producers,
+                           const SymbolTable* symbols)
+    : sinks_(std::move(sinks)), symbols_(symbols) {
+  if (sinks_.empty()) throw std::invalid_argument("AsyncStorage: no sinks");
+  if (n_producers == 0) n_producers = 1;
+
+  producers_.reserve(n_producers);
+  for (std::size_t p = 0; p < n_producers; ++p)
+    producers_.push_back(std::make_unique<Producer>());
+
+  bells_.reserve(sinks_.size());
+  for (std::size_t w = 0; w < sinks_.size(); ++w)
+    bells_.push_back(std::make_unique<Doorbell>());
+
+  threads_.reserve(sinks_.size());
+  for (std::size_t w = 0; w < sinks_.size(); ++w)
+    threads_.emplace_back([this, w] { writer_loop(w); });
+}
+
+AsyncStorage::~AsyncStorage() {
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+void AsyncStorage::writer_loop(std::size_t w) {
+  IStorage& sink = *sinks_[w];
+  const std::size_t n_writers = sinks_.size();
+  std::vector<CompactEvent> rows(kDrainBatch);
+  auto batch = std::make_unique<EventBatch>(symbols_);
+  bool failed = false;  // keep draining after a backend error so producers
+                        // never spin on a full ring forever
+
+  auto report = [&](const char* what) {
+    std::cerr << "[AsyncStorage] writer " << w << " failed: " << what
+              << " (dropping remaining events)\n";
+    failed = true;
+  };
+
+  for (;;) {
+    // Observe `closing_` before draining: once it is set every producer has
+    // finished, so an empty pass after that means the rings are drained.
+    const bool closing = closing_.load(std::memory_order_acquire);
+
+    std::size_t got = 0;
+    for (std::size_t p = w; p < producers_.size(); p += n_writers) {
+      const std::size_t n =
+          producers_[p]->ring.try_pop_bulk(rows.data(), rows.size());
+      if (n == 0 || failed) continue;
+
+      batch->clear();
+      batch->source = static_cast<uint32_t>(p);
+      for (std::size_t i = 0; i < n; ++i) batch->push(rows[i]);
+      try {
+        sink.write_batch(*batch);
+        got += n;
+      } catch (const std::exception& ex) {
+        report(ex.what());
+      }
+    }
+
+    if (got) {
+      written_.fetch_add(got, std::memory_order_relaxed);
+    } else if (closing && !any_pending(w)) {
+      break;
+    } else {
+      bells_[w]->wait([&] {
+        return closing_.load(std::memory_order_acquire) || any_pending(w);
+      });
+    }
+  }
+
+  release_sink(sinks_[w], !failed,
+               "[AsyncStorage] writer " + std::to_string(w));
+}
+
+bool AsyncStorage::any_pending(std::size_t w) const noexcept {
+  for (std::size_t p = w; p < producers_.size(); p += sinks_.size())
+    if (!producers_[p]->ring.empty()) return true;
+  return false;
+}
+
+void AsyncStorage::close() {
+  if (closed_) return;
+  closed_ = true;
+
+  closing_.store(true, std::memory_order_release);
+  for (auto& b : bells_) b->ring();
+  for (auto& th : threads_) th.join();
+  threads_.clear();
+}
+
+uint64_t AsyncStorage::stalls() const noexcept {
+  uint64_t n = 0;
+  for (auto& p : producers_) n += p->stalls;
+  return n;
+}
+
+}  // namespace msim
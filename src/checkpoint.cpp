@@ -0,0 +1,303 @@
+#include "msim/checkpoint.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace msim {
+
+namespace {
+
+constexpr uint64_t align8(uint64_t n) noexcept {
+  return (n + 7) & ~uint64_t(7);
+}
+
+void write_all(std::FILE* fp, const void* p, size_t n) {
+  if (n && std::fwrite(p, 1, n, fp) != n)
+    throw std::runtime_error("checkpoint write failed");
+}
+
+void write_pad(std::FILE* fp, uint64_t n) {
+  static const uint8_t zeros[8] = {};
+  write_all(fp, zeros, size_t(align8(n) - n));
+}
+
+}  // namespace
+
+CheckpointSymbol capture_symbol(const IOrderBook& book, double mid_tick,
+                                const uint64_t* live, std::size_t n_live) {
+  CheckpointSymbol s;
+  s.name = book.symbol();
+  s.mid_tick = mid_tick;
+  book.resting_orders(s.orders);
+  s.live.assign(live, live + n_live);
+  return s;
+}
+
+void write_checkpoint(const std::string& path, uint64_t seed,
+                      bool realtime_ts,
+                      const std::vector<CheckpointWorker>& workers) {
+  // Lay out every section first; offsets only depend on the counts.
+  size_t n_symbols = 0;
+  uint64_t n_orders = 0, n_live = 0, name_bytes = 0, events_done = 0;
+  for (const CheckpointWorker& w : workers) {
+    n_symbols += w.symbols.size();
+    events_done += w.step;
+    for (const CheckpointSymbol& s : w.symbols) {
+      n_orders += s.orders.size();
+      n_live += s.live.size();
+      name_bytes += align8(s.name.size());
+    }
+  }
+  const uint64_t workers_off = sizeof(ckpt::FileHeader);
+  const uint64_t symbols_off =
+      workers_off + workers.size() * sizeof(ckpt::WorkerRec);
+  const uint64_t orders_off =
+      symbols_off + n_symbols * sizeof(ckpt::SymbolRec);
+  const uint64_t live_off = orders_off + n_orders * sizeof(ckpt::OrderRec);
+  const uint64_t names_off = live_off + n_live * sizeof(uint64_t);
+
+  ckpt::FileHeader h{};
+  std::memcpy(h.magic, ckpt::kMagic, sizeof(h.magic));
+  h.version = ckpt::kVersion;
+  h.n_workers = uint32_t(workers.size());
+  h.n_symbols = uint32_t(n_symbols);
+  h.realtime_ts = realtime_ts ? 1 : 0;
+  h.seed = seed;
+  h.events_done = events_done;
+  h.file_bytes = names_off + name_bytes;
+
+  std::vector<ckpt::WorkerRec> wrecs;
+  std::vector<ckpt::SymbolRec> srecs;
+  wrecs.reserve(workers.size());
+  srecs.reserve(n_symbols);
+  uint64_t o_at = orders_off, l_at = live_off, n_at = names_off;
+  for (size_t wi = 0; wi < workers.size(); ++wi) {
+    const CheckpointWorker& w = workers[wi];
+    ckpt::WorkerRec r{};
+    r.step = w.step;
+    r.next_id = w.next_id;
+    r.seq = w.seq;
+    r.last_ts = w.last_ts;
+    r.gen = w.gen;
+    r.batch_row = w.batch_row;
+    r.first_symbol = uint32_t(srecs.size());
+    r.n_symbols = uint32_t(w.symbols.size());
+    wrecs.push_back(r);
+    for (const CheckpointSymbol& s : w.symbols) {
+      ckpt::SymbolRec sr{};
+      sr.name_off = n_at;
+      sr.orders_off = o_at;
+      sr.live_off = l_at;
+      sr.n_orders = s.orders.size();
+      sr.n_live = s.live.size();
+      sr.mid_tick = s.mid_tick;
+      sr.name_len = uint32_t(s.name.size());
+      sr.worker = uint32_t(wi);
+      srecs.push_back(sr);
+      o_at += sr.n_orders * sizeof(ckpt::OrderRec);
+      l_at += sr.n_live * sizeof(uint64_t);
+      n_at += align8(sr.name_len);
+    }
+  }
+
+  const std::string tmp = path + ".tmp";
+  std::FILE* fp = std::fopen(tmp.c_str(), "wb");
+  if (!fp) throw std::runtime_error("open checkpoint failed: " + tmp);
+  try {
+    write_all(fp, &h, sizeof(h));
+    write_all(fp, wrecs.data(), wrecs.size() * sizeof(ckpt::WorkerRec));
+    write_all(fp, srecs.data(), srecs.size() * sizeof(ckpt::SymbolRec));
+    for (const CheckpointWorker& w : workers)
+      for (const CheckpointSymbol& s : w.symbols)
+        for (const Order& o : s.orders) {
+          ckpt::OrderRec r{};
+          r.id = o.id;
+          r.ts_ns = o.ts_ns;
+          r.tick = o.tick;
+          r.qty = o.qty;
+          r.side = uint8_t(o.side);
+          write_all(fp, &r, sizeof(r));
+        }
+    for (const CheckpointWorker& w : workers)
+      for (const CheckpointSymbol& s : w.symbols)
+        write_all(fp, s.live.data(), s.live.size() * sizeof(uint64_t));
+    for (const CheckpointWorker& w : workers)
+      for (const CheckpointSymbol& s : w.symbols) {
+        write_all(fp, s.name.data(), s.name.size());
+        write_pad(fp, s.name.size());
+      }
+    if (std::fflush(fp) != 0)
+      throw std::runtime_error("checkpoint write failed");
+  } catch (...) {
+    std::fclose(fp);
+    std::remove(tmp.c_str());
+    throw;
+  }
+  if (std::fclose(fp) != 0) {
+    std::remove(tmp.c_str());
+    throw std::runtime_error("checkpoint write failed: " + tmp);
+  }
+#ifdef _WIN32
+  std::remove(path.c_str());  // rename() won't replace on Windows
+#endif
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    throw std::runtime_error("rename checkpoint failed: " + path);
+  }
+}
+
+// ── CheckpointGate ───────────────────────────────────────────────
+
+CheckpointGate::CheckpointGate(std::size_t n_workers, Writer write)
+    : write_(std::move(write)), parts_(n_workers), expected_(n_workers) {}
+
+void CheckpointGate::arrive(std::size_t worker, CheckpointWorker part) {
+  std::unique_lock<std::mutex> lk(mu_);
+  parts_[worker] = std::move(part);
+  if (++arrived_ < expected_) {
+    const uint64_t gen = generation_;
+    cv_.wait(lk, [&] { return generation_ != gen; });
+    return;
+  }
+  write_locked();
+}
+
+void CheckpointGate::leave(std::size_t worker, CheckpointWorker part) {
+  std::lock_guard<std::mutex> lk(mu_);
+  parts_[worker] = std::move(part);
+  --expected_;
+  // The others may all be parked on this generation already.
+  if (arrived_ > 0 && arrived_ == expected_) write_locked();
+}
+
+void CheckpointGate::write_locked() {
+  // Everyone else is parked, so writing under the lock is no extra stall.
+  write_(parts_);
+  arrived_ = 0;
+  ++generation_;
+  cv_.notify_all();
+}
+
+uint64_t CheckpointGate::written() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return generation_;
+}
+
+// ── CheckpointReader ─────────────────────────────────────────────
+
+CheckpointReader::CheckpointReader(const std::string& path)
+    : file_(path, "checkpoint"),
+      header_(reinterpret_cast<const ckpt::FileHeader*>(file_.data())),
+      workers_(nullptr),
+      symbols_(nullptr) {
+  if (file_.size() < sizeof(ckpt::FileHeader) ||
+      std::memcmp(header_->magic, ckpt::kMagic, sizeof(ckpt::kMagic)) != 0)
+    throw std::runtime_error("not a checkpoint: " + path);
+  if (header_->version != ckpt::kVersion)
+    throw std::runtime_error("unsupported checkpoint version " +
+                             std::to_string(header_->version) + ": " + path);
+  if (header_->file_bytes != file_.size())
+    throw std::runtime_error("checkpoint is truncated: " + path);
+
+  const uint64_t workers_off = sizeof(ckpt::FileHeader);
+  const uint64_t symbols_off =
+      workers_off + uint64_t(header_->n_workers) * sizeof(ckpt::WorkerRec);
+  const uint64_t end =
+      symbols_off + uint64_t(header_->n_symbols) * sizeof(ckpt::SymbolRec);
+  if (end > file_.size())
+    throw std::runtime_error("checkpoint is truncated: " + path);
+  workers_ =
+      reinterpret_cast<const ckpt::WorkerRec*>(file_.data() + workers_off);
+  symbols_ =
+      reinterpret_cast<const ckpt::SymbolRec*>(file_.data() + symbols_off);
+  validate(path);
+}
+
+void CheckpointReader::validate(const std::string& path) const {
+  const uint64_t size = file_.size();
+  auto in_file = [size](uint64_t off, uint64_t n, uint64_t elem) {
+    return off % 8 == 0 && off <= size && n <= (size - off) / elem;
+  };
+  const auto bad = [&path](const char* what) {
+    return std::runtime_error(std::string("corrupt checkpoint (") + what +
+                              "): " + path);
+  };
+
+  uint64_t next = 0;  // workers own consecutive symbol ranges
+  for (size_t w = 0; w < workers(); ++w) {
+    const ckpt::WorkerRec& r = workers_[w];
+    if (r.first_symbol != next ||
+        uint64_t(r.first_symbol) + r.n_symbols > header_->n_symbols)
+      throw bad("worker symbols");
+    if (r.batch_row >= IntentBatch::kCapacity || r.batch_row > r.step)
+      throw bad("worker batch row");
+    next += r.n_symbols;
+  }
+  if (next != header_->n_symbols) throw bad("worker symbols");
+
+  for (size_t s = 0; s < header_->n_symbols; ++s) {
+    const ckpt::SymbolRec& r = symbols_[s];
+    if (r.worker >= workers() || !in_file(r.name_off, r.name_len, 1))
+      throw bad("symbol");
+    if (!in_file(r.orders_off, r.n_orders, sizeof(ckpt::OrderRec)) ||
+        !in_file(r.live_off, r.n_live, sizeof(uint64_t)))
+      throw bad("symbol data");
+
+    // BookDigest order: bids best -> worst, then asks best -> worst, and
+    // the best bid below the best ask.
+    const ckpt::OrderRec* o = orders(r);
+    bool asks = false, ok = true;
+    for (uint64_t i = 0; ok && i < r.n_orders; ++i) {
+      const bool sell = o[i].side == uint8_t(Side::SELL);
+      ok = o[i].qty > 0 && (sell || o[i].side == uint8_t(Side::BUY));
+      if (!ok || i == 0) {
+        asks = sell;
+        continue;
+      }
+      if (sell && !asks)
+        ok = o[i].tick > o[0].tick;  // first ask vs best bid
+      else if (sell)
+        ok = o[i].tick >= o[i - 1].tick;
+      else
+        ok = !asks && o[i].tick <= o[i - 1].tick;
+      asks = sell;
+    }
+    if (!ok) throw bad("book");
+  }
+}
+
+std::string_view CheckpointReader::name(const ckpt::SymbolRec& s) const {
+  return {reinterpret_cast<const char*>(file_.data() + s.name_off),
+          s.name_len};
+}
+
+const ckpt::OrderRec* CheckpointReader::orders(
+    const ckpt::SymbolRec& s) const {
+  return reinterpret_cast<const ckpt::OrderRec*>(file_.data() +
+                                                 s.orders_off);
+}
+
+const uint64_t* CheckpointReader::live(const ckpt::SymbolRec& s) const {
+  return reinterpret_cast<const uint64_t*>(file_.data() + s.live_off);
+}
+
+void CheckpointReader::restore_book(const ckpt::SymbolRec& s,
+                                    IOrderBook& book) const {
+  // Through apply() in chunks; validate() made sure nothing trades.
+  constexpr uint64_t kChunk = 256;
+  const ckpt::OrderRec* o = orders(s);
+  std::vector<BookCommand> cmds;
+  std::vector<Fill> fills;
+  cmds.reserve(kChunk);
+  for (uint64_t i0 = 0; i0 < s.n_orders; i0 += kChunk) {
+    cmds.clear();
+    for (uint64_t i = i0; i < s.n_orders && i < i0 + kChunk; ++i)
+      cmds.push_back(BookCommand::add(
+          Order{o[i].id, o[i].tick, o[i].qty, Side(o[i].side), o[i].ts_ns},
+          OrderType::Limit));
+    book.apply(cmds.data(), cmds.size(), fills);
+  }
+}
+
+}  // namespace msim
@@ -0,0 +1,429 @@
+#include "msim/collector.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <type_traits>
+
+#include "msim/event_batch.hpp"
+#include "msim/event_convert.hpp"
+#include "msim/symbol_table.hpp"
+
+namespace msim {
+
+// ─────────────── Sink ───────────────
+
+// Bounded MPSC hand-off from the CQ threads to one writer thread that owns
+// the IStorage. The writer re-interns symbols into its own table and feeds
+// the backend's columnar write_batch() path.
+class Collector::Sink {
+ public:
+  Sink(const std::string& path, StorageOptions opts, std::size_t capacity)
+      : capacity_(std::max<std::size_t>(capacity, 1)),
+        batch_(std::make_unique<EventBatch>(&symbols_)) {
+    opts.lmdb_shards = 1;  // a single writer
+    storage_ = make_storage(path, opts);
+    thread_ = std::thread([this] { run(); });
+  }
+  ~Sink() { close(); }
+
+  void push(std::vector<Event>&& events) {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (queue_.size() >= capacity_) {
+      ++stalls_;
+      room_cv_.wait(lk, [this] { return queue_.size() < capacity_; });
+    }
+    queue_.push_back(std::move(events));
+    lk.unlock();
+    ready_cv_.notify_one();
+  }
+
+  // Drains the queue, flushes and releases the storage.
+  void close() {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      closing_ = true;
+    }
+    ready_cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+  }
+
+  uint64_t written() const noexcept {
+    return written_.load(std::memory_order_relaxed);
+  }
+  uint64_t stalls() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stalls_;
+  }
+  std::size_t depth() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return queue_.size();
+  }
+  std::size_t capacity() const noexcept { return capacity_; }
+
+ private:
+  void run() {
+    EventBatch& batch = *batch_;
+    for (;;) {
+      std::vector<Event> chunk;
+      {
+        std::unique_lock<std::mutex> lk(mu_);
+        ready_cv_.wait(lk, [this] { return !queue_.empty() || closing_; });
+        if (queue_.empty()) break;  // closing and drained
+        chunk = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      room_cv_.notify_one();
+
+      for (const Event& e : chunk) {
+        const uint16_t id = symbols_.intern(e.symbol);
+        batch.push(CompactEvent{e.ts_ns, symbols_.to_tick(id, e.price), e.qty,
+                                id, e.type, e.side, e.order_id});
+        if (batch.full()) {
+          storage_->write_batch(batch);
+          batch.clear();
+        }
+      }
+      // Don't sit on a partial batch between chunks.
+      if (!batch.empty()) {
+        storage_->write_batch(batch);
+        batch.clear();
+      }
+      written_.fetch_add(chunk.size(), std::memory_order_relaxed);
+    }
+    storage_->flush_source(0);
+    storage_->flush();
+  }
+
+  const std::size_t capacity_;
+  SymbolTable symbols_;  // writer thread only
+  std::unique_ptr<EventBatch> batch_;
+  std::unique_ptr<IStorage> storage_;
+  std::thread thread_;
+
+  mutable std::mutex mu_;
+  std::condition_variable ready_cv_;  // queue non-empty or closing
+  std::condition_variable room_cv_;   // queue below capacity
+  std::deque<std::vector<Event>> queue_;
+  bool closing_ = false;
+  uint64_t stalls_ = 0;
+  std::atomic<uint64_t> written_{0};
+};
+
+// ─────────────── Calls ───────────────
+
+// A completion-queue tag: one per stream, advanced by whichever thread
+// polls its CQ.
+class Collector::CallBase {
+ public:
+  virtual ~CallBase() = default;
+  // `ok` is the completed op's result; `draining` means the CQ is shutting
+  // down and no new op may be started.
+  virtual void proceed(bool ok, bool draining) = 0;
+};
+
+// One Publish (EventBatch) or PublishPacked (PackedBatch) stream:
+// Request -> Read* -> Finish.
+template <typename Msg>
+class Collector::Call final : public CallBase {
+  static constexpr bool kPacked = std::is_same_v<Msg, rpc::PackedBatch>;
+
+ public:
+  Call(Collector& owner, grpc::ServerCompletionQueue* cq)
+      : owner_(owner), cq_(cq), reader_(&ctx_) {
+    if constexpr (kPacked)
+      owner_.service_.RequestPublishPacked(&ctx_, &reader_, cq_, cq_, this);
+    else
+      owner_.service_.RequestPublish(&ctx_, &reader_, cq_, cq_, this);
+  }
+
+  void proceed(bool ok, bool draining) override {
+    if (draining) {
+      if (stats_) owner_.close_stream(stats_, events_ == 0);
+      delete this;
+      return;
+    }
+    switch (state_) {
+      case State::Request:
+        if (!ok) {  // server shutting down
+          delete this;
+          return;
+        }
+        new Call<Msg>(owner_, cq_);  // await the next stream
+        stats_ = owner_.open_stream(ctx_.peer(), kPacked ? "packed" : "rows");
+        state_ = State::Read;
+        reader_.Read(&msg_, this);
+        return;
+
+      case State::Read:
+        if (!ok) {  // client half-closed (or went away)
+          ack_.set_count(events_);
+          state_ = State::Finish;
+          reader_.Finish(ack_, grpc::Status::OK, this);
+          return;
+        }
+        if (!handle()) {
+          owner_.rejected_.fetch_add(1, std::memory_order_relaxed);
+          state_ = State::Finish;
+          reader_.FinishWithError(
+              grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                           "malformed PackedBatch"),
+              this);
+          return;
+        }
+        reader_.Read(&msg_, this);
+        return;
+
+      case State::Finish:
+        owner_.close_stream(stats_, events_ == 0);
+        delete this;
+        return;
+    }
+  }
+
+ private:
+  enum class State { Request, Read, Finish };
+
+  // Decodes (when needed), forwards and accounts one batch.
+  bool handle() {
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<Event> events;
+    uint64_t n = 0;
+    if constexpr (kPacked) {
+      // Always decoded: from_packed() is also the validation.
+      if (!EventConvert::from_packed(msg_, events)) return false;
+      n = events.size();
+    } else {
+      n = uint64_t(msg_.events_size());
+      if (owner_.sink_) {
+        events.reserve(std::size_t(n));
+        for (const auto& e : msg_.events())
+          events.push_back(EventConvert::from_proto(e));
+      }
+    }
+    const uint64_t bytes = msg_.ByteSizeLong();
+    owner_.forward(std::move(events));
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - t0)
+                        .count();
+
+    events_ += n;
+    std::lock_guard<std::mutex> lk(stats_->mu);
+    stats_->events += n;
+    stats_->batches += 1;
+    stats_->bytes += bytes;
+    stats_->interval_ns.record(uint64_t(ns));
+    return true;
+  }
+
+  Collector& owner_;
+  grpc::ServerCompletionQueue* cq_;
+  grpc::ServerContext ctx_;
+  grpc::ServerAsyncReader<rpc::Ack, Msg> reader_;
+  Msg msg_;
+  rpc::Ack ack_;
+  State state_ = State::Request;
+  std::shared_ptr<StreamStats> stats_;
+  uint64_t events_ = 0;
+};
+
+// ─────────────── Collector ───────────────
+
+Collector::Collector(CollectorOptions opt) : opt_(std::move(opt)) {
+  opt_.threads = std::max<std::size_t>(opt_.threads, 1);
+  if (!opt_.sink_path.empty())
+    sink_ = std::make_unique<Sink>(opt_.sink_path, opt_.storage,
+                                   opt_.sink_queue);
+
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(opt_.address, grpc::InsecureServerCredentials(),
+                           &port_);
+  builder.RegisterService(&service_);
+  for (std::size_t q = 0; q < opt_.threads; ++q)
+    cqs_.push_back(builder.AddCompletionQueue());
+  server_ = builder.BuildAndStart();
+  if (!server_ || port_ == 0) {
+    for (auto& cq : cqs_) {
+      cq->Shutdown();
+      void* tag;
+      bool ok;
+      while (cq->Next(&tag, &ok)) {
+      }
+    }
+    throw std::runtime_error("collector: cannot listen on " + opt_.address);
+  }
+
+  cq_mu_ = std::vector<std::mutex>(cqs_.size());
+  for (auto& cq : cqs_) {
+    new Call<rpc::EventBatch>(*this, cq.get());
+    new Call<rpc::PackedBatch>(*this, cq.get());
+  }
+  for (std::size_t q = 0; q < cqs_.size(); ++q)
+    threads_.emplace_back([this, q] { serve(q); });
+  if (opt_.log && opt_.stats_every.count() > 0)
+    reporter_ = std::thread([this] { report_loop(); });
+}
+
+Collector::~Collector() { shutdown(); }
+
+void Collector::serve(std::size_t q) {
+  void* tag;
+  bool ok;
+  while (cqs_[q]->Next(&tag, &ok)) {
+    // Held while a call starts its next op, so shutdown() can't close the
+    // CQ in between.
+    std::lock_guard<std::mutex> lk(cq_mu_[q]);
+    static_cast<CallBase*>(tag)->proceed(ok, draining_);
+  }
+}
+
+void Collector::shutdown() {
+  if (shut_down_) return;
+  shut_down_ = true;
+
+  {
+    std::lock_guard<std::mutex> lk(stop_mu_);
+    stopping_ = true;
+  }
+  stop_cv_.notify_all();
+  if (reporter_.joinable()) reporter_.join();
+
+  // Give open streams a moment to finish, then cancel them; the CQ
+  // threads are still running their completions.
+  server_->Shutdown(std::chrono::system_clock::now() +
+                    std::chrono::seconds(1));
+  for (std::size_t q = 0; q < cqs_.size(); ++q) {
+    std::lock_guard<std::mutex> lk(cq_mu_[q]);
+    draining_ = true;
+    cqs_[q]->Shutdown();
+  }
+  for (auto& t : threads_) t.join();
+  if (sink_) sink_->close();
+}
+
+void Collector::forward(std::vector<Event>&& events) {
+  if (sink_ && !events.empty()) sink_->push(std::move(events));
+}
+
+std::shared_ptr<Collector::StreamStats> Collector::open_stream(
+    const std::string& peer, const char* format) {
+  auto s = std::make_shared<StreamStats>();
+  s->peer = peer;
+  s->format = format;
+  s->start = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lk(streams_mu_);
+  s->id = next_id_++;
+  live_.emplace(s->id, s);
+  return s;
+}
+
+void Collector::close_stream(const std::shared_ptr<StreamStats>& s,
+                             bool probe) {
+  uint64_t events, batches, bytes;
+  {
+    std::lock_guard<std::mutex> lk(streams_mu_);
+    live_.erase(s->id);
+    std::lock_guard<std::mutex> slk(s->mu);
+    events = s->events;
+    batches = s->batches;
+    bytes = s->bytes;
+    closed_since_report_ += events - s->last_events;
+    done_.streams += probe ? 0 : 1;
+    done_.events += events;
+    done_.batches += batches;
+    done_.bytes += bytes;
+    if (probe || !opt_.log) return;  // exporter's format probe: no line
+  }
+
+  const double secs = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - s->start)
+                          .count();
+  std::lock_guard<std::mutex> lk(log_mu_);
+  *opt_.log << "Received " << events << " events at "
+            << uint64_t(secs > 0 ? double(events) / secs : 0.0) << " ev/s, "
+            << double(bytes) / double(events) << " bytes/event ("
+            << s->format << ", stream " << s->id << ", " << s->peer
+            << ")" << std::endl;
+}
+
+Collector::Totals Collector::totals() const {
+  Totals t;
+  {
+    std::lock_guard<std::mutex> lk(streams_mu_);
+    t = done_;
+    for (const auto& [id, s] : live_) {
+      std::lock_guard<std::mutex> slk(s->mu);
+      t.events += s->events;
+      t.batches += s->batches;
+      t.bytes += s->bytes;
+    }
+  }
+  t.rejected = rejected_.load(std::memory_order_relaxed);
+  if (sink_) {
+    t.sink_written = sink_->written();
+    t.sink_stalls = sink_->stalls();
+  }
+  return t;
+}
+
+void Collector::report_loop() {
+  auto last = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lk(stop_mu_);
+  while (!stop_cv_.wait_for(lk, opt_.stats_every,
+                            [this] { return stopping_; })) {
+    const auto now = std::chrono::steady_clock::now();
+    report(*opt_.log, std::chrono::duration<double>(now - last).count());
+    last = now;
+  }
+}
+
+// One line per live stream with its interval rates and batch service-time
+// quantiles, then a total line with the sink's queue depth (ingest
+// saturation shows up there first).
+void Collector::report(std::ostream& os, double secs) {
+  if (secs <= 0) return;
+  std::vector<std::shared_ptr<StreamStats>> live;
+  uint64_t total = 0;
+  {
+    std::lock_guard<std::mutex> lk(streams_mu_);
+    for (const auto& [id, s] : live_) live.push_back(s);
+    total = closed_since_report_;
+    closed_since_report_ = 0;
+  }
+
+  std::lock_guard<std::mutex> lk(log_mu_);
+  std::size_t active = 0;
+  for (const auto& s : live) {
+    uint64_t d_events, d_bytes, events, p50, p99, max;
+    {
+      std::lock_guard<std::mutex> slk(s->mu);
+      if (s->events == 0) continue;  // idle stream (or a probe)
+      d_events = s->events - s->last_events;
+      d_bytes = s->bytes - s->last_bytes;
+      events = s->events;
+      p50 = s->interval_ns.quantile(0.50);
+      p99 = s->interval_ns.quantile(0.99);
+      max = s->interval_ns.max();
+      s->last_events = s->events;
+      s->last_bytes = s->bytes;
+      s->interval_ns = LatencyHistogram{};
+    }
+    ++active;
+    total += d_events;
+    os << "[stats] stream " << s->id << " " << s->peer << " (" << s->format
+       << "): " << uint64_t(double(d_events) / secs) << " ev/s, "
+       << double(d_bytes) / secs / 1e6 << " MB/s, " << events
+       << " events, batch p50=" << p50 / 1000 << " p99=" << p99 / 1000
+       << " max=" << max / 1000 << " us\n";
+  }
+  if (active == 0 && total == 0) return;  // idle: stay quiet
+  os << "[stats] total: " << active << " stream(s), "
+     << uint64_t(double(total) / secs) << " ev/s";
+  if (sink_)
+    os << ", sink queue " << sink_->depth() << "/" << sink_->capacity()
+       << ", " << sink_->written() << " written, " << sink_->stalls()
+       << " stalls";
+  os << std::endl;
+}
+
+}  // namespace msim
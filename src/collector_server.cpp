@@ -1,50 +1,94 @@
-#include <grpcpp/grpcpp.h>
-
+#include <atomic>
 #include <chrono>
+#include <csignal>
+#include <exception>
 #include <iostream>
+#include <string>
+#include <thread>
 
-#include "market.grpc.pb.h"
-
-class CollectorService : public msim::rpc::MarketStream::Service {
- public:
-  grpc::Status Publish(grpc::ServerContext*,
-                       grpc::ServerReader<msim::rpc::EventBatch>* reader,
-                       msim::rpc::Ack* ack) override {
-    msim::rpc::EventBatch batch;
-    uint64_t count = 0;
+#include "msim/collector.hpp"
 
-    auto start = std::chrono::steady_clock::now();
+using namespace msim;
 
-    while (reader->Read(&batch)) {
-      count += static_cast<uint64_t>(batch.events_size());
-      // you could also inspect batch.events(i) here if you want
-    }
+static std::atomic<bool> g_stop{false};
 
-    auto end = std::chrono::steady_clock::now();
-    double secs = std::chrono::duration<double>(end - start).count();
+static void on_signal(int) { g_stop = true; }
 
-    std::cout << "Received " << count << " events at "
-              << (secs > 0 ? count / secs : 0.0) << " ev/s\n";
+int main(int argc, char** argv) {
+  CollectorOptions opt;
+  opt.log = &std::cout;
 
-    ack->set_count(count);
-    return grpc::Status::OK;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    if (a == "--threads" && i + 1 < argc)
+      opt.threads = std::stoull(argv[++i]);
+    else if (a == "--stats-ms" && i + 1 < argc)
+      opt.stats_every = std::chrono::milliseconds(std::stoll(argv[++i]));
+    else if (a == "--sink" && i + 1 < argc)
+      opt.sink_path = argv[++i];
+    else if (a == "--sink-queue" && i + 1 < argc)
+      opt.sink_queue = std::stoull(argv[++i]);
+    else if (a == "--lmdb-durability" && i + 1 < argc) {
+      const std::string tier = argv[++i];
+      if (tier == "sync")
+        opt.storage.lmdb_durability = LmdbDurability::Sync;
+      else if (tier == "nosync")
+        opt.storage.lmdb_durability = LmdbDurability::NoSync;
+      else if (tier == "writemap")
+        opt.storage.lmdb_durability = LmdbDurability::WriteMap;
+      else {
+        std::cerr << "Unknown --lmdb-durability '" << tier
+                  << "' (use sync|nosync|writemap)\n";
+        return 2;
+      }
+    } else if (a == "--help") {
+      std::cout
+          << "Usage: ./collector_server [ADDR] [options]\n"
+          << "  ADDR                 Listen address (default 0.0.0.0:50051)\n"
+          << "  --threads N          Completion-queue threads (default 2)\n"
+          << "  --stats-ms N         Per-stream stats every N ms; 0 = off "
+             "(default 1000)\n"
+          << "  --sink PATH          Store received events (.mdb = LMDB, "
+             ".mcol = columnar, else binary log)\n"
+          << "  --sink-queue N       Decoded batches buffered for the sink "
+             "(default 64)\n"
+          << "  --lmdb-durability D  sync | nosync | writemap (default "
+             "sync)\n";
+      return 0;
+    } else if (!a.empty() && a[0] != '-')
+      opt.address = a;
+    else {
+      std::cerr << "Unknown option '" << a << "' (see --help)\n";
+      return 2;
+    }
   }
-};
 
-int main(int argc, char** argv) {
-  std::string addr = "0.0.0.0:50051";
-  if (argc > 1) {
-    addr = argv[1];
-  }
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
 
-  CollectorService service;
+  try {
+    Collector collector(opt);
+    std::cout << "[collector] Listening on " << opt.address << " ("
+              << opt.threads << " CQ thread(s)"
+              << (opt.sink_path.empty() ? "" : ", sink " + opt.sink_path)
+              << ")" << std::endl;
 
-  grpc::ServerBuilder builder;
-  builder.AddListeningPort(addr, grpc::InsecureServerCredentials());
-  builder.RegisterService(&service);
-  std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+    while (!g_stop)
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
-  std::cout << "[collector] Listening on " << addr << "\n";
-  server->Wait();
+    // Drain open streams and flush the sink before exiting.
+    collector.shutdown();
+    const Collector::Totals t = collector.totals();
+    std::cout << "[collector] " << t.streams << " stream(s), " << t.events
+              << " events, " << t.batches << " batches, " << t.rejected
+              << " rejected";
+    if (!opt.sink_path.empty())
+      std::cout << ", " << t.sink_written << " stored (" << t.sink_stalls
+                << " sink stalls)";
+    std::cout << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "[ERROR] " << e.what() << "\n";
+    return 1;
+  }
   return 0;
 }
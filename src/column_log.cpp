@@ -0,0 +1,329 @@
+#include "msim/column_log.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace msim {
+
+namespace {
+
+// Column offsets inside a block, relative to the block start.
+struct ColumnLayout {
+  size_t ts, oid, px, qty, sym, type, side;
+
+  explicit ColumnLayout(uint32_t n) {
+    ts = sizeof(mcol::BlockHeader);
+    oid = ts + size_t(n) * sizeof(uint64_t);
+    px = oid + size_t(n) * sizeof(uint64_t);
+    qty = px + size_t(n) * sizeof(int32_t);
+    sym = qty + size_t(n) * sizeof(int32_t);
+    type = sym + size_t(n) * sizeof(uint16_t);
+    side = type + size_t(n) * sizeof(EventType);
+  }
+};
+
+void write_all(std::FILE* fp, const void* p, size_t n) {
+  if (std::fwrite(p, 1, n, fp) != n)
+    throw std::runtime_error("column log write failed");
+}
+
+}  // namespace
+
+// ── ColumnLogStorage ─────────────────────────────────────────────
+
+ColumnLogStorage::ColumnLogStorage(const std::string& path,
+                                   uint32_t block_events)
+    : block_events_(block_events ? block_events : mcol::kDefaultBlockEvents),
+      block_bytes_(mcol::block_bytes(block_events_)) {
+  fp_ = std::fopen(path.c_str(), "wb");
+  if (!fp_) throw std::runtime_error("open column log failed: " + path);
+
+  mcol::FileHeader fh{};
+  std::memcpy(fh.magic, mcol::kFileMagic, sizeof(fh.magic));
+  fh.version = mcol::kVersion;
+  fh.block_events = block_events_;
+  fh.block_bytes = block_bytes_;
+  write_all(fp_, &fh, sizeof(fh));
+  offset_ = sizeof(fh);
+
+  block_.assign(block_bytes_, 0);
+  const ColumnLayout l(block_events_);
+  uint8_t* b = block_.data();
+  hdr_ = reinterpret_cast<mcol::BlockHeader*>(b);
+  ts_ = reinterpret_cast<uint64_t*>(b + l.ts);
+  oid_ = reinterpret_cast<uint64_t*>(b + l.oid);
+  px_ = reinterpret_cast<int32_t*>(b + l.px);
+  qty_ = reinterpret_cast<int32_t*>(b + l.qty);
+  sym_ = reinterpret_cast<uint16_t*>(b + l.sym);
+  type_ = reinterpret_cast<EventType*>(b + l.type);
+  side_ = reinterpret_cast<Side*>(b + l.side);
+  std::memcpy(hdr_->magic, mcol::kBlockMagic, sizeof(hdr_->magic));
+}
+
+ColumnLogStorage::~ColumnLogStorage() {
+  if (!fp_) return;
+  try {
+    std::lock_guard<std::mutex> lock(mtx_);
+    seal_block();
+    write_footer();
+  } catch (const std::exception& ex) {
+    std::fprintf(stderr, "[ColumnLog] %s\n", ex.what());
+  }
+  std::fclose(fp_);
+}
+
+void ColumnLogStorage::append(uint16_t sym, uint64_t ts, int32_t px,
+                              int32_t qty, EventType type, Side side,
+                              uint64_t order_id) {
+  const uint32_t i = hdr_->count;
+  ts_[i] = ts;
+  oid_[i] = order_id;
+  px_[i] = px;
+  qty_[i] = qty;
+  sym_[i] = sym;
+  type_[i] = type;
+  side_[i] = side;
+
+  if (i == 0) {
+    hdr_->min_ts = hdr_->max_ts = ts;
+  } else {
+    hdr_->min_ts = std::min(hdr_->min_ts, ts);
+    hdr_->max_ts = std::max(hdr_->max_ts, ts);
+  }
+  const uint32_t bit = sym % mcol::kBitmapBits;
+  hdr_->symbols[bit >> 6] |= 1ull << (bit & 63);
+  ++sym_events_[sym];
+
+  if (++hdr_->count == block_events_) seal_block();
+}
+
+uint16_t ColumnLogStorage::map_symbol(const SymbolTable& syms, uint16_t id) {
+  if (mapped_table_ != &syms) {
+    mapped_table_ = &syms;
+    id_map_.assign(syms.size(), kUnmapped);
+  }
+  if (id >= id_map_.size()) id_map_.resize(size_t(id) + 1, kUnmapped);
+
+  uint32_t& local = id_map_[id];
+  if (local == kUnmapped) {
+    local = symbols_.intern(syms.name(id), syms.tick_size(id));
+    if (sym_events_.size() < symbols_.size()) sym_events_.resize(symbols_.size());
+  }
+  return static_cast<uint16_t>(local);
+}
+
+void ColumnLogStorage::write(const Event& e) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  const uint16_t id = symbols_.intern(e.symbol);
+  if (sym_events_.size() < symbols_.size()) sym_events_.resize(symbols_.size());
+  append(id, e.ts_ns, symbols_.to_tick(id, e.price), e.qty, e.type, e.side,
+         e.order_id);
+}
+
+void ColumnLogStorage::write_batch(const EventBatch& b) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  for (size_t i = 0; i < b.size(); ++i) {
+    const uint16_t id = map_symbol(*b.symbols, b.symbol_id[i]);
+    append(id, b.ts_ns[i], b.price_tick[i], b.qty[i], b.type[i], b.side[i],
+           b.order_id[i]);
+  }
+}
+
+void ColumnLogStorage::flush() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  seal_block();
+  if (fp_) std::fflush(fp_);
+}
+
+void ColumnLogStorage::seal_block() {
+  if (hdr_->count == 0) return;
+
+  // Zero the unused tail of each column so partial blocks are deterministic.
+  const uint32_t n = hdr_->count;
+  const uint32_t rest = block_events_ - n;
+  if (rest) {
+    std::memset(ts_ + n, 0, rest * sizeof(*ts_));
+    std::memset(oid_ + n, 0, rest * sizeof(*oid_));
+    std::memset(px_ + n, 0, rest * sizeof(*px_));
+    std::memset(qty_ + n, 0, rest * sizeof(*qty_));
+    std::memset(sym_ + n, 0, rest * sizeof(*sym_));
+    std::memset(type_ + n, 0, rest * sizeof(*type_));
+    std::memset(side_ + n, 0, rest * sizeof(*side_));
+  }
+
+  write_all(fp_, block_.data(), block_.size());
+  index_.push_back(mcol::BlockIndex{offset_, *hdr_});
+  offset_ += block_bytes_;
+
+  hdr_->count = 0;
+  hdr_->min_ts = hdr_->max_ts = 0;
+  std::memset(hdr_->symbols, 0, sizeof(hdr_->symbols));
+}
+
+void ColumnLogStorage::write_footer() {
+  mcol::FooterHeader f{};
+  std::memcpy(f.magic, mcol::kFooterMagic, sizeof(f.magic));
+  f.n_blocks = index_.size();
+  f.n_symbols = static_cast<uint32_t>(symbols_.size());
+  f.min_ts = index_.empty() ? 0 : index_.front().header.min_ts;
+  for (const auto& bi : index_) {
+    f.n_events += bi.header.count;
+    f.min_ts = std::min(f.min_ts, bi.header.min_ts);
+    f.max_ts = std::max(f.max_ts, bi.header.max_ts);
+  }
+
+  write_all(fp_, &f, sizeof(f));
+  if (!index_.empty())
+    write_all(fp_, index_.data(), index_.size() * sizeof(mcol::BlockIndex));
+
+  std::vector<uint8_t> syms;
+  for (uint16_t id = 0; id < symbols_.size(); ++id) {
+    const std::string& name = symbols_.name(id);
+    const double tick = symbols_.tick_size(id);
+    const uint64_t events = sym_events_[id];
+    const uint16_t len = static_cast<uint16_t>(name.size());
+    const size_t off = syms.size();
+    syms.resize(off + sizeof(tick) + sizeof(events) + sizeof(len) + len);
+    uint8_t* p = syms.data() + off;
+    std::memcpy(p, &tick, sizeof(tick));
+    std::memcpy(p + 8, &events, sizeof(events));
+    std::memcpy(p + 16, &len, sizeof(len));
+    std::memcpy(p + 18, name.data(), len);
+  }
+  if (!syms.empty()) write_all(fp_, syms.data(), syms.size());
+
+  mcol::Trailer t{};
+  t.footer_offset = offset_;
+  std::memcpy(t.magic, mcol::kEndMagic, sizeof(t.magic));
+  write_all(fp_, &t, sizeof(t));
+  std::fflush(fp_);
+}
+
+// ── ColumnLogReader ──────────────────────────────────────────────
+
+ColumnLogReader::ColumnLogReader(const std::string& path)
+    : file_(path, "column log"), base_(file_.data()), size_(file_.size()) {
+  parse_footer();
+}
+
+ColumnLogReader::~ColumnLogReader() = default;
+
+void ColumnLogReader::parse_footer() {
+  if (size_ < sizeof(mcol::FileHeader) + sizeof(mcol::Trailer))
+    throw std::runtime_error("column log truncated");
+
+  mcol::FileHeader fh;
+  std::memcpy(&fh, base_, sizeof(fh));
+  if (std::memcmp(fh.magic, mcol::kFileMagic, sizeof(fh.magic)) != 0)
+    throw std::runtime_error("not a column log (bad magic)");
+  if (fh.version != mcol::kVersion)
+    throw std::runtime_error("unsupported column log version");
+  if (fh.block_events == 0 || fh.block_bytes != mcol::block_bytes(fh.block_events))
+    throw std::runtime_error("column log header corrupt");
+  block_events_ = fh.block_events;
+
+  mcol::Trailer t;
+  std::memcpy(&t, base_ + size_ - sizeof(t), sizeof(t));
+  if (std::memcmp(t.magic, mcol::kEndMagic, sizeof(t.magic)) != 0)
+    throw std::runtime_error("column log has no footer (writer not closed?)");
+  if (t.footer_offset < sizeof(fh) ||
+      t.footer_offset + sizeof(mcol::FooterHeader) > size_ - sizeof(t))
+    throw std::runtime_error("column log footer offset out of range");
+
+  // Blocks are 64-byte aligned and the footer follows them, so the footer
+  // and index can be used in place.
+  footer_ = reinterpret_cast<const mcol::FooterHeader*>(base_ + t.footer_offset);
+  if (std::memcmp(footer_->magic, mcol::kFooterMagic, sizeof(footer_->magic)) != 0)
+    throw std::runtime_error("column log footer corrupt");
+
+  n_blocks_ = static_cast<size_t>(footer_->n_blocks);
+  const size_t idx_off = t.footer_offset + sizeof(mcol::FooterHeader);
+  const size_t sym_off = idx_off + n_blocks_ * sizeof(mcol::BlockIndex);
+  if (sym_off > size_ - sizeof(t))
+    throw std::runtime_error("column log index truncated");
+  index_ = reinterpret_cast<const mcol::BlockIndex*>(base_ + idx_off);
+  for (size_t i = 0; i < n_blocks_; ++i)
+    if (index_[i].offset + fh.block_bytes > t.footer_offset ||
+        index_[i].header.count > block_events_)
+      throw std::runtime_error("column log index corrupt");
+
+  const uint8_t* p = base_ + sym_off;
+  const uint8_t* end = base_ + size_ - sizeof(t);
+  for (uint32_t i = 0; i < footer_->n_symbols; ++i) {
+    double tick;
+    uint64_t events;
+    uint16_t len;
+    if (end - p < 18) throw std::runtime_error("column log symbols truncated");
+    std::memcpy(&tick, p, sizeof(tick));
+    std::memcpy(&events, p + 8, sizeof(events));
+    std::memcpy(&len, p + 16, sizeof(len));
+    p += 18;
+    if (end - p < len) throw std::runtime_error("column log symbols truncated");
+    symbols_.intern(std::string(reinterpret_cast<const char*>(p), len), tick);
+    sym_events_.push_back(events);
+    p += len;
+  }
+}
+
+ColumnBlockView ColumnLogReader::block(size_t i) const {
+  const mcol::BlockIndex& bi = index_[i];
+  const uint8_t* b = base_ + bi.offset;
+  const ColumnLayout l(block_events_);
+  return ColumnBlockView{
+      &bi.header,
+      bi.header.count,
+      reinterpret_cast<const uint64_t*>(b + l.ts),
+      reinterpret_cast<const uint64_t*>(b + l.oid),
+      reinterpret_cast<const int32_t*>(b + l.px),
+      reinterpret_cast<const int32_t*>(b + l.qty),
+      reinterpret_cast<const uint16_t*>(b + l.sym),
+      reinterpret_cast<const EventType*>(b + l.type),
+      reinterpret_cast<const Side*>(b + l.side),
+  };
+}
+
+size_t ColumnLogReader::scan_blocks(const ColumnQuery& q,
+                                    const BlockSink& sink) const {
+  size_t visited = 0;
+  for (size_t i = 0; i < n_blocks_; ++i) {
+    const mcol::BlockHeader& h = index_[i].header;
+    if (!h.overlaps(q.ts_from, q.ts_to)) continue;
+    if (q.symbol && !h.may_contain(*q.symbol)) continue;
+    ++visited;
+    if (!sink(block(i))) break;
+  }
+  return visited;
+}
+
+size_t ColumnLogReader::read_batches(const ColumnQuery& q, EventBatch& batch,
+                                     const BatchSink& sink) const {
+  size_t delivered = 0;
+  bool stop = false;
+  batch.clear();
+
+  scan_blocks(q, [&](const ColumnBlockView& v) {
+    for (size_t i = 0; i < v.n; ++i) {
+      if (v.ts_ns[i] < q.ts_from || v.ts_ns[i] > q.ts_to) continue;
+      if (q.symbol && v.symbol_id[i] != *q.symbol) continue;
+      batch.push(CompactEvent{v.ts_ns[i], v.price_tick[i], v.qty[i],
+                              v.symbol_id[i], v.type[i], v.side[i],
+                              v.order_id[i]});
+      ++delivered;
+      if (batch.full()) {
+        stop = !sink(batch);
+        batch.clear();
+        if (stop) return false;
+      }
+    }
+    return true;
+  });
+
+  if (!stop && !batch.empty()) {
+    sink(batch);
+    batch.clear();
+  }
+  return delivered;
+}
+
+}  // namespace msim
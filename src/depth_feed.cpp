@@ -0,0 +1,93 @@
+#include "msim/depth_feed.hpp"
+
+#include <algorithm>
+
+namespace msim {
+
+DepthFeed::DepthFeed(IOrderBook& book, std::size_t levels,
+                     uint64_t snapshot_every)
+    : book_(book), levels_(levels ? levels : 1),
+      snapshot_every_(snapshot_every) {
+  log_.reserve(64);
+  bids_.reserve(levels_ + 1);
+  asks_.reserve(levels_ + 1);
+  // Start from whatever is resting already.
+  book_.depth(Side::BUY, levels_, bids_);
+  book_.depth(Side::SELL, levels_, asks_);
+  book_.set_depth_log(&log_);
+}
+
+DepthFeed::~DepthFeed() { book_.set_depth_log(nullptr); }
+
+// Invariant: a view shorter than levels_ holds every level of its side,
+// except while a refill is pending for that side.
+void DepthFeed::apply(const DepthUpdate& u, std::vector<DepthUpdate>& out) {
+  auto& v = view(u.side);
+  const int32_t tick = u.level.tick;
+  auto it = std::find_if(v.begin(), v.end(),
+                         [&](const DepthLevel& l) { return l.tick == tick; });
+
+  if (it != v.end()) {
+    if (u.level.orders == 0) {
+      v.erase(it);
+      (u.side == Side::BUY ? refill_bid_ : refill_ask_) = true;
+    } else {
+      *it = u.level;
+    }
+    out.push_back(u);
+    return;
+  }
+  if (u.level.orders == 0) return;  // outside the view
+
+  if (v.size() >= levels_) {
+    if (!better(u.side, tick, v.back().tick)) return;
+    out.push_back({u.side, {v.back().tick, 0, 0}});  // pushed out
+    v.pop_back();
+  }
+  auto pos = std::find_if(v.begin(), v.end(), [&](const DepthLevel& l) {
+    return better(u.side, tick, l.tick);
+  });
+  v.insert(pos, u.level);
+  out.push_back(u);
+}
+
+// Re-reads the side from the book and reports the difference; only runs
+// after a level inside the view was removed.
+void DepthFeed::refill(Side s, std::vector<DepthUpdate>& out) {
+  auto& v = view(s);
+  book_.depth(s, levels_, scratch_);
+  for (const DepthLevel& l : v) {
+    const bool kept = std::any_of(
+        scratch_.begin(), scratch_.end(),
+        [&](const DepthLevel& n) { return n.tick == l.tick; });
+    if (!kept) out.push_back({s, {l.tick, 0, 0}});
+  }
+  for (const DepthLevel& n : scratch_) {
+    const bool same = std::any_of(v.begin(), v.end(), [&](const DepthLevel& l) {
+      return l.tick == n.tick && l.qty == n.qty && l.orders == n.orders;
+    });
+    if (!same) out.push_back({s, n});
+  }
+  v.swap(scratch_);
+}
+
+bool DepthFeed::update(std::vector<DepthUpdate>& out) {
+  for (const DepthUpdate& u : log_) apply(u, out);
+  log_.clear();
+
+  if (refill_bid_) refill(Side::BUY, out);
+  if (refill_ask_) refill(Side::SELL, out);
+  refill_bid_ = refill_ask_ = false;
+
+  if (snapshot_every_ == 0 || ++since_snapshot_ < snapshot_every_)
+    return false;
+  since_snapshot_ = 0;
+  return true;
+}
+
+void DepthFeed::snapshot(std::vector<DepthUpdate>& out) const {
+  for (const DepthLevel& l : bids_) out.push_back({Side::BUY, l});
+  for (const DepthLevel& l : asks_) out.push_back({Side::SELL, l});
+}
+
+}  // namespace msim
@@ -0,0 +1,418 @@
+#include "msim/grpc_exporter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <type_traits>
+
+namespace msim {
+
+// ─────────────── Stream ───────────────
+
+GrpcExporter::StreamBase::StreamBase(GrpcExporter& owner,
+                                     std::shared_ptr<grpc::Channel> channel)
+    : owner_(owner),
+      channel_(std::move(channel)),
+      stub_(rpc::MarketStream::NewStub(channel_)) {}
+
+// The reactor for one call; `Msg` picks the RPC and the Pending member.
+template <typename Msg>
+class GrpcExporter::Stream final : public StreamBase,
+                                   public grpc::ClientWriteReactor<Msg> {
+ public:
+  using StreamBase::StreamBase;
+
+  void start() override {
+    if constexpr (std::is_same_v<Msg, rpc::PackedBatch>)
+      stub_->async()->PublishPacked(&context_, &ack_, this);
+    else
+      stub_->async()->Publish(&context_, &ack_, this);
+    // Writes are started from the exporter thread, outside any reaction, so
+    // hold the call open until finish() says no more are coming.
+    this->AddHold();
+    this->StartCall();
+  }
+
+  void OnWriteDone(bool ok) override { on_write_done(ok); }
+  void OnDone(const grpc::Status& status) override { on_done(status); }
+
+ private:
+  void write(Pending& b) override {
+    if constexpr (std::is_same_v<Msg, rpc::PackedBatch>)
+      this->StartWrite(&b.packed);
+    else
+      this->StartWrite(&b.rows);
+  }
+  void writes_done() override { this->StartWritesDone(); }
+  void remove_hold() override { this->RemoveHold(); }
+};
+
+void GrpcExporter::StreamBase::take_next_locked() {
+  current_ = std::move(queue_.front());
+  queue_.pop_front();
+}
+
+bool GrpcExporter::StreamBase::offer(Pending&& b) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (failed_) return false;
+    queue_.push_back(std::move(b));
+    if (writing_) return true;  // on_write_done() picks it up
+    writing_ = true;
+    take_next_locked();
+  }
+  // Outside mu_: a reaction may run inline and take it.
+  write(current_);
+  return true;
+}
+
+std::size_t GrpcExporter::StreamBase::drop_oldest() {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (queue_.empty()) return 0;
+  const std::size_t n = queue_.front().events;
+  queue_.pop_front();
+  return n;
+}
+
+std::size_t GrpcExporter::StreamBase::outstanding() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return queue_.size() + (writing_ ? 1 : 0);
+}
+
+bool GrpcExporter::StreamBase::healthy() const {
+  std::lock_guard<std::mutex> lk(mu_);
+  return !failed_;
+}
+
+void GrpcExporter::StreamBase::on_write_done(bool ok) {
+  bool next = false, half_close = false;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!ok) {
+      // The call is broken; on_done() carries the status. Everything that
+      // was waiting on this stream is lost.
+      std::size_t lost = current_.events;
+      for (const auto& b : queue_) lost += b.events;
+      queue_.clear();
+      owner_.queue_drops_.fetch_add(lost, std::memory_order_relaxed);
+      failed_ = true;
+      writing_ = false;
+    } else {
+      sent_.fetch_add(current_.events, std::memory_order_relaxed);
+      batches_.fetch_add(1, std::memory_order_relaxed);
+      bytes_.fetch_add(current_.bytes, std::memory_order_relaxed);
+      if (!queue_.empty()) {
+        take_next_locked();
+        next = true;
+      } else {
+        writing_ = false;
+        half_close = finishing_ && !writes_done_;
+        writes_done_ = writes_done_ || half_close;
+      }
+    }
+  }
+  owner_.notify_room();
+  if (next)
+    write(current_);
+  else if (half_close)
+    writes_done();
+}
+
+void GrpcExporter::StreamBase::on_done(const grpc::Status& status) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    status_ = status;
+    failed_ = failed_ || !status.ok();
+  }
+  owner_.notify_room();
+  // Last touch of `this`: once finish() sees done_ the stream may be
+  // destroyed, so notify under the lock and return.
+  std::lock_guard<std::mutex> lk(mu_);
+  done_ = true;
+  done_cv_.notify_all();
+}
+
+bool GrpcExporter::StreamBase::finish() {
+  bool half_close = false;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    finishing_ = true;
+    if (!writing_ && !writes_done_ && !failed_) {
+      writes_done_ = true;
+      half_close = true;
+    }
+  }
+  if (half_close) writes_done();
+  remove_hold();
+
+  std::unique_lock<std::mutex> lk(mu_);
+  if (!done_cv_.wait_for(lk, std::chrono::seconds(10),
+                         [this] { return done_; })) {
+    // Collector stopped reading; don't hang the simulator's shutdown.
+    lk.unlock();
+    context_.TryCancel();
+    lk.lock();
+    done_cv_.wait(lk, [this] { return done_; });
+  }
+  return !failed_;
+}
+
+// ─────────────── GrpcExporter ───────────────
+
+GrpcExporter::GrpcExporter(const std::string& target, std::size_t n_producers,
+                           const SymbolTable* symbols, ExportOptions opt)
+    : opt_(opt), symbols_(symbols), packer_(symbols) {
+  if (n_producers == 0) n_producers = 1;
+  opt_.streams = std::max<std::size_t>(opt_.streams, 1);
+  opt_.batch_events = std::max<std::size_t>(opt_.batch_events, 1);
+  opt_.max_queued = std::max<std::size_t>(opt_.max_queued, 1);
+  opt_.sample_every = std::max<uint32_t>(opt_.sample_every, 1);
+
+  producers_.reserve(n_producers);
+  for (std::size_t p = 0; p < n_producers; ++p)
+    producers_.push_back(std::make_unique<Producer>());
+
+  // A private subchannel pool per channel, so N channels are N connections
+  // rather than N handles on one shared HTTP/2 connection.
+  grpc::ChannelArguments args;
+  args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+  const auto deadline =
+      std::chrono::system_clock::now() + std::chrono::seconds(5);
+
+  // Negotiate per channel: packed only if every stream's collector takes
+  // it, so the exporter thread builds one kind of batch.
+  std::vector<std::shared_ptr<grpc::Channel>> channels;
+  bool packed = opt_.format != WireFormat::Rows;
+  for (std::size_t i = 0; i < opt_.streams; ++i) {
+    auto channel = grpc::CreateCustomChannel(
+        target, grpc::InsecureChannelCredentials(), args);
+    if (!channel->WaitForConnected(deadline))
+      throw std::runtime_error("gRPC: cannot connect to " + target);
+    if (packed && !supports_packed(channel)) {
+      if (opt_.format == WireFormat::Packed)
+        throw std::runtime_error("gRPC: collector at " + target +
+                                 " does not support PublishPacked");
+      packed = false;
+    }
+    channels.push_back(std::move(channel));
+  }
+  format_ = packed ? WireFormat::Packed : WireFormat::Rows;
+
+  streams_.reserve(channels.size());
+  for (auto& channel : channels) {
+    if (packed)
+      streams_.push_back(std::make_unique<Stream<rpc::PackedBatch>>(
+          *this, std::move(channel)));
+    else
+      streams_.push_back(std::make_unique<Stream<rpc::EventBatch>>(
+          *this, std::move(channel)));
+  }
+  for (auto& s : streams_) s->start();
+
+  thread_ = std::thread([this] { export_loop(); });
+}
+
+GrpcExporter::~GrpcExporter() {
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+bool GrpcExporter::supports_packed(
+    const std::shared_ptr<grpc::Channel>& channel) {
+  // An empty PublishPacked stream: an old collector answers UNIMPLEMENTED,
+  // a current one acks zero events.
+  auto stub = rpc::MarketStream::NewStub(channel);
+  grpc::ClientContext ctx;
+  ctx.set_deadline(std::chrono::system_clock::now() +
+                   std::chrono::seconds(5));
+  rpc::Ack ack;
+  auto writer = stub->PublishPacked(&ctx, &ack);
+  writer->WritesDone();
+  const grpc::Status status = writer->Finish();
+  if (status.ok()) return true;
+  if (status.error_code() == grpc::StatusCode::UNIMPLEMENTED) return false;
+  throw std::runtime_error("gRPC: format probe failed: " +
+                           status.error_message());
+}
+
+void GrpcExporter::notify_room() { room_cv_.notify_one(); }
+
+void GrpcExporter::begin(Pending& cur) {
+  cur = Pending{};
+  if (format_ == WireFormat::Packed) packer_.reset(&cur.packed);
+}
+
+void GrpcExporter::append(const CompactEvent& e, Pending& cur) {
+  if (sampling_ && sample_seq_++ % opt_.sample_every != 0) {
+    ++sampled_out_;
+    return;
+  }
+  if (format_ == WireFormat::Packed) {
+    packer_.add(e);
+    cur.bytes = packer_.bytes();
+  } else {
+    rpc::Event* ev = cur.rows.add_events();
+    EventConvert::to_proto(e, *symbols_, ev);
+    cur.bytes += ev->ByteSizeLong() + 2;  // + field tag and length prefix
+  }
+  ++cur.events;
+}
+
+GrpcExporter::StreamBase* GrpcExporter::least_loaded(
+    std::size_t& outstanding) {
+  StreamBase* best = nullptr;
+  const std::size_t n = streams_.size();
+  for (std::size_t k = 0; k < n; ++k) {
+    StreamBase* s = streams_[(rr_ + k) % n].get();
+    if (!s->healthy()) continue;
+    const std::size_t o = s->outstanding();
+    if (!best || o < outstanding) {
+      best = s;
+      outstanding = o;
+    }
+  }
+  rr_ = (rr_ + 1) % n;
+  return best;
+}
+
+void GrpcExporter::submit(Pending&& b) {
+  // The builder's running size is an estimate; count the real one.
+  if (format_ == WireFormat::Packed) b.bytes = b.packed.ByteSizeLong();
+  std::size_t outstanding = 0;
+  for (;;) {
+    StreamBase* s = least_loaded(outstanding);
+    if (!s) {  // every stream has failed
+      queue_drops_.fetch_add(b.events, std::memory_order_relaxed);
+      return;
+    }
+    if (outstanding < opt_.max_queued) {
+      if (s->offer(std::move(b))) break;
+      continue;  // failed since least_loaded()
+    }
+
+    if (opt_.overflow == OverflowPolicy::DropOldest) {
+      // Only the in-flight write is older than `b`: then `b` is the oldest
+      // batch not yet handed to gRPC.
+      const std::size_t n = s->drop_oldest();
+      queue_drops_.fetch_add(n ? n : b.events, std::memory_order_relaxed);
+      if (n) continue;
+      break;
+    }
+    if (opt_.overflow == OverflowPolicy::Sample) {
+      queue_drops_.fetch_add(b.events, std::memory_order_relaxed);
+      break;
+    }
+    // Block: wait for a write to complete. The timeout covers a wakeup
+    // that lands between least_loaded() and the wait.
+    std::unique_lock<std::mutex> lk(room_mu_);
+    room_cv_.wait_for(lk, std::chrono::milliseconds(1));
+  }
+
+  if (opt_.overflow == OverflowPolicy::Sample) {
+    least_loaded(outstanding);
+    sampling_ = outstanding * 2 >= opt_.max_queued;
+  }
+}
+
+void GrpcExporter::export_loop() {
+  std::vector<CompactEvent> rows(kDrainBatch);
+  Pending cur;
+  begin(cur);
+
+  for (;;) {
+    // Observe `closing_` before draining: once it is set every producer has
+    // finished, so an empty pass after that means the rings are drained.
+    const bool closing = closing_.load(std::memory_order_acquire);
+
+    std::size_t got = 0;
+    for (auto& p : producers_) {
+      const std::size_t n = p->ring.try_pop_bulk(rows.data(), rows.size());
+      got += n;
+      for (std::size_t i = 0; i < n; ++i) {
+        append(rows[i], cur);
+        if (cur.events >= opt_.batch_events ||
+            cur.bytes >= opt_.batch_bytes) {
+          submit(std::move(cur));
+          begin(cur);
+        }
+      }
+    }
+    if (got) continue;
+
+    // Idle: don't sit on a partial batch.
+    if (cur.events) {
+      submit(std::move(cur));
+      begin(cur);
+    }
+    if (closing && !any_pending()) break;
+    bell_.wait([&] {
+      return closing_.load(std::memory_order_acquire) || any_pending();
+    });
+  }
+}
+
+bool GrpcExporter::any_pending() const noexcept {
+  for (const auto& p : producers_)
+    if (!p->ring.empty()) return true;
+  return false;
+}
+
+bool GrpcExporter::close() {
+  if (closed_) return ok_;
+  closed_ = true;
+
+  closing_.store(true, std::memory_order_release);
+  bell_.ring();
+  if (thread_.joinable()) thread_.join();
+
+  for (auto& s : streams_) {
+    if (s->finish()) continue;
+    ok_ = false;
+    if (error_.empty()) error_ = s->status().error_message();
+  }
+  return ok_;
+}
+
+uint64_t GrpcExporter::sent() const noexcept {
+  uint64_t n = 0;
+  for (const auto& s : streams_) n += s->sent();
+  return n;
+}
+
+uint64_t GrpcExporter::acked() const noexcept {
+  uint64_t n = 0;
+  for (const auto& s : streams_) n += s->acked();
+  return n;
+}
+
+uint64_t GrpcExporter::batches() const noexcept {
+  uint64_t n = 0;
+  for (const auto& s : streams_) n += s->batches();
+  return n;
+}
+
+uint64_t GrpcExporter::bytes() const noexcept {
+  uint64_t n = 0;
+  for (const auto& s : streams_) n += s->bytes();
+  return n;
+}
+
+uint64_t GrpcExporter::ring_drops() const noexcept {
+  uint64_t n = 0;
+  for (const auto& p : producers_) n += p->ring_drops;
+  return n;
+}
+
+uint64_t GrpcExporter::dropped() const noexcept {
+  return ring_drops() + queue_drops() + sampled_out_;
+}
+
+uint64_t GrpcExporter::stalls() const noexcept {
+  uint64_t n = 0;
+  for (const auto& p : producers_) n += p->stalls;
+  return n;
+}
+
+}  // namespace msim
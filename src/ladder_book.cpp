@@ -0,0 +1,341 @@
+#include "msim/ladder_book.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace msim {
+
+static constexpr std::size_t kIndexCap = 16384;  // initial; grows past it
+using detail::kPrefetchAhead;
+using detail::NoFill;
+
+LadderOrderBook::LadderOrderBook(std::string symbol,
+                                 std::pmr::memory_resource* mr,
+                                 double tick_size, double ref_price)
+    : slots_(kSlots, nullptr, mr),
+      index_(mr, kIndexCap, /*allow_grow=*/true),
+      pool_(mr),
+      free_levels_(mr),
+      symbol_(std::move(symbol)),
+      mr_(mr),
+      tick_size_(tick_size),
+      inv_tick_(1.0 / tick_size) {
+  if (!(tick_size_ > 0.0)) std::abort();
+  base_tick_ = price_to_tick(ref_price) - int32_t(kSlots / 2);
+  free_levels_.reserve(256);
+}
+
+LadderOrderBook::~LadderOrderBook() {
+  std::pmr::polymorphic_allocator<Level> a(mr_);
+  for (Level* lvl : slots_)
+    if (lvl) a.deallocate(lvl, 1);
+  for (Level* lvl : free_levels_) a.deallocate(lvl, 1);
+}
+
+int32_t LadderOrderBook::price_to_tick(double px) const noexcept {
+  return round_tick(px * inv_tick_);
+}
+
+void LadderOrderBook::refresh_best(Side side) noexcept {
+  const Occupancy& b = bits(side);
+  auto& best = (side == Side::BUY) ? best_bid_tick_ : best_ask_tick_;
+  if (b.empty()) {
+    best.reset();
+    return;
+  }
+  const uint32_t s = (side == Side::BUY) ? b.highest() : b.lowest();
+  best = base_tick_ + int32_t(s);
+}
+
+void LadderOrderBook::release_level(Side side, uint32_t slot, Level* lvl) {
+  slots_[slot] = nullptr;
+  bits(side).clear(slot);
+  free_levels_.push_back(lvl);
+
+  const auto& best = (side == Side::BUY) ? best_bid_tick_ : best_ask_tick_;
+  if (best && *best == lvl->tick) refresh_best(side);
+}
+
+template <class OnFill>
+int LadderOrderBook::match(Side aggressor, int32_t limit, int remaining,
+                           int32_t& trade_tick, OnFill&& on_fill) {
+  const Side passive = (aggressor == Side::BUY) ? Side::SELL : Side::BUY;
+  auto& best = (passive == Side::SELL) ? best_ask_tick_ : best_bid_tick_;
+
+  auto crosses = [&](int32_t t) {
+    return aggressor == Side::BUY ? t <= limit : t >= limit;
+  };
+
+  while (remaining > 0 && best && crosses(*best)) {
+    const uint32_t slot = slot_of(*best);
+    Level* lvl = slots_[slot];
+    trade_tick = lvl->tick;
+
+    while (remaining > 0 && !lvl->empty()) {
+      OrderNode* top = lvl->front();
+      const int traded = std::min(remaining, top->o.qty);
+      remaining -= traded;
+      on_fill(top->o, lvl->tick, traded);
+      lvl->fill(top, traded);
+
+      if (top->o.qty == 0) {
+        index_.erase(top->o.id);
+        lvl->pop_front();
+        pool_.release(top);
+      }
+    }
+
+    note_level(passive, lvl->tick, *lvl);
+    if (lvl->empty()) release_level(passive, slot, lvl);
+  }
+  return remaining;
+}
+
+bool LadderOrderBook::recentre(int32_t tick) {
+  int64_t lo = tick, hi = tick;
+  for (const Occupancy* b : {&bid_bits_, &ask_bits_}) {
+    if (b->empty()) continue;
+    lo = std::min<int64_t>(lo, base_tick_ + int64_t(b->lowest()));
+    hi = std::max<int64_t>(hi, base_tick_ + int64_t(b->highest()));
+  }
+  const int64_t span = hi - lo + 1;
+  if (span > int64_t(kSlots)) return false;
+
+  // Rare path: collect live levels, then re-seat them around the new base.
+  std::vector<std::pair<Level*, Side>> live;
+  for (uint32_t s = 0; s < kSlots; ++s) {
+    if (!slots_[s]) continue;
+    live.emplace_back(slots_[s], bid_bits_.test(s) ? Side::BUY : Side::SELL);
+    slots_[s] = nullptr;
+  }
+  bid_bits_ = Occupancy{};
+  ask_bits_ = Occupancy{};
+
+  base_tick_ = static_cast<int32_t>(lo - (int64_t(kSlots) - span) / 2);
+  for (auto& [lvl, side] : live) {
+    const uint32_t s = slot_of(lvl->tick);
+    slots_[s] = lvl;
+    bits(side).set(s);
+  }
+  return true;
+}
+
+bool LadderOrderBook::rest(const Order& o, int32_t tick, int remaining) {
+  if (!in_window(tick) && !recentre(tick)) {
+    ++rejected_;
+    return false;
+  }
+
+  const uint32_t slot = slot_of(tick);
+  Level* lvl = slots_[slot];
+  if (!lvl) {
+    if (!free_levels_.empty()) {
+      lvl = free_levels_.back();
+      free_levels_.pop_back();
+      lvl->reset(tick);
+    } else {
+      std::pmr::polymorphic_allocator<Level> a(mr_);
+      lvl = a.allocate(1);
+      ::new (static_cast<void*>(lvl)) Level(tick);
+    }
+    slots_[slot] = lvl;
+    bits(o.side).set(slot);
+
+    if (o.side == Side::BUY) {
+      if (!best_bid_tick_ || tick > *best_bid_tick_) best_bid_tick_ = tick;
+    } else {
+      if (!best_ask_tick_ || tick < *best_ask_tick_) best_ask_tick_ = tick;
+    }
+  }
+
+  OrderNode* n = pool_.acquire(o);
+  n->o.qty = remaining;
+  lvl->push_back(n);
+  note_level(o.side, tick, *lvl);
+
+  if (!index_.insert(o.id, n)) std::abort();
+  return true;
+}
+
+int LadderOrderBook::add_order(const Order& o, int32_t& trade_tick,
+                               OrderType type) {
+  return add_impl(o, trade_tick, type, NoFill{});
+}
+
+template <class OnFill>
+int LadderOrderBook::add_impl(const Order& o, int32_t& trade_tick,
+                              OrderType type, OnFill&& on_fill) {
+  // Market orders take any price; everything else stops at its limit.
+  constexpr int32_t kAnyAsk = std::numeric_limits<int32_t>::max();
+  constexpr int32_t kAnyBid = std::numeric_limits<int32_t>::min();
+  const int32_t tick = type != OrderType::Market ? o.tick
+                       : o.side == Side::BUY     ? kAnyAsk
+                                                 : kAnyBid;
+
+  if (type == OrderType::PostOnly || type == OrderType::FOK) {
+    const bool crosses = o.side == Side::BUY
+                             ? best_ask_tick_ && *best_ask_tick_ <= tick
+                             : best_bid_tick_ && *best_bid_tick_ >= tick;
+    const bool kill = type == OrderType::PostOnly
+                          ? crosses
+                          : !crosses || fillable(o.side, tick, o.qty) < o.qty;
+    if (kill) return 0;
+  }
+
+  const int remaining = match(o.side, tick, o.qty, trade_tick, on_fill);
+  if (remaining > 0 && rests(type) && !rest(o, tick, remaining))
+    return add_rejected(o.qty - remaining);
+  return o.qty - remaining;
+}
+
+int64_t LadderOrderBook::fillable(Side taker, int32_t limit,
+                                  int64_t need) const {
+  const Occupancy& b = taker == Side::BUY ? ask_bits_ : bid_bits_;
+  int64_t have = 0;
+  // Same best-first walk as depth(): asks up from the lowest slot, bids
+  // down from the highest, stopping at the limit.
+  if (taker == Side::BUY) {
+    for (uint64_t sum = b.summary; sum && have < need; sum &= sum - 1) {
+      const uint32_t wi = detail::ctz64(sum);
+      for (uint64_t w = b.words[wi]; w && have < need; w &= w - 1) {
+        const Level* lvl = slots_[(wi << 6) | detail::ctz64(w)];
+        if (lvl->tick > limit) return have;
+        have += lvl->qty;
+      }
+    }
+  } else {
+    for (uint64_t sum = b.summary; sum && have < need;) {
+      const uint32_t wi = detail::msb64(sum);
+      sum &= ~(1ull << wi);
+      for (uint64_t w = b.words[wi]; w && have < need;) {
+        const uint32_t bit = detail::msb64(w);
+        w &= ~(1ull << bit);
+        const Level* lvl = slots_[(wi << 6) | bit];
+        if (lvl->tick < limit) return have;
+        have += lvl->qty;
+      }
+    }
+  }
+  return have;
+}
+
+bool LadderOrderBook::cancel_order(uint64_t order_id) {
+  auto ref = index_.find_ptr(order_id);
+  if (!ref) return false;
+
+  OrderNode* n = *ref;
+  index_.erase(order_id);
+
+  Level* lvl = static_cast<Level*>(n->queue);
+  const Side side = n->o.side;
+  lvl->erase(n);
+  pool_.release(n);
+  note_level(side, lvl->tick, *lvl);
+  if (lvl->empty()) release_level(side, slot_of(lvl->tick), lvl);
+  return true;
+}
+
+void LadderOrderBook::apply(const BookCommand* cmds, std::size_t n,
+                            std::vector<Fill>& fills, int32_t* results) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i + kPrefetchAhead < n) {
+      // A cancel will look up its id; an add may insert its id and rest at
+      // its own tick. Best prices come from the bitsets, so there is
+      // nothing to defer past a cancel.
+      const BookCommand& ahead = cmds[i + kPrefetchAhead];
+      index_.prefetch(ahead.order.id);
+      if (ahead.op == BookOp::Add && in_window(ahead.order.tick))
+        detail::prefetch(&slots_[slot_of(ahead.order.tick)]);
+    }
+
+    const BookCommand& c = cmds[i];
+    int32_t r;
+    if (c.op == BookOp::Cancel) {
+      r = cancel_order(c.order.id) ? 1 : 0;
+    } else {
+      int32_t trade_tick = 0;
+      r = add_impl(c.order, trade_tick, c.type,
+                   [&](const Order& maker, int32_t tick, int qty) {
+                     fills.push_back({c.order.id, maker.id, tick, qty,
+                                      uint32_t(i), c.order.side});
+                   });
+    }
+    if (results) results[i] = r;
+  }
+}
+
+std::optional<double> LadderOrderBook::best_bid() const {
+  if (!best_bid_tick_) return std::nullopt;
+  return tick_to_price(*best_bid_tick_);
+}
+
+std::optional<double> LadderOrderBook::best_ask() const {
+  if (!best_ask_tick_) return std::nullopt;
+  return tick_to_price(*best_ask_tick_);
+}
+
+uint64_t LadderOrderBook::state_checksum() const {
+  BookDigest d;
+  // The window is ordered by tick: bids walk down from the top, asks up.
+  for (uint32_t s = kSlots; s-- > 0;) {
+    const Level* lvl = slots_[s];
+    if (!lvl || !bid_bits_.test(s)) continue;
+    d.level(Side::BUY, lvl->tick);
+    for (const OrderNode* n = lvl->front(); n; n = n->next)
+      d.order(n->o.id, n->o.qty);
+  }
+  for (uint32_t s = 0; s < kSlots; ++s) {
+    const Level* lvl = slots_[s];
+    if (!lvl || !ask_bits_.test(s)) continue;
+    d.level(Side::SELL, lvl->tick);
+    for (const OrderNode* n = lvl->front(); n; n = n->next)
+      d.order(n->o.id, n->o.qty);
+  }
+  return d.value();
+}
+
+void LadderOrderBook::resting_orders(std::vector<Order>& out) const {
+  for (uint32_t s = kSlots; s-- > 0;)
+    if (slots_[s] && bid_bits_.test(s))
+      for (const OrderNode* n = slots_[s]->front(); n; n = n->next)
+        out.push_back(n->o);
+  for (uint32_t s = 0; s < kSlots; ++s)
+    if (slots_[s] && ask_bits_.test(s))
+      for (const OrderNode* n = slots_[s]->front(); n; n = n->next)
+        out.push_back(n->o);
+}
+
+void LadderOrderBook::depth(Side side, std::size_t n,
+                            std::vector<DepthLevel>& out) const {
+  out.clear();
+  const Occupancy& b = (side == Side::BUY) ? bid_bits_ : ask_bits_;
+  auto take = [&](uint32_t s) {
+    const Level* lvl = slots_[s];
+    out.push_back({lvl->tick, lvl->qty, lvl->count});
+  };
+  // Walk the occupancy words outward from the best slot, skipping empty
+  // words via the summary bits.
+  if (side == Side::BUY) {
+    for (uint64_t sum = b.summary; sum && out.size() < n;) {
+      const uint32_t wi = detail::msb64(sum);
+      sum &= ~(1ull << wi);
+      for (uint64_t w = b.words[wi]; w && out.size() < n;) {
+        const uint32_t bit = detail::msb64(w);
+        w &= ~(1ull << bit);
+        take((wi << 6) | bit);
+      }
+    }
+  } else {
+    for (uint64_t sum = b.summary; sum && out.size() < n; sum &= sum - 1) {
+      const uint32_t wi = detail::ctz64(sum);
+      for (uint64_t w = b.words[wi]; w && out.size() < n; w &= w - 1)
+        take((wi << 6) | detail::ctz64(w));
+    }
+  }
+}
+
+}  // namespace msim
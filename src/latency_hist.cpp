@@ -0,0 +1,64 @@
+#include "msim/latency_hist.hpp"
+
+#include <cmath>
+
+namespace msim {
+
+double LatencyClock::Calibration::ns_per_tick() const noexcept {
+#ifdef MSIM_HAVE_RDTSC
+  const uint64_t ticks = now() - tick0;
+  const double ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - t0)
+                        .count();
+  return ticks ? ns / double(ticks) : 1.0;
+#else
+  return 1.0;  // already ns
+#endif
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+  for (size_t b = 0; b < kBuckets; ++b) counts_[b] += other.counts_[b];
+  count_ += other.count_;
+  if (other.max_ > max_) max_ = other.max_;
+}
+
+uint64_t LatencyHistogram::bucket_high(size_t b) noexcept {
+  if (b < kSub) return b;
+  const unsigned shift = unsigned(b / kSub) - 1;
+  const uint64_t low = (uint64_t(kSub) + (b % kSub)) << shift;
+  return low + ((uint64_t(1) << shift) - 1);
+}
+
+uint64_t LatencyHistogram::quantile(double q) const noexcept {
+  if (count_ == 0) return 0;
+  // Rank of the q-quantile, 1-based: the smallest value with at least
+  // ceil(q * count) samples at or below it.
+  uint64_t rank = uint64_t(std::ceil(q * double(count_)));
+  if (rank == 0) rank = 1;
+  uint64_t seen = 0;
+  for (size_t b = 0; b < kBuckets; ++b) {
+    seen += counts_[b];
+    if (seen >= rank) {
+      const uint64_t hi = bucket_high(b);
+      return hi < max_ ? hi : max_;
+    }
+  }
+  return max_;
+}
+
+void OpLatency::print(std::ostream& os, double ns_per_tick) const {
+  auto ns = [ns_per_tick](uint64_t ticks) {
+    return uint64_t(std::llround(double(ticks) * ns_per_tick));
+  };
+  auto line = [&](const char* name, const LatencyHistogram& h) {
+    os << "Latency " << name << ": count=" << h.count()
+       << " p50=" << ns(h.quantile(0.50)) << " p99=" << ns(h.quantile(0.99))
+       << " p99.9=" << ns(h.quantile(0.999)) << " max=" << ns(h.max())
+       << " (ns)\n";
+  };
+  line("add", add);
+  line("fill", fill);
+  line("cancel", cancel);
+}
+
+}  // namespace msim
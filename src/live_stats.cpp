@@ -0,0 +1,64 @@
+#include "msim/live_stats.hpp"
+
+#include <cstdio>
+
+namespace msim {
+
+LiveMonitor::LiveMonitor(const std::vector<LiveStats>& stats,
+                         uint64_t total_events,
+                         std::chrono::milliseconds period, std::ostream& out)
+    : stats_(stats), total_events_(total_events), period_(period), out_(out) {
+  thread_ = std::thread([this] { loop(); });
+}
+
+LiveMonitor::~LiveMonitor() { stop(); }
+
+LiveStats::Snapshot LiveMonitor::total() const noexcept {
+  LiveStats::Snapshot t;
+  for (const LiveStats& s : stats_) {
+    const LiveStats::Snapshot v = s.sample();
+    t.events += v.events;
+    t.adds += v.adds;
+    t.cancels += v.cancels;
+    t.trades += v.trades;
+  }
+  return t;
+}
+
+void LiveMonitor::loop() {
+  auto last = std::chrono::steady_clock::now();
+  uint64_t last_events = 0;
+  std::unique_lock<std::mutex> lk(mu_);
+  while (!cv_.wait_for(lk, period_, [this] { return stopping_; })) {
+    const auto now = std::chrono::steady_clock::now();
+    const double secs = std::chrono::duration<double>(now - last).count();
+    const LiveStats::Snapshot t = total();
+    const double pct =
+        total_events_ ? 100.0 * double(t.events) / double(total_events_) : 0;
+    const double evps =
+        secs > 0 ? double(t.events - last_events) / secs : 0.0;
+
+    char line[160];
+    std::snprintf(line, sizeof(line),
+                  "[progress] %llu / %llu events (%.1f%%), %.0f ev/s, "
+                  "adds=%llu cancels=%llu trades=%llu\n",
+                  (unsigned long long)t.events,
+                  (unsigned long long)total_events_, pct, evps,
+                  (unsigned long long)t.adds, (unsigned long long)t.cancels,
+                  (unsigned long long)t.trades);
+    out_ << line << std::flush;
+    last = now;
+    last_events = t.events;
+  }
+}
+
+void LiveMonitor::stop() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+}  // namespace msim
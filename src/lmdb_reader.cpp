@@ -1,79 +1,402 @@
 #include "msim/lmdb_reader.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
+#include "msim/lmdb_storage.hpp"
+
+namespace fs = std::filesystem;
 namespace msim {
 
-LMDBReader::LMDBReader(const std::string& path) {
-  int rc = mdb_env_create(&env_);
+// Cursor over one DBI plus the next in-range view it will deliver.
+struct LMDBReader::Scan {
+  MDB_env* env = nullptr;
+  size_t shard = 0;
+  MDB_dbi dbi = 0;
+  MDB_cursor* cursor = nullptr;
+  bool ordered = false;  // MDB_INTEGERKEY: key order == ts order
+  bool valid = false;    // `cur` holds the next view
+  double tick_size = 0.01;  // the symbol's; resolves cur's price fields
+  EventView cur{};
+
+  // Moves to the next view with ts in [ts_from, ts_to] (`op` is the first
+  // cursor op); clears `valid` at the end of the range.
+  void advance(MDB_cursor_op op, uint64_t ts_from, uint64_t ts_to) {
+    MDB_val key, val;
+    if (op == MDB_SET_RANGE) {
+      key.mv_size = sizeof(ts_from);
+      key.mv_data = &ts_from;
+    }
+    valid = false;
+    for (; mdb_cursor_get(cursor, &key, &val, op) == 0; op = MDB_NEXT) {
+      size_t consumed = 0;
+      auto v = EventView::parse(static_cast<const uint8_t*>(val.mv_data),
+                                val.mv_size, consumed);
+      if (!v) continue;
+      if (v->ts_ns > ts_to) {
+        if (ordered) return;
+        continue;
+      }
+      if (v->ts_ns < ts_from) continue;
+      cur = *v;
+      cur.resolve(tick_size);
+      valid = true;
+      return;
+    }
+  }
+
+  // Closes the DBI too unless `env` is null (a shared, exported handle).
+  void close() noexcept {
+    if (cursor) mdb_cursor_close(cursor);
+    if (env) mdb_dbi_close(env, dbi);
+    cursor = nullptr;
+    env = nullptr;
+  }
+};
+
+LMDBReader::Shard LMDBReader::open_shard(const std::string& path) {
+  Shard sh;
+  int rc = mdb_env_create(&sh.env);
   if (rc)
     throw std::runtime_error("mdb_env_create failed: " + std::to_string(rc));
 
   // Allow many DBIs (important when you have one per symbol)
-  mdb_env_set_maxdbs(env_, 64);
+  mdb_env_set_maxdbs(sh.env, 64);
 
-  rc = mdb_env_open(env_, path.c_str(), MDB_RDONLY, 0664);
-  if (rc)
-    throw std::runtime_error("mdb_env_open failed: " + std::to_string(rc));
+  // MDB_NOTLS: for_each_parallel() opens more read txns on a thread that
+  // already holds this one.
+  rc = mdb_env_open(sh.env, path.c_str(), MDB_RDONLY | MDB_NOTLS, 0664);
+  if (rc) {
+    mdb_env_close(sh.env);
+    throw std::runtime_error("mdb_env_open failed: " + std::to_string(rc) +
+                             " path=" + path);
+  }
 
   // Start a read txn and open unnamed meta DB to ensure sub-DB visibility
-  rc = mdb_txn_begin(env_, nullptr, MDB_RDONLY, &txn_);
-  if (rc)
+  rc = mdb_txn_begin(sh.env, nullptr, MDB_RDONLY, &sh.txn);
+  if (rc) {
+    mdb_env_close(sh.env);
     throw std::runtime_error("mdb_txn_begin failed: " + std::to_string(rc));
+  }
 
   // Important: open unnamed meta-DB once to populate handles
   MDB_dbi main_dbi;
-  rc = mdb_dbi_open(txn_, nullptr, 0, &main_dbi);
-  if (rc)
+  rc = mdb_dbi_open(sh.txn, nullptr, 0, &main_dbi);
+  if (rc) {
+    mdb_txn_abort(sh.txn);
+    mdb_env_close(sh.env);
     throw std::runtime_error("mdb_dbi_open meta failed: " + std::to_string(rc));
-  mdb_dbi_close(env_, main_dbi);
+  }
+  mdb_dbi_close(sh.env, main_dbi);
+  return sh;
+}
+
+LMDBReader::LMDBReader(const std::string& path) {
+  const fs::path manifest = fs::path(path) / "shards";
+  size_t n_shards = 0;
+  if (fs::exists(manifest)) {
+    std::ifstream in(manifest);
+    if (!(in >> n_shards) || n_shards == 0)
+      throw std::runtime_error("bad shard manifest: " + manifest.string());
+  }
+
+  try {
+    if (n_shards == 0) {
+      shards_.push_back(open_shard(path));
+    } else {
+      shards_.reserve(n_shards);
+      for (size_t i = 0; i < n_shards; ++i)
+        shards_.push_back(
+            open_shard(ShardedLMDBStorage::shard_dir(path, i)));
+    }
+  } catch (...) {
+    for (auto& sh : shards_) {
+      mdb_txn_abort(sh.txn);
+      mdb_env_close(sh.env);
+    }
+    throw;
+  }
 }
 
 LMDBReader::~LMDBReader() {
-  if (txn_) mdb_txn_abort(txn_);
-  if (env_) mdb_env_close(env_);
+  for (auto& sh : shards_) {
+    if (sh.txn) mdb_txn_abort(sh.txn);
+    if (sh.env) mdb_env_close(sh.env);
+  }
+}
+
+bool LMDBReader::open_dbi(const Shard& sh, const std::string& symbol,
+                          MDB_dbi& dbi) {
+  const int rc = mdb_dbi_open(sh.txn, symbol.c_str(), 0, &dbi);
+  if (rc == MDB_NOTFOUND) return false;
+  if (rc) throw std::runtime_error("dbi open failed: " + symbol);
+  return true;
 }
 
 std::vector<Event> LMDBReader::read_all(const std::string& symbol) {
-  MDB_dbi dbi;
-  if (mdb_dbi_open(txn_, symbol.c_str(), 0, &dbi) != 0)
+  std::vector<Event> out;
+  for_each(symbol, [&](const EventView& v) {
+    out.push_back(v.to_event());
+    return true;
+  });
+  return out;
+}
+
+size_t LMDBReader::count(const std::string& symbol) {
+  size_t n = 0;
+  bool found = false;
+  for (const Shard& sh : shards_) {
+    MDB_dbi dbi;
+    if (!open_dbi(sh, symbol, dbi)) continue;
+    found = true;
+    MDB_stat st{};
+    int rc = mdb_stat(sh.txn, dbi, &st);
+    mdb_dbi_close(sh.env, dbi);
+    if (rc) throw std::runtime_error("mdb_stat failed: " + symbol);
+    n += st.ms_entries;
+  }
+  if (!found) throw std::runtime_error("dbi open failed: " + symbol);
+  return n;
+}
+
+void LMDBReader::add_scans(const std::string& symbol,
+                           std::vector<Scan>& scans) {
+  bool found = false;
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    const Shard& sh = shards_[i];
+    Scan s;
+    if (!open_dbi(sh, symbol, s.dbi)) continue;
+    found = true;
+    s.env = sh.env;
+    s.shard = i;
+    s.tick_size = symbols_.tick_size(symbols_.intern(symbol));
+
+    unsigned int flags = 0;
+    mdb_dbi_flags(sh.txn, s.dbi, &flags);
+    s.ordered = (flags & MDB_INTEGERKEY) != 0;
+
+    if (mdb_cursor_open(sh.txn, s.dbi, &s.cursor)) {
+      s.cursor = nullptr;
+      s.close();
+      for (auto& open : scans) open.close();
+      throw std::runtime_error("mdb_cursor_open failed: " + symbol);
+    }
+    scans.push_back(s);
+  }
+  if (!found) {
+    for (auto& open : scans) open.close();
     throw std::runtime_error("dbi open failed: " + symbol);
+  }
+}
 
-  MDB_cursor* cursor = nullptr;
-  mdb_cursor_open(txn_, dbi, &cursor);
+size_t LMDBReader::merge(std::vector<Scan>& scans, const ViewSink& sink,
+                         uint64_t ts_from, uint64_t ts_to) {
+  for (Scan& s : scans)
+    s.advance(s.ordered && ts_from > 0 ? MDB_SET_RANGE : MDB_NEXT, ts_from,
+              ts_to);
 
-  MDB_val key, val;
-  std::vector<Event> out;
+  // Shard counts are small (one per worker), so a linear pick of the
+  // smallest head beats maintaining a heap.
+  size_t delivered = 0;
+  for (;;) {
+    Scan* next = nullptr;
+    for (Scan& s : scans)
+      if (s.valid && (!next || s.cur.ts_ns < next->cur.ts_ns)) next = &s;
+    if (!next) break;
 
-  while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
-    size_t consumed = 0;
-    auto evt = Event::deserialize(static_cast<const uint8_t*>(val.mv_data),
-                                  val.mv_size, consumed);
-    if (evt) out.push_back(std::move(*evt));
+    ++delivered;
+    if (!sink(next->cur)) break;
+    next->advance(MDB_NEXT, ts_from, ts_to);
   }
 
-  mdb_cursor_close(cursor);
-  mdb_dbi_close(env_, dbi);
-  return out;
+  for (Scan& s : scans) s.close();
+  return delivered;
 }
 
-std::vector<std::string> LMDBReader::list_symbols() {
-  MDB_dbi dbi;
-  if (mdb_dbi_open(txn_, nullptr, 0, &dbi) != 0)
-    throw std::runtime_error("dbi_open failed for unnamed DB");
+size_t LMDBReader::for_each(const std::string& symbol, const ViewSink& sink,
+                            uint64_t ts_from, uint64_t ts_to) {
+  if (ts_from > ts_to) return 0;
+  std::vector<Scan> scans;
+  add_scans(symbol, scans);
+  return merge(scans, sink, ts_from, ts_to);
+}
 
-  MDB_cursor* cursor = nullptr;
-  mdb_cursor_open(txn_, dbi, &cursor);
+size_t LMDBReader::for_each_merged(const std::vector<std::string>& symbols,
+                                   const ViewSink& sink, uint64_t ts_from,
+                                   uint64_t ts_to) {
+  if (ts_from > ts_to) return 0;
+  // Shard-major, so equal timestamps resolve by shard, then symbol.
+  std::vector<Scan> scans;
+  for (const auto& sym : symbols) add_scans(sym, scans);
+  std::stable_sort(
+      scans.begin(), scans.end(),
+      [](const Scan& a, const Scan& b) { return a.shard < b.shard; });
+  return merge(scans, sink, ts_from, ts_to);
+}
 
-  MDB_val key, val;
+size_t LMDBReader::for_each_parallel(const std::vector<std::string>& symbols,
+                                     size_t n_threads,
+                                     const IndexedViewSink& sink,
+                                     uint64_t ts_from, uint64_t ts_to) {
+  if (ts_from > ts_to || symbols.empty()) return 0;
+
+  // DBI handles opened in a txn are private to it until it commits, and
+  // mdb_dbi_open must not run in concurrent txns, so open every handle here
+  // in one short read txn per shard and commit it; the workers' txns,
+  // begun afterwards, all see them.
+  struct Dbi {
+    size_t shard;
+    MDB_dbi dbi;
+    bool ordered;
+  };
+  std::vector<std::vector<Dbi>> dbis(symbols.size());
+  auto close_all = [&] {
+    for (const auto& per_symbol : dbis)
+      for (const Dbi& d : per_symbol) mdb_dbi_close(shards_[d.shard].env, d.dbi);
+  };
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    MDB_txn* txn = nullptr;
+    if (mdb_txn_begin(shards_[i].env, nullptr, MDB_RDONLY, &txn)) {
+      close_all();
+      throw std::runtime_error("mdb_txn_begin failed");
+    }
+    for (size_t s = 0; s < symbols.size(); ++s) {
+      Dbi d{i, 0, false};
+      const int rc = mdb_dbi_open(txn, symbols[s].c_str(), 0, &d.dbi);
+      if (rc == MDB_NOTFOUND) continue;
+      if (rc) {
+        mdb_txn_abort(txn);
+        close_all();
+        throw std::runtime_error("dbi open failed: " + symbols[s]);
+      }
+      unsigned int flags = 0;
+      mdb_dbi_flags(txn, d.dbi, &flags);
+      d.ordered = (flags & MDB_INTEGERKEY) != 0;
+      dbis[s].push_back(d);
+    }
+    if (mdb_txn_commit(txn)) {
+      close_all();
+      throw std::runtime_error("mdb_txn_commit failed");
+    }
+  }
+  std::vector<double> tick_sizes(symbols.size());
+  for (size_t s = 0; s < symbols.size(); ++s) {
+    if (dbis[s].empty()) {
+      close_all();
+      throw std::runtime_error("dbi open failed: " + symbols[s]);
+    }
+    tick_sizes[s] = symbols_.tick_size(symbols_.intern(symbols[s]));
+  }
+
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> delivered{0};
+  std::mutex error_mu;
+  std::exception_ptr error;
+  auto work = [&] {
+    std::vector<MDB_txn*> txns(shards_.size(), nullptr);
+    try {
+      for (size_t i = 0; i < shards_.size(); ++i)
+        if (mdb_txn_begin(shards_[i].env, nullptr, MDB_RDONLY, &txns[i]))
+          throw std::runtime_error("mdb_txn_begin failed");
+      for (size_t s; (s = next.fetch_add(1)) < symbols.size();) {
+        std::vector<Scan> scans;  // shard order, as for_each()
+        for (const Dbi& d : dbis[s]) {
+          Scan sc;
+          sc.shard = d.shard;
+          sc.dbi = d.dbi;
+          sc.ordered = d.ordered;
+          sc.tick_size = tick_sizes[s];
+          if (mdb_cursor_open(txns[d.shard], d.dbi, &sc.cursor)) {
+            for (auto& open : scans) open.close();
+            throw std::runtime_error("mdb_cursor_open failed: " +
+                                     symbols[s]);
+          }
+          scans.push_back(sc);
+        }
+        delivered += merge(
+            scans, [&](const EventView& v) { return sink(s, v); }, ts_from,
+            ts_to);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lk(error_mu);
+      if (!error) error = std::current_exception();
+      next = symbols.size();  // the others stop after their current symbol
+    }
+    for (MDB_txn* t : txns)
+      if (t) mdb_txn_abort(t);
+  };
+
+  const size_t n = std::max<size_t>(1, std::min(n_threads, symbols.size()));
+  std::vector<std::thread> workers;
+  workers.reserve(n);
+  for (size_t t = 0; t < n; ++t) workers.emplace_back(work);
+  for (auto& t : workers) t.join();
+
+  close_all();
+  if (error) std::rethrow_exception(error);
+  return delivered;
+}
+
+size_t LMDBReader::read_batches(const std::string& symbol, EventBatch& batch,
+                                const BatchSink& sink, uint64_t ts_from,
+                                uint64_t ts_to) {
+  const uint16_t id = symbols_.intern(symbol);
+  batch.symbols = &symbols_;
+  batch.clear();
+
+  size_t delivered = 0;
+  bool more = true;
+  for_each(
+      symbol,
+      [&](const EventView& v) {
+        batch.push(CompactEvent{v.ts_ns, v.price_tick, v.qty, id, v.type,
+                                v.side, v.order_id});
+        if (batch.full()) {
+          delivered += batch.size();
+          more = sink(batch);
+          batch.clear();
+        }
+        return more;
+      },
+      ts_from, ts_to);
+
+  if (more && !batch.empty()) {
+    delivered += batch.size();
+    sink(batch);
+  }
+  batch.clear();
+  return delivered;
+}
+
+std::vector<std::string> LMDBReader::list_symbols() {
   std::vector<std::string> names;
-  while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
-    names.emplace_back(static_cast<const char*>(key.mv_data), key.mv_size);
+  for (const Shard& sh : shards_) {
+    MDB_dbi dbi;
+    if (mdb_dbi_open(sh.txn, nullptr, 0, &dbi) != 0)
+      throw std::runtime_error("dbi_open failed for unnamed DB");
+
+    MDB_cursor* cursor = nullptr;
+    mdb_cursor_open(sh.txn, dbi, &cursor);
+
+    MDB_val key, val;
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0)
+      names.emplace_back(static_cast<const char*>(key.mv_data), key.mv_size);
+
+    mdb_cursor_close(cursor);
+    mdb_dbi_close(sh.env, dbi);
   }
 
-  mdb_cursor_close(cursor);
-  mdb_dbi_close(env_, dbi);
+  // Each shard's main DB is already sorted; only a merge needs this.
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+  for (const auto& n : names) symbols_.intern(n);
   return names;
 }
 
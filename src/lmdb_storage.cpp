@@ -1,5 +1,6 @@
 #include "msim/lmdb_storage.hpp"
 
+#include <cstdio>
 #include <cstring>
 #include <filesystem>
 #include <iostream>
@@ -7,25 +8,50 @@
 namespace fs = std::filesystem;
 namespace msim {
 
+// MDB_INTEGERKEY keys must be unsigned int or size_t sized.
+static_assert(sizeof(size_t) == sizeof(uint64_t),
+              "LMDB ts keys require a 64-bit size_t");
+
 LMDBStorage::LMDBStorage(const std::string& path, size_t map_size_bytes)
-    : path_(path) {
+    : LMDBStorage(path, [&] {
+        StorageOptions o;
+        o.lmdb_map_bytes = map_size_bytes;
+        return o;
+      }()) {}
+
+LMDBStorage::LMDBStorage(const std::string& path, const StorageOptions& opts)
+    : path_(path), opts_(opts) {
   fs::create_directories(path_);
 
   int rc = mdb_env_create(&env_);
   if (rc) throw std::runtime_error("mdb_env_create failed");
 
-  mdb_env_set_mapsize(env_, map_size_bytes);
+  unsigned int env_flags = 0;
+  switch (opts_.lmdb_durability) {
+    case LmdbDurability::Sync:
+      break;
+    case LmdbDurability::NoSync:
+      env_flags = MDB_NOSYNC;
+      break;
+    case LmdbDurability::WriteMap:
+      env_flags = MDB_NOSYNC | MDB_WRITEMAP;
+      break;
+  }
+
+  mdb_env_set_mapsize(env_, opts_.lmdb_map_bytes);
   mdb_env_set_maxdbs(env_, 64);
-  rc = mdb_env_open(env_, path_.c_str(), 0, 0);
+  rc = mdb_env_open(env_, path_.c_str(), env_flags, 0664);
   if (rc) {
     std::cerr << "[LMDBStorage] mdb_env_open failed (" << rc
               << "): " << mdb_strerror(rc) << " path=" << path_ << std::endl;
+    mdb_env_close(env_);
+    env_ = nullptr;
     throw std::runtime_error("mdb_env_open failed");
   }
 
-  // Begin first transaction
-  rc = mdb_txn_begin(env_, nullptr, 0, &txn_);
-  if (rc) throw std::runtime_error("mdb_txn_begin failed");
+  // The write txn is begun lazily on the first write(). LMDB ties a write txn
+  // to the thread that began it, so this lets a dedicated writer thread (see
+  // AsyncStorage) own the txn even though the env was opened elsewhere.
 }
 
 LMDBStorage::~LMDBStorage() {
@@ -33,6 +59,9 @@ LMDBStorage::~LMDBStorage() {
     flush();
   } catch (...) {
   }
+  if (append_fallbacks_)
+    std::cerr << "[LMDBStorage] " << append_fallbacks_
+              << " put(s) were out of key order (MDB_APPEND not used)\n";
   if (txn_) mdb_txn_abort(txn_);
   if (env_) mdb_env_close(env_);
 }
@@ -41,8 +70,10 @@ MDB_dbi LMDBStorage::dbi_for_symbol(const std::string& sym) {
   auto it = dbis_.find(sym);
   if (it != dbis_.end()) return it->second;
 
+  // Integer keys keep each DBI in timestamp order, so readers can seek to a
+  // ts with MDB_SET_RANGE. Existing DBIs keep the flags they were made with.
   MDB_dbi dbi;
-  int rc = mdb_dbi_open(txn_, sym.c_str(), MDB_CREATE, &dbi);
+  int rc = mdb_dbi_open(txn_, sym.c_str(), MDB_CREATE | MDB_INTEGERKEY, &dbi);
   if (rc)
     throw std::runtime_error("mdb_dbi_open failed: " +
                              std::string(mdb_strerror(rc)));
@@ -50,59 +81,174 @@ MDB_dbi LMDBStorage::dbi_for_symbol(const std::string& sym) {
   return dbi;
 }
 
+void LMDBStorage::begin_txn() {
+  int rc = mdb_txn_begin(env_, nullptr, 0, &txn_);
+  if (rc != MDB_SUCCESS) {
+    txn_ = nullptr;
+    throw std::runtime_error("mdb_txn_begin failed: " +
+                             std::string(mdb_strerror(rc)));
+  }
+}
+
 void LMDBStorage::commit_txn() {
   if (!txn_) return;
   int rc = mdb_txn_commit(txn_);
   if (rc != MDB_SUCCESS) {
     std::cerr << "LMDB commit failed: " << mdb_strerror(rc) << "\n";
-    mdb_txn_abort(txn_);  // ensure clean state
   }
 
+  // mdb_txn_commit frees the txn (and its cursors) even on failure; the
+  // next write() begins a fresh one on the calling thread.
   txn_ = nullptr;
-  batch_count_ = 0;
+  txn_bytes_ = 0;
+  cursors_.assign(cursors_.size(), nullptr);
+}
 
-  // Immediately start a fresh write txn for continuity
-  rc = mdb_txn_begin(env_, nullptr, 0, &txn_);  // restart txn
-  if (rc != MDB_SUCCESS) {
-    std::cerr << "[LMDBStorage] txn restart failed: " << mdb_strerror(rc)
-              << "\n";
-    txn_ = nullptr;  // mark unusable
+MDB_cursor* LMDBStorage::cursor_for(MDB_dbi dbi) {
+  if (dbi >= cursors_.size()) cursors_.resize(size_t(dbi) + 1, nullptr);
+  MDB_cursor*& c = cursors_[dbi];
+  if (!c) {
+    int rc = mdb_cursor_open(txn_, dbi, &c);
+    if (rc)
+      throw std::runtime_error("mdb_cursor_open failed: " +
+                               std::string(mdb_strerror(rc)));
   }
+  return c;
 }
 
-void LMDBStorage::write(const Event& e) {
-  // Serialize event into a linear byte buffer
-  std::vector<uint8_t> buf;
-  buf.reserve(e.serialized_size());
-  buf = e.serialize();
+MDB_dbi LMDBStorage::dbi_for_id(const SymbolTable& syms, uint16_t id) {
+  if (dbi_table_ != &syms) {
+    dbi_table_ = &syms;
+    dbi_by_id_.assign(syms.size(), 0);
+    dbi_by_id_set_.assign(syms.size(), false);
+  }
+  // The table may have grown since (a collector keeps interning into it).
+  if (id >= dbi_by_id_.size()) {
+    dbi_by_id_.resize(size_t(id) + 1, 0);
+    dbi_by_id_set_.resize(size_t(id) + 1, false);
+  }
+  if (!dbi_by_id_set_[id]) {
+    dbi_by_id_[id] = dbi_for_symbol(syms.name(id));
+    dbi_by_id_set_[id] = true;
+  }
+  return dbi_by_id_[id];
+}
 
-  // Prepare key = timestamp
+void LMDBStorage::put(MDB_dbi dbi, uint64_t ts_ns, const uint8_t* data,
+                      size_t len) {
+  // Prepare key = timestamp, value = serialized bytes
   MDB_val key, val;
-  key.mv_size = sizeof(e.ts_ns);
-  key.mv_data = const_cast<uint64_t*>(&e.ts_ns);
-
-  // Value = serialized bytes
-  val.mv_size = buf.size();
-  val.mv_data = buf.data();
-
-  // Open or reuse DBI for symbol
-  MDB_dbi dbi = dbi_for_symbol(e.symbol);
-  int rc = mdb_put(txn_, dbi, &key, &val, 0);
+  key.mv_size = sizeof(ts_ns);
+  key.mv_data = &ts_ns;
+  val.mv_size = len;
+  val.mv_data = const_cast<uint8_t*>(data);
+
+  MDB_cursor* c = cursor_for(dbi);
+  int rc = mdb_cursor_put(c, &key, &val, MDB_APPEND);
+  if (rc == MDB_KEYEXIST) {  // key <= last key of this DBI
+    ++append_fallbacks_;
+    rc = mdb_cursor_put(c, &key, &val, 0);
+  }
   if (rc) {
     std::cerr << "mdb_put failed: " << mdb_strerror(rc) << "\n";
   }
 
-  if (++batch_count_ >= batch_limit_) {
+  txn_bytes_ += key.mv_size + val.mv_size;
+  if (txn_bytes_ >= opts_.lmdb_txn_bytes) {
     commit_txn();
   }
 }
 
+void LMDBStorage::write(const Event& e) {
+  if (!txn_) begin_txn();
+
+  // Serialize event into a linear byte buffer
+  scratch_.resize(e.serialized_size());
+  Event::serialize_to(scratch_.data(), e.ts_ns, e.type, e.symbol, e.price,
+                      e.qty, e.side, e.order_id);
+
+  // Open or reuse DBI for symbol
+  MDB_dbi dbi = dbi_for_symbol(e.symbol);
+  put(dbi, e.ts_ns, scratch_.data(), scratch_.size());
+}
+
+void LMDBStorage::write_batch(const EventBatch& b) {
+  if (b.empty()) return;
+
+  // Counting sort of row indices by symbol id (stable, so each symbol's rows
+  // keep their ts order): every DBI then gets one contiguous append run.
+  const size_t n_syms = b.symbols->size();
+  group_start_.assign(n_syms + 1, 0);
+  for (size_t i = 0; i < b.size(); ++i) ++group_start_[b.symbol_id[i] + 1];
+  for (size_t s = 0; s < n_syms; ++s) group_start_[s + 1] += group_start_[s];
+  group_.resize(b.size());
+  for (size_t i = 0; i < b.size(); ++i)
+    group_[group_start_[b.symbol_id[i]]++] = static_cast<uint32_t>(i);
+
+  for (const uint32_t i : group_) {
+    if (!txn_) begin_txn();
+
+    const uint16_t id = b.symbol_id[i];
+    const std::string& sym = b.symbols->name(id);
+    scratch_.resize(Event::tick_serialized_size(sym.size()));
+    Event::serialize_tick_to(scratch_.data(), b.ts_ns[i], b.type[i], sym,
+                             b.price_tick[i], b.qty[i], b.side[i],
+                             b.order_id[i]);
+    put(dbi_for_id(*b.symbols, id), b.ts_ns[i], scratch_.data(),
+        scratch_.size());
+  }
+}
+
+void LMDBStorage::flush_source(uint32_t /*source*/) { commit_txn(); }
+
 void LMDBStorage::flush() {
-  if (txn_ && batch_count_ > 0) commit_txn();
+  if (txn_) commit_txn();
+  // Non-sync tiers skip fsync per commit; make everything durable here.
+  if (env_ && opts_.lmdb_durability != LmdbDurability::Sync)
+    mdb_env_sync(env_, 1);
+}
+
+ShardedLMDBStorage::ShardedLMDBStorage(const std::string& path,
+                                       const StorageOptions& opts) {
+  if (opts.lmdb_shards == 0)
+    throw std::runtime_error("ShardedLMDBStorage: lmdb_shards must be > 0");
+  fs::create_directories(path);
+
+  // Manifest first: readers trust it over whatever shard dirs exist.
+  std::FILE* fp = std::fopen((fs::path(path) / "shards").string().c_str(), "w");
+  if (!fp) throw std::runtime_error("open shard manifest failed: " + path);
+  std::fprintf(fp, "%zu\n", opts.lmdb_shards);
+  std::fclose(fp);
+
+  shards_.reserve(opts.lmdb_shards);
+  for (size_t i = 0; i < opts.lmdb_shards; ++i)
+    shards_.push_back(std::make_unique<LMDBStorage>(shard_dir(path, i), opts));
+}
+
+std::string ShardedLMDBStorage::shard_dir(const std::string& path,
+                                          size_t shard) {
+  char name[16];
+  std::snprintf(name, sizeof(name), "shard-%03zu", shard);
+  return (fs::path(path) / name).string();
+}
+
+void ShardedLMDBStorage::write(const Event& e) { shards_[0]->write(e); }
+
+void ShardedLMDBStorage::write_batch(const EventBatch& b) {
+  shards_[b.source % shards_.size()]->write_batch(b);
+}
+
+void ShardedLMDBStorage::flush_source(uint32_t source) {
+  shards_[source % shards_.size()]->flush();
+}
+
+void ShardedLMDBStorage::flush() {
+  for (auto& s : shards_) s->flush();
 }
 
-std::unique_ptr<IStorage> make_lmdb_storage(const std::string& path) {
-  return std::make_unique<LMDBStorage>(path);
+std::unique_ptr<IStorage> make_lmdb_storage(const std::string& path,
+                                            const StorageOptions& opts) {
+  return std::make_unique<LMDBStorage>(path, opts);
 }
 
 }  // namespace msim
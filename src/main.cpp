@@ -1,9 +1,15 @@
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <limits>
 #include <sstream>
 
+#include "msim/column_log.hpp"
 #include "msim/lmdb_reader.hpp"
+#include "msim/replay.hpp"
 #include "msim/simulator.hpp"
+#include "msim/thread_utils.hpp"
 
 using namespace msim;
 
@@ -16,11 +22,165 @@ static std::vector<std::string> split_csv(const std::string& s) {
   return out;
 }
 
+static bool ends_with(const std::string& s, const std::string& suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static int read_lmdb(const std::string& path, int dump_n, uint64_t ts_from,
+                     uint64_t ts_to) {
+  LMDBReader reader(path);
+  auto symbols = reader.list_symbols();
+  if (symbols.empty()) {
+    std::cout << "No symbols found in " << path << "\n";
+    return 0;
+  }
+
+  std::cout << "Found " << symbols.size() << " symbol(s): ";
+  for (auto& s : symbols) std::cout << s << " ";
+  std::cout << "\n";
+
+  auto batch = std::make_unique<EventBatch>(&reader.symbols());
+  for (auto& sym : symbols) {
+    const size_t total = reader.count(sym);
+    std::cout << sym << ": " << total << " events\n";
+
+    if (total > 0 && dump_n > 0) {
+      const size_t n = std::min<size_t>(dump_n, total);
+      std::cout << "First " << n << " events in t=[" << ts_from << ", "
+                << ts_to << "]:\n";
+      size_t printed = 0;
+      reader.read_batches(
+          sym, *batch,
+          [&](const EventBatch& b) {
+            for (size_t i = 0; i < b.size() && printed < n; ++i, ++printed)
+              std::cout << " " << b.to_event(i).to_string() << "\n";
+            return printed < n;
+          },
+          ts_from, ts_to);
+    }
+  }
+  return 0;
+}
+
+// --read with --threads N: every symbol is scanned in full (each record
+// parsed), N symbols at a time, and the per-symbol counters and dumps are
+// printed in symbol order once all are done.
+static int read_lmdb_parallel(const std::string& path, int dump_n,
+                              uint64_t ts_from, uint64_t ts_to,
+                              size_t n_threads) {
+  LMDBReader reader(path);
+  auto symbols = reader.list_symbols();
+  if (symbols.empty()) {
+    std::cout << "No symbols found in " << path << "\n";
+    return 0;
+  }
+
+  std::cout << "Found " << symbols.size() << " symbol(s): ";
+  for (auto& s : symbols) std::cout << s << " ";
+  std::cout << "\n";
+
+  // Each symbol's entry is only touched by the worker scanning it.
+  struct SymbolScan {
+    size_t events = 0;
+    size_t adds = 0;
+    size_t cancels = 0;
+    size_t trades = 0;
+    size_t depth = 0;
+    std::vector<std::string> dump;
+  };
+  std::vector<SymbolScan> scans(symbols.size());
+  const size_t n_dump = dump_n > 0 ? size_t(dump_n) : 0;
+
+  const auto t0 = std::chrono::steady_clock::now();
+  const size_t scanned = reader.for_each_parallel(
+      symbols, n_threads,
+      [&](size_t s, const EventView& v) {
+        SymbolScan& sc = scans[s];
+        ++sc.events;
+        if (is_order_add(v.type))
+          ++sc.adds;
+        else if (v.type == EventType::ORDER_CANCEL)
+          ++sc.cancels;
+        else if (v.type == EventType::TRADE)
+          ++sc.trades;
+        else
+          ++sc.depth;
+        if (sc.dump.size() < n_dump) sc.dump.push_back(v.to_event().to_string());
+        return true;
+      },
+      ts_from, ts_to);
+  const double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - t0)
+                        .count();
+
+  for (size_t s = 0; s < symbols.size(); ++s) {
+    const SymbolScan& sc = scans[s];
+    std::cout << symbols[s] << ": " << reader.count(symbols[s])
+              << " events\n  in t=[" << ts_from << ", " << ts_to
+              << "]: " << sc.events << " (adds=" << sc.adds
+              << " cancels=" << sc.cancels << " trades=" << sc.trades
+              << " depth=" << sc.depth << ")\n";
+    if (sc.dump.empty()) continue;
+    std::cout << "First " << sc.dump.size() << " events in t=[" << ts_from
+              << ", " << ts_to << "]:\n";
+    for (const std::string& line : sc.dump) std::cout << " " << line << "\n";
+  }
+  std::cout << "Scanned " << scanned << " events with "
+            << std::min(n_threads, symbols.size()) << " reader thread(s) in "
+            << ms << " ms\n";
+  return 0;
+}
+
+static int read_column_log(const std::string& path, int dump_n,
+                           uint64_t ts_from, uint64_t ts_to) {
+  ColumnLogReader reader(path);
+  const SymbolTable& syms = reader.symbols();
+  if (syms.size() == 0) {
+    std::cout << "No symbols found in " << path << "\n";
+    return 0;
+  }
+
+  std::cout << "Found " << syms.size() << " symbol(s): ";
+  for (uint16_t id = 0; id < syms.size(); ++id) std::cout << syms.name(id) << " ";
+  std::cout << "\n"
+            << reader.events() << " events in " << reader.blocks()
+            << " block(s), t=[" << reader.min_ts() << ", " << reader.max_ts()
+            << "]\n";
+
+  auto batch = std::make_unique<EventBatch>(&syms);
+  for (uint16_t id = 0; id < syms.size(); ++id) {
+    std::cout << syms.name(id) << ": " << reader.events(id) << " events\n";
+    if (dump_n <= 0) continue;
+
+    ColumnQuery q;
+    q.ts_from = ts_from;
+    q.ts_to = ts_to;
+    q.symbol = id;
+    const size_t n = static_cast<size_t>(dump_n);
+    std::cout << "First " << n << " events in t=[" << ts_from << ", " << ts_to
+              << "]:\n";
+    size_t printed = 0;
+    reader.read_batches(q, *batch, [&](const EventBatch& b) {
+      for (size_t i = 0; i < b.size() && printed < n; ++i, ++printed)
+        std::cout << " " << b.to_event(i).to_string() << "\n";
+      return printed < n;
+    });
+  }
+  return 0;
+}
+
 int main(int argc, char** argv) {
   SimConfig cfg;
   bool no_log = false;
   bool read_mode = false;
+  bool threads_set = false;
   std::string read_path;
+  std::string replay_path;
+  std::string cpus_spec;
+  std::string scenario;  // --scenario; resolved after parsing
+  uint64_t ts_from = 0;
+  uint64_t ts_to = std::numeric_limits<uint64_t>::max();
 
   for (int i = 1; i < argc; ++i) {
     std::string a = argv[i];
@@ -32,16 +192,108 @@ int main(int argc, char** argv) {
       cfg.symbol_list = split_csv(argv[++i]);
     else if (a == "--arena-bytes" && i + 1 < argc)
       cfg.arena_bytes = std::stoull(argv[++i]);
+    else if (a == "--huge-pages" && i + 1 < argc) {
+      const std::string mode = argv[++i];
+      if (mode == "off")
+        cfg.huge_pages = HugePages::Off;
+      else if (mode == "thp")
+        cfg.huge_pages = HugePages::Transparent;
+      else if (mode == "hugetlb")
+        cfg.huge_pages = HugePages::Explicit;
+      else {
+        std::cerr << "Unknown --huge-pages '" << mode
+                  << "' (use off|thp|hugetlb)\n";
+        return 2;
+      }
+    } else if (a == "--arena" && i + 1 < argc) {
+      const std::string kind = argv[++i];
+      if (kind == "monotonic")
+        cfg.arena_kind = ArenaKind::Monotonic;
+      else if (kind == "pool")
+        cfg.arena_kind = ArenaKind::Pool;
+      else {
+        std::cerr << "Unknown --arena '" << kind
+                  << "' (use monotonic|pool)\n";
+        return 2;
+      }
+    } else if (a == "--cpus" && i + 1 < argc)
+      cpus_spec = argv[++i];
     else if (a == "--sigma" && i + 1 < argc)
       cfg.sigma = std::stod(argv[++i]);
     else if (a == "--drift-ampl" && i + 1 < argc)
       cfg.drift_ampl = std::stod(argv[++i]);
     else if (a == "--drift-period" && i + 1 < argc)
       cfg.drift_period = std::stoull(argv[++i]);
+    else if (a == "--book" && i + 1 < argc) {
+      const std::string kind = argv[++i];
+      if (kind == "hash")
+        cfg.book_kind = BookKind::Hash;
+      else if (kind == "ladder")
+        cfg.book_kind = BookKind::Ladder;
+      else {
+        std::cerr << "Unknown --book '" << kind << "' (use hash|ladder)\n";
+        return 2;
+      }
+    } else if (a == "--sched" && i + 1 < argc) {
+      const std::string mode = argv[++i];
+      if (mode == "static")
+        cfg.sched = SchedMode::Static;
+      else if (mode == "pinned")
+        cfg.sched = SchedMode::Pinned;
+      else if (mode == "steal")
+        cfg.sched = SchedMode::Steal;
+      else {
+        std::cerr << "Unknown --sched '" << mode
+                  << "' (use static|pinned|steal)\n";
+        return 2;
+      }
+    } else if (a == "--scenario" && i + 1 < argc)
+      scenario = argv[++i];
+    else if (a == "--zipf" && i + 1 < argc)
+      cfg.zipf = std::stod(argv[++i]);
+    else if (a == "--steal-quantum" && i + 1 < argc)
+      cfg.steal_quantum = std::stoull(argv[++i]);
     else if (a == "--log" && i + 1 < argc)
       cfg.log_path = argv[++i];
+    else if (a == "--async-log")
+      cfg.async_log = true;
+    else if (a == "--sequence")
+      cfg.sequence = true;
+    else if (a == "--lmdb-durability" && i + 1 < argc) {
+      const std::string tier = argv[++i];
+      if (tier == "sync")
+        cfg.storage.lmdb_durability = LmdbDurability::Sync;
+      else if (tier == "nosync")
+        cfg.storage.lmdb_durability = LmdbDurability::NoSync;
+      else if (tier == "writemap")
+        cfg.storage.lmdb_durability = LmdbDurability::WriteMap;
+      else {
+        std::cerr << "Unknown --lmdb-durability '" << tier
+                  << "' (use sync|nosync|writemap)\n";
+        return 2;
+      }
+    } else if (a == "--lmdb-txn-mb" && i + 1 < argc)
+      cfg.storage.lmdb_txn_bytes = std::stoull(argv[++i]) << 20;
     else if (a == "--print-arena")
       cfg.print_arena = true;
+    else if (a == "--json" && i + 1 < argc)
+      cfg.json_path = argv[++i];
+    else if (a == "--progress" && i + 1 < argc)
+      cfg.progress_ms = std::stoull(argv[++i]);
+    else if (a == "--checkpoint" && i + 1 < argc)
+      cfg.checkpoint_path = argv[++i];
+    else if (a == "--checkpoint-every" && i + 1 < argc)
+      cfg.checkpoint_every = std::stoull(argv[++i]);
+    else if (a == "--resume" && i + 1 < argc)
+      cfg.resume_path = argv[++i];
+    else if (a == "--latency")
+      cfg.latency = true;
+    else if (a == "--perf")
+      cfg.perf = true;
+    else if (a == "--depth" && i + 1 < argc)
+      cfg.depth_levels = std::stoull(argv[++i]);
+    else if (a == "--depth-snapshot" && i + 1 < argc)
+      cfg.depth_snapshot_every = std::stoull(argv[++i]);
     else if (a == "--dump" && i + 1 < argc)
       cfg.dump_n = std::stoi(argv[++i]);
     else if (a == "--read" && i + 1 < argc) {
@@ -50,8 +302,16 @@ int main(int argc, char** argv) {
         read_path = argv[++i];
       else
         read_path = "store.mdb";
-    } else if (a == "--threads" && i + 1 < argc)
+    } else if (a == "--ts-from" && i + 1 < argc)
+      ts_from = std::stoull(argv[++i]);
+    else if (a == "--ts-to" && i + 1 < argc)
+      ts_to = std::stoull(argv[++i]);
+    else if (a == "--replay" && i + 1 < argc)
+      replay_path = argv[++i];
+    else if (a == "--threads" && i + 1 < argc) {
       cfg.num_threads = std::stoi(argv[++i]);
+      threads_set = true;
+    }
     else if (a == "--no-log") {
       no_log = true;
       cfg.log_path.clear();
@@ -59,6 +319,43 @@ int main(int argc, char** argv) {
       cfg.realtime_ts = true;
     else if (a == "--grpc" && i + 1 < argc)
       cfg.grpc_target = argv[++i];
+    else if (a == "--grpc-streams" && i + 1 < argc)
+      cfg.grpc.streams = std::stoull(argv[++i]);
+    else if (a == "--grpc-batch" && i + 1 < argc)
+      cfg.grpc.batch_events = std::stoull(argv[++i]);
+    else if (a == "--grpc-batch-kb" && i + 1 < argc)
+      cfg.grpc.batch_bytes = std::stoull(argv[++i]) << 10;
+    else if (a == "--grpc-queue" && i + 1 < argc)
+      cfg.grpc.max_queued = std::stoull(argv[++i]);
+    else if (a == "--grpc-overflow" && i + 1 < argc) {
+      const std::string policy = argv[++i];
+      if (policy == "block")
+        cfg.grpc.overflow = OverflowPolicy::Block;
+      else if (policy == "drop-oldest")
+        cfg.grpc.overflow = OverflowPolicy::DropOldest;
+      else if (policy == "sample")
+        cfg.grpc.overflow = OverflowPolicy::Sample;
+      else {
+        std::cerr << "Unknown --grpc-overflow '" << policy
+                  << "' (use block|drop-oldest|sample)\n";
+        return 2;
+      }
+    } else if (a == "--grpc-sample" && i + 1 < argc)
+      cfg.grpc.sample_every = static_cast<uint32_t>(std::stoul(argv[++i]));
+    else if (a == "--grpc-format" && i + 1 < argc) {
+      const std::string format = argv[++i];
+      if (format == "auto")
+        cfg.grpc.format = WireFormat::Auto;
+      else if (format == "rows")
+        cfg.grpc.format = WireFormat::Rows;
+      else if (format == "packed")
+        cfg.grpc.format = WireFormat::Packed;
+      else {
+        std::cerr << "Unknown --grpc-format '" << format
+                  << "' (use auto|rows|packed)\n";
+        return 2;
+      }
+    }
     else if (a == "--help") {
       std::cout
           << "Usage: ./market_sim [options]\n"
@@ -66,15 +363,76 @@ int main(int argc, char** argv) {
           << "  --symbols CSV        Symbol list (default AAPL,MSFT,GOOG)\n"
           << "  --seed S             RNG seed\n"
           << "  --arena-bytes BYTES  Per-symbol arena size (default 1<<20)\n"
+          << "  --arena KIND         Arena resource: monotonic | pool "
+             "(recycles frees; default monotonic)\n"
+          << "  --huge-pages MODE    Arena backing: off | thp | hugetlb "
+             "(default off)\n"
+          << "  --cpus LIST          CPUs for workers, e.g. 0-7,16-23 "
+             "(default worker t -> cpu t)\n"
           << "  --sigma X            Gaussian sigma as fraction of mid "
              "(default 0.001)\n"
           << "  --drift-ampl A       Volatility drift amplitude (default 0.0)\n"
           << "  --drift-period P     Drift period in events (default 10000)\n"
-          << "  --log PATH           Append-only event log path\n"
-          << "  --print-arena        Print arena upstream usage\n"
-          << "  --read PATH          Read and dump LMDB log instead of sim\n"
+          << "  --book KIND          Order book engine: hash | ladder "
+             "(default hash)\n"
+          << "  --sched MODE         Multi-thread scheduling: static | pinned | "
+             "steal (default static)\n"
+          << "  --scenario S         Workload shape: default | balanced | sweep "
+             "| maker | taker | skewed, or a key = value file\n"
+          << "  --zipf S             Zipf skew of per-symbol activity for "
+             "pinned|steal (default 0 = uniform)\n"
+          << "  --steal-quantum N    Events per scheduled symbol slice "
+             "(default 4096)\n"
+          << "  --log PATH           Event log path (.mdb = LMDB, .mcol = columnar, "
+             "else binary)\n"
+          << "  --async-log          Log via per-thread rings drained by a "
+             "writer thread\n"
+          << "  --sequence           Merge --threads workers into one "
+             "time-ordered tape for --log / --grpc\n"
+          << "  --lmdb-durability D  LMDB commit durability: sync | nosync | "
+             "writemap (default sync)\n"
+          << "  --lmdb-txn-mb N      LMDB txn size in MiB of records (default 8)\n"
+          << "  --print-arena        Print arena placement, upstream spill and "
+             "(pool) live / high-water bytes\n"
+          << "  --read PATH          Read and dump an LMDB (.mdb) or columnar "
+             "(.mcol) log instead of sim; with --threads N > 1, scan LMDB "
+             "symbols on N threads\n"
+          << "  --ts-from T / --ts-to T  Time window for --read --dump\n"
           << "  --dump N             Number of events to print per-symbol "
              "(default 0)\n"
+          << "  --replay PATH        Re-drive fresh books from an LMDB log "
+             "(one symbol per worker unless --threads)\n"
+          << "  --json PATH          Also write the run's results (config, "
+             "per-thread stats, rates, latency, counters, arenas) as JSON\n"
+          << "  --progress MS        Live progress line on stderr every MS ms "
+             "(0 = off, default)\n"
+          << "  --checkpoint PATH    Snapshot books, mids, live ids, RNG and "
+             "id state at the end of the run\n"
+          << "  --checkpoint-every N Also snapshot every N events in total "
+             "(N / workers steps per worker)\n"
+          << "  --resume PATH        Start from a --checkpoint snapshot and "
+             "run --events more\n"
+          << "  --latency            Per-op latency histograms (add / fill / "
+             "cancel p50..max)\n"
+          << "  --perf               Hardware counters per worker: IPC, "
+             "cycles, L1d / LLC / branch / dTLB misses per event (Linux)\n"
+          << "  --depth N            Log / export L2 deltas for the top N "
+             "levels per book (default 0 = off)\n"
+          << "  --depth-snapshot K   Full top-N snapshot every K book ops; 0 = "
+             "deltas only (default 10000)\n"
+          << "  --grpc HOST:PORT     Export events to a collector (MSIM_WITH_GRPC "
+             "builds)\n"
+          << "  --grpc-streams N     Parallel gRPC channels / streams (default 1)\n"
+          << "  --grpc-batch N       Events per exported batch (default 512)\n"
+          << "  --grpc-batch-kb N    Encoded KiB per exported batch (default 256)\n"
+          << "  --grpc-queue N       Batches in flight + queued per stream "
+             "(default 8)\n"
+          << "  --grpc-overflow P    When the collector lags: block | "
+             "drop-oldest | sample (default block)\n"
+          << "  --grpc-sample N      sample: keep 1 in N events under pressure "
+             "(default 8)\n"
+          << "  --grpc-format F      Batch encoding: auto | rows | packed "
+             "(default auto: packed if the collector supports it)\n"
           << "  --realtime-ts        Use realtime steady_clock timestamps (slower)\n";
       return 0;
     }
@@ -82,62 +440,68 @@ int main(int argc, char** argv) {
 
   try {
     if (no_log) cfg.log_path.clear();
-
-    if (cfg.num_threads > 1 && cfg.log_path.find(".mdb") != std::string::npos) {
-      std::cerr << "[WARN] LMDB logging not thread-safe; disabling logging\n";
-      cfg.log_path.clear();
+    if (!cpus_spec.empty()) cfg.cpu_list = parse_cpu_list(cpus_spec);
+    if (!scenario.empty()) cfg.scenario = Scenario::resolve(scenario);
+#ifndef MSIM_WITH_GRPC
+    if (!cfg.grpc_target.empty()) {
+      std::cerr << "[WARN] built without MSIM_WITH_GRPC; --grpc ignored\n";
+      cfg.grpc_target.clear();
     }
+#endif
+    if (cfg.zipf != 0.0 && cfg.sched == SchedMode::Static)
+      std::cerr << "[WARN] --zipf only applies to --sched pinned|steal; "
+                   "ignored\n";
+    if (cfg.sequence &&
+        (cfg.num_threads <= 1 || cfg.sched != SchedMode::Static)) {
+      std::cerr << "[WARN] --sequence only applies to --threads N > 1 with "
+                   "--sched static; ignored\n";
+      cfg.sequence = false;
+    }
+    if ((!cfg.checkpoint_path.empty() || !cfg.resume_path.empty()) &&
+        cfg.sched != SchedMode::Static) {
+      std::cerr << "[WARN] --checkpoint / --resume only apply to --sched "
+                   "static; ignored\n";
+      cfg.checkpoint_path.clear();
+      cfg.resume_path.clear();
+    }
+    if (cfg.checkpoint_every && cfg.checkpoint_path.empty())
+      std::cerr << "[WARN] --checkpoint-every needs --checkpoint PATH; "
+                   "ignored\n";
 
-    if (read_mode) {
-      LMDBReader reader(
-          (read_path.empty() ? std::string("store.mdb") : read_path));
-      auto symbols = reader.list_symbols();
-      if (symbols.empty()) {
-        std::cout << "No symbols found in " << read_path << "\n";
-        return 0;
-      }
-
-      std::cout << "Found " << symbols.size() << " symbol(s): ";
-      for (auto& s : symbols) std::cout << s << " ";
-      std::cout << "\n";
-
-      for (auto& sym : symbols) {
-        auto events = reader.read_all(sym);
-        std::cout << sym << ": " << events.size() << " events\n";
+    if (!replay_path.empty()) {
+      ReplayConfig rc;
+      rc.path = replay_path;
+      rc.symbol_list = cfg.symbol_list;
+      rc.num_threads = threads_set ? cfg.num_threads : 0;
+      rc.book_kind = cfg.book_kind;
+      rc.arena_bytes = cfg.arena_bytes;
+      rc.huge_pages = cfg.huge_pages;
+      rc.cpu_list = cfg.cpu_list;
 
-        if (!events.empty() && cfg.dump_n > 0) {
-          int n = std::min<int>(cfg.dump_n, events.size());
-          std::cout << "First " << n << " events:\n";
-          for (int i = 0; i < n; ++i)
-            std::cout << " " << events[i].to_string() << "\n";
-        }
-      }
+      ReplayEngine engine(rc);
+      engine.load();
+      std::cout << "Replay: " << replay_path << " (" << engine.loaded_ops()
+                << " events loaded in " << engine.load_ms() << " ms)\n";
+      const auto stats = engine.run();
+      ReplayEngine::print_report(stats, engine.workers());
       return 0;
     }
-    Simulator sim(cfg);
-
-#ifdef MSIM_WITH_GRPC
-    std::unique_ptr<msim::GrpcStorage> grpc_sink;
 
-    if (!cfg.grpc_target.empty()) {
-      grpc_sink = std::make_unique<msim::GrpcStorage>(cfg.grpc_target);
-      if (!grpc_sink->open()) {
-        std::cerr << "Failed to open gRPC stream to " << cfg.grpc_target
-                  << "\n";
-        return 1;
-      }
-      sim.set_grpc_sink(grpc_sink.get());
+    if (read_mode) {
+      if (read_path.empty()) read_path = "store.mdb";
+      if (ends_with(read_path, ".mcol"))
+        return read_column_log(read_path, cfg.dump_n, ts_from, ts_to);
+      if (threads_set && cfg.num_threads > 1)
+        return read_lmdb_parallel(read_path, cfg.dump_n, ts_from, ts_to,
+                                  size_t(cfg.num_threads));
+      return read_lmdb(read_path, cfg.dump_n, ts_from, ts_to);
     }
-#endif
-
-    (cfg.num_threads > 1) ? sim.run_mt() : sim.run();
+    Simulator sim(cfg);
 
-#ifdef MSIM_WITH_GRPC
-    if (grpc_sink) {
-      grpc_sink->close();
-      std::cout << "Collector ACK count: " << grpc_sink->ack_count() << "\n";
-    }
-#endif
+    if (cfg.sched != SchedMode::Static)
+      sim.run_tasks();
+    else
+      (cfg.num_threads > 1) ? sim.run_mt() : sim.run();
 
   } catch (const std::exception& ex) {
     std::cerr << "Error: " << ex.what() << "\n";
@@ -0,0 +1,69 @@
+#include "msim/mapped_file.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace msim {
+
+MappedFile::MappedFile(const std::string& path, const char* what) {
+  const std::string name(what);
+#ifdef _WIN32
+  HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (f == INVALID_HANDLE_VALUE)
+    throw std::runtime_error("open " + name + " failed: " + path);
+  LARGE_INTEGER sz;
+  if (!GetFileSizeEx(f, &sz) || sz.QuadPart == 0) {
+    CloseHandle(f);
+    throw std::runtime_error(name + " is empty: " + path);
+  }
+  HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void* p = m ? MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!p) {
+    if (m) CloseHandle(m);
+    CloseHandle(f);
+    throw std::runtime_error("mmap " + name + " failed: " + path);
+  }
+  file_ = f;
+  mapping_ = m;
+  size_ = static_cast<std::size_t>(sz.QuadPart);
+  base_ = static_cast<const uint8_t*>(p);
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("open " + name + " failed: " + path);
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    throw std::runtime_error(name + " is empty: " + path);
+  }
+  void* p = ::mmap(nullptr, std::size_t(st.st_size), PROT_READ, MAP_SHARED,
+                   fd, 0);
+  ::close(fd);  // the mapping keeps the file referenced
+  if (p == MAP_FAILED)
+    throw std::runtime_error("mmap " + name + " failed: " + path);
+  size_ = std::size_t(st.st_size);
+  base_ = static_cast<const uint8_t*>(p);
+#endif
+}
+
+MappedFile::~MappedFile() {
+  if (!base_) return;
+#ifdef _WIN32
+  UnmapViewOfFile(base_);
+  CloseHandle(static_cast<HANDLE>(mapping_));
+  CloseHandle(static_cast<HANDLE>(file_));
+#else
+  ::munmap(const_cast<uint8_t*>(base_), size_);
+#endif
+}
+
+}  // namespace msim
@@ -0,0 +1,165 @@
+#include "msim/node_buffer.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include "msim/thread_utils.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace msim {
+
+static constexpr size_t kHugePage = size_t(2) << 20;
+
+static size_t round_up(size_t n, size_t to) { return (n + to - 1) / to * to; }
+
+// One warning per process, not one per arena.
+static bool first_warning() {
+  static std::atomic<bool> warned{false};
+  return !warned.exchange(true, std::memory_order_relaxed);
+}
+
+const char* NodeBuffer::huge_name(HugePages h) noexcept {
+  switch (h) {
+    case HugePages::Transparent:
+      return "thp";
+    case HugePages::Explicit:
+      return "hugetlb";
+    default:
+      return "off";
+  }
+}
+
+#ifdef _WIN32
+
+NodeBuffer::NodeBuffer(size_t bytes, int node, HugePages huge) : size_(bytes) {
+  bytes = bytes ? bytes : 1;
+  const DWORD type = MEM_RESERVE | MEM_COMMIT;
+  const int want = node >= 0 ? node : current_numa_node();
+  auto alloc = [&](DWORD flags, size_t n) {
+    return want >= 0 ? VirtualAllocExNuma(GetCurrentProcess(), nullptr, n,
+                                          type | flags, PAGE_READWRITE,
+                                          DWORD(want))
+                     : VirtualAlloc(nullptr, n, type | flags, PAGE_READWRITE);
+  };
+
+  // Large pages need SeLockMemoryPrivilege; THP has no Windows analogue.
+  if (huge != HugePages::Off) {
+    const size_t large = GetLargePageMinimum();
+    if (large) {
+      map_bytes_ = round_up(bytes, large);
+      map_ = alloc(MEM_LARGE_PAGES, map_bytes_);
+    }
+    if (map_)
+      huge_ = HugePages::Explicit;
+    else if (first_warning())
+      std::cerr << "[WARN] large pages unavailable (err=" << GetLastError()
+                << "); using regular pages\n";
+  }
+  if (!map_) {
+    map_bytes_ = bytes;
+    map_ = alloc(0, map_bytes_);
+  }
+  if (!map_) throw std::bad_alloc();
+
+  data_ = static_cast<std::byte*>(map_);
+  std::memset(data_, 0, size_);  // commit every page from this thread
+  node_ = want;
+}
+
+NodeBuffer::~NodeBuffer() {
+  if (map_) VirtualFree(map_, 0, MEM_RELEASE);
+}
+
+#else
+
+NodeBuffer::NodeBuffer(size_t bytes, int node, HugePages huge) : size_(bytes) {
+  bytes = bytes ? bytes : 1;  // always map at least one page
+  const long page = sysconf(_SC_PAGESIZE);
+  const int prot = PROT_READ | PROT_WRITE;
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_HUGETLB
+  if (huge == HugePages::Explicit) {
+    map_bytes_ = round_up(bytes, kHugePage);
+    map_ = mmap(nullptr, map_bytes_, prot, flags | MAP_HUGETLB, -1, 0);
+    if (map_ == MAP_FAILED) {
+      map_ = nullptr;
+      if (first_warning())
+        std::cerr << "[WARN] MAP_HUGETLB failed (no reserved huge pages?); "
+                     "falling back to transparent huge pages\n";
+      huge = HugePages::Transparent;
+    } else {
+      data_ = static_cast<std::byte*>(map_);
+      huge_ = HugePages::Explicit;
+    }
+  }
+#endif
+
+  if (!map_) {
+    // THP only backs 2 MiB-aligned extents: over-map and align inside.
+    const bool thp = huge != HugePages::Off;
+    const size_t len =
+        thp ? round_up(bytes, kHugePage) : round_up(bytes, size_t(page));
+    map_bytes_ = thp ? len + kHugePage : len;
+    map_ = mmap(nullptr, map_bytes_, prot, flags, -1, 0);
+    if (map_ == MAP_FAILED) {
+      map_ = nullptr;
+      throw std::bad_alloc();
+    }
+    auto* p = static_cast<std::byte*>(map_);
+    if (thp) {
+      p = reinterpret_cast<std::byte*>(
+          round_up(reinterpret_cast<uintptr_t>(p), kHugePage));
+#ifdef MADV_HUGEPAGE
+      if (madvise(p, len, MADV_HUGEPAGE) == 0) huge_ = HugePages::Transparent;
+#endif
+    }
+    data_ = p;
+  }
+
+#ifdef __linux__
+  // Bind before the first touch; MPOL_PREFERRED still succeeds (remote) if
+  // the node is out of memory rather than failing the run.
+  if (node >= 0 && node < int(8 * sizeof(unsigned long))) {
+    unsigned long mask = 1ul << node;
+    // maxnode counts one past the last bit, as libnuma passes it.
+    if (syscall(SYS_mbind, data_, round_up(bytes, size_t(page)),
+                MPOL_PREFERRED, &mask, 8 * sizeof(mask) + 1, 0) != 0)
+      std::cerr << "[WARN] mbind to NUMA node " << node << " failed\n";
+  }
+#endif
+
+  for (size_t off = 0; off < size_; off += size_t(page))
+    data_[off] = std::byte{0};
+
+#ifdef __linux__
+  int where = -1;
+  if (size_ > 0 &&
+      syscall(SYS_get_mempolicy, &where, nullptr, 0, data_,
+              MPOL_F_NODE | MPOL_F_ADDR) == 0)
+    node_ = where;
+#else
+  (void)node;
+#endif
+}
+
+NodeBuffer::~NodeBuffer() {
+  if (map_) munmap(map_, map_bytes_);
+}
+
+#endif
+
+}  // namespace msim
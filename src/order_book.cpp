@@ -1,73 +1,106 @@
 #include "msim/order_book.hpp"
 
 #include <algorithm>
-#include <cmath>
 #include <cstdlib>
+#include <functional>
 // #include <memory> // c++ 20
 #include <new>
+#include <utility>
+#include <vector>
+
+#include "msim/ladder_book.hpp"
 
 namespace msim {
 
-static constexpr std::size_t kLevelCap = 2048;   // max distinct ticks per side
-static constexpr std::size_t kIndexCap = 16384;  // max live resting orders
+std::unique_ptr<IOrderBook> make_order_book(BookKind kind, std::string symbol,
+                                            std::pmr::memory_resource* mr,
+                                            double tick_size,
+                                            double ref_price) {
+  if (kind == BookKind::Ladder)
+    return std::make_unique<LadderOrderBook>(std::move(symbol), mr, tick_size,
+                                             ref_price);
+  return std::make_unique<OrderBook>(std::move(symbol), mr, tick_size);
+}
+
+// Initial capacities; the tables double past them (deep books).
+static constexpr std::size_t kLevelCap = 2048;   // distinct ticks per side
+static constexpr std::size_t kIndexCap = 16384;  // live resting orders
+
+using DepthLog = std::vector<DepthUpdate>;
+
+static void note_level(DepthLog* log, Side side, int32_t tick,
+                       const OrderQueue& q) {
+  if (log) log->push_back({side, {tick, q.qty, q.count}});
+}
 
-OrderBook::OrderBook(std::string symbol, std::pmr::memory_resource* mr, double tick_size)
-    : bid_levels_(mr, kLevelCap, /*allow_grow=*/false),
-      ask_levels_(mr, kLevelCap, /*allow_grow=*/false),
-      index_(mr, kIndexCap, /*allow_grow=*/false),
-      bid_ticks_(mr),
-      ask_ticks_(mr),
+using detail::kPrefetchAhead;
+using detail::NoFill;
+
+// ---------------- HashBookCore ----------------
+
+HashBookCore::SideLevels::SideLevels(std::pmr::memory_resource* mr,
+                                     std::size_t cap)
+    : levels(mr, cap, /*allow_grow=*/true), ticks(mr) {
+  ticks.reserve(512);
+}
+
+HashBookCore::HashBookCore(std::pmr::memory_resource* mr, double tick_size)
+    : bids_(mr, kLevelCap),
+      asks_(mr, kLevelCap),
+      index_(mr, kIndexCap, /*allow_grow=*/true),
+      pool_(mr),
       free_levels_(mr),
-      symbol_(std::move(symbol)),
       mr_(mr),
-      tick_size_(tick_size),
-      inv_tick_(1.0 / tick_size) {
-  if (!(tick_size_ > 0.0)) std::abort();
-  bid_ticks_.reserve(512);
-  ask_ticks_.reserve(512);
+      tick_size_(tick_size) {
   free_levels_.reserve(256);
 }
 
-int32_t OrderBook::price_to_tick(double px) const noexcept {
-  // Deterministic rounding; prices here are always positive in this sim.
-  // Using llround on px*inv_tick is stable enough on MSVC for this workload.
-  const double x = px * inv_tick_;
-  return static_cast<int32_t>(std::llround(x));
+HashBookCore::~HashBookCore() {
+  std::pmr::polymorphic_allocator<Level> a(mr_);
+  auto release = [&](int32_t, Level* lvl) { a.deallocate(lvl, 1); };
+  bids_.levels.for_each(release);
+  asks_.levels.for_each(release);
+  for (Level* lvl : free_levels_) a.deallocate(lvl, 1);
 }
 
-OrderBook::Level* OrderBook::get_level(Side side, int32_t tick) noexcept {
-  if (side == Side::BUY) {
-    auto p = bid_levels_.find_ptr(tick);
-    return p ? *p : nullptr;
-  } else {
-    auto p = ask_levels_.find_ptr(tick);
-    return p ? *p : nullptr;
+HashBookCore::Level* HashBookCore::new_level(int32_t tick) {
+  if (!free_levels_.empty()) {
+    Level* lvl = free_levels_.back();
+    free_levels_.pop_back();
+    lvl->reset(tick);
+    return lvl;
   }
+  std::pmr::polymorphic_allocator<Level> a(mr_);
+  Level* lvl = a.allocate(1);
+  // std::construct_at(lvl, tick, mr_); // c++20
+  ::new (static_cast<void*>(lvl)) Level(tick);
+  return lvl;
 }
 
-const OrderBook::Level* OrderBook::get_level(Side side, int32_t tick) const noexcept {
-  if (side == Side::BUY) {
-    auto p = bid_levels_.find_ptr(tick);
-    return p ? *p : nullptr;
-  } else {
-    auto p = ask_levels_.find_ptr(tick);
-    return p ? *p : nullptr;
-  }
-}
+template <Side S>
+HashBookCore::Level* HashBookCore::get_or_create_level(int32_t tick) {
+  SideLevels& sl = side<S>();
+  if (Level* lvl = sl.find(tick)) return lvl;
 
-void OrderBook::add_active_tick(Side side, int32_t tick) {
-  auto& v = (side == Side::BUY) ? bid_ticks_ : ask_ticks_;
-  v.push_back(tick);
+  Level* lvl = new_level(tick);
+  if (!sl.levels.insert(tick, lvl)) std::abort();  // capacity misuse
 
-  if (side == Side::BUY) {
-    if (!best_bid_tick_ || tick > *best_bid_tick_) best_bid_tick_ = tick;
-  } else {
-    if (!best_ask_tick_ || tick < *best_ask_tick_) best_ask_tick_ = tick;
-  }
+  sl.ticks.push_back(tick);
+  // A stale best is rescanned (with this tick) before it is next read.
+  if (!sl.stale && (!sl.best || SidePolicy<S>::better(tick, *sl.best)))
+    sl.best = tick;
+  return lvl;
 }
 
-void OrderBook::remove_active_tick(Side side, int32_t tick) {
-  auto& v = (side == Side::BUY) ? bid_ticks_ : ask_ticks_;
+template <Side S>
+void HashBookCore::remove_level_if_empty(int32_t tick, Level* lvl,
+                                         bool defer_best) {
+  if (!lvl->empty()) return;
+
+  SideLevels& sl = side<S>();
+  (void)sl.levels.erase(tick);
+
+  auto& v = sl.ticks;
   for (std::size_t i = 0; i < v.size(); ++i) {
     if (v[i] == tick) {
       v[i] = v.back();
@@ -75,199 +108,295 @@ void OrderBook::remove_active_tick(Side side, int32_t tick) {
       break;
     }
   }
-}
 
-void OrderBook::recompute_best(Side side) {
-  auto& v = (side == Side::BUY) ? bid_ticks_ : ask_ticks_;
-  if (v.empty()) {
-    if (side == Side::BUY) best_bid_tick_.reset();
-    else best_ask_tick_.reset();
-    return;
+  if (sl.best && *sl.best == tick) {
+    if (defer_best)
+      sl.stale = true;
+    else
+      recompute_best<S>();
   }
 
-  int32_t best = v[0];
-  if (side == Side::BUY) {
-    for (std::size_t i = 1; i < v.size(); ++i) best = std::max(best, v[i]);
-    best_bid_tick_ = best;
-  } else {
-    for (std::size_t i = 1; i < v.size(); ++i) best = std::min(best, v[i]);
-    best_ask_tick_ = best;
-  }
+  // keep level for reuse
+  free_levels_.push_back(lvl);
 }
 
-OrderBook::Level* OrderBook::get_or_create_level(Side side, int32_t tick) {
-  Level* lvl = get_level(side, tick);
-  if (lvl) return lvl;
-
-  // allocate/reuse Level
-  if (!free_levels_.empty()) {
-    lvl = free_levels_.back();
-    free_levels_.pop_back();
-    lvl->reset(tick);
-  } else {
-    std::pmr::polymorphic_allocator<Level> a(mr_);
-    lvl = a.allocate(1);
-    // std::construct_at(lvl, tick, mr_); // c++20
-    ::new (static_cast<void*>(lvl)) Level(tick, mr_);
+template <Side S>
+void HashBookCore::recompute_best() {
+  SideLevels& sl = side<S>();
+  sl.stale = false;
+  if (sl.ticks.empty()) {
+    sl.best.reset();
+    return;
   }
+  int32_t best = sl.ticks[0];
+  for (std::size_t i = 1; i < sl.ticks.size(); ++i)
+    if (SidePolicy<S>::better(sl.ticks[i], best)) best = sl.ticks[i];
+  sl.best = best;
+}
+
+int HashBookCore::add_order(const Order& o, int32_t& trade_tick,
+                            OrderType type, DepthLog* log) {
+  return o.side == Side::BUY
+             ? add_side<Side::BUY>(o, trade_tick, type, log, NoFill{})
+             : add_side<Side::SELL>(o, trade_tick, type, log, NoFill{});
+}
 
-  bool ok = false;
-  if (side == Side::BUY) ok = bid_levels_.insert(tick, lvl);
-  else ok = ask_levels_.insert(tick, lvl);
+template <Side S, class OnFill>
+int HashBookCore::add_side(const Order& o, int32_t& trade_tick,
+                           OrderType type, DepthLog* log, OnFill&& on_fill) {
+  using P = SidePolicy<S>;
+  constexpr Side kOpp = P::kOpp;
+  SideLevels& opp = side<kOpp>();
+  if (opp.stale) recompute_best<kOpp>();  // cancels in this apply() batch
+  int remaining = o.qty;
 
-  if (!ok) std::abort();  // should never happen; indicates capacity misuse
+  // Market orders take any price; everything else stops at its limit.
+  const int32_t tick = type != OrderType::Market ? o.tick : P::kAny;
 
-  add_active_tick(side, tick);
-  return lvl;
-}
+  if (type == OrderType::PostOnly || type == OrderType::FOK) {
+    const bool crosses = opp.best && P::reaches(tick, *opp.best);
+    const bool kill = type == OrderType::PostOnly
+                          ? crosses
+                          : !crosses || fillable<S>(tick, o.qty) < o.qty;
+    if (kill) return 0;
+  }
 
-void OrderBook::remove_level_if_empty(Side side, int32_t tick, Level* lvl) {
-  if (!lvl->q.empty()) return;
+  // match against the best opposite levels while crossing
+  while (remaining > 0 && opp.best && P::reaches(tick, *opp.best)) {
+    const int32_t best_tick = *opp.best;
+    Level* lvl = opp.find(best_tick);
+    if (!lvl) {
+      // should not happen if invariants hold; recompute and continue
+      recompute_best<kOpp>();
+      continue;
+    }
+    trade_tick = best_tick;
+
+    while (remaining > 0 && !lvl->empty()) {
+      OrderNode* top = lvl->front();
+      const int traded = std::min(remaining, top->o.qty);
+      remaining -= traded;
+      on_fill(top->o, best_tick, traded);
+      lvl->fill(top, traded);
+
+      if (top->o.qty == 0) {
+        // Correctness: remove filled resting order from index
+        index_.erase(top->o.id);
+        lvl->pop_front();
+        pool_.release(top);
+      }
+    }
 
-  // remove from map
-  if (side == Side::BUY) {
-    (void)bid_levels_.erase(tick);
-  } else {
-    (void)ask_levels_.erase(tick);
+    note_level(log, kOpp, best_tick, *lvl);
+    remove_level_if_empty<kOpp>(best_tick, lvl);
+    // loop continues if still crossing
   }
 
-  remove_active_tick(side, tick);
+  if (remaining > 0 && rests(type)) {
+    Level* lvl = get_or_create_level<S>(tick);
+    OrderNode* n = pool_.acquire(o);
+    n->o.qty = remaining;
+    lvl->push_back(n);
+    note_level(log, S, tick, *lvl);
 
-  // update best if needed
-  if (side == Side::BUY) {
-    if (best_bid_tick_ && *best_bid_tick_ == tick) recompute_best(Side::BUY);
-  } else {
-    if (best_ask_tick_ && *best_ask_tick_ == tick) recompute_best(Side::SELL);
+    // Index the resting order for cancels
+    if (!index_.insert(o.id, n)) std::abort();
   }
 
-  // keep level for reuse
-  free_levels_.push_back(lvl);
+  return o.qty - remaining;
 }
 
-int OrderBook::add_order(const Order& o, double& trade_price) {
-  int remaining = o.qty;
+bool HashBookCore::cancel_order(uint64_t order_id, DepthLog* log) {
+  return cancel(order_id, log, /*defer_best=*/false);
+}
 
-  const int32_t tick = price_to_tick(o.price);
-  const double snapped_px = tick_to_price(tick);
-
-  if (o.side == Side::BUY) {
-    // match against best asks while crossing
-    while (remaining > 0 && best_ask_tick_ && *best_ask_tick_ <= tick) {
-      const int32_t best_tick = *best_ask_tick_;
-      Level* lvl = get_level(Side::SELL, best_tick);
-      if (!lvl) {
-        // should not happen if invariants hold; recompute and continue
-        recompute_best(Side::SELL);
-        continue;
-      }
+bool HashBookCore::cancel(uint64_t order_id, DepthLog* log, bool defer_best) {
+  auto ref = index_.find_ptr(order_id);
+  if (!ref) return false;
 
-      auto& q = lvl->q;
-      while (remaining > 0 && !q.empty()) {
-        Order& top = q.front();
-        const int traded = std::min(remaining, top.qty);
-        remaining -= traded;
-        top.qty -= traded;
-        trade_price = top.price;
-
-        if (top.qty == 0) {
-          // Correctness: remove filled resting order from index
-          index_.erase(top.id);
-          q.pop_front();
-        }
-      }
+  OrderNode* n = *ref;
+  index_.erase(order_id);
 
-      remove_level_if_empty(Side::SELL, best_tick, lvl);
-      // loop continues if still crossing
-    }
+  // O(1): the node knows its level, the level knows its side via the order.
+  Level* lvl = level_of(n);
+  const Side s = n->o.side;
+  lvl->erase(n);
+  pool_.release(n);
+  note_level(log, s, lvl->tick, *lvl);
+  if (s == Side::BUY)
+    remove_level_if_empty<Side::BUY>(lvl->tick, lvl, defer_best);
+  else
+    remove_level_if_empty<Side::SELL>(lvl->tick, lvl, defer_best);
+  return true;
+}
 
-    if (remaining > 0) {
-      Level* lvl = get_or_create_level(Side::BUY, tick);
-      Order rest = o;
-      rest.qty = remaining;
-      rest.price = snapped_px;
-      lvl->q.push_back(rest);
+void HashBookCore::apply(const BookCommand* cmds, std::size_t n,
+                         std::vector<Fill>& fills, int32_t* results,
+                         DepthLog* log) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i + kPrefetchAhead < n) {
+      // A cancel will look up its id; an add may insert its id and rest at
+      // its own tick.
+      const BookCommand& ahead = cmds[i + kPrefetchAhead];
+      index_.prefetch(ahead.order.id);
+      if (ahead.op == BookOp::Add)
+        (ahead.order.side == Side::BUY ? bids_ : asks_)
+            .levels.prefetch(ahead.order.tick);
+    }
 
-      // Index the resting order for cancels
-      if (!index_.insert(rest.id, OrderRef{Side::BUY, tick})) std::abort();
+    const BookCommand& c = cmds[i];
+    int32_t r;
+    if (c.op == BookOp::Cancel) {
+      r = cancel(c.order.id, log, /*defer_best=*/true) ? 1 : 0;
+    } else {
+      auto on_fill = [&](const Order& maker, int32_t tick, int qty) {
+        fills.push_back({c.order.id, maker.id, tick, qty, uint32_t(i),
+                         c.order.side});
+      };
+      int32_t trade_tick = 0;
+      r = c.order.side == Side::BUY
+              ? add_side<Side::BUY>(c.order, trade_tick, c.type, log, on_fill)
+              : add_side<Side::SELL>(c.order, trade_tick, c.type, log,
+                                     on_fill);
     }
+    if (results) results[i] = r;
+  }
+  if (bids_.stale) recompute_best<Side::BUY>();
+  if (asks_.stale) recompute_best<Side::SELL>();
+}
 
-  } else {
-    // SELL: match against best bids while crossing
-    while (remaining > 0 && best_bid_tick_ && *best_bid_tick_ >= tick) {
-      const int32_t best_tick = *best_bid_tick_;
-      Level* lvl = get_level(Side::BUY, best_tick);
-      if (!lvl) {
-        recompute_best(Side::BUY);
-        continue;
-      }
+template <Side S>
+int64_t HashBookCore::fillable(int32_t limit, int64_t need) const {
+  const SideLevels& opp = side<SidePolicy<S>::kOpp>();
+  int64_t have = 0;
+  for (std::size_t i = 0; i < opp.ticks.size() && have < need; ++i) {
+    const int32_t t = opp.ticks[i];
+    if (SidePolicy<S>::reaches(limit, t)) have += opp.find(t)->qty;
+  }
+  return have;
+}
 
-      auto& q = lvl->q;
-      while (remaining > 0 && !q.empty()) {
-        Order& top = q.front();
-        const int traded = std::min(remaining, top.qty);
-        remaining -= traded;
-        top.qty -= traded;
-        trade_price = top.price;
-
-        if (top.qty == 0) {
-          index_.erase(top.id);
-          q.pop_front();
-        }
-      }
+std::optional<double> HashBookCore::best_bid() const {
+  if (!bids_.best) return std::nullopt;
+  return double(*bids_.best) * tick_size_;
+}
 
-      remove_level_if_empty(Side::BUY, best_tick, lvl);
-    }
+std::optional<double> HashBookCore::best_ask() const {
+  if (!asks_.best) return std::nullopt;
+  return double(*asks_.best) * tick_size_;
+}
 
-    if (remaining > 0) {
-      Level* lvl = get_or_create_level(Side::SELL, tick);
-      Order rest = o;
-      rest.qty = remaining;
-      rest.price = snapped_px;
-      lvl->q.push_back(rest);
-      if (!index_.insert(rest.id, OrderRef{Side::SELL, tick})) std::abort();
+uint64_t HashBookCore::state_checksum() const {
+  BookDigest d;
+  for (Side s : {Side::BUY, Side::SELL}) {
+    const SideLevels& sl = s == Side::BUY ? bids_ : asks_;
+    std::vector<int32_t> ticks(sl.ticks.begin(), sl.ticks.end());
+    if (s == Side::BUY)
+      std::sort(ticks.begin(), ticks.end(), std::greater<int32_t>());
+    else
+      std::sort(ticks.begin(), ticks.end());
+
+    for (int32_t t : ticks) {
+      const Level* lvl = sl.find(t);
+      if (!lvl || lvl->empty()) continue;
+      d.level(s, t);
+      for (const OrderNode* n = lvl->front(); n; n = n->next)
+        d.order(n->o.id, n->o.qty);
     }
   }
+  return d.value();
+}
 
-  return o.qty - remaining;
+void HashBookCore::resting_orders(std::vector<Order>& out) const {
+  for (Side s : {Side::BUY, Side::SELL}) {
+    const SideLevels& sl = s == Side::BUY ? bids_ : asks_;
+    std::vector<int32_t> ticks(sl.ticks.begin(), sl.ticks.end());
+    if (s == Side::BUY)
+      std::sort(ticks.begin(), ticks.end(), std::greater<int32_t>());
+    else
+      std::sort(ticks.begin(), ticks.end());
+
+    for (int32_t t : ticks)
+      if (const Level* lvl = sl.find(t))
+        for (const OrderNode* n = lvl->front(); n; n = n->next)
+          out.push_back(n->o);
+  }
+}
+
+void HashBookCore::depth(Side s, std::size_t n,
+                         std::vector<DepthLevel>& out) const {
+  if (s == Side::BUY)
+    depth_side<Side::BUY>(n, out);
+  else
+    depth_side<Side::SELL>(n, out);
+}
+
+template <Side S>
+void HashBookCore::depth_side(std::size_t n,
+                              std::vector<DepthLevel>& out) const {
+  out.clear();
+  const SideLevels& sl = side<S>();
+  std::vector<int32_t> ticks(sl.ticks.begin(), sl.ticks.end());
+  n = std::min(n, ticks.size());
+  // Only the best n need ordering.
+  std::partial_sort(ticks.begin(), ticks.begin() + n, ticks.end(),
+                    [](int32_t a, int32_t b) {
+                      return SidePolicy<S>::better(a, b);
+                    });
+
+  for (std::size_t i = 0; i < n; ++i) {
+    const Level* lvl = sl.find(ticks[i]);
+    out.push_back({ticks[i], lvl->qty, lvl->count});
+  }
+}
+
+// ---------------- OrderBook ----------------
+
+OrderBook::OrderBook(std::string symbol, std::pmr::memory_resource* mr,
+                     double tick_size)
+    : symbol_(std::move(symbol)), core_(mr, tick_size) {
+  if (!(tick_size > 0.0)) std::abort();
+}
+
+int OrderBook::add_order(const Order& o, int32_t& trade_tick,
+                         OrderType type) {
+  return core_.add_order(o, trade_tick, type, depth_log_);
 }
 
 bool OrderBook::cancel_order(uint64_t order_id) {
-  auto ref = index_.find_ptr(order_id);
-  if (!ref) return false;
+  return core_.cancel_order(order_id, depth_log_);
+}
 
-  const Side side = ref->side;
-  const int32_t tick = ref->tick;
+std::optional<int32_t> OrderBook::best_bid_tick() const {
+  return core_.best_bid_tick();
+}
 
-  Level* lvl = get_level(side, tick);
-  if (!lvl) {
-    // Stale index entry would imply bug; erase and return false.
-    index_.erase(order_id);
-    return false;
-  }
+std::optional<int32_t> OrderBook::best_ask_tick() const {
+  return core_.best_ask_tick();
+}
 
-  auto& q = lvl->q;
-  for (auto it = q.begin(); it != q.end(); ++it) {
-    if (it->id == order_id) {
-      q.erase(it);
-      index_.erase(order_id);
-      remove_level_if_empty(side, tick, lvl);
-      return true;
-    }
-  }
+std::optional<double> OrderBook::best_bid() const { return core_.best_bid(); }
 
-  // If we got here, the index was stale. Clean it up.
-  index_.erase(order_id);
-  return false;
+std::optional<double> OrderBook::best_ask() const { return core_.best_ask(); }
+
+std::size_t OrderBook::index_size() const noexcept {
+  return core_.index_size();
+}
+
+uint64_t OrderBook::state_checksum() const { return core_.state_checksum(); }
+
+void OrderBook::apply(const BookCommand* cmds, std::size_t n,
+                      std::vector<Fill>& fills, int32_t* results) {
+  core_.apply(cmds, n, fills, results, depth_log_);
 }
 
-std::optional<double> OrderBook::best_bid() const {
-  if (!best_bid_tick_) return std::nullopt;
-  return tick_to_price(*best_bid_tick_);
+void OrderBook::resting_orders(std::vector<Order>& out) const {
+  core_.resting_orders(out);
 }
 
-std::optional<double> OrderBook::best_ask() const {
-  if (!best_ask_tick_) return std::nullopt;
-  return tick_to_price(*best_ask_tick_);
+void OrderBook::depth(Side side, std::size_t n,
+                      std::vector<DepthLevel>& out) const {
+  core_.depth(side, n, out);
 }
 
 }  // namespace msim
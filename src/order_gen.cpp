@@ -0,0 +1,148 @@
+#define _USE_MATH_DEFINES
+#include "msim/order_gen.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace msim {
+
+static size_t round_lanes(size_t n) {
+  constexpr size_t k = Xoroshiro128PlusX4::kLanes;
+  return (n + k - 1) / k * k;
+}
+
+static uint64_t cut32(double share) {  // share of 2^32, saturating
+  return share >= 1.0 ? (uint64_t(1) << 32)
+                      : static_cast<uint64_t>(share * 4294967296.0);
+}
+
+OrderGenerator::OrderGenerator(uint64_t seed, size_t n_symbols, double sigma,
+                               double drift_ampl, uint64_t drift_period,
+                               const Scenario& scenario)
+    : rng_(seed),
+      normal_(seed),
+      n_symbols_(static_cast<uint32_t>(n_symbols)),
+      sigma_(sigma),
+      drift_ampl_(drift_ampl),
+      drift_period_(drift_period),
+      sc_(scenario) {
+  sc_.validate();
+  const Scenario d;
+  const bool bursts = sc_.burst_every > 0 && sc_.burst_len > 0;
+  mix_ = sc_.cancel_ratio != d.cancel_ratio || sc_.ioc > 0.0 ||
+         sc_.fok > 0.0 || sc_.market > 0.0 || sc_.post_only > 0.0 || bursts;
+  add_cut_ = cut32(sc_.cancel_ratio);
+  double acc = 0.0;
+  const double shares[4] = {sc_.ioc, sc_.fok, sc_.market, sc_.post_only};
+  for (int k = 0; k < 4; ++k) type_cut_[k] = cut32(acc += shares[k]);
+  burst_market_cut_ = cut32(sc_.burst_market);
+
+  if (sc_.symbol_skew > 0.0 && n_symbols_ > 1) {
+    std::vector<double> w(n_symbols_);
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n_symbols_; ++i)
+      sum += w[i] = std::pow(double(i + 1), -sc_.symbol_skew);
+    acc = 0.0;
+    sym_cut_.resize(n_symbols_);
+    for (uint32_t i = 0; i < n_symbols_; ++i)
+      sym_cut_[i] = cut32((acc += w[i]) / sum);
+    sym_cut_.back() = uint64_t(1) << 32;
+  }
+}
+
+int32_t OrderGenerator::qty_of(uint64_t bits30) const {
+  if (sc_.qty_dist == QtyDist::Pareto) {
+    const double u = (double(bits30) + 0.5) * (1.0 / 1073741824.0);
+    const double q = double(sc_.qty_min) * std::pow(u, -1.0 / sc_.qty_alpha);
+    return q >= double(sc_.qty_max) ? sc_.qty_max : int32_t(q);
+  }
+  const uint64_t span = uint64_t(sc_.qty_max - sc_.qty_min) + 1;
+  return sc_.qty_min + int32_t((bits30 * span) >> 30);
+}
+
+OrderGenerator::State OrderGenerator::state() const noexcept {
+  State s{};
+  for (size_t k = 0; k < Xoroshiro128PlusX4::kLanes; ++k) {
+    s.lane_s0[k] = rng_.s0[k];
+    s.lane_s1[k] = rng_.s1[k];
+  }
+  s.tail_s0 = normal_.tail_state().s0;
+  s.tail_s1 = normal_.tail_state().s1;
+  return s;
+}
+
+void OrderGenerator::restore(const State& s) noexcept {
+  for (size_t k = 0; k < Xoroshiro128PlusX4::kLanes; ++k) {
+    rng_.s0[k] = s.lane_s0[k];
+    rng_.s1[k] = s.lane_s1[k];
+  }
+  Xoroshiro128Plus tail = normal_.tail_state();
+  tail.s0 = s.tail_s0;
+  tail.s1 = s.tail_s1;
+  normal_.set_tail_state(tail);
+}
+
+void OrderGenerator::fill(IntentBatch& b, uint64_t first_step, size_t n) {
+  b.n = n;
+  if (n == 0) return;
+
+  rng_.fill(fields_, round_lanes(n));
+  rng_.fill(picks_, round_lanes(n));
+  rng_.fill(normals_, round_lanes((n + 1) / 2));
+
+  // Field word: bit 0 add, bit 1 side, bits 2..31 qty, bits 32..63 symbol.
+  // Multiply-shift maps a k-bit draw onto [0, m) without division.
+  for (size_t i = 0; i < n; ++i) {
+    const uint64_t w = fields_[i];
+    b.add[i] = uint8_t(w & 1);
+    b.side[i] = (w & 2) ? Side::BUY : Side::SELL;
+    b.qty[i] = qty_of((w >> 2) & 0x3FFFFFFFull);
+    b.sym[i] = sym_cut_.empty()
+                   ? uint32_t(((w >> 32) * n_symbols_) >> 32)
+                   : uint32_t(std::upper_bound(sym_cut_.begin(),
+                                               sym_cut_.end(), w >> 32) -
+                              sym_cut_.begin());
+    b.type[i] = OrderType::Limit;
+    b.pick[i] = to_uniform01(picks_[i]);
+  }
+
+  // Mix word: low half picks add vs cancel, high half the order type.
+  if (mix_) {
+    rng_.fill(mix_words_, round_lanes(n));
+    for (size_t i = 0; i < n; ++i) {
+      const uint64_t m = mix_words_[i];
+      b.add[i] = uint8_t((m & 0xFFFFFFFFull) >= add_cut_);
+      uint8_t t = 0;
+      while (t < 4 && (m >> 32) >= type_cut_[t]) ++t;
+      b.type[i] = t < 4 ? OrderType(t + 1) : OrderType::Limit;
+    }
+  }
+
+  // Bursts: one-sided, oversized adds, mostly market (pick is unused on
+  // an add, so it decides which).
+  if (sc_.burst_every > 0 && sc_.burst_len > 0) {
+    for (size_t i = 0; i < n; ++i) {
+      const uint64_t step = first_step + i;
+      if (step % sc_.burst_every >= sc_.burst_len) continue;
+      b.add[i] = 1;
+      b.side[i] = (step / sc_.burst_every) & 1 ? Side::SELL : Side::BUY;
+      b.qty[i] = int32_t(std::min<int64_t>(
+          int64_t(b.qty[i]) * sc_.burst_qty_mult, int64_t(1) << 30));
+      if ((picks_[i] >> 32) < burst_market_cut_)
+        b.type[i] = OrderType::Market;
+    }
+  }
+
+  normal_.fill(b.move, normals_, n);
+  if (drift_ampl_ > 0.0 && drift_period_ > 0) {
+    for (size_t i = 0; i < n; ++i) {
+      const double phase = double((first_step + i) % drift_period_) /
+                           double(drift_period_);
+      b.move[i] *= sigma_ * (1.0 + drift_ampl_ * std::sin(phase * 2.0 * M_PI));
+    }
+  } else {
+    for (size_t i = 0; i < n; ++i) b.move[i] *= sigma_;
+  }
+}
+
+}  // namespace msim
@@ -0,0 +1,192 @@
+#include "msim/perf_counters.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace msim {
+
+const char* perf_event_name(PerfEvent e) noexcept {
+  switch (e) {
+    case PerfEvent::Cycles:
+      return "cycles";
+    case PerfEvent::Instructions:
+      return "instructions";
+    case PerfEvent::L1dMisses:
+      return "l1d_misses";
+    case PerfEvent::LlcMisses:
+      return "llc_misses";
+    case PerfEvent::BranchMisses:
+      return "branch_misses";
+    case PerfEvent::DtlbMisses:
+      return "dtlb_misses";
+  }
+  return "?";
+}
+
+double PerfCounts::ipc() const noexcept {
+  if (!has(PerfEvent::Cycles) || !has(PerfEvent::Instructions) ||
+      (*this)[PerfEvent::Cycles] == 0)
+    return 0.0;
+  return double((*this)[PerfEvent::Instructions]) /
+         double((*this)[PerfEvent::Cycles]);
+}
+
+double PerfCounts::per_event(PerfEvent e, uint64_t events) const noexcept {
+  if (!has(e) || events == 0) return 0.0;
+  return double((*this)[e]) / double(events);
+}
+
+void PerfCounts::merge(const PerfCounts& other) noexcept {
+  if (other.threads == 0) return;
+  valid = threads ? valid & other.valid : other.valid;
+  for (std::size_t e = 0; e < kPerfEvents; ++e) value[e] += other.value[e];
+  threads += other.threads;
+}
+
+void PerfCounts::print(std::ostream& os, const char* label,
+                       uint64_t events) const {
+  char buf[48];
+  os << "Perf " << label << ": ipc=";
+  if (has(PerfEvent::Cycles) && has(PerfEvent::Instructions)) {
+    std::snprintf(buf, sizeof(buf), "%.3f", ipc());
+    os << buf;
+  } else {
+    os << "n/a";
+  }
+  for (std::size_t e = 0; e < kPerfEvents; ++e) {
+    const PerfEvent ev = PerfEvent(e);
+    os << ' ' << perf_event_name(ev) << "/ev=";
+    if (has(ev)) {
+      std::snprintf(buf, sizeof(buf), "%.3f", per_event(ev, events));
+      os << buf;
+    } else {
+      os << "n/a";
+    }
+  }
+  os << " (" << events << " events)\n";
+}
+
+#ifdef __linux__
+
+namespace {
+
+struct EventSpec {
+  uint32_t type;
+  uint64_t config;
+};
+
+constexpr uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result) {
+  return cache | (op << 8) | (result << 16);
+}
+
+// Indexed by PerfEvent.
+constexpr EventSpec kSpecs[kPerfEvents] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE,
+     cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                 PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE,
+     cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                 PERF_COUNT_HW_CACHE_RESULT_MISS)},
+};
+
+int open_event(const EventSpec& spec) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = spec.type;
+  attr.config = spec.config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;  // allowed at perf_event_paranoid <= 2
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // This thread, any CPU, no group, no flags.
+  return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+}  // namespace
+
+bool PerfCounters::supported() noexcept { return true; }
+
+PerfCounters::PerfCounters() {
+  fd_.fill(-1);
+  int first_errno = 0;
+  for (std::size_t e = 0; e < kPerfEvents; ++e) {
+    fd_[e] = open_event(kSpecs[e]);
+    if (fd_[e] >= 0)
+      open_ |= 1u << e;
+    else if (!first_errno)
+      first_errno = errno;
+  }
+  if (!open_)
+    error_ = first_errno == EACCES || first_errno == EPERM
+                 ? "perf_event_open not permitted (see "
+                   "/proc/sys/kernel/perf_event_paranoid)"
+             : first_errno == ENOENT || first_errno == EOPNOTSUPP
+                 ? "no hardware counters on this CPU / VM"
+                 : "perf_event_open failed";
+}
+
+PerfCounters::~PerfCounters() {
+  for (int fd : fd_)
+    if (fd >= 0) close(fd);
+}
+
+void PerfCounters::start() noexcept {
+  for (int fd : fd_)
+    if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+  for (int fd : fd_)
+    if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+void PerfCounters::stop() noexcept {
+  for (int fd : fd_)
+    if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  if (!open_) return;
+  for (std::size_t e = 0; e < kPerfEvents; ++e) {
+    if (fd_[e] < 0) continue;
+    uint64_t buf[3] = {};  // value, time enabled, time running
+    if (read(fd_[e], buf, sizeof(buf)) != ssize_t(sizeof(buf))) continue;
+    // Never scheduled (every counter taken): no estimate, drop the event.
+    if (buf[2] == 0) {
+      if (buf[1] != 0) open_ &= ~(1u << e);
+      continue;
+    }
+    const uint64_t v =
+        buf[2] < buf[1]
+            ? uint64_t(double(buf[0]) * double(buf[1]) / double(buf[2]))
+            : buf[0];
+    counts_.value[e] += v;
+  }
+  counts_.valid = open_;
+  counts_.threads = 1;
+}
+
+#else  // !__linux__
+
+bool PerfCounters::supported() noexcept { return false; }
+
+PerfCounters::PerfCounters() {
+  fd_.fill(-1);
+  error_ = "hardware counters need Linux perf_event_open";
+}
+
+PerfCounters::~PerfCounters() = default;
+void PerfCounters::start() noexcept {}
+void PerfCounters::stop() noexcept {}
+
+#endif
+
+}  // namespace msim
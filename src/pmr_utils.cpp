@@ -1 +1,81 @@
 #include "msim/pmr_utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace msim {
+
+static size_t class_size(size_t c) { return SizeClassPool::kMinClass << c; }
+
+SizeClassPool::SizeClassPool(void* buffer, size_t bytes,
+                             std::pmr::memory_resource* upstream)
+    : cur_(static_cast<std::byte*>(buffer)),
+      end_(static_cast<std::byte*>(buffer) + bytes),
+      upstream_(upstream) {}
+
+SizeClassPool::~SizeClassPool() {
+  for (auto& [p, n] : chunks_) upstream_->deallocate(p, n, kMaxAlign);
+}
+
+size_t SizeClassPool::class_of(size_t bytes, size_t align) noexcept {
+  const size_t want = std::max({bytes, align, kMinClass});
+  if (want > kMaxClass || align > kMaxAlign) return kClasses;
+  size_t c = 0;
+  while (class_size(c) < want) ++c;
+  return c;
+}
+
+// Every block of class size s starts on a min(s, kMaxAlign) boundary, so a
+// recycled block satisfies any alignment its class admits.
+void* SizeClassPool::carve(size_t size) {
+  const size_t align = std::min(size, kMaxAlign);
+  auto aligned = [align](std::byte* p) {
+    const auto u = reinterpret_cast<uintptr_t>(p);
+    return reinterpret_cast<std::byte*>((u + align - 1) & ~(align - 1));
+  };
+  std::byte* p = cur_ ? aligned(cur_) : nullptr;
+  if (!p || p > end_ || size_t(end_ - p) < size) {
+    const size_t n = std::max(kChunkBytes, size);
+    p = static_cast<std::byte*>(upstream_->allocate(n, kMaxAlign));
+    chunks_.emplace_back(p, n);
+    end_ = p + n;
+  }
+  cur_ = p + size;
+  return p;
+}
+
+void* SizeClassPool::do_allocate(size_t bytes, size_t align) {
+  const size_t c = class_of(bytes, align);
+  if (c == kClasses) {
+    void* p = upstream_->allocate(bytes, align);
+    live_ += bytes;
+    high_ = std::max(high_, live_);
+    return p;
+  }
+
+  void* p;
+  if (FreeBlock* b = free_[c]) {
+    free_[c] = b->next;
+    p = b;
+  } else {
+    p = carve(class_size(c));
+  }
+  live_ += class_size(c);
+  high_ = std::max(high_, live_);
+  return p;
+}
+
+void SizeClassPool::do_deallocate(void* p, size_t bytes, size_t align) {
+  const size_t c = class_of(bytes, align);
+  if (c == kClasses) {
+    upstream_->deallocate(p, bytes, align);
+    live_ -= bytes;
+    return;
+  }
+  auto* b = static_cast<FreeBlock*>(p);
+  b->next = free_[c];
+  free_[c] = b;
+  live_ -= class_size(c);
+}
+
+}  // namespace msim
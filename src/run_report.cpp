@@ -0,0 +1,286 @@
+#include "msim/run_report.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace msim {
+
+namespace {
+
+// Just enough JSON for RunReport: nested objects / arrays, string, integer,
+// double and bool values, two-space indent.
+class JsonWriter {
+ public:
+  explicit JsonWriter(std::ostream& os) : os_(os) {}
+
+  void begin_object() { open('{'); }
+  void end_object() { close('}'); }
+  void begin_array() { open('['); }
+  void end_array() { close(']'); }
+
+  JsonWriter& key(const char* k) {
+    separate();
+    string(k);
+    os_ << ": ";
+    after_key_ = true;
+    return *this;
+  }
+
+  void value(const std::string& s) {
+    separate();
+    string(s.c_str());
+  }
+  void value(const char* s) {
+    separate();
+    string(s);
+  }
+  void value(bool b) {
+    separate();
+    os_ << (b ? "true" : "false");
+  }
+  void value(uint64_t v) {
+    separate();
+    os_ << v;
+  }
+  void value(int v) {
+    separate();
+    os_ << v;
+  }
+  void value(double v) {
+    separate();
+    if (!std::isfinite(v)) {
+      os_ << "null";
+      return;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.17g", v);
+    os_ << buf;
+  }
+  template <class T>
+  void value(const std::optional<T>& v) {
+    if (v)
+      value(*v);
+    else
+      null();
+  }
+  void null() {
+    separate();
+    os_ << "null";
+  }
+
+ private:
+  void open(char c) {
+    separate();
+    os_ << c;
+    first_ = true;
+    ++depth_;
+  }
+  void close(char c) {
+    --depth_;
+    if (!first_) newline();
+    os_ << c;
+    first_ = false;
+  }
+  // Comma and newline before every element but a key's value.
+  void separate() {
+    if (after_key_) {
+      after_key_ = false;
+      return;
+    }
+    if (depth_ == 0) return;
+    if (!first_) os_ << ',';
+    newline();
+    first_ = false;
+  }
+  void newline() {
+    os_ << '\n';
+    for (int i = 0; i < depth_; ++i) os_ << "  ";
+  }
+  void string(const char* s) {
+    os_ << '"';
+    for (; *s; ++s) {
+      const unsigned char c = static_cast<unsigned char>(*s);
+      if (c == '"' || c == '\\') {
+        os_ << '\\' << char(c);
+      } else if (c < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        os_ << buf;
+      } else {
+        os_ << char(c);
+      }
+    }
+    os_ << '"';
+  }
+
+  std::ostream& os_;
+  int depth_ = 0;
+  bool first_ = true;
+  bool after_key_ = false;
+};
+
+// --perf counters over `events` events; null when nothing was counted.
+void write_perf(JsonWriter& w, const PerfCounts& p, uint64_t events) {
+  if (!p.threads) {
+    w.null();
+    return;
+  }
+  w.begin_object();
+  w.key("threads").value(uint64_t(p.threads));
+  w.key("events").value(events);
+  w.key("ipc");
+  if (p.has(PerfEvent::Cycles) && p.has(PerfEvent::Instructions))
+    w.value(p.ipc());
+  else
+    w.null();
+  for (const bool per_event : {false, true}) {
+    w.key(per_event ? "per_event" : "counts").begin_object();
+    for (std::size_t e = 0; e < kPerfEvents; ++e) {
+      const PerfEvent ev = PerfEvent(e);
+      w.key(perf_event_name(ev));
+      if (!p.has(ev))
+        w.null();
+      else if (per_event)
+        w.value(p.per_event(ev, events));
+      else
+        w.value(p[ev]);
+    }
+    w.end_object();
+  }
+  w.end_object();
+}
+
+}  // namespace
+
+void RunReport::add_latency(const OpLatency& lat, double ns_per_tick) {
+  auto ns = [ns_per_tick](uint64_t ticks) {
+    return uint64_t(std::llround(double(ticks) * ns_per_tick));
+  };
+  auto add = [&](const char* op, const LatencyHistogram& h) {
+    latency_ns.push_back({op, h.count(), ns(h.quantile(0.50)),
+                          ns(h.quantile(0.99)), ns(h.quantile(0.999)),
+                          ns(h.max())});
+  };
+  add("add", lat.add);
+  add("fill", lat.fill);
+  add("cancel", lat.cancel);
+}
+
+void write_json(std::ostream& os, const RunReport& r) {
+  JsonWriter w(os);
+  w.begin_object();
+  w.key("schema").value(RunReport::kSchema);
+
+  w.key("config").begin_object();
+  w.key("mode").value(r.mode);
+  w.key("scenario").value(r.scenario);
+  w.key("book").value(r.book);
+  w.key("arena").value(r.arena);
+  w.key("seed").value(r.seed);
+  w.key("total_events").value(r.total_events);
+  w.key("symbols").value(uint64_t(r.n_symbols));
+  w.key("threads").value(uint64_t(r.n_threads));
+  w.key("arena_bytes").value(uint64_t(r.arena_bytes));
+  w.key("log_path").value(r.log_path);
+  w.key("latency").value(r.latency);
+  w.key("perf").value(r.perf);
+  w.key("resumed_at").value(r.resumed_at);
+  w.end_object();
+
+  w.key("totals").begin_object();
+  w.key("adds").value(r.adds);
+  w.key("cancels").value(r.cancels);
+  w.key("trades").value(r.trades);
+  w.key("rejected").value(r.rejected);
+  w.key("depth_records").value(r.depth_records);
+  w.key("migrations").value(r.migrations);
+  w.key("wall_ms").value(r.wall_ms);
+  w.key("elapsed_max_ms").value(r.elapsed_max_ms);
+  w.key("generator_ms").value(r.generator_ms);
+  w.key("imbalance").value(r.imbalance);
+  w.key("throughput_ev_s").value(r.throughput_ev_s);
+  w.key("steps_per_s").value(r.steps_per_s);
+  w.key("book_ops_per_s").value(r.book_ops_per_s);
+  w.key("match_ops_per_s").value(r.match_ops_per_s);
+  w.end_object();
+
+  w.key("threads").begin_array();
+  for (const ThreadReport& t : r.threads) {
+    w.begin_object();
+    w.key("thread").value(uint64_t(t.thread));
+    w.key("cpu").value(uint64_t(t.cpu));
+    w.key("node").value(t.node);
+    w.key("symbols").value(uint64_t(t.symbols));
+    w.key("steps").value(t.steps);
+    w.key("adds").value(t.adds);
+    w.key("cancels").value(t.cancels);
+    w.key("trades").value(t.trades);
+    w.key("rejected").value(t.rejected);
+    w.key("quanta").value(t.quanta);
+    w.key("steals").value(t.steals);
+    w.key("elapsed_ms").value(t.elapsed_ms);
+    w.key("gen_ms").value(t.gen_ms);
+    w.key("perf");
+    write_perf(w, t.perf, t.steps);
+    w.end_object();
+  }
+  w.end_array();
+
+  w.key("latency_ns").begin_object();
+  for (const LatencyReport& l : r.latency_ns) {
+    w.key(l.op.c_str()).begin_object();
+    w.key("count").value(l.count);
+    w.key("p50").value(l.p50_ns);
+    w.key("p99").value(l.p99_ns);
+    w.key("p99.9").value(l.p999_ns);
+    w.key("max").value(l.max_ns);
+    w.end_object();
+  }
+  w.end_object();
+
+  w.key("perf");
+  write_perf(w, r.perf_counts, r.total_events);
+
+  w.key("arenas").begin_array();
+  for (const ArenaReport& a : r.arenas) {
+    w.begin_object();
+    w.key("label").value(a.label);
+    w.key("upstream_bytes").value(a.upstream_bytes);
+    w.key("live_bytes").value(a.live_bytes);
+    w.key("high_water").value(a.high_water);
+    w.key("node").value(a.node);
+    w.key("want_node").value(a.want_node);
+    w.key("pages").value(a.pages);
+    w.end_object();
+  }
+  w.end_array();
+
+  w.key("books").begin_array();
+  for (const BookReport& b : r.books) {
+    char sum[24];
+    std::snprintf(sum, sizeof(sum), "%016llx",
+                  (unsigned long long)b.checksum);
+    w.begin_object();
+    w.key("symbol").value(b.symbol);
+    w.key("resting").value(uint64_t(b.resting));
+    w.key("checksum").value(sum);
+    w.key("rejected").value(b.rejected);
+    w.end_object();
+  }
+  w.end_array();
+
+  w.end_object();
+  os << '\n';
+}
+
+void write_json_file(const std::string& path, const RunReport& r) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) throw std::runtime_error("open json report failed: " + path);
+  write_json(out, r);
+  out.flush();
+  if (!out) throw std::runtime_error("write json report failed: " + path);
+}
+
+}  // namespace msim
@@ -0,0 +1,181 @@
+#include "msim/scenario.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace msim {
+
+bool Scenario::is_default() const {
+  const Scenario d;
+  return cancel_ratio == d.cancel_ratio && ioc == 0.0 && fok == 0.0 &&
+         market == 0.0 && post_only == 0.0 && qty_dist == QtyDist::Uniform &&
+         qty_min == d.qty_min && qty_max == d.qty_max && symbol_skew == 0.0 &&
+         (burst_every == 0 || burst_len == 0);
+}
+
+void Scenario::validate() const {
+  auto fail = [&](const std::string& what) {
+    throw std::runtime_error("scenario " + name + ": " + what);
+  };
+  auto share = [&](double v, const char* field) {
+    if (!(v >= 0.0 && v <= 1.0))
+      fail(std::string(field) + " must be in [0,1]");
+  };
+  share(cancel_ratio, "cancel_ratio");
+  share(ioc, "ioc");
+  share(fok, "fok");
+  share(market, "market");
+  share(post_only, "post_only");
+  share(burst_market, "burst_market");
+  if (ioc + fok + market + post_only > 1.0 + 1e-9)
+    fail("ioc + fok + market + post_only exceeds 1");
+  if (qty_min < 1 || qty_max < qty_min) fail("need 1 <= qty_min <= qty_max");
+  if (qty_dist == QtyDist::Pareto && !(qty_alpha > 0.0))
+    fail("qty_alpha must be > 0");
+  if (symbol_skew < 0.0) fail("symbol_skew must be >= 0");
+  if (burst_every && burst_len > burst_every)
+    fail("burst_len exceeds burst_every");
+  if (burst_qty_mult < 1) fail("burst_qty_mult must be >= 1");
+}
+
+std::vector<std::string> Scenario::presets() {
+  return {"default", "balanced", "sweep", "maker", "taker", "skewed"};
+}
+
+Scenario Scenario::preset(const std::string& name) {
+  Scenario s;
+  s.name = name;
+  if (name == "default") return s;
+  if (name == "balanced") {  // a bit of everything, heavy-tailed sizes
+    s.cancel_ratio = 0.45;
+    s.ioc = 0.08;
+    s.fok = 0.02;
+    s.market = 0.02;
+    s.post_only = 0.10;
+    s.qty_dist = QtyDist::Pareto;
+    s.qty_max = 2000;
+    s.qty_alpha = 1.3;
+    s.symbol_skew = 0.8;
+  } else if (name == "sweep") {  // liquidity builds, then market bursts
+    s.cancel_ratio = 0.4;
+    s.burst_every = 2000;
+    s.burst_len = 20;
+    s.burst_market = 1.0;
+    s.burst_qty_mult = 25;
+  } else if (name == "maker") {  // passive flow, little crossing
+    s.cancel_ratio = 0.55;
+    s.post_only = 0.6;
+    s.ioc = 0.02;
+  } else if (name == "taker") {  // aggressive flow
+    s.cancel_ratio = 0.35;
+    s.ioc = 0.3;
+    s.fok = 0.1;
+    s.market = 0.05;
+  } else if (name == "skewed") {  // a few hot symbols, big tails
+    s.symbol_skew = 1.2;
+    s.qty_dist = QtyDist::Pareto;
+    s.qty_max = 1000;
+    s.qty_alpha = 1.2;
+  } else {
+    throw std::runtime_error("unknown scenario preset '" + name + "'");
+  }
+  return s;
+}
+
+static std::string trim(const std::string& s) {
+  const auto b = s.find_first_not_of(" \t\r");
+  if (b == std::string::npos) return "";
+  const auto e = s.find_last_not_of(" \t\r");
+  return s.substr(b, e - b + 1);
+}
+
+Scenario Scenario::load(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("scenario: cannot open " + path);
+
+  Scenario s;
+  const auto slash = path.find_last_of("/\\");
+  s.name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+  if (const auto dot = s.name.rfind('.'); dot != std::string::npos && dot > 0)
+    s.name.resize(dot);
+
+  std::string line;
+  for (int ln = 1; std::getline(in, line); ++ln) {
+    const std::string where = "scenario: " + path + ":" + std::to_string(ln);
+    if (const auto hash = line.find('#'); hash != std::string::npos)
+      line.resize(hash);
+    line = trim(line);
+    if (line.empty()) continue;
+
+    const auto eq = line.find('=');
+    if (eq == std::string::npos)
+      throw std::runtime_error(where + ": expected key = value");
+    const std::string key = trim(line.substr(0, eq));
+    const std::string val = trim(line.substr(eq + 1));
+
+    try {
+      if (key == "preset") {
+        const std::string keep = s.name;
+        try {
+          s = preset(val);
+        } catch (const std::runtime_error& e) {
+          throw std::runtime_error(where + ": " + e.what());
+        }
+        s.name = keep;
+      } else if (key == "cancel_ratio")
+        s.cancel_ratio = std::stod(val);
+      else if (key == "ioc")
+        s.ioc = std::stod(val);
+      else if (key == "fok")
+        s.fok = std::stod(val);
+      else if (key == "market")
+        s.market = std::stod(val);
+      else if (key == "post_only")
+        s.post_only = std::stod(val);
+      else if (key == "qty_dist") {
+        if (val == "uniform")
+          s.qty_dist = QtyDist::Uniform;
+        else if (val == "pareto")
+          s.qty_dist = QtyDist::Pareto;
+        else
+          throw std::invalid_argument("use uniform|pareto");
+      } else if (key == "qty_min")
+        s.qty_min = std::stoi(val);
+      else if (key == "qty_max")
+        s.qty_max = std::stoi(val);
+      else if (key == "qty_alpha")
+        s.qty_alpha = std::stod(val);
+      else if (key == "symbol_skew")
+        s.symbol_skew = std::stod(val);
+      else if (key == "burst_every")
+        s.burst_every = std::stoull(val);
+      else if (key == "burst_len")
+        s.burst_len = std::stoull(val);
+      else if (key == "burst_market")
+        s.burst_market = std::stod(val);
+      else if (key == "burst_qty_mult")
+        s.burst_qty_mult = std::stoi(val);
+      else
+        throw std::runtime_error(where + ": unknown key '" + key + "'");
+    } catch (const std::logic_error& e) {  // stod & co., bad qty_dist
+      throw std::runtime_error(where + ": bad value '" + val + "' for " +
+                               key + " (" + e.what() + ")");
+    }
+  }
+  s.validate();
+  return s;
+}
+
+Scenario Scenario::resolve(const std::string& name_or_path) {
+  std::string known;
+  for (const auto& p : presets()) {
+    if (p == name_or_path) return preset(p);
+    known += (known.empty() ? "" : "|") + p;
+  }
+  if (!std::ifstream(name_or_path))
+    throw std::runtime_error("unknown scenario '" + name_or_path +
+                             "' (presets: " + known + ", or a file)");
+  return load(name_or_path);
+}
+
+}  // namespace msim
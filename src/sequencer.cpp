@@ -0,0 +1,146 @@
+#include "msim/sequencer.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace msim {
+
+Sequencer::Sequencer(std::unique_ptr<IStorage> sink, std::size_t n_producers,
+                     const SymbolTable* symbols, Tap tap)
+    : sink_(std::move(sink)), tap_(std::move(tap)) {
+  if (!sink_) throw std::invalid_argument("Sequencer: no sink");
+  if (n_producers == 0) n_producers = 1;
+
+  producers_.reserve(n_producers);
+  for (std::size_t p = 0; p < n_producers; ++p)
+    producers_.push_back(std::make_unique<Producer>());
+  out_ = std::make_unique<EventBatch>(symbols);
+
+  thread_ = std::thread([this] { merger_loop(); });
+}
+
+Sequencer::~Sequencer() {
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+uint64_t Sequencer::bound(std::size_t p, Cursor& c) {
+  if (c.r < c.n) return c.buf[c.r].key;
+  if (c.done) return kDone;
+
+  // Watermark first: a kDone read here happens-after the producer's last
+  // push, so an empty pop below really means drained.
+  const uint64_t wm = producers_[p]->watermark.load(std::memory_order_acquire);
+  c.r = 0;
+  c.n = producers_[p]->ring.try_pop_bulk(c.buf.data(), c.buf.size());
+  if (c.n) return c.buf[0].key;
+  if (wm == kDone) c.done = true;
+  return wm;
+}
+
+void Sequencer::wait(const std::vector<Cursor>& cur,
+                     const std::vector<uint64_t>& lim) {
+  ++waits_;
+  bell_.wait([&] {
+    for (std::size_t p = 0; p < cur.size(); ++p) {
+      const Cursor& c = cur[p];
+      if (c.done || c.r < c.n) continue;  // bound() already knows
+      const Producer& pr = *producers_[p];
+      if (!pr.ring.empty() ||
+          pr.watermark.load(std::memory_order_acquire) != lim[p])
+        return true;
+    }
+    return false;
+  });
+}
+
+void Sequencer::merger_loop() {
+  const std::size_t np = producers_.size();
+  std::vector<Cursor> cur(np);
+  for (auto& c : cur) c.buf.resize(kDrainBatch);
+  std::vector<uint64_t> lim(np);
+
+  for (;;) {
+    // Smallest buffered head by (key, producer); everybody's lower bound.
+    std::size_t best = np;
+    bool all_done = true;
+    for (std::size_t p = 0; p < np; ++p) {
+      lim[p] = bound(p, cur[p]);
+      all_done &= cur[p].done;
+      if (cur[p].r < cur[p].n && (best == np || lim[p] < lim[best])) best = p;
+    }
+    if (all_done) break;
+    if (best == np) {  // every live producer is empty; wait for one
+      wait(cur, lim);
+      continue;
+    }
+
+    // The tightest bound among the others caps what `best` may release.
+    uint64_t cap = kDone;
+    std::size_t cap_p = np;
+    for (std::size_t q = 0; q < np; ++q)
+      if (q != best && lim[q] < cap) {
+        cap = lim[q];
+        cap_p = q;
+      }
+
+    Cursor& c = cur[best];
+    const std::size_t r0 = c.r;
+    while (c.r < c.n) {
+      const uint64_t k = c.buf[c.r].key;
+      if (k > cap || (k == cap && best > cap_p)) break;
+      emit(c.buf[c.r++]);
+    }
+    if (c.r == r0) wait(cur, lim);  // held back by another's watermark
+  }
+  flush_out();
+
+  release_sink(sink_, !failed_, "[Sequencer] sink");
+}
+
+void Sequencer::emit(const Stamped& s) {
+  // Merge keys only order the tape; a ts must also be unique per record.
+  const uint64_t ts = any_out_ && s.key <= last_ts_ ? last_ts_ + 1 : s.key;
+  any_out_ = true;
+  last_ts_ = ts;
+
+  CompactEvent e = s.e;
+  e.ts_ns = ts;
+  out_->push(e);
+  if (out_->full()) flush_out();
+}
+
+void Sequencer::flush_out() {
+  EventBatch& b = *out_;
+  if (b.empty()) return;
+  if (tap_) tap_(b);
+  if (!failed_) {
+    try {
+      sink_->write_batch(b);
+      written_.fetch_add(b.size(), std::memory_order_relaxed);
+    } catch (const std::exception& ex) {
+      std::cerr << "[Sequencer] sink failed: " << ex.what()
+                << " (dropping remaining events)\n";
+      failed_ = true;
+    }
+  }
+  b.clear();
+}
+
+void Sequencer::close() {
+  if (closed_) return;
+  closed_ = true;
+
+  for (std::size_t p = 0; p < producers_.size(); ++p) finish(p);
+  thread_.join();
+}
+
+uint64_t Sequencer::stalls() const noexcept {
+  uint64_t n = 0;
+  for (auto& p : producers_) n += p->stalls;
+  return n;
+}
+
+}  // namespace msim
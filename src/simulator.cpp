@@ -4,19 +4,16 @@
 #include <algorithm>
 #include <atomic>
 #include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <mutex>
 #include <thread>
+#include <type_traits>
 
+#include "msim/ladder_book.hpp"
 #include "msim/rng.hpp"
-
-#ifdef _WIN32
-#define NOMINMAX
-#include <windows.h>
-#else
-#include <pthread.h>
-#include <sched.h>
-#endif
+#include "msim/thread_utils.hpp"
+#include "msim/work_steal.hpp"
 
 static std::mutex io_mtx;
 // ─────────────── Thread-safe logging helper ───────────────
@@ -45,209 +42,600 @@ Simulator::Simulator(SimConfig cfg) : cfg_(std::move(cfg)), rng_(cfg_.seed) {
   auto symbols =
       cfg_.symbol_list.empty() ? default_symbols() : cfg_.symbol_list;
   for (auto& s : symbols) {
-    auto mem = std::make_unique<ArenaBundle>(cfg_.arena_bytes);
-    auto book = std::make_unique<OrderBook>(s, &mem->arena);
-    syms_.emplace(s, SymState{std::move(mem), std::move(book), 100.0});
+    const uint16_t id = symbols_.intern(s);
+    auto mem = std::make_unique<ArenaBundle>(
+        cfg_.arena_bytes, -1, cfg_.huge_pages, cfg_.arena_kind);
+    auto book = make_order_book(cfg_.book_kind, s, mem->resource(),
+                                symbols_.tick_size(id));
+    syms_.emplace(s, SymState{std::move(mem), std::move(book), nullptr,
+                              kStartPrice / symbols_.tick_size(id), id});
   }
+  // run_tasks() draws one symbol per generator; its skew lives in the
+  // per-symbol budgets instead.
+  if (cfg_.zipf == 0.0) cfg_.zipf = cfg_.scenario.symbol_skew;
+
+  // run_mt() workers write LMDB directly, one env each; with --async-log or
+  // --sequence a single writer thread owns one env instead.
+  if (cfg_.num_threads > 1 && !cfg_.async_log && !cfg_.sequence)
+    cfg_.storage.lmdb_shards = worker_count(cfg_.num_threads, syms_.size());
+
+  if (!cfg_.resume_path.empty()) {
+    resume_ = std::make_unique<CheckpointReader>(cfg_.resume_path);
+    if (resume_->header().seed != cfg_.seed)
+      std::cerr << "[WARN] checkpoint was taken with --seed "
+                << resume_->header().seed
+                << "; its generator streams continue as saved\n";
+  }
+
   if (!cfg_.log_path.empty())
-    storage_ = make_storage(cfg_.log_path);
+    storage_ = make_storage(cfg_.log_path, cfg_.storage);
   else
     storage_ = make_storage("");  // returns a NullStorage sink
 }
 
-void Simulator::bind_to_core(size_t core_id) {
-  /** Pins the current thread to a specific physical CPU core
-   * so that the OS scheduler stops moving it around between cores.
-   *
-   * That one move changes how cache, memory, and timing behave.
-   *
-   * Without affinity:
-   *   Windows/Linux can migrate your threads between cores.
-   *   Each migration flushes its L1/L2 caches -> cold caches -> jitter.
-   *   The thread's working memory may sit on a different NUMA node -> remote
-   *    memory latency.
-   *
-   * With affinity:
-   *   The thread ALWAYS runs on that one core.
-   *   All allocations it makes (like its PMR arena) are serviced by that core's
-   *    NUMA node. Cache lines stay hot and deterministic.
-   *
-   * In an HFT system, this is the difference between 70ns and 250ns latency
-   * spikes.
-   */
-#ifdef _WIN32
-  // bitmask representing which cores this thread may run on
-  DWORD_PTR mask = 1ull << core_id;
-  if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
-    std::cerr << "[WARN] SetThreadAffinityMask failed for core " << core_id
-              << " (err=" << GetLastError() << ")\n";
+uint64_t Simulator::make_ts(ThreadContext& ctx) const {
+  // Deterministic + fast. Unique across threads.
+  return make_ts(uint64_t(ctx.thread_id) << 48, ctx.seq, ctx.last_ts);
+}
+
+uint64_t Simulator::make_ts(uint64_t base, uint64_t& seq,
+                            uint64_t& last_ts) const {
+  // One ts per emitted event, strictly increasing per stream, so an ADD and
+  // the TRADE it caused get distinct (ordered) log keys.
+  if (cfg_.realtime_ts) {
+    last_ts = std::max(now_ns(), last_ts + 1);
+    return last_ts;
   }
+  return base | seq++;
+}
 
-  // --- Log NUMA node for this core ---
-  USHORT node = 0;
-  PROCESSOR_NUMBER pn{};
-  pn.Group = 0;
-  pn.Number = static_cast<BYTE>(core_id);
-  if (GetNumaProcessorNodeEx(&pn, &node)) {
-    safe_log("[Affinity] Thread pinned to core ", core_id, " on NUMA node ",
-             node);
-  } else {
-    safe_log("[Affinity] Thread pinned to core ", core_id,
-             " (NUMA node unknown)");
+uint64_t Simulator::now_ns() const {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::unique_ptr<OrderGenerator> Simulator::make_generator(
+    uint64_t seed, size_t n_symbols) const {
+  return std::make_unique<OrderGenerator>(seed, n_symbols, cfg_.sigma,
+                                          cfg_.drift_ampl, cfg_.drift_period,
+                                          cfg_.scenario);
+}
+
+size_t Simulator::next_intents(ThreadContext& ctx, uint64_t first_step) {
+  ctx.batch_step = first_step;
+  ctx.batch_gen = ctx.gen->state();
+  return next_intents(ctx, *ctx.gen, *ctx.intents, first_step);
+}
+
+size_t Simulator::next_intents(ThreadContext& ctx, OrderGenerator& gen,
+                               IntentBatch& b, uint64_t first_step) {
+  using clock = std::chrono::steady_clock;
+  const size_t n = IntentBatch::kCapacity;
+  const auto t0 = clock::now();
+  gen.fill(b, first_step, n);
+  ctx.gen_ms +=
+      std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+  return n;
+}
+
+void Simulator::emit(ThreadContext& ctx, const CompactEvent& e) {
+  if (sequencer_) {  // the merger feeds storage and export in tape order
+    sequencer_->push(ctx.thread_id, cfg_.realtime_ts ? e.ts_ns : ctx.seq_key,
+                     e);
+    return;
   }
-#else
-  cpu_set_t cpuset;
-  CPU_ZERO(&cpuset);
-  CPU_SET(core_id, &cpuset);
-  int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
-  if (rc != 0) {
-    std::cerr << "[WARN] pthread_setaffinity_np failed for core " << core_id
-              << "(errno=" << rc << ")\n";
+#ifdef MSIM_WITH_GRPC
+  if (grpc_export_) grpc_export_->push(ctx.thread_id, e);
+#endif
+  if (async_storage_) {
+    async_storage_->push(ctx.thread_id, e);
+    return;
   }
 
-  // --- Log NUMA node for this core ---
-  int node = -1;
-// requires <numaif.h> and linking with -lnuma on Linux
-#ifdef __linux__
-  if (numa_node_of_cpu(core_id, &node) == 0)
-    std::cout << "[Affinity] Thread pinned to core " << core_id
-              << " on NUMA node " << node << "\n";
+  EventBatch& b = *ctx.batch;
+  b.push(e);
+  if (b.full()) flush_events(ctx);
+}
+
+void Simulator::flush_events(ThreadContext& ctx) {
+  EventBatch& b = *ctx.batch;
+  if (b.empty()) return;
+
+  if (!async_storage_) storage_->write_batch(b);
+  b.clear();
+}
+
+template <typename TsFn>
+void Simulator::publish_depth(ThreadContext& ctx, DepthFeed& feed,
+                              uint16_t sym, TsFn&& ts) {
+  // Every record gets its own ts: stores key records by (symbol, ts).
+  auto& out = ctx.depth_out;
+  out.clear();
+  const bool snap = feed.update(out);
+  for (const DepthUpdate& u : out)
+    emit(ctx, DepthFeed::to_event(ts(), sym, EventType::DEPTH_UPDATE, u));
+  ctx.depth_records += out.size();
+  if (!snap) return;
+
+  out.clear();
+  feed.snapshot(out);
+  emit(ctx, DepthFeed::snapshot_header(ts(), sym, out.size()));
+  for (const DepthUpdate& u : out)
+    emit(ctx, DepthFeed::to_event(ts(), sym, EventType::DEPTH_SNAPSHOT, u));
+  ctx.depth_records += out.size() + 1;
+}
+
+// Calls fn(Book*) with a null pointer to the engine make_order_book(kind)
+// builds, so the caller's loop is instantiated once per engine and can
+// call its (final) books directly rather than through IOrderBook.
+template <typename Fn>
+static void with_book_type(BookKind kind, Fn&& fn) {
+  if (kind == BookKind::Ladder)
+    fn(static_cast<LadderOrderBook*>(nullptr));
   else
-    std::cout << "[Affinity] Thread pinned to core " << core_id
-              << " (NUMA node unknown)\n";
+    fn(static_cast<OrderBook*>(nullptr));
+}
+
+template <class Book, typename IdFn, typename TsFn>
+void Simulator::step(ThreadContext& ctx, const IntentBatch& in, size_t r,
+                     const StepSym& sym, IdFn&& next_id, TsFn&& ts) {
+  Book& book = static_cast<Book&>(sym.book);
+  auto& live_ids = sym.live;
+  OpLatency* const lat = ctx.lat.get();
+
+  if (in.add[r] || live_ids.empty()) {
+    const Side side = in.side[r];
+    const int32_t tick = round_tick(sym.mid_tick + sym.mid_tick * in.move[r]);
+    const int qty = in.qty[r];
+    const OrderType type = in.type[r];
+
+    const uint64_t id = next_id();
+    const uint64_t add_ts = ts();
+
+    Order o{id, tick, qty, side, add_ts};
+
+    int32_t trade_tick = 0;
+    const uint64_t c0 = lat ? LatencyClock::now() : 0;
+    const int result = book.add_order(o, trade_tick, type);
+    const int matched = filled_qty(result);
+    if (lat)
+      (matched > 0 ? lat->fill : lat->add).record(LatencyClock::now() - c0);
+
+    // A dropped remainder (ladder window) never reached the book: log the
+    // ADD with only the qty that traded, so a replay trades the same and
+    // rests nothing, and don't track the id.
+    const bool dropped = is_rejected(result);
+    if (dropped) ++ctx.rejected;
+    if (!dropped || matched > 0)
+      emit(ctx, CompactEvent{add_ts, tick, dropped ? matched : qty, sym.id,
+                             add_event(type), side, id});
+    if (matched > 0) {
+      emit(ctx, CompactEvent{ts(), trade_tick, matched, sym.id,
+                             EventType::TRADE, side, id});
+      ++ctx.trades;
+    } else if (!dropped) {
+      ++ctx.adds;
+    }
+
+    // If not fully filled, the order rests and can be canceled later
+    if (!dropped && matched < qty && rests(type)) live_ids.push_back(id);
+
+    // Mid update
+    auto bb = book.best_bid_tick();
+    auto ba = book.best_ask_tick();
+    if (bb && ba)
+      sym.mid_tick = (double(*bb) + *ba) * 0.5;
+    else if (bb)
+      sym.mid_tick = *bb;
+    else if (ba)
+      sym.mid_tick = *ba;
+
+  } else {
+    // Cancel a random known-live id. If it's stale, we drop it.
+    const size_t li = static_cast<size_t>(in.pick[r] * live_ids.size());
+    const uint64_t victim = live_ids[li];
+    live_ids[li] = live_ids.back();
+    live_ids.pop_back();
+
+    const uint64_t c0 = lat ? LatencyClock::now() : 0;
+    const bool canceled = book.cancel_order(victim);
+    if (lat) lat->cancel.record(LatencyClock::now() - c0);
+    if (canceled) {
+      emit(ctx, CompactEvent{ts(), 0, 0, sym.id, EventType::ORDER_CANCEL,
+                             Side::BUY, victim});
+      ++ctx.cancels;
+    }
+  }
+  if (sym.depth) publish_depth(ctx, *sym.depth, sym.id, ts);
+}
+
+void Simulator::start_async_storage(size_t n_producers) {
+  if (!cfg_.async_log || cfg_.log_path.empty() || sequencer_) return;
+
+  std::vector<std::unique_ptr<IStorage>> sinks;
+  sinks.push_back(std::move(storage_));
+  storage_ = make_storage("");  // NullStorage; the writer thread owns the log
+  async_storage_ = std::make_unique<AsyncStorage>(std::move(sinks),
+                                                  n_producers, &symbols_);
+}
+
+void Simulator::stop_async_storage() {
+  if (!async_storage_) return;
+  async_storage_->close();
+  std::cout << "Async log:     " << async_storage_->written() << " events, "
+            << async_storage_->writers() << " writer(s), "
+            << async_storage_->stalls() << " producer stalls\n";
+  async_storage_.reset();
+}
+
+void Simulator::start_monitor(size_t n_workers) {
+  if (cfg_.progress_ms == 0) return;
+  live_stats_ = std::vector<LiveStats>(n_workers);
+  monitor_ = std::make_unique<LiveMonitor>(
+      live_stats_, cfg_.total_events,
+      std::chrono::milliseconds(cfg_.progress_ms), std::cerr);
+}
+
+void Simulator::stop_monitor() {
+  if (!monitor_) return;
+  monitor_->stop();
+  monitor_.reset();
+  live_stats_.clear();
+}
+
+void Simulator::start_sequencer(size_t n_producers) {
+  if (!cfg_.sequence) return;
+
+  Sequencer::Tap tap;
+#ifdef MSIM_WITH_GRPC
+  tap = [this](const EventBatch& b) {
+    if (!grpc_export_) return;
+    for (size_t i = 0; i < b.size(); ++i) grpc_export_->push(0, b.row(i));
+  };
 #endif
+  sequencer_ = std::make_unique<Sequencer>(std::move(storage_), n_producers,
+                                           &symbols_, std::move(tap));
+  storage_ = make_storage("");  // NullStorage; the merger owns the log
+}
+
+void Simulator::stop_sequencer() {
+  if (!sequencer_) return;
+  sequencer_->close();
+  std::cout << "Sequencer:     " << sequencer_->written() << " events from "
+            << sequencer_->producers() << " worker(s), "
+            << sequencer_->stalls() << " producer stalls, "
+            << sequencer_->waits() << " merger waits\n";
+  sequencer_.reset();
+}
+
+void Simulator::start_grpc_export(size_t n_producers) {
+#ifdef MSIM_WITH_GRPC
+  if (cfg_.grpc_target.empty()) return;
+  grpc_export_ = std::make_unique<GrpcExporter>(cfg_.grpc_target, n_producers,
+                                                &symbols_, cfg_.grpc);
+#else
+  (void)n_producers;
 #endif
 }
 
-uint64_t Simulator::make_ts(uint64_t i_event, uint32_t thread_id) const {
-  if (cfg_.realtime_ts) return now_ns();
-  // Deterministic + fast. Unique across threads.
-  return (uint64_t(thread_id) << 48) | i_event;
+void Simulator::stop_grpc_export() {
+#ifdef MSIM_WITH_GRPC
+  if (!grpc_export_) return;
+  const bool ok = grpc_export_->close();
+  const GrpcExporter& x = *grpc_export_;
+  std::cout << "gRPC export:   " << x.sent() << " sent, " << x.dropped()
+            << " dropped (ring " << x.ring_drops() << ", queue "
+            << x.queue_drops() << ", sampled " << x.sampled_out() << "), "
+            << x.batches() << " batches over " << x.streams()
+            << " stream(s), " << x.stalls() << " producer stalls\n"
+            << "gRPC wire:     "
+            << (x.format() == WireFormat::Packed ? "packed" : "rows") << ", "
+            << (x.sent() ? double(x.bytes()) / double(x.sent()) : 0.0)
+            << " bytes/event\n"
+            << "Collector ACK count: " << x.acked() << "\n";
+  if (!ok)
+    std::cerr << "[WARN] gRPC export ended with an error: " << x.error()
+              << "\n";
+  grpc_export_.reset();
+#endif
 }
 
-uint64_t Simulator::now_ns() const {
-  using namespace std::chrono;
-  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
-      .count();
+uint64_t Simulator::checkpoint_steps(size_t n_workers) const {
+  if (!cfg_.checkpoint_every || cfg_.checkpoint_path.empty()) return 0;
+  return std::max<uint64_t>(1, cfg_.checkpoint_every / n_workers);
 }
 
-double Simulator::draw_price(double mid, uint64_t i_event, ThreadContext& ctx) {
-  double sigma = cfg_.sigma;
+CheckpointWorker Simulator::save_worker(const ThreadContext& ctx,
+                                        uint64_t step, uint64_t next_id) {
+  CheckpointWorker w;
+  w.step = step;
+  w.next_id = next_id;
+  w.seq = ctx.seq;
+  w.last_ts = ctx.last_ts;
+  // Rows of the batch in hand that already ran; the rest were drawn but
+  // not run, so save the state they were drawn from.
+  const uint64_t row = step - ctx.batch_step;
+  if (row < ctx.intents->n) {
+    w.gen = ctx.batch_gen;
+    w.batch_row = static_cast<uint32_t>(row);
+  } else {
+    w.gen = ctx.gen->state();
+  }
+  return w;
+}
 
-  if (cfg_.drift_ampl > 0.0 && cfg_.drift_period > 0) {
-    double phase =
-        double(i_event % cfg_.drift_period) / double(cfg_.drift_period);
-    sigma *= (1.0 + cfg_.drift_ampl * std::sin(phase * 2.0 * M_PI));
+size_t Simulator::restore_worker(const ckpt::WorkerRec& w,
+                                 ThreadContext& ctx) {
+  ctx.seq = w.seq;
+  ctx.last_ts = w.last_ts;
+  ctx.gen->restore(w.gen);
+  if (w.batch_row == 0) return 0;
+  next_intents(ctx, w.step - w.batch_row);
+  return w.batch_row;
+}
+
+void Simulator::check_resume(
+    const std::vector<std::vector<std::string>>& want) const {
+  const CheckpointReader& r = *resume_;
+  if (r.workers() != want.size())
+    throw std::runtime_error(
+        "checkpoint has " + std::to_string(r.workers()) +
+        " worker(s); this run has " + std::to_string(want.size()) +
+        " (use the same --threads and symbols)");
+  for (size_t w = 0; w < want.size(); ++w) {
+    const ckpt::WorkerRec& rec = r.worker(w);
+    bool same = rec.n_symbols == want[w].size();
+    for (size_t k = 0; same && k < want[w].size(); ++k)
+      same = r.name(r.symbol(rec.first_symbol + k)) == want[w][k];
+    if (!same)
+      throw std::runtime_error("checkpoint worker " + std::to_string(w) +
+                               " holds different symbols than this run");
   }
+}
 
-  return ctx.normal(ctx.rng, mid, mid * sigma);
+void Simulator::save_checkpoint(
+    const std::vector<CheckpointWorker>& parts) const {
+  try {
+    write_checkpoint(cfg_.checkpoint_path, cfg_.seed, cfg_.realtime_ts,
+                     parts);
+  } catch (const std::exception& ex) {
+    safe_err("[Checkpoint] write failed: ", ex.what());
+  }
 }
 
-void Simulator::emit_event(const Event& e) {
-  storage_->write(e);
+std::vector<std::pair<std::string, uint64_t>> Simulator::book_checksums()
+    const {
+  std::vector<std::pair<std::string, uint64_t>> out(syms_.size());
+  for (const auto& kv : syms_)
+    out[kv.second.id] = {kv.first, kv.second.book->state_checksum()};
+  return out;
+}
 
-#ifdef MSIM_WITH_GRPC
-  if (grpc_sink_) grpc_sink_->write_event(e);
-#endif
+ArenaReport Simulator::arena_report(const std::string& label,
+                                    const ArenaBundle& a, int want_node) {
+  ArenaReport r;
+  r.label = label;
+  r.upstream_bytes = a.counter.bytes_allocated();
+  if (a.pool) {
+    r.live_bytes = a.pool->live_bytes();
+    r.high_water = a.pool->high_water();
+  }
+  r.node = a.buffer.node();
+  r.want_node = want_node;
+  r.pages = NodeBuffer::huge_name(a.buffer.huge_pages());
+  return r;
+}
+
+void Simulator::print_arena(const ArenaReport& a) {
+  std::cout << "  " << a.label << ": " << a.upstream_bytes
+            << " bytes upstream";
+  if (a.live_bytes)
+    std::cout << ", live " << *a.live_bytes << ", high-water "
+              << *a.high_water;
+  std::cout << ", node "
+            << (a.node >= 0 ? std::to_string(a.node) : "?") << ", pages "
+            << a.pages;
+  if (a.node >= 0 && a.want_node >= 0 && a.node != a.want_node)
+    std::cout << " [REMOTE: worker on node " << a.want_node << "]";
+  std::cout << "\n";
+}
+
+ThreadReport Simulator::thread_report(const ThreadContext& c) {
+  ThreadReport r;
+  r.thread = c.thread_id;
+  r.cpu = c.cpu;
+  r.node = c.node;
+  r.symbols = c.symbols.size();
+  r.steps = c.steps;
+  r.adds = c.adds;
+  r.cancels = c.cancels;
+  r.trades = c.trades;
+  r.rejected = c.rejected;
+  r.quanta = c.quanta;
+  r.steals = c.steals;
+  r.elapsed_ms = c.elapsed_ms;
+  r.gen_ms = c.gen_ms;
+  r.perf = c.perf;
+  return r;
+}
+
+std::unique_ptr<PerfCounters> Simulator::open_perf() {
+  auto perf = std::make_unique<PerfCounters>();
+  if (perf->available()) return perf;
+  static std::atomic<bool> warned{false};
+  if (!warned.exchange(true, std::memory_order_relaxed))
+    safe_err("[WARN] --perf: ", perf->error(), "; counters off");
+  return nullptr;
+}
+
+void Simulator::print_perf(const Contexts& contexts, RunReport& rep) {
+  for (const auto& c : contexts) {
+    if (!c->perf.threads) continue;
+    const std::string label = "thread " + std::to_string(c->thread_id);
+    c->perf.print(std::cout, label.c_str(), c->steps);
+    rep.perf_counts.merge(c->perf);
+  }
+  if (rep.perf_counts.threads)
+    rep.perf_counts.print(std::cout, "all", rep.total_events);
+}
+
+RunReport Simulator::make_report(const char* mode, size_t n_threads) const {
+  RunReport r;
+  r.mode = mode;
+  r.scenario = cfg_.scenario.name;
+  r.book = cfg_.book_kind == BookKind::Ladder ? "ladder" : "hash";
+  r.arena = cfg_.arena_kind == ArenaKind::Pool ? "pool" : "monotonic";
+  r.seed = cfg_.seed;
+  r.total_events = cfg_.total_events;
+  r.n_symbols = syms_.size();
+  r.n_threads = n_threads;
+  r.arena_bytes = cfg_.arena_bytes;
+  r.log_path = cfg_.log_path;
+  r.latency = cfg_.latency;
+  r.perf = cfg_.perf;
+  if (resume_) r.resumed_at = resume_->header().events_done;
+  return r;
+}
+
+void Simulator::write_report(
+    RunReport& rep, const std::vector<const IOrderBook*>& books) const {
+  if (cfg_.json_path.empty()) return;
+  for (const IOrderBook* b : books)
+    rep.books.push_back({b->symbol(), b->index_size(), b->state_checksum(),
+                         b->rejected()});
+  write_json_file(cfg_.json_path, rep);
+}
+
+// Final book digest; `--replay` of the same log must print the same value.
+void Simulator::print_checksum(const IOrderBook& book) {
+  char sum[24];
+  std::snprintf(sum, sizeof(sum), "%016llx",
+                (unsigned long long)book.state_checksum());
+  std::cout << "Book " << book.symbol() << ": resting=" << book.index_size()
+            << " checksum=" << sum;
+  if (book.rejected()) std::cout << " rejected=" << book.rejected();
+  std::cout << "\n";
+}
+
+// Names every book that dropped an add's remainder (the ladder's window is
+// too narrow for the run's price range).
+static void warn_rejected(const std::vector<const IOrderBook*>& books) {
+  uint64_t n = 0;
+  std::string which;
+  for (const IOrderBook* b : books) {
+    if (!b->rejected()) continue;
+    n += b->rejected();
+    which += " " + b->symbol() + "=" + std::to_string(b->rejected());
+  }
+  if (n)
+    std::cerr << "[WARN] " << n << " adds had their remainder dropped: its "
+              << "price fell outside the ladder window (" << which.substr(1)
+              << ")\n";
 }
 
 void Simulator::run() {
   using clock = std::chrono::high_resolution_clock;
   auto t0 = clock::now();
 
-  uint64_t adds = 0, cancels = 0, trades = 0;
+  start_async_storage(1);
+  start_grpc_export(1);
+  start_monitor(1);
 
   ThreadContext ctx;
-  ctx.rng = Xoroshiro128Plus(cfg_.seed);
-  ctx.normal = NormalBM{};
+  ctx.gen = make_generator(cfg_.seed, syms_.size());
+  ctx.intents = std::make_unique<IntentBatch>();
+  ctx.thread_id = 0;
+  ctx.batch = std::make_unique<EventBatch>(&symbols_, ctx.thread_id);
+  if (!live_stats_.empty()) ctx.stats = &live_stats_[0];
 
   // Build stable arrays so we don't hash strings in the loop
-  std::vector<std::string> names;
   std::vector<SymState*> states;
-  names.reserve(syms_.size());
   states.reserve(syms_.size());
-  for (auto& kv : syms_) {
-    names.push_back(kv.first);
-    states.push_back(&kv.second);
+  for (auto& kv : syms_) states.push_back(&kv.second);
+
+  // Per-symbol live id list (may contain stale ids; we clean on failed
+  // cancel), each in its symbol's arena
+  std::vector<std::pmr::vector<uint64_t>> live;
+  live.reserve(states.size());
+  for (SymState* st : states) live.emplace_back(st->mem->resource());
+
+  uint64_t i0 = 0;  // first step; the checkpoint's with --resume
+  size_t r0 = 0;    // its row of ctx.intents
+  if (resume_) {
+    std::vector<std::string> names;
+    for (SymState* st : states) names.push_back(st->book->symbol());
+    check_resume({names});
+    const ckpt::WorkerRec& w = resume_->worker(0);
+    for (size_t si = 0; si < states.size(); ++si) {
+      const ckpt::SymbolRec& rec = resume_->symbol(w.first_symbol + si);
+      resume_->restore_book(rec, *states[si]->book);
+      states[si]->mid_tick = rec.mid_tick;
+      live[si].assign(resume_->live(rec), resume_->live(rec) + rec.n_live);
+    }
+    r0 = restore_worker(w, ctx);
+    next_order_id_ = w.next_id;
+    i0 = w.step;
   }
-
-  // Per-symbol live id list (may contain stale ids; we clean on failed cancel)
-  std::vector<std::vector<uint64_t>> live(states.size());
-
-  for (uint64_t i = 0; i < cfg_.total_events; ++i) {
-    const size_t si = rand_index(ctx.rng, states.size());
-    SymState& st = *states[si];
-    OrderBook& book = *st.book;
-
-    auto& live_ids = live[si];
-    const bool do_add = rand_bool(ctx.rng, 0.5);
-
-    if (do_add || live_ids.empty()) {
-      const Side side = rand_bool(ctx.rng, 0.5) ? Side::BUY : Side::SELL;
-      const double p = draw_price(st.mid, i, ctx);
-      const int qty = rand_int(ctx.rng, 1, 100);
-
-      const uint64_t id = next_order_id_++;
-      const uint64_t ts = make_ts(i, /*thread_id=*/0);
-
-      Order o{id, p, qty, side, ts};
-
-      double trade_px = 0.0;
-      const int matched = book.add_order(o, trade_px);
-
-      Event e;
-      e.ts_ns = ts;
-      e.symbol = names[si];
-      e.price = o.price;
-      e.qty = o.qty;
-      e.side = o.side;
-
-      if (matched > 0) {
-        e.type = EventType::TRADE;
-        e.price = trade_px;
-        e.qty = matched;
-        emit_event(e);
-        ++trades;
-      } else {
-        e.type = EventType::ORDER_ADD;
-        emit_event(e);
-        ++adds;
+  const uint64_t end = i0 + cfg_.total_events;
+
+  // After any restore, so feeds start from the resting books.
+  if (cfg_.depth_levels)
+    for (SymState* st : states)
+      st->depth = std::make_unique<DepthFeed>(*st->book, cfg_.depth_levels,
+                                              cfg_.depth_snapshot_every);
+
+  const uint64_t ckpt_every = checkpoint_steps(1);
+  uint64_t ckpt_at = ckpt_every ? i0 + ckpt_every : UINT64_MAX;  // periodic
+  auto snapshot = [&](uint64_t step) {
+    std::vector<CheckpointWorker> parts{
+        save_worker(ctx, step, next_order_id_)};
+    for (size_t si = 0; si < states.size(); ++si)
+      parts[0].symbols.push_back(capture_symbol(
+          *states[si]->book, states[si]->mid_tick, live[si].data(),
+          live[si].size()));
+    save_checkpoint(parts);
+  };
+
+  if (cfg_.latency) ctx.lat = std::make_unique<OpLatency>();
+  OpLatency* const lat = ctx.lat.get();
+  const LatencyClock::Calibration cal;
+  const auto perf = cfg_.perf ? open_perf() : nullptr;
+  if (perf) perf->start();
+
+  const IntentBatch& in = *ctx.intents;
+  with_book_type(cfg_.book_kind, [&](auto* book_type) {
+    using Book = std::remove_pointer_t<decltype(book_type)>;
+    size_t r = r0, n = in.n;  // row in / rows of the current intent batch
+    for (uint64_t i = i0; i < end; ++i, ++r) {
+      if (i == ckpt_at) {
+        snapshot(i);
+        ckpt_at += ckpt_every;
       }
-
-      // If not fully filled, the order rests and can be canceled later
-      if (matched < qty) live_ids.push_back(id);
-
-      // Mid update
-      auto bb = book.best_bid();
-      auto ba = book.best_ask();
-      if (bb && ba)
-        st.mid = (*bb + *ba) * 0.5;
-      else if (bb)
-        st.mid = *bb;
-      else if (ba)
-        st.mid = *ba;
-
-    } else {
-      // Cancel a random known-live id. If it's stale, we drop it.
-      const size_t li = rand_index(ctx.rng, live_ids.size());
-      const uint64_t victim = live_ids[li];
-      live_ids[li] = live_ids.back();
-      live_ids.pop_back();
-
-      if (book.cancel_order(victim)) {
-        Event e;
-        e.ts_ns = make_ts(i, /*thread_id=*/0);
-        e.type = EventType::ORDER_CANCEL;
-        e.symbol = names[si];
-        e.price = 0.0;
-        e.qty = 0;
-        e.side = Side::BUY;
-        emit_event(e);
-        ++cancels;
+      if (r == n) {
+        ctx.steps = i - i0;
+        publish_stats(ctx);
+        n = next_intents(ctx, i);
+        r = 0;
       }
+      const size_t si = in.sym[r];
+      SymState& st = *states[si];
+      step<Book>(ctx, in, r,
+                 {*st.book, st.mid_tick, live[si], st.depth.get(), st.id},
+                 [&] { return next_order_id_++; },
+                 [&] { return make_ts(ctx); });
     }
+  });
+  if (perf) {
+    perf->stop();
+    ctx.perf = perf->counts();
   }
 
+  flush_events(ctx);
+  if (!cfg_.checkpoint_path.empty()) snapshot(end);
+  stop_monitor();
+  stop_async_storage();
+  stop_grpc_export();
   storage_->flush();
   auto t1 = clock::now();
   auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
@@ -256,77 +644,164 @@ void Simulator::run() {
   std::cout << "MarketSim (PMR) Report\n"
             << "---------------------------\n"
             << "Symbols:           " << syms_.size() << "\n"
-            << "Total events:      " << cfg_.total_events << "\n"
-            << "Adds:              " << adds << "\n"
-            << "Cancels:           " << cancels << "\n"
-            << "Trades:            " << trades << "\n"
-            << "Elapsed:           " << us / 1000.0 << " ms\n"
+            << "Scenario:          " << cfg_.scenario.name << "\n"
+            << "Total events:      " << cfg_.total_events << "\n";
+  if (resume_)
+    std::cout << "Resumed at:        " << i0 << " events ("
+              << cfg_.resume_path << ")\n";
+  std::cout << "Adds:              " << ctx.adds << "\n"
+            << "Cancels:           " << ctx.cancels << "\n"
+            << "Trades:            " << ctx.trades << "\n";
+  if (ctx.rejected)
+    std::cout << "Rejected:          " << ctx.rejected
+              << " (remainder dropped)\n";
+  std::cout << "Elapsed:           " << us / 1000.0 << " ms\n"
+            << "Generator:         " << ctx.gen_ms << " ms\n"
             << "Throughput:        " << (uint64_t)evps << " ev/s\n";
-
+  if (cfg_.depth_levels)
+    std::cout << "Depth records:     " << ctx.depth_records << " (top "
+              << cfg_.depth_levels << ")\n";
+  if (lat) lat->print(std::cout, cal.ns_per_tick());
+  if (ctx.perf.threads) ctx.perf.print(std::cout, "all", cfg_.total_events);
+
+  RunReport report = make_report("run", 1);
+  report.adds = ctx.adds;
+  report.cancels = ctx.cancels;
+  report.trades = ctx.trades;
+  report.rejected = ctx.rejected;
+  report.depth_records = ctx.depth_records;
+  report.wall_ms = report.elapsed_max_ms = us / 1000.0;
+  report.generator_ms = ctx.gen_ms;
+  report.throughput_ev_s = report.steps_per_s = evps;
+  const double ops = double(ctx.adds + ctx.cancels + ctx.trades);
+  report.book_ops_per_s = ops * 1e6 / double(us);
+  const double match_ms = report.wall_ms - ctx.gen_ms;
+  report.match_ops_per_s = match_ms > 0.0 ? ops * 1000.0 / match_ms : 0.0;
+  ThreadReport thread;  // not thread_report(): run()'s ctx has no symbols
+  thread.node = current_numa_node();
+  thread.symbols = states.size();
+  thread.steps = cfg_.total_events;
+  thread.adds = ctx.adds;
+  thread.cancels = ctx.cancels;
+  thread.trades = ctx.trades;
+  thread.rejected = ctx.rejected;
+  thread.elapsed_ms = report.wall_ms;
+  thread.gen_ms = ctx.gen_ms;
+  thread.perf = report.perf_counts = ctx.perf;
+  report.threads.push_back(thread);
+  if (lat) report.add_latency(*lat, cal.ns_per_tick());
+
+  for (auto& kv : syms_)
+    report.arenas.push_back(
+        arena_report(kv.first, *kv.second.mem, thread.node));
   if (cfg_.print_arena) {
     std::cout << "Arena usage (upstream bytes requested):\n";
-    for (auto& kv : syms_) {
-      std::cout << "  " << kv.first << ": "
-                << kv.second.mem->counter.bytes_allocated() << " bytes\n";
-    }
+    for (const ArenaReport& a : report.arenas) print_arena(a);
+  }
+  if (!cfg_.log_path.empty()) {
+    for (auto& kv : syms_) print_checksum(*kv.second.book);
   }
   std::cout << "---------------------------\n";
+
+  std::vector<const IOrderBook*> books;
+  for (SymState* st : states) books.push_back(st->book.get());
+  warn_rejected(books);
+  write_report(report, books);
 }  // Simulator::run
 
 void Simulator::run_mt() {
   using clock = std::chrono::high_resolution_clock;
   auto t0 = clock::now();
+  const LatencyClock::Calibration cal;
 
   const size_t n_symbols = syms_.size();
-  size_t n_threads =
-      (cfg_.num_threads > 0)
-          ? static_cast<size_t>(cfg_.num_threads)
-          : std::min(n_symbols, static_cast<size_t>(std::thread::hardware_concurrency()));
-
-  n_threads = std::max<size_t>(1, std::min(n_threads, n_symbols));
-  const size_t per_thread = (n_symbols + n_threads - 1) / n_threads;
+  const size_t n_threads = worker_count(cfg_.num_threads, n_symbols);
+  const auto chunks = partition_range(n_symbols, n_threads);
 
   // Gather symbol names once
   std::vector<std::string> all_syms;
   all_syms.reserve(n_symbols);
   for (auto& kv : syms_) all_syms.push_back(kv.first);
 
-  std::vector<std::thread> workers;
-  std::vector<ThreadContext> contexts(n_threads);
-
-  // Build per-thread contexts (symbols + books + mids + live lists)
-  size_t idx = 0;
-  for (size_t t = 0; t < n_threads; ++t) {
-    ThreadContext& ctx = contexts[t];
-
-    const size_t start = idx;
-    const size_t end = std::min(start + per_thread, n_symbols);
-    idx = end;
-
-    ctx.symbols.reserve(end - start);
-    for (size_t i = start; i < end; ++i) ctx.symbols.push_back(all_syms[i]);
-
-    ctx.rng = Xoroshiro128Plus(cfg_.seed + static_cast<uint64_t>(t));
-    ctx.normal = NormalBM{};
-    ctx.arena = std::make_unique<ArenaBundle>(cfg_.arena_bytes);
+  if (resume_) {
+    std::vector<std::vector<std::string>> want(n_threads);
+    for (size_t t = 0; t < n_threads; ++t)
+      want[t].assign(all_syms.begin() + chunks[t].first,
+                     all_syms.begin() + chunks[t].second);
+    check_resume(want);
+  }
+  if (!cfg_.checkpoint_path.empty())
+    ckpt_gate_ = std::make_unique<CheckpointGate>(
+        n_threads,
+        [this](const std::vector<CheckpointWorker>& parts) {
+          save_checkpoint(parts);
+        });
 
-    ctx.books.reserve(ctx.symbols.size());
-    ctx.mid.resize(ctx.symbols.size(), 100.0);
-    ctx.live.resize(ctx.symbols.size());
+  std::vector<std::thread> workers;
+  Contexts contexts(n_threads);  // each filled in by its own worker
 
-    for (size_t i = 0; i < ctx.symbols.size(); ++i) {
-      ctx.books.emplace_back(std::make_unique<OrderBook>(ctx.symbols[i], &ctx.arena->arena));
-    }
-  }
+  start_sequencer(n_threads);
+  start_async_storage(n_threads);  // no-op under --sequence
+  start_grpc_export(sequencer_ ? 1 : n_threads);
+  start_monitor(n_threads);
 
   // Launch workers
   workers.reserve(n_threads);
   for (size_t t = 0; t < n_threads; ++t) {
-    workers.emplace_back([this, &contexts, t, n_threads]() {
-      ThreadContext& ctx = contexts[t];
-      if (ctx.symbols.empty()) return;
-
-      this->bind_to_core(t);
+    workers.emplace_back([this, &contexts, &all_syms, &chunks, t,
+                          n_threads]() {
+      // Pin first: the context, its arena, books, live lists, generator
+      // and emit buffer are all allocated (and first-touched) after this,
+      // on this worker's node.
+      const size_t cpu = worker_cpu(cfg_.cpu_list, t);
+      const int node = bind_to_core(cpu);
+      contexts[t] = std::make_unique<ThreadContext>();
+      ThreadContext& ctx = *contexts[t];
+      ctx.thread_id = static_cast<uint32_t>(t);
+      ctx.cpu = cpu;
+      ctx.node = node;
+      if (!live_stats_.empty()) ctx.stats = &live_stats_[t];
+
+      const auto [start, end] = chunks[t];
+      if (start == end) {
+        if (sequencer_) sequencer_->finish(t);
+        if (ckpt_gate_) ckpt_gate_->leave(t, CheckpointWorker{});
+        return;
+      }
+      ctx.symbols.reserve(end - start);
+      for (size_t i = start; i < end; ++i) {
+        ctx.symbols.push_back(all_syms[i]);
+        ctx.sym_ids.push_back(syms_.at(all_syms[i]).id);
+      }
+      ctx.batch = std::make_unique<EventBatch>(&symbols_, ctx.thread_id);
+      ctx.gen =
+          make_generator(cfg_.seed + static_cast<uint64_t>(t), end - start);
+      ctx.intents = std::make_unique<IntentBatch>();
+
+      ctx.arena = std::make_unique<ArenaBundle>(
+          cfg_.arena_bytes, ctx.node, cfg_.huge_pages, cfg_.arena_kind);
+      ctx.books.reserve(ctx.symbols.size());
+      ctx.live.reserve(ctx.symbols.size());
+      for (size_t i = 0; i < ctx.symbols.size(); ++i) {
+        ctx.books.emplace_back(make_order_book(
+            cfg_.book_kind, ctx.symbols[i], ctx.arena->resource(),
+            symbols_.tick_size(ctx.sym_ids[i])));
+        ctx.mid_tick.push_back(kStartPrice /
+                               symbols_.tick_size(ctx.sym_ids[i]));
+        ctx.live.emplace_back(ctx.arena->resource());
+        if (resume_) {
+          const ckpt::SymbolRec& rec =
+              resume_->symbol(resume_->worker(t).first_symbol + i);
+          resume_->restore_book(rec, *ctx.books.back());
+          ctx.mid_tick.back() = rec.mid_tick;
+          ctx.live.back().assign(resume_->live(rec),
+                                 resume_->live(rec) + rec.n_live);
+        }
+        if (cfg_.depth_levels)  // after the restore: starts from its book
+          ctx.depth.emplace_back(std::make_unique<DepthFeed>(
+              *ctx.books.back(), cfg_.depth_levels,
+              cfg_.depth_snapshot_every));
+      }
 
       auto t0_thread = clock::now();
 
@@ -335,76 +810,76 @@ void Simulator::run_mt() {
       const uint64_t iters = base + (t == n_threads - 1 ? rem : 0);
 
       uint64_t local_id = 1;  // thread-local ids; no contention
-
-      for (uint64_t i = 0; i < iters; ++i) {
-        const size_t si = rand_index(ctx.rng, ctx.symbols.size());
-        OrderBook& book = *ctx.books[si];
-        auto& live_ids = ctx.live[si];
-
-        const bool do_add = rand_bool(ctx.rng, 0.5);
-
-        if (do_add || live_ids.empty()) {
-          const Side side = rand_bool(ctx.rng, 0.5) ? Side::BUY : Side::SELL;
-          const double p = draw_price(ctx.mid[si], i, ctx);
-          const int qty = rand_int(ctx.rng, 1, 100);
-
-          const uint64_t id = (uint64_t(t) << 56) | local_id++;
-          const uint64_t ts = make_ts(i, static_cast<uint32_t>(t));
-
-          Order o{id, p, qty, side, ts};
-
-          double trade_px = 0.0;
-          const int matched = book.add_order(o, trade_px);
-
-          Event e;
-          e.ts_ns = ts;
-          e.symbol = ctx.symbols[si];
-          e.price = o.price;
-          e.qty = o.qty;
-          e.side = o.side;
-
-          if (matched > 0) {
-            e.type = EventType::TRADE;
-            e.price = trade_px;
-            e.qty = matched;
-            emit_event(e);
-            ++ctx.trades;
-          } else {
-            e.type = EventType::ORDER_ADD;
-            emit_event(e);
-            ++ctx.adds;
+      uint64_t i0 = 0;        // first step; the checkpoint's with --resume
+      size_t r0 = 0;          // its row of ctx.intents
+      if (resume_) {
+        const ckpt::WorkerRec& w = resume_->worker(t);
+        r0 = restore_worker(w, ctx);
+        local_id = w.next_id;
+        i0 = w.step;
+      }
+      const uint64_t i_end = i0 + iters;
+
+      // Periodic snapshots stop short of the shortest worker's end, so
+      // every worker reaches each one.
+      const uint64_t ckpt_every = checkpoint_steps(n_threads);
+      auto next_ckpt = [&](uint64_t i) {
+        return ckpt_every && i + ckpt_every < i0 + base ? i + ckpt_every
+                                                        : UINT64_MAX;
+      };
+      uint64_t ckpt_at = next_ckpt(i0);
+      auto snapshot = [&](uint64_t step) {
+        CheckpointWorker part = save_worker(ctx, step, local_id);
+        for (size_t k = 0; k < ctx.books.size(); ++k)
+          part.symbols.push_back(capture_symbol(*ctx.books[k],
+                                                ctx.mid_tick[k],
+                                                ctx.live[k].data(),
+                                                ctx.live[k].size()));
+        ckpt_gate_->arrive(t, std::move(part));
+      };
+
+      if (cfg_.latency) ctx.lat = std::make_unique<OpLatency>();
+      const auto perf = cfg_.perf ? open_perf() : nullptr;
+      if (perf) perf->start();
+
+      const IntentBatch& in = *ctx.intents;
+      with_book_type(cfg_.book_kind, [&](auto* book_type) {
+        using Book = std::remove_pointer_t<decltype(book_type)>;
+        size_t r = r0, n = in.n;
+        for (uint64_t i = i0; i < i_end; ++i, ++r) {
+          // Step i of every worker shares one slot of logical time, so the
+          // merged tape interleaves workers step by step, the same every
+          // run.
+          ctx.seq_key = i * n_threads + t;
+          if (i == ckpt_at) {
+            snapshot(i);
+            ckpt_at = next_ckpt(i);
           }
-
-          if (matched < qty) live_ids.push_back(id);
-
-          auto bb = book.best_bid();
-          auto ba = book.best_ask();
-          if (bb && ba)
-            ctx.mid[si] = (*bb + *ba) * 0.5;
-          else if (bb)
-            ctx.mid[si] = *bb;
-          else if (ba)
-            ctx.mid[si] = *ba;
-
-        } else {
-          const size_t li = rand_index(ctx.rng, live_ids.size());
-          const uint64_t victim = live_ids[li];
-          live_ids[li] = live_ids.back();
-          live_ids.pop_back();
-
-          if (book.cancel_order(victim)) {
-            Event e;
-            e.ts_ns = make_ts(i, static_cast<uint32_t>(t));
-            e.type = EventType::ORDER_CANCEL;
-            e.symbol = ctx.symbols[si];
-            e.price = 0.0;
-            e.qty = 0;
-            e.side = Side::BUY;
-            emit_event(e);
-            ++ctx.cancels;
+          if (r == n) {
+            ctx.steps = i - i0;
+            publish_stats(ctx);
+            n = next_intents(ctx, i);
+            r = 0;
           }
+          const size_t si = in.sym[r];
+          step<Book>(ctx, in, r,
+                     {*ctx.books[si], ctx.mid_tick[si], ctx.live[si],
+                      ctx.depth.empty() ? nullptr : ctx.depth[si].get(),
+                      ctx.sym_ids[si]},
+                     [&] { return (uint64_t(t) << 56) | local_id++; },
+                     [&] { return make_ts(ctx); });
         }
+      });
+      if (perf) {
+        perf->stop();
+        ctx.perf = perf->counts();
       }
+      flush_events(ctx);
+      if (!async_storage_) storage_->flush_source(ctx.thread_id);
+      if (sequencer_) sequencer_->finish(ctx.thread_id);
+      if (ckpt_gate_) snapshot(i_end);
+      ctx.steps = iters;
+      publish_stats(ctx);
 
       auto t1_thread = clock::now();
       ctx.elapsed_ms =
@@ -414,35 +889,101 @@ void Simulator::run_mt() {
   }
 
   for (auto& th : workers) th.join();
-
-  uint64_t adds = 0, cancels = 0, trades = 0;
-  double max_ms = 0.0;
-  for (auto& c : contexts) {
-    adds += c.adds;
-    cancels += c.cancels;
-    trades += c.trades;
-    max_ms = std::max(max_ms, c.elapsed_ms);
-  }
+  ckpt_gate_.reset();
+  stop_monitor();
+  stop_sequencer();  // before the exporter: the merger feeds it
+  stop_async_storage();
+  stop_grpc_export();
+  storage_->flush();
 
   auto t1 = clock::now();
   const double elapsed_ms =
       std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(t1 - t0).count();
-  const double evps = (cfg_.total_events * 1000.0) / elapsed_ms;
 
+  RunReport report = make_report("run_mt", n_threads);
   std::cout << "\nPer-Thread Summary\n-------------------------------\n";
   for (size_t t = 0; t < n_threads; ++t) {
-    const auto& c = contexts[t];
+    const auto& c = *contexts[t];
     std::cout << "[Thread " << t << "] Symbols=" << c.symbols.size()
               << " Adds=" << c.adds << " Cancels=" << c.cancels
-              << " Trades=" << c.trades << " Time=" << c.elapsed_ms << " ms\n";
+              << " Trades=" << c.trades << " Time=" << c.elapsed_ms
+              << " ms (gen " << c.gen_ms << " ms)\n";
+    report.threads.push_back(thread_report(c));
+  }
+  print_mt_totals(contexts, elapsed_ms, report);
+  if (cfg_.latency) print_latency(contexts, cal, report);
+  if (cfg_.perf) print_perf(contexts, report);
+
+  for (const auto& c : contexts)
+    if (c->arena)
+      report.arenas.push_back(arena_report(
+          "thread " + std::to_string(c->thread_id) + " cpu " +
+              std::to_string(c->cpu),
+          *c->arena, c->node));
+  if (cfg_.print_arena) {
+    std::cout << "Arena placement (per thread):\n";
+    for (const ArenaReport& a : report.arenas) print_arena(a);
+  }
+  if (!cfg_.log_path.empty()) {
+    for (auto& c : contexts)
+      for (auto& book : c->books) print_checksum(*book);
+  }
+
+  std::vector<const IOrderBook*> books;
+  for (const auto& c : contexts)
+    for (const auto& book : c->books) books.push_back(book.get());
+  warn_rejected(books);
+  write_report(report, books);
+}  // Simulator::run_mt (multi-threaded)
+
+void Simulator::print_latency(const Contexts& contexts,
+                              const LatencyClock::Calibration& cal,
+                              RunReport& rep) {
+  auto all = std::make_unique<OpLatency>();  // ~46 KiB; keep it off the stack
+  for (const auto& c : contexts)
+    if (c->lat) all->merge(*c->lat);
+  all->print(std::cout, cal.ns_per_tick());
+  rep.add_latency(*all, cal.ns_per_tick());
+}
+
+void Simulator::print_mt_totals(const Contexts& contexts, double wall_ms,
+                                RunReport& rep) const {
+  uint64_t adds = 0, cancels = 0, trades = 0, rejected = 0, depth_records = 0;
+  double max_ms = 0.0, sum_ms = 0.0, max_gen_ms = 0.0, max_match_ms = 0.0;
+  for (auto& p : contexts) {
+    const ThreadContext& c = *p;
+    adds += c.adds;
+    cancels += c.cancels;
+    trades += c.trades;
+    rejected += c.rejected;
+    depth_records += c.depth_records;
+    max_ms = std::max(max_ms, c.elapsed_ms);
+    sum_ms += c.elapsed_ms;
+    max_gen_ms = std::max(max_gen_ms, c.gen_ms);
+    max_match_ms = std::max(max_match_ms, c.elapsed_ms - c.gen_ms);
   }
+  const double evps = (cfg_.total_events * 1000.0) / wall_ms;
+  // Slowest thread over the average one; 1.0 = every core busy to the end.
+  const double imbalance =
+      sum_ms > 0.0 ? max_ms * double(contexts.size()) / sum_ms : 1.0;
+
   std::cout << "-------------------------------\n"
-            << "Threads:       " << n_threads << "\n"
-            << "Total events:  " << cfg_.total_events << "\n"
-            << "Adds:          " << adds << "\n"
+            << "Threads:       " << contexts.size() << "\n"
+            << "Scenario:      " << cfg_.scenario.name << "\n"
+            << "Total events:  " << cfg_.total_events << "\n";
+  if (resume_)
+    std::cout << "Resumed at:    " << resume_->header().events_done
+              << " events\n";
+  std::cout << "Adds:          " << adds << "\n"
             << "Cancels:       " << cancels << "\n"
-            << "Trades:        " << trades << "\n"
-            << "Elapsed (max): " << max_ms << " ms\n"
+            << "Trades:        " << trades << "\n";
+  if (rejected)
+    std::cout << "Rejected:      " << rejected << " (remainder dropped)\n";
+  if (cfg_.depth_levels)
+    std::cout << "Depth records: " << depth_records << " (top "
+              << cfg_.depth_levels << ")\n";
+  std::cout << "Elapsed (max): " << max_ms << " ms\n"
+            << "Imbalance:     " << imbalance << " (max/mean thread time)\n"
             << "Throughput:    " << static_cast<uint64_t>(evps) << " ev/s\n"
             << "-------------------------------\n";
     
@@ -464,7 +1005,238 @@ void Simulator::run_mt() {
     << "Elapsed (max): " << ms << " ms\n"
     << "Steps/sec:     " << static_cast<uint64_t>(steps_per_s) << "\n"
     << "(steps -> generator iterations. book -> matching engine)\n"
-    << "Book ops/sec:  " << static_cast<uint64_t>(ops_per_s) << "\n";
-}  // Simulator::run_mt (multi-threaded)
+    << "Book ops/sec:  " << static_cast<uint64_t>(ops_per_s) << "\n"
+    << "Generator:     " << max_gen_ms << " ms (max thread)\n"
+    << "Match ops/sec: "
+    << static_cast<uint64_t>(max_match_ms > 0.0 ? (ops * 1000.0) / max_match_ms
+                                                : 0.0)
+    << " (excluding generator)\n";
+
+  rep.adds = adds;
+  rep.cancels = cancels;
+  rep.trades = trades;
+  rep.rejected = rejected;
+  rep.depth_records = depth_records;
+  rep.wall_ms = wall_ms;
+  rep.elapsed_max_ms = max_ms;
+  rep.generator_ms = max_gen_ms;
+  rep.imbalance = imbalance;
+  rep.throughput_ev_s = evps;
+  rep.steps_per_s = steps_per_s;
+  rep.book_ops_per_s = ops_per_s;
+  rep.match_ops_per_s =
+      max_match_ms > 0.0 ? (ops * 1000.0) / max_match_ms : 0.0;
+}
+
+// Splits `total` events over `n` symbols by weight 1/(rank+1)^zipf (rank =
+// SymbolTable id; zipf 0 = uniform). Largest remainder, ties to the lower
+// rank, so budgets depend only on the config.
+static std::vector<uint64_t> symbol_budgets(uint64_t total, size_t n,
+                                            double zipf) {
+  std::vector<double> w(n);
+  double sum = 0.0;
+  for (size_t i = 0; i < n; ++i) sum += w[i] = std::pow(double(i + 1), -zipf);
+
+  std::vector<uint64_t> out(n);
+  std::vector<std::pair<double, size_t>> rem(n);
+  uint64_t given = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const double exact = double(total) * w[i] / sum;
+    out[i] = static_cast<uint64_t>(exact);
+    given += out[i];
+    rem[i] = {exact - double(out[i]), i};
+  }
+  std::stable_sort(rem.begin(), rem.end(),
+                   [](const auto& a, const auto& b) { return a.first > b.first; });
+  for (size_t k = 0; given < total; ++k, ++given) ++out[rem[k % n].second];
+  return out;
+}
+
+void Simulator::run_quantum(ThreadContext& ctx, SymTask& task, uint64_t n) {
+  SymState& st = *task.st;
+  if (!task.gen) {
+    // The constructor built this book on the main thread; it is still
+    // empty, so rebuild it (and its arena) local to the first worker; the
+    // live id list goes in the new arena too.
+    std::string name = st.book->symbol();
+    st.depth.reset();
+    st.book.reset();
+    st.mem = std::make_unique<ArenaBundle>(cfg_.arena_bytes, ctx.node,
+                                           cfg_.huge_pages, cfg_.arena_kind);
+    st.book = make_order_book(cfg_.book_kind, std::move(name),
+                              st.mem->resource(), symbols_.tick_size(st.id));
+    task.gen = make_generator(
+        cfg_.seed ^ (uint64_t(st.id + 1) * 0x9E3779B97F4A7C15ull), 1);
+    task.intents = std::make_unique<IntentBatch>();
+    task.live.emplace(st.mem->resource());
+    if (cfg_.depth_levels)
+      st.depth = std::make_unique<DepthFeed>(*st.book, cfg_.depth_levels,
+                                             cfg_.depth_snapshot_every);
+  }
+  const IntentBatch& in = *task.intents;
+  const StepSym sym{*st.book, st.mid_tick, *task.live, st.depth.get(), st.id};
+  auto ts = [&] { return make_ts(task.ts_base, task.seq, task.last_ts); };
+
+  const uint64_t end = task.done + n;
+  with_book_type(cfg_.book_kind, [&](auto* book_type) {
+    using Book = std::remove_pointer_t<decltype(book_type)>;
+    for (; task.done < end; ++task.done, ++task.r) {
+      if (task.r == in.n) {
+        next_intents(ctx, *task.gen, *task.intents, task.done);
+        task.r = 0;
+      }
+      step<Book>(ctx, in, task.r, sym, [&] { return task.next_id++; }, ts);
+    }
+  });
+}
+
+void Simulator::run_tasks() {
+  using clock = std::chrono::high_resolution_clock;
+  auto t0 = clock::now();
+  const LatencyClock::Calibration cal;
+
+  const size_t n_symbols = syms_.size();
+  const size_t n_threads = worker_count(cfg_.num_threads, n_symbols);
+  const bool steal = cfg_.sched == SchedMode::Steal;
+  const uint64_t quantum = std::max<uint64_t>(1, cfg_.steal_quantum);
+
+  // One task per symbol, in SymbolTable id order (budget rank).
+  std::vector<SymTask> tasks(n_symbols);
+  for (auto& kv : syms_) tasks[kv.second.id].st = &kv.second;
+  const auto budgets = symbol_budgets(cfg_.total_events, n_symbols, cfg_.zipf);
+  for (size_t i = 0; i < n_symbols; ++i) {
+    tasks[i].budget = budgets[i];
+    tasks[i].ts_base = uint64_t(i) << 40;
+    tasks[i].next_id = (uint64_t(i) + 1) << 40;
+  }
+
+  // Same contiguous split as run_mt(); pushed in reverse so each owner
+  // pops its chunk in ascending order.
+  WorkQueues queues(n_threads);
+  std::atomic<size_t> pending{0};
+  const auto chunks = partition_range(n_symbols, n_threads);
+  for (size_t t = 0; t < n_threads; ++t)
+    for (size_t i = chunks[t].second; i-- > chunks[t].first;)
+      if (tasks[i].budget > 0) {
+        queues.push(t, static_cast<uint32_t>(i));
+        pending.fetch_add(1, std::memory_order_relaxed);
+      }
+
+  Contexts contexts(n_threads);  // each built by its worker, as in run_mt()
+
+  start_async_storage(n_threads);
+  start_grpc_export(n_threads);
+  start_monitor(n_threads);
+
+  std::vector<std::thread> workers;
+  workers.reserve(n_threads);
+  for (size_t t = 0; t < n_threads; ++t) {
+    workers.emplace_back([&, t]() {
+      const size_t cpu = worker_cpu(cfg_.cpu_list, t);
+      const int node = bind_to_core(cpu);
+      contexts[t] = std::make_unique<ThreadContext>();
+      ThreadContext& ctx = *contexts[t];
+      ctx.thread_id = static_cast<uint32_t>(t);
+      ctx.cpu = cpu;
+      ctx.node = node;
+      if (cfg_.latency) ctx.lat = std::make_unique<OpLatency>();
+      ctx.batch = std::make_unique<EventBatch>(&symbols_, ctx.thread_id);
+      if (!live_stats_.empty()) ctx.stats = &live_stats_[t];
+      const auto perf = cfg_.perf ? open_perf() : nullptr;
+      auto t0_thread = clock::now();
+      if (perf) perf->start();
+
+      uint32_t id = 0;
+      for (;;) {
+        bool got = queues.pop(t, id);
+        if (!got && steal && (got = queues.steal(t, id))) ++ctx.steals;
+        if (!got) {
+          // Pinned: our deque only ever holds our own tasks. Steal: a task
+          // may still be out on another worker and come back stealable.
+          if (!steal || pending.load(std::memory_order_acquire) == 0) break;
+          std::this_thread::yield();
+          continue;
+        }
+
+        SymTask& task = tasks[id];
+        if (task.last_worker != t) {
+          if (task.last_worker == UINT32_MAX)
+            task.first_worker = static_cast<uint32_t>(t);
+          else
+            ++task.migrations;
+          task.last_worker = static_cast<uint32_t>(t);
+        }
+        const uint64_t slice = std::min(quantum, task.budget - task.done);
+        run_quantum(ctx, task, slice);
+        ++ctx.quanta;
+        ctx.steps += slice;
+        publish_stats(ctx);
+
+        if (task.done < task.budget)
+          queues.push(t, id);
+        else
+          pending.fetch_sub(1, std::memory_order_release);
+      }
+      if (perf) {
+        perf->stop();
+        ctx.perf = perf->counts();
+      }
+      flush_events(ctx);
+      if (!async_storage_) storage_->flush_source(ctx.thread_id);
+
+      ctx.elapsed_ms = std::chrono::duration<double, std::milli>(
+                           clock::now() - t0_thread)
+                           .count();
+    });
+  }
+
+  for (auto& th : workers) th.join();
+  stop_monitor();
+  stop_async_storage();
+  stop_grpc_export();
+  storage_->flush();
+
+  const double elapsed_ms =
+      std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+  uint64_t migrations = 0;
+  for (const auto& task : tasks) migrations += task.migrations;
+
+  std::cout << "\nPer-Thread Summary ("
+            << (steal ? "steal" : "pinned") << ", quantum " << quantum
+            << ", zipf " << cfg_.zipf << ")\n-------------------------------\n";
+  for (size_t t = 0; t < n_threads; ++t) {
+    const auto& c = *contexts[t];
+    std::cout << "[Thread " << t << "] Quanta=" << c.quanta
+              << " Steals=" << c.steals << " Adds=" << c.adds
+              << " Cancels=" << c.cancels << " Trades=" << c.trades
+              << " Time=" << c.elapsed_ms << " ms (gen " << c.gen_ms
+              << " ms)\n";
+  }
+  std::cout << "Migrations:    " << migrations << " (symbol slices moved)\n";
+  RunReport report = make_report(steal ? "steal" : "pinned", n_threads);
+  report.migrations = migrations;
+  for (const auto& c : contexts) report.threads.push_back(thread_report(*c));
+  print_mt_totals(contexts, elapsed_ms, report);
+  if (cfg_.latency) print_latency(contexts, cal, report);
+  if (cfg_.perf) print_perf(contexts, report);
+
+  for (const auto& task : tasks)
+    if (task.last_worker != UINT32_MAX)
+      report.arenas.push_back(arena_report(
+          task.st->book->symbol(), *task.st->mem,
+          contexts[task.first_worker]->node));
+  if (cfg_.print_arena) {
+    std::cout << "Arena placement (per symbol, first worker):\n";
+    for (const ArenaReport& a : report.arenas) print_arena(a);
+  }
+  if (!cfg_.log_path.empty()) {
+    for (const auto& task : tasks) print_checksum(*task.st->book);
+  }
+
+  std::vector<const IOrderBook*> books;
+  for (const auto& task : tasks) books.push_back(task.st->book.get());
+  warn_rejected(books);
+  write_report(report, books);
+}  // Simulator::run_tasks (work-stealing)
 
 }  // namespace msim
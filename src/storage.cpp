@@ -1,5 +1,9 @@
 #include "msim/storage.hpp"
 
+#include <cstring>
+#include <iostream>
+
+#include "msim/column_log.hpp"
 #include "msim/lmdb_storage.hpp"
 
 namespace msim {
@@ -7,6 +11,7 @@ namespace msim {
 BinaryLogStorage::BinaryLogStorage(const std::string& path) {
   fp_ = std::fopen(path.c_str(), "wb");
   if (!fp_) throw std::runtime_error("open log failed");
+  buf_.reserve(64 * 1024);
 }
 
 BinaryLogStorage::~BinaryLogStorage() {
@@ -22,20 +27,55 @@ void BinaryLogStorage::write(const Event& e) {
   std::fwrite(b.data(), 1, b.size(), fp_);
 }
 
+void BinaryLogStorage::write_batch(const EventBatch& b) {
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  // Stage [u32 len][record] for the whole batch, then one fwrite.
+  buf_.clear();
+  for (size_t i = 0; i < b.size(); ++i) {
+    const std::string& sym = b.symbol(i);
+    const uint32_t n =
+        static_cast<uint32_t>(Event::tick_serialized_size(sym.size()));
+    const size_t off = buf_.size();
+    buf_.resize(off + sizeof(n) + n);
+    std::memcpy(buf_.data() + off, &n, sizeof(n));
+    Event::serialize_tick_to(buf_.data() + off + sizeof(n), b.ts_ns[i],
+                             b.type[i], sym, b.price_tick[i], b.qty[i],
+                             b.side[i], b.order_id[i]);
+  }
+  std::fwrite(buf_.data(), 1, buf_.size(), fp_);
+}
+
 void BinaryLogStorage::flush() {
   std::lock_guard<std::mutex> lock(mtx_);
   if (fp_) std::fflush(fp_);
 }
 
-std::unique_ptr<IStorage> make_storage(const std::string& path) {
+std::unique_ptr<IStorage> make_storage(const std::string& path,
+                                       const StorageOptions& opts) {
   if (path.empty()) return std::make_unique<NullStorage>();
 
   auto has_mdb_ext =
       path.size() >= 4 && path.compare(path.size() - 4, 4, ".mdb") == 0;
   if (has_mdb_ext || path.find(".mdb/") != std::string::npos)
-    return make_lmdb_storage(path);
+    return opts.lmdb_shards > 1
+               ? std::make_unique<ShardedLMDBStorage>(path, opts)
+               : make_lmdb_storage(path, opts);
+
+  if (path.size() >= 5 && path.compare(path.size() - 5, 5, ".mcol") == 0)
+    return std::make_unique<ColumnLogStorage>(path);
 
   return std::make_unique<BinaryLogStorage>(path);
 }
 
+void release_sink(std::unique_ptr<IStorage>& sink, bool flush,
+                  const std::string& who) {
+  try {
+    if (flush && sink) sink->flush();
+  } catch (const std::exception& ex) {
+    std::cerr << who << " flush failed: " << ex.what() << "\n";
+  }
+  sink.reset();
+}
+
 }  // namespace msim
@@ -0,0 +1,166 @@
+#include "msim/thread_utils.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+namespace {
+
+template <typename... Args>
+void safe_log(Args&&... args) {
+  static std::mutex log_mtx;
+  std::lock_guard<std::mutex> lock(log_mtx);
+  (std::cout << ... << args) << std::endl;
+}
+
+}  // namespace
+
+namespace msim {
+
+int current_numa_node() {
+#ifdef _WIN32
+  PROCESSOR_NUMBER pn{};
+  GetCurrentProcessorNumberEx(&pn);
+  USHORT node = 0;
+  return GetNumaProcessorNodeEx(&pn, &node) ? int(node) : -1;
+#elif defined(__linux__)
+  // getcpu(2) directly: no libnuma needed for topology queries.
+  unsigned cpu = 0, node = 0;
+  return syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? int(node) : -1;
+#else
+  return -1;
+#endif
+}
+
+int bind_to_core(size_t core_id) {
+  /** Pins the current thread to a specific physical CPU core
+   * so that the OS scheduler stops moving it around between cores.
+   *
+   * That one move changes how cache, memory, and timing behave.
+   *
+   * Without affinity:
+   *   Windows/Linux can migrate your threads between cores.
+   *   Each migration flushes its L1/L2 caches -> cold caches -> jitter.
+   *   The thread's working memory may sit on a different NUMA node -> remote
+   *    memory latency.
+   *
+   * With affinity:
+   *   The thread ALWAYS runs on that one core.
+   *   All allocations it makes (like its PMR arena) are serviced by that core's
+   *    NUMA node. Cache lines stay hot and deterministic.
+   *
+   * In an HFT system, this is the difference between 70ns and 250ns latency
+   * spikes.
+   */
+#ifdef _WIN32
+  // bitmask representing which cores this thread may run on
+  DWORD_PTR mask = 1ull << core_id;
+  if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+    std::cerr << "[WARN] SetThreadAffinityMask failed for core " << core_id
+              << " (err=" << GetLastError() << ")\n";
+  }
+
+  const int node = current_numa_node();
+  if (node >= 0) {
+    safe_log("[Affinity] Thread pinned to core ", core_id, " on NUMA node ",
+             node);
+  } else {
+    safe_log("[Affinity] Thread pinned to core ", core_id,
+             " (NUMA node unknown)");
+  }
+#else
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(core_id, &cpuset);
+  int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+  if (rc != 0) {
+    std::cerr << "[WARN] pthread_setaffinity_np failed for core " << core_id
+              << "(errno=" << rc << ")\n";
+  }
+
+  // Asked after pinning, so this is the node of `core_id` (or of wherever
+  // the scheduler left us if pinning failed).
+  const int node = current_numa_node();
+  if (node >= 0)
+    safe_log("[Affinity] Thread pinned to core ", core_id, " on NUMA node ",
+             node);
+  else
+    safe_log("[Affinity] Thread pinned to core ", core_id,
+             " (NUMA node unknown)");
+#endif
+  return node;
+}
+
+std::vector<size_t> parse_cpu_list(const std::string& spec) {
+  std::vector<size_t> cpus;
+  std::stringstream ss(spec);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (item.empty()) continue;
+    size_t lo = 0, hi = 0, used = 0;
+    try {
+      const size_t dash = item.find('-');
+      lo = std::stoul(item.substr(0, dash), &used);
+      if (used != (dash == std::string::npos ? item.size() : dash))
+        throw std::invalid_argument(item);
+      hi = lo;
+      if (dash != std::string::npos) {
+        hi = std::stoul(item.substr(dash + 1), &used);
+        if (used != item.size() - dash - 1) throw std::invalid_argument(item);
+      }
+    } catch (const std::exception&) {
+      throw std::runtime_error("bad CPU list entry '" + item + "' in '" +
+                               spec + "'");
+    }
+    if (hi < lo)
+      throw std::runtime_error("bad CPU range '" + item + "' in '" + spec +
+                               "'");
+    for (size_t c = lo; c <= hi; ++c) cpus.push_back(c);
+  }
+  if (cpus.empty()) throw std::runtime_error("empty CPU list '" + spec + "'");
+  return cpus;
+}
+
+size_t worker_cpu(const std::vector<size_t>& cpus, size_t worker) {
+  return cpus.empty() ? worker : cpus[worker % cpus.size()];
+}
+
+size_t worker_count(int requested, size_t n_items) {
+  size_t n = (requested > 0)
+                 ? static_cast<size_t>(requested)
+                 : std::min(n_items, static_cast<size_t>(
+                                         std::thread::hardware_concurrency()));
+  return std::max<size_t>(1, std::min(n, n_items));
+}
+
+std::vector<std::pair<size_t, size_t>> partition_range(size_t n_items,
+                                                       size_t n_workers) {
+  n_workers = std::max<size_t>(1, n_workers);
+  const size_t per = (n_items + n_workers - 1) / n_workers;
+  std::vector<std::pair<size_t, size_t>> out;
+  out.reserve(n_workers);
+  size_t idx = 0;
+  for (size_t w = 0; w < n_workers; ++w) {
+    const size_t end = std::min(idx + per, n_items);
+    out.emplace_back(idx, end);
+    idx = end;
+  }
+  return out;
+}
+
+}  // namespace msim
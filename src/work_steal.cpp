@@ -0,0 +1,39 @@
+#include "msim/work_steal.hpp"
+
+namespace msim {
+
+WorkQueues::WorkQueues(size_t n_workers) {
+  queues_.reserve(n_workers);
+  for (size_t w = 0; w < n_workers; ++w)
+    queues_.push_back(std::make_unique<Queue>());
+}
+
+void WorkQueues::push(size_t worker, uint32_t task) {
+  Queue& q = *queues_[worker];
+  std::lock_guard<std::mutex> lock(q.mtx);
+  q.tasks.push_back(task);
+}
+
+bool WorkQueues::pop(size_t worker, uint32_t& task) {
+  Queue& q = *queues_[worker];
+  std::lock_guard<std::mutex> lock(q.mtx);
+  if (q.tasks.empty()) return false;
+  task = q.tasks.back();
+  q.tasks.pop_back();
+  return true;
+}
+
+bool WorkQueues::steal(size_t thief, uint32_t& task) {
+  const size_t n = queues_.size();
+  for (size_t k = 1; k < n; ++k) {
+    Queue& q = *queues_[(thief + k) % n];
+    std::lock_guard<std::mutex> lock(q.mtx);
+    if (q.tasks.empty()) continue;
+    task = q.tasks.front();
+    q.tasks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+}  // namespace msim
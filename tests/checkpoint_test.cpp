@@ -0,0 +1,315 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "msim/checkpoint.hpp"
+#include "msim/order_book.hpp"
+#include "msim/order_gen.hpp"
+#include "msim/rng.hpp"
+#include "msim/simulator.hpp"
+
+using namespace msim;
+
+static bool throws(const std::string& path) {
+  try {
+    CheckpointReader r(path);
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+// A deep book with several orders per level, partly drained so queues
+// don't start at their first order.
+static void fill_book(IOrderBook& book, uint64_t seed) {
+  Xoroshiro128Plus rng(seed);
+  int32_t tp = 0;
+  for (uint64_t id = 1; id <= 4000; ++id) {
+    const bool buy = rand_bool(rng, 0.5);
+    const int32_t tick = buy ? rand_int(rng, 9900, 9999)
+                             : rand_int(rng, 10001, 10100);
+    book.add_order(Order{id, tick, rand_int(rng, 1, 50),
+                         buy ? Side::BUY : Side::SELL, id * 10},
+                   tp);
+    if (id % 7 == 0) book.cancel_order(id - 3);
+  }
+}
+
+// Books, live lists and generator state survive a write / map / restore,
+// into either book engine.
+static void test_round_trip(const std::string& path) {
+  std::pmr::unsynchronized_pool_resource mr;
+  auto a = make_order_book(BookKind::Hash, "AAA", &mr, 0.01);
+  auto b = make_order_book(BookKind::Ladder, "BBBBBBBBBB", &mr, 0.01);
+  auto c = make_order_book(BookKind::Hash, "C", &mr, 0.01);
+  fill_book(*a, 1);
+  fill_book(*b, 2);  // c stays empty
+
+  OrderGenerator gen(7, 2, 0.001);
+  IntentBatch batch;
+  gen.fill(batch, 0, IntentBatch::kCapacity);
+
+  const std::vector<uint64_t> live_a = {5, 9, 3, 3000};
+  std::vector<CheckpointWorker> parts(2);
+  parts[0].step = 1024;
+  parts[0].next_id = 4001;
+  parts[0].seq = 77;
+  parts[0].gen = gen.state();
+  parts[0].batch_row = 5;
+  parts[0].symbols.push_back(
+      capture_symbol(*a, 10000.5, live_a.data(), live_a.size()));
+  parts[0].symbols.push_back(capture_symbol(*b, 10000.0, nullptr, 0));
+  parts[1].step = 1000;
+  parts[1].last_ts = 123456789;
+  parts[1].symbols.push_back(capture_symbol(*c, 10000.0, nullptr, 0));
+  write_checkpoint(path, 42, false, parts);
+
+  CheckpointReader r(path);
+  bool ok = r.header().seed == 42 && r.header().events_done == 2024;
+  ok &= r.workers() == 2 && r.header().n_symbols == 3;
+  ok &= r.worker(0).next_id == 4001 && r.worker(0).seq == 77;
+  ok &= r.worker(0).batch_row == 5 && r.worker(1).batch_row == 0;
+  ok &= r.worker(1).last_ts == 123456789 && r.worker(1).first_symbol == 2;
+  ok &= r.name(r.symbol(0)) == "AAA" && r.name(r.symbol(1)) == "BBBBBBBBBB";
+  ok &= r.symbol(0).mid_tick == 10000.5 && r.symbol(2).n_orders == 0;
+  ok &= r.symbol(0).n_live == live_a.size() &&
+        std::memcmp(r.live(r.symbol(0)), live_a.data(),
+                    live_a.size() * sizeof(uint64_t)) == 0;
+
+  const IOrderBook* src[3] = {a.get(), b.get(), c.get()};
+  for (size_t s = 0; s < 3; ++s)
+    for (BookKind kind : {BookKind::Hash, BookKind::Ladder}) {
+      auto book = make_order_book(kind, std::string(r.name(r.symbol(s))),
+                                  &mr, 0.01);
+      r.restore_book(r.symbol(s), *book);
+      ok &= book->state_checksum() == src[s]->state_checksum();
+      ok &= book->index_size() == src[s]->index_size();
+    }
+
+  // The restored generator carries on where the saved one would.
+  OrderGenerator resumed(999, 2, 0.001);
+  resumed.restore(r.worker(0).gen);
+  IntentBatch want, got;
+  gen.fill(want, 1024, IntentBatch::kCapacity);
+  resumed.fill(got, 1024, IntentBatch::kCapacity);
+  for (size_t i = 0; i < IntentBatch::kCapacity; ++i)
+    ok &= want.sym[i] == got.sym[i] && want.qty[i] == got.qty[i] &&
+          want.move[i] == got.move[i] && want.pick[i] == got.pick[i];
+  assert(ok);
+  (void)ok;
+}
+
+// Truncated, mislabelled and crossed snapshots are rejected up front.
+static void test_rejects_bad_files(const std::string& path) {
+  std::pmr::unsynchronized_pool_resource mr;
+  auto a = make_order_book(BookKind::Hash, "AAA", &mr, 0.01);
+  fill_book(*a, 3);
+  std::vector<CheckpointWorker> parts(1);
+  parts[0].symbols.push_back(capture_symbol(*a, 10000.0, nullptr, 0));
+  write_checkpoint(path, 1, false, parts);
+
+  std::vector<uint8_t> bytes;
+  {
+    std::FILE* fp = std::fopen(path.c_str(), "rb");
+    assert(fp);
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0)
+      bytes.insert(bytes.end(), buf, buf + n);
+    std::fclose(fp);
+  }
+  auto rewrite = [&](const std::vector<uint8_t>& v) {
+    std::FILE* fp = std::fopen(path.c_str(), "wb");
+    assert(fp);
+    std::fwrite(v.data(), 1, v.size(), fp);
+    std::fclose(fp);
+  };
+
+  bool ok = !throws(path);
+  std::vector<uint8_t> v(bytes.begin(), bytes.end() - 8);
+  rewrite(v);
+  ok &= throws(path);  // truncated
+
+  v = bytes;
+  v[0] = 'X';
+  rewrite(v);
+  ok &= throws(path);  // magic
+
+  v = bytes;
+  reinterpret_cast<ckpt::WorkerRec*>(v.data() + sizeof(ckpt::FileHeader))
+      ->batch_row = 1;  // past step 0
+  rewrite(v);
+  ok &= throws(path);
+
+  // Make the first ask (right after the bids) trade through the best bid.
+  v = bytes;
+  const auto* s = reinterpret_cast<const ckpt::SymbolRec*>(
+      v.data() + sizeof(ckpt::FileHeader) + sizeof(ckpt::WorkerRec));
+  auto* o = reinterpret_cast<ckpt::OrderRec*>(v.data() + s->orders_off);
+  uint64_t first_ask = 0;
+  while (o[first_ask].side == uint8_t(Side::BUY)) ++first_ask;
+  o[first_ask].tick = o[0].tick;
+  rewrite(v);
+  ok &= throws(path);  // crossed
+  assert(ok);
+  (void)ok;
+}
+
+// Workers hand in parts at the same step; the last one in writes them all.
+static void test_gate() {
+  const size_t kWorkers = 3;
+  std::vector<std::vector<uint64_t>> seen;
+  CheckpointGate gate(kWorkers, [&](const std::vector<CheckpointWorker>& p) {
+    std::vector<uint64_t> steps;
+    for (const CheckpointWorker& w : p) steps.push_back(w.step + w.next_id);
+    seen.push_back(steps);
+  });
+  std::vector<std::thread> th;
+  for (size_t w = 0; w < kWorkers; ++w)
+    th.emplace_back([&, w] {
+      for (uint64_t k = 1; k <= 4; ++k) {
+        CheckpointWorker part;
+        part.step = k * 1024;
+        part.next_id = w;
+        if (w == 1) std::this_thread::yield();
+        gate.arrive(w, std::move(part));
+      }
+    });
+  for (auto& t : th) t.join();
+
+  bool ok = gate.written() == 4 && seen.size() == 4;
+  for (size_t k = 0; ok && k < seen.size(); ++k)
+    for (size_t w = 0; w < kWorkers; ++w)
+      ok &= seen[k][w] == (k + 1) * 1024 + w;
+  assert(ok);
+  (void)ok;
+}
+
+// A worker with nothing to run leaves once; its part is in every snapshot
+// the others take, before or after it left.
+static void test_gate_leave() {
+  const size_t kWorkers = 3;
+  std::vector<std::vector<uint64_t>> seen;
+  CheckpointGate gate(kWorkers, [&](const std::vector<CheckpointWorker>& p) {
+    std::vector<uint64_t> ids;
+    for (const CheckpointWorker& w : p) ids.push_back(w.next_id);
+    seen.push_back(ids);
+  });
+  std::vector<std::thread> th;
+  for (size_t w = 0; w < kWorkers; ++w)
+    th.emplace_back([&, w] {
+      if (w == 2) {
+        std::this_thread::yield();
+        CheckpointWorker part;
+        part.next_id = 7;
+        gate.leave(w, std::move(part));
+        return;
+      }
+      for (uint64_t k = 1; k <= 3; ++k) {
+        CheckpointWorker part;
+        part.next_id = w + 1;
+        gate.arrive(w, std::move(part));
+      }
+    });
+  for (auto& t : th) t.join();
+
+  bool ok = gate.written() == 3 && seen.size() == 3;
+  for (const auto& ids : seen)
+    ok &= ids.size() == 3 && ids[0] == 1 && ids[1] == 2 && ids[2] == 7;
+  assert(ok);
+  (void)ok;
+}
+
+// 5 symbols on 4 threads leaves the last worker empty (ceil-sized chunks);
+// periodic and final snapshots still complete and hold all four workers.
+static void test_mt_empty_worker(const std::string& path) {
+  SimConfig cfg;
+  cfg.total_events = 40000;
+  cfg.num_threads = 4;
+  cfg.symbol_list = {"A", "B", "C", "D", "E"};
+  cfg.checkpoint_path = path;
+  cfg.checkpoint_every = 10000;
+  Simulator(cfg).run_mt();
+
+  CheckpointReader r(path);
+  bool ok = r.workers() == 4 && r.header().n_symbols == 5;
+  ok &= r.worker(0).step == 10000 && r.worker(2).n_symbols == 1;
+  ok &= r.worker(3).n_symbols == 0 && r.worker(3).step == 0;
+  assert(ok);
+  (void)ok;
+}
+
+static std::vector<uint8_t> read_file(const std::string& path) {
+  std::vector<uint8_t> bytes;
+  std::FILE* fp = std::fopen(path.c_str(), "rb");
+  assert(fp);
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0)
+    bytes.insert(bytes.end(), buf, buf + n);
+  std::fclose(fp);
+  return bytes;
+}
+
+// Stopping at a step that isn't a multiple of the intent batch (with
+// periodic snapshots mid-batch too) and resuming ends in the same state as
+// one uninterrupted run: the final snapshots match byte for byte.
+static void test_resume_unaligned(const std::string& path) {
+  const std::string whole = path + ".whole";
+  SimConfig cfg;
+  cfg.symbol_list = {"A", "B", "C"};
+
+  cfg.checkpoint_path = whole;  // run(): 7777 + 5003 steps in one go
+  cfg.total_events = 12780;
+  Simulator one(cfg);
+  one.run();
+  cfg.checkpoint_path = path;
+  cfg.total_events = 7777;
+  cfg.checkpoint_every = 3001;
+  Simulator(cfg).run();
+  cfg.resume_path = path;
+  cfg.total_events = 5003;
+  cfg.checkpoint_every = 0;
+  Simulator two(cfg);
+  two.run();
+  bool ok = one.book_checksums() == two.book_checksums();
+  ok &= read_file(path) == read_file(whole);
+
+  cfg.num_threads = 2;  // run_mt(): 7777 + 5003 steps per worker
+  cfg.resume_path.clear();
+  cfg.checkpoint_path = whole;
+  cfg.total_events = 2 * 12780;
+  Simulator(cfg).run_mt();
+  cfg.checkpoint_path = path;
+  cfg.total_events = 2 * 7777;
+  cfg.checkpoint_every = 2 * 3001;
+  Simulator(cfg).run_mt();
+  cfg.resume_path = path;
+  cfg.total_events = 2 * 5003;
+  cfg.checkpoint_every = 0;
+  Simulator(cfg).run_mt();
+  ok &= read_file(path) == read_file(whole);
+  assert(ok);
+  (void)ok;
+  std::remove(whole.c_str());
+}
+
+int main() {
+  const std::string path = "checkpoint_test.mckp";
+  test_round_trip(path);
+  test_rejects_bad_files(path);
+  test_gate();
+  test_gate_leave();
+  test_mt_empty_worker(path);
+  test_resume_unaligned(path);
+  std::remove(path.c_str());
+  std::cout << "checkpoint_test OK\n";
+  return 0;
+}
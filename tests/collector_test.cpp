@@ -0,0 +1,191 @@
+#include <grpcpp/grpcpp.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "market.grpc.pb.h"
+#include "msim/collector.hpp"
+#include "msim/column_log.hpp"
+#include "msim/grpc_exporter.hpp"
+
+using namespace msim;
+
+static const char* kPath = "collector_test.mcol";
+
+static SymbolTable make_symbols() {
+  SymbolTable syms;
+  for (int i = 0; i < 4; ++i) syms.intern("SYM" + std::to_string(i));
+  return syms;
+}
+
+static CollectorOptions local_options() {
+  CollectorOptions opt;
+  opt.address = "127.0.0.1:0";
+  opt.threads = 2;
+  return opt;
+}
+
+static std::string target(const Collector& c) {
+  return "127.0.0.1:" + std::to_string(c.port());
+}
+
+static void produce(GrpcExporter& x, uint64_t n) {
+  for (uint64_t i = 0; i < n; ++i) {
+    const uint16_t sym = static_cast<uint16_t>(i % 4);
+    x.push(0, CompactEvent{i, 100 + int32_t(i % 50), int32_t(sym + 1), sym,
+                           EventType::ORDER_ADD, Side::SELL, i + 1});
+  }
+}
+
+// Several exporters, rows and packed, stream into one collector at once;
+// every event is counted once and every exporter is acked in full.
+static void test_concurrent_streams() {
+  Collector c(local_options());
+  const SymbolTable syms = make_symbols();
+
+  std::vector<std::thread> nodes;
+  std::vector<uint64_t> acked(4, 0);
+  for (std::size_t k = 0; k < acked.size(); ++k)
+    nodes.emplace_back([&, k] {
+      ExportOptions opt;
+      opt.streams = 2;
+      opt.batch_events = 256;
+      opt.format = k % 2 ? WireFormat::Packed : WireFormat::Rows;
+      GrpcExporter x(target(c), 1, &syms, opt);
+      produce(x, 20000);
+      const bool ok = x.close();
+      assert(ok);
+      (void)ok;
+      acked[k] = x.acked();
+    });
+  for (auto& t : nodes) t.join();
+
+  c.shutdown();
+  const Collector::Totals t = c.totals();
+  for (uint64_t a : acked) assert(a == 20000);
+  assert(t.events == 4 * 20000);
+  assert(t.streams == 4 * 2);  // format probes not counted
+  assert(t.rejected == 0);
+  assert(t.sink_written == 0);
+  (void)t;
+}
+
+// With a sink, received events land in the same column log market_sim
+// writes, symbols and prices intact.
+static void test_sink_stores_events() {
+  std::remove(kPath);
+  {
+    CollectorOptions opt = local_options();
+    opt.sink_path = kPath;
+    opt.sink_queue = 2;
+    Collector c(opt);
+
+    const SymbolTable syms = make_symbols();
+    GrpcExporter x(target(c), 1, &syms);
+    produce(x, 30000);
+    const bool ok = x.close();
+    assert(ok);
+    (void)ok;
+
+    c.shutdown();
+    assert(c.totals().sink_written == 30000);
+  }
+
+  ColumnLogReader r(kPath);
+  assert(r.events() == 30000);
+  EventBatch batch(&r.symbols());
+  uint64_t seen = 0;
+  bool intact = true;
+  r.read_batches({}, batch, [&](const EventBatch& b) {
+    for (std::size_t i = 0; i < b.size(); ++i) {
+      const Event e = b.to_event(i);
+      if (e.symbol != "SYM" + std::to_string(e.qty - 1) ||
+          e.side != Side::SELL ||
+          b.price_tick[i] != 100 + int32_t(e.ts_ns % 50))
+        intact = false;
+      ++seen;
+    }
+    return true;
+  });
+  assert(seen == 30000);
+  assert(intact);
+  (void)seen;
+  (void)intact;
+  std::remove(kPath);
+}
+
+// A malformed PackedBatch ends that stream with INVALID_ARGUMENT; the
+// collector keeps serving.
+static void test_malformed_batch_rejected() {
+  Collector c(local_options());
+  auto stub = rpc::MarketStream::NewStub(
+      grpc::CreateChannel(target(c), grpc::InsecureChannelCredentials()));
+
+  grpc::ClientContext ctx;
+  rpc::Ack ack;
+  auto writer = stub->PublishPacked(&ctx, &ack);
+  rpc::PackedBatch bad;
+  bad.add_symbols("SYM0");
+  bad.add_tick_sizes(0.01);
+  bad.add_type(rpc::EventType(0));  // one type, no other columns
+  writer->Write(bad);
+  writer->WritesDone();
+  const grpc::Status status = writer->Finish();
+  assert(status.error_code() == grpc::StatusCode::INVALID_ARGUMENT);
+  (void)status;
+
+  const SymbolTable syms = make_symbols();
+  GrpcExporter x(target(c), 1, &syms);
+  produce(x, 1000);
+  const bool ok = x.close();
+  assert(ok && x.acked() == 1000);
+  (void)ok;
+
+  c.shutdown();
+  assert(c.totals().rejected == 1);
+}
+
+// Live streams show up in the periodic report; each finished stream gets
+// a "Received ..." line.
+static void test_periodic_stats() {
+  std::ostringstream log;
+  CollectorOptions opt = local_options();
+  opt.log = &log;
+  opt.stats_every = std::chrono::milliseconds(20);
+  Collector c(opt);
+
+  const SymbolTable syms = make_symbols();
+  {
+    GrpcExporter x(target(c), 1, &syms);
+    for (int round = 0; round < 5; ++round) {
+      produce(x, 2000);
+      std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    }
+    const bool ok = x.close();
+    assert(ok);
+    (void)ok;
+  }
+  c.shutdown();
+
+  const std::string out = log.str();
+  assert(out.find("[stats] stream ") != std::string::npos);
+  assert(out.find("[stats] total: ") != std::string::npos);
+  assert(out.find("Received 10000 events") != std::string::npos);
+  (void)out;
+}
+
+int main() {
+  test_concurrent_streams();
+  test_sink_stores_events();
+  test_malformed_batch_rejected();
+  test_periodic_stats();
+  std::cout << "collector_test OK\n";
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "msim/column_log.hpp"
+
+using namespace msim;
+
+static const char* kPath = "column_log_test.mcol";
+
+// 1000 events over two symbols, block size 64; ts == row number.
+static void write_fixture() {
+  SymbolTable syms;
+  const uint16_t a = syms.intern("AAA");
+  const uint16_t b = syms.intern("BBB", 0.5);
+
+  ColumnLogStorage log(kPath, 64);
+  auto batch = std::make_unique<EventBatch>(&syms);
+  for (uint64_t t = 0; t < 1000; ++t) {
+    // BBB only appears in the second half
+    const uint16_t sym = (t >= 500 && t % 2) ? b : a;
+    batch->push({t, int32_t(1000 + t), int32_t(t % 7 + 1), sym,
+                 EventType::ORDER_ADD, t % 2 ? Side::SELL : Side::BUY, t + 1});
+    if (batch->full()) {
+      log.write_batch(*batch);
+      batch->clear();
+    }
+  }
+  log.write_batch(*batch);
+  // per-event path shares the same symbol ids
+  log.write(Event{1000, EventType::TRADE, "BBB", 600.5, 3, Side::BUY});
+}
+
+static void test_roundtrip() {
+  ColumnLogReader r(kPath);
+  assert(r.events() == 1001);
+  assert(r.blocks() == (1001 + 63) / 64);
+  assert(r.min_ts() == 0 && r.max_ts() == 1000);
+
+  const auto a = r.symbols().find("AAA");
+  const auto b = r.symbols().find("BBB");
+  assert(a && b && r.symbols().tick_size(*b) == 0.5);
+  assert(r.events(*a) == 750 && r.events(*b) == 251);
+
+  // every row comes back in write order
+  uint64_t next = 0;
+  r.scan_blocks(ColumnQuery{}, [&](const ColumnBlockView& v) {
+    for (size_t i = 0; i < v.n; ++i, ++next) {
+      assert(v.ts_ns[i] == next);
+      if (next < 1000) assert(v.price_tick[i] == int32_t(1000 + next));
+    }
+    return true;
+  });
+  assert(next == 1001);
+}
+
+static void test_block_skipping() {
+  ColumnLogReader r(kPath);
+  const uint16_t b = *r.symbols().find("BBB");
+
+  // time window touches only the blocks overlapping [200, 263]
+  ColumnQuery q;
+  q.ts_from = 200;
+  q.ts_to = 263;
+  const size_t visited = r.scan_blocks(q, [](const ColumnBlockView&) { return true; });
+  assert(visited == 2);  // rows 192..255 and 256..319
+  (void)visited;
+
+  auto batch = std::make_unique<EventBatch>(&r.symbols());
+  size_t got = r.read_batches(q, *batch, [](const EventBatch& eb) {
+    for (size_t i = 0; i < eb.size(); ++i)
+      assert(eb.ts_ns[i] >= 200 && eb.ts_ns[i] <= 263);
+    return true;
+  });
+  assert(got == 64);
+
+  // symbol filter skips the first half via the block bitmap
+  ColumnQuery qs;
+  qs.symbol = b;
+  const size_t sym_blocks =
+      r.scan_blocks(qs, [](const ColumnBlockView&) { return true; });
+  assert(sym_blocks < r.blocks() / 2 + 2);
+  (void)sym_blocks;
+
+  double last_price = 0;
+  got = r.read_batches(qs, *batch, [&](const EventBatch& eb) {
+    for (size_t i = 0; i < eb.size(); ++i) assert(eb.symbol(i) == "BBB");
+    last_price = eb.price(eb.size() - 1);
+    return true;
+  });
+  assert(got == 251 && last_price == 600.5);
+
+  // early stop after the first batch
+  size_t calls = 0;
+  r.read_batches(ColumnQuery{}, *batch, [&](const EventBatch&) {
+    ++calls;
+    return false;
+  });
+  assert(calls == 1);
+  (void)got;
+}
+
+static void test_rejects_unclosed() {
+  std::FILE* fp = std::fopen(kPath, "wb");
+  std::fputs("not a column log, definitely not", fp);
+  std::fclose(fp);
+  bool threw = false;
+  try {
+    ColumnLogReader r(kPath);
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  assert(threw);
+  (void)threw;
+}
+
+int main() {
+  write_fixture();
+  test_roundtrip();
+  test_block_skipping();
+  test_rejects_unclosed();
+  std::remove(kPath);
+  std::cout << "OK: column_log\n";
+  return 0;
+}
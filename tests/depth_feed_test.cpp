@@ -0,0 +1,204 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "msim/depth_feed.hpp"
+#include "msim/ladder_book.hpp"
+#include "msim/order_book.hpp"
+#include "msim/rng.hpp"
+
+using msim::DepthLevel;
+using msim::DepthUpdate;
+using msim::Side;
+
+static bool same(const std::vector<DepthLevel>& a,
+                 const std::vector<DepthLevel>& b) {
+  if (a.size() != b.size()) return false;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    if (a[i].tick != b[i].tick || a[i].qty != b[i].qty ||
+        a[i].orders != b[i].orders)
+      return false;
+  return true;
+}
+
+// Level totals follow adds, partial fills and cancels without a rescan.
+static void test_level_aggregates() {
+  std::vector<std::byte> buf(1 << 16);
+  std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+  msim::OrderBook book("X", &mr, /*tick_size=*/1.0);
+  int32_t tp = 0;
+
+  book.add_order({1, 101, 10, Side::SELL, 0}, tp);
+  book.add_order({2, 101, 5, Side::SELL, 0}, tp);
+  book.add_order({3, 103, 7, Side::SELL, 0}, tp);
+  book.add_order({4, 99, 4, Side::BUY, 0}, tp);
+
+  std::vector<DepthLevel> d;
+  book.depth(Side::SELL, 10, d);
+  assert(same(d, {{101, 15, 2}, {103, 7, 1}}));
+
+  const int m = book.add_order({5, 101, 12, Side::BUY, 0}, tp);
+  assert(m == 12);
+  (void)m;
+  book.depth(Side::SELL, 10, d);
+  assert(same(d, {{101, 3, 1}, {103, 7, 1}}));
+
+  const bool c = book.cancel_order(2);
+  assert(c);
+  (void)c;
+  book.depth(Side::SELL, 1, d);
+  assert(same(d, {{103, 7, 1}}));
+  book.depth(Side::BUY, 10, d);
+  assert(same(d, {{99, 4, 1}}));
+}
+
+// Rebuilds the top N of each side from the feed's records alone.
+struct Replica {
+  std::map<int32_t, DepthLevel> side[2];
+
+  void apply(const DepthUpdate& u) {
+    auto& m = side[u.side == Side::BUY ? 0 : 1];
+    if (u.level.orders == 0)
+      m.erase(u.level.tick);
+    else
+      m[u.level.tick] = u.level;
+  }
+  std::vector<DepthLevel> levels(Side s) const {
+    std::vector<DepthLevel> out;
+    const auto& m = side[s == Side::BUY ? 0 : 1];
+    if (s == Side::BUY)
+      for (auto it = m.rbegin(); it != m.rend(); ++it) out.push_back(it->second);
+    else
+      for (const auto& kv : m) out.push_back(kv.second);
+    return out;
+  }
+};
+
+// Random flow: after every op the replica equals the book's own top N, and
+// each due snapshot equals the replica.
+static void test_replica_tracks_book(std::unique_ptr<msim::IOrderBook> book,
+                                     std::size_t n) {
+  msim::DepthFeed feed(*book, n, /*snapshot_every=*/997);
+  Replica rep;
+  Xoroshiro128Plus rng(11);
+  std::vector<uint64_t> live;
+  std::vector<DepthUpdate> out;
+  std::vector<DepthLevel> want;
+  uint64_t next_id = 1, deltas = 0, snapshots = 0;
+  bool ok = true;
+
+  for (int i = 0; i < 100000; ++i) {
+    if (live.empty() || rand_bool(rng, 0.55)) {
+      const Side side = rand_bool(rng, 0.5) ? Side::BUY : Side::SELL;
+      const int32_t tick = 10000 + rand_int(rng, -40, 40);
+      msim::Order o{next_id++, tick, rand_int(rng, 1, 100), side, 0};
+      int32_t tp = 0;
+      if (book->add_order(o, tp) < o.qty) live.push_back(o.id);
+    } else {
+      const std::size_t li = rand_index(rng, live.size());
+      book->cancel_order(live[li]);
+      live[li] = live.back();
+      live.pop_back();
+    }
+
+    out.clear();
+    const bool snap = feed.update(out);
+    for (const DepthUpdate& u : out) rep.apply(u);
+    deltas += out.size();
+
+    for (Side s : {Side::BUY, Side::SELL}) {
+      book->depth(s, n, want);
+      if (!same(rep.levels(s), want)) ok = false;
+    }
+    if (snap) {
+      ++snapshots;
+      out.clear();
+      feed.snapshot(out);
+      Replica fresh;
+      for (const DepthUpdate& u : out) fresh.apply(u);
+      for (Side s : {Side::BUY, Side::SELL})
+        if (!same(fresh.levels(s), rep.levels(s))) ok = false;
+    }
+  }
+  assert(ok);
+  assert(snapshots == 100000 / 997);
+  // Far fewer records than book ops: most activity is outside the top N.
+  assert(deltas > 0 && deltas < 3 * 100000);
+  (void)ok;
+  (void)snapshots;
+  (void)deltas;
+}
+
+// Both engines report the same depth for the same flow.
+static void test_engines_agree() {
+  std::vector<std::byte> buf_a(1 << 20), buf_b(1 << 20);
+  std::pmr::monotonic_buffer_resource mr_a(buf_a.data(), buf_a.size());
+  std::pmr::monotonic_buffer_resource mr_b(buf_b.data(), buf_b.size());
+  msim::OrderBook hash("X", &mr_a);
+  msim::LadderOrderBook ladder("X", &mr_b);
+
+  Xoroshiro128Plus rng(3);
+  std::vector<uint64_t> live;
+  std::vector<DepthLevel> a, b;
+  uint64_t next_id = 1;
+  bool ok = true;
+  for (int i = 0; i < 50000; ++i) {
+    if (live.empty() || rand_bool(rng, 0.5)) {
+      const Side side = rand_bool(rng, 0.5) ? Side::BUY : Side::SELL;
+      const int32_t tick = 10000 + rand_int(rng, -50, 50);
+      msim::Order o{next_id++, tick, rand_int(rng, 1, 100), side, 0};
+      int32_t tp = 0;
+      hash.add_order(o, tp);
+      if (ladder.add_order(o, tp) < o.qty) live.push_back(o.id);
+    } else {
+      const std::size_t li = rand_index(rng, live.size());
+      hash.cancel_order(live[li]);
+      ladder.cancel_order(live[li]);
+      live[li] = live.back();
+      live.pop_back();
+    }
+    if (i % 100 == 0)
+      for (Side s : {Side::BUY, Side::SELL}) {
+        hash.depth(s, 1000, a);
+        ladder.depth(s, 1000, b);
+        if (!same(a, b)) ok = false;
+      }
+  }
+  assert(ok);
+  (void)ok;
+}
+
+// Wire form: deltas and snapshot headers as CompactEvents.
+static void test_event_encoding() {
+  const DepthUpdate u{Side::SELL, {10123, int64_t(1) << 40, 7}};
+  const msim::CompactEvent e =
+      msim::DepthFeed::to_event(5, 2, msim::EventType::DEPTH_UPDATE, u);
+  assert(e.ts_ns == 5 && e.symbol_id == 2 && e.price_tick == 10123);
+  assert(e.qty == INT32_MAX && e.order_id == 7 && e.side == Side::SELL);
+
+  const msim::CompactEvent h = msim::DepthFeed::snapshot_header(6, 2, 20);
+  assert(h.type == msim::EventType::DEPTH_SNAPSHOT && h.qty == 20);
+  assert(h.order_id == 0);
+  (void)e;
+  (void)h;
+}
+
+int main() {
+  test_level_aggregates();
+  for (std::size_t n : {1, 5, 20}) {
+    std::vector<std::byte> buf(1 << 22);
+    std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+    test_replica_tracks_book(
+        msim::make_order_book(msim::BookKind::Hash, "X", &mr), n);
+    test_replica_tracks_book(
+        msim::make_order_book(msim::BookKind::Ladder, "X", &mr), n);
+  }
+  test_engines_agree();
+  test_event_encoding();
+  std::cout << "OK: depth_feed\n";
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "msim/event.hpp"
+#include "msim/event_batch.hpp"
+#include "msim/symbol_table.hpp"
+
+static void test_serialize_roundtrip() {
+  msim::Event e{42,  msim::EventType::TRADE, "AAPL", 101.25,
+                7,   msim::Side::SELL,      9001};
+  auto bytes = e.serialize();
+  assert(bytes.size() == e.serialized_size());
+
+  // serialize_to() must produce the same record as serialize()
+  std::vector<uint8_t> raw(msim::Event::serialized_size(4));
+  const size_t n = msim::Event::serialize_to(raw.data(), e.ts_ns, e.type,
+                                             e.symbol, e.price, e.qty, e.side,
+                                             e.order_id);
+  assert(n == bytes.size() && raw == bytes);
+  (void)n;
+
+  size_t consumed = 0;
+  auto v = msim::EventView::parse(bytes.data(), bytes.size(), consumed);
+  assert(v && consumed == bytes.size());
+  assert(v->symbol == "AAPL" && v->ts_ns == 42 && v->price == 101.25);
+  assert(v->qty == 7 && v->side == msim::Side::SELL && v->order_id == 9001);
+
+  auto d = msim::Event::deserialize(bytes.data(), bytes.size(), consumed);
+  assert(d && d->symbol == e.symbol && d->type == e.type);
+
+  // records written before order ids were logged still parse (id = 0)
+  const size_t legacy = bytes.size() - sizeof(uint64_t);
+  auto old = msim::EventView::parse(bytes.data(), legacy, consumed);
+  assert(old && consumed == legacy && old->order_id == 0 && old->qty == 7);
+
+  // truncated input is rejected
+  assert(!msim::EventView::parse(bytes.data(), legacy - 1, consumed));
+}
+
+// Tick records: 4 bytes shorter, flagged in the type byte, and resolve()
+// derives the decimal price (and the tick, for decimal records).
+static void test_tick_record() {
+  std::vector<uint8_t> raw(msim::Event::tick_serialized_size(4));
+  const size_t n = msim::Event::serialize_tick_to(
+      raw.data(), 42, msim::EventType::ORDER_IOC, "AAPL", 10125, 7,
+      msim::Side::SELL, 9001);
+  assert(n == raw.size());
+  assert(n + 4 == msim::Event::serialized_size(4));
+  (void)n;
+
+  size_t consumed = 0;
+  auto v = msim::EventView::parse(raw.data(), raw.size(), consumed);
+  assert(v && consumed == raw.size() && v->tick_priced);
+  assert(v->type == msim::EventType::ORDER_IOC && v->price_tick == 10125);
+  assert(v->qty == 7 && v->side == msim::Side::SELL && v->order_id == 9001);
+  v->resolve(0.01);
+  assert(v->price == 101.25);
+
+  // truncated tick records are rejected, not read as decimal ones
+  assert(!msim::EventView::parse(raw.data(), raw.size() - 1, consumed));
+
+  auto bytes = msim::Event{1, msim::EventType::ORDER_ADD, "AAPL", 101.25, 7,
+                           msim::Side::BUY, 5}
+                   .serialize();
+  auto d = msim::EventView::parse(bytes.data(), bytes.size(), consumed);
+  assert(d && !d->tick_priced);
+  d->resolve(0.01);
+  assert(d->price_tick == 10125);
+}
+
+static void test_batch_columns() {
+  msim::SymbolTable syms;
+  const uint16_t a = syms.intern("AAPL");
+  const uint16_t m = syms.intern("MSFT", 0.5);
+  assert(syms.intern("AAPL") == a && syms.size() == 2);
+
+  auto b = std::make_unique<msim::EventBatch>(&syms, 3);
+  assert(b->empty() && b->source == 3);
+
+  b->push({1, 10050, 5, a, msim::EventType::ORDER_ADD, msim::Side::BUY, 11});
+  b->push({2, 201, 9, m, msim::EventType::TRADE, msim::Side::SELL, 11});
+  assert(b->size() == 2);
+  assert(b->symbol(1) == "MSFT" && b->price(1) == 100.5);
+
+  msim::Event e = b->to_event(0);
+  assert(e.symbol == "AAPL" && e.price == 100.5 && e.qty == 5);
+  assert(e.order_id == 11 && b->row(1).order_id == 11);
+  assert(syms.to_tick(a, e.price) == 10050);
+
+  while (!b->full()) b->push(b->row(0));
+  assert(b->size() == msim::EventBatch::kCapacity);
+  b->clear();
+  assert(b->empty());
+}
+
+int main() {
+  test_serialize_roundtrip();
+  test_tick_record();
+  test_batch_columns();
+  std::cout << "OK: event\n";
+  return 0;
+}
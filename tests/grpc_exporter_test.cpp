@@ -0,0 +1,250 @@
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "market.grpc.pb.h"
+#include "msim/event_convert.hpp"
+#include "msim/grpc_exporter.hpp"
+
+using namespace msim;
+
+// Rows-only collector (predates PublishPacked): counts events and checks
+// each one decoded intact.
+class RowsCollector : public rpc::MarketStream::Service {
+ public:
+  std::atomic<uint64_t> events{0};
+  std::atomic<uint64_t> streams{0};
+  std::atomic<uint64_t> packed_streams{0};
+  std::atomic<bool> consistent{true};
+
+  grpc::Status Publish(grpc::ServerContext*,
+                       grpc::ServerReader<rpc::EventBatch>* reader,
+                       rpc::Ack* ack) override {
+    ++streams;
+    rpc::EventBatch batch;
+    uint64_t n = 0;
+    while (reader->Read(&batch)) {
+      for (const auto& e : batch.events()) check(EventConvert::from_proto(e));
+      n += static_cast<uint64_t>(batch.events_size());
+    }
+    events += n;
+    ack->set_count(n);
+    return grpc::Status::OK;
+  }
+
+ protected:
+  // Symbol i carries qty i and price i + 1 (see produce()).
+  void check(const Event& e) {
+    if (e.symbol != "SYM" + std::to_string(e.qty) ||
+        std::abs(e.price - double(e.qty + 1)) > 1e-9 ||
+        e.order_id != e.ts_ns + 1)
+      consistent = false;
+  }
+};
+
+// Current collector: also takes PackedBatch streams.
+class CountingCollector : public RowsCollector {
+ public:
+  grpc::Status PublishPacked(grpc::ServerContext*,
+                             grpc::ServerReader<rpc::PackedBatch>* reader,
+                             rpc::Ack* ack) override {
+    rpc::PackedBatch batch;
+    std::vector<Event> decoded;
+    uint64_t n = 0;
+    while (reader->Read(&batch)) {
+      decoded.clear();
+      if (!EventConvert::from_packed(batch, decoded))
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "malformed");
+      for (const Event& e : decoded) check(e);
+      n += decoded.size();
+    }
+    if (n) ++packed_streams;  // not the exporter's empty format probe
+    events += n;
+    ack->set_count(n);
+    return grpc::Status::OK;
+  }
+};
+
+template <typename Service = CountingCollector>
+struct Server {
+  Service service;
+  std::unique_ptr<grpc::Server> server;
+  std::string target;
+
+  Server() {
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(),
+                             &port);
+    builder.RegisterService(&service);
+    server = builder.BuildAndStart();
+    target = "127.0.0.1:" + std::to_string(port);
+  }
+  ~Server() { server->Shutdown(); }
+};
+
+static SymbolTable make_symbols() {
+  SymbolTable syms;
+  for (int i = 0; i < 4; ++i) syms.intern("SYM" + std::to_string(i));
+  return syms;
+}
+
+// Producer threads push `per_producer` events each; symbol i carries qty i
+// and price i + 1 so the collector can check every event survived
+// conversion.
+static void produce(GrpcExporter& x, size_t n_producers,
+                    uint64_t per_producer) {
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < n_producers; ++p)
+    threads.emplace_back([&x, p, per_producer] {
+      for (uint64_t i = 0; i < per_producer; ++i) {
+        const uint16_t sym = static_cast<uint16_t>(i % 4);
+        x.push(p, CompactEvent{i, int32_t(sym + 1) * 100, int32_t(sym), sym,
+                               EventType::ORDER_ADD, Side::BUY, i + 1});
+      }
+    });
+  for (auto& t : threads) t.join();
+}
+
+// Block is lossless: everything pushed is sent, and the collector acks it
+// across every stream.
+static void test_block_is_lossless() {
+  Server<> srv;
+  const SymbolTable syms = make_symbols();
+  ExportOptions opt;
+  opt.streams = 3;
+  opt.batch_events = 100;
+  opt.max_queued = 2;
+
+  GrpcExporter x(srv.target, 4, &syms, opt);
+  produce(x, 4, 50000);
+  const bool ok = x.close();
+  assert(ok);
+  assert(x.streams() == 3);
+  assert(x.dropped() == 0);
+  assert(x.sent() == 4 * 50000);
+  assert(x.acked() == x.sent());
+  assert(srv.service.events.load() == x.sent());
+  assert(srv.service.packed_streams.load() == 3);  // Auto negotiated
+  assert(srv.service.consistent.load());
+  assert(x.batches() >= x.sent() / opt.batch_events);
+  (void)ok;
+}
+
+// Lossy policies never stall producers, and every event is accounted for
+// as either sent or dropped.
+static void test_lossy_policies_account_for_everything() {
+  for (OverflowPolicy policy :
+       {OverflowPolicy::DropOldest, OverflowPolicy::Sample}) {
+    Server<> srv;
+    const SymbolTable syms = make_symbols();
+    ExportOptions opt;
+    opt.batch_events = 16;
+    opt.max_queued = 1;
+    opt.overflow = policy;
+    opt.sample_every = 4;
+
+    GrpcExporter x(srv.target, 2, &syms, opt);
+    produce(x, 2, 100000);
+    const bool ok = x.close();
+    assert(ok);
+    assert(x.stalls() == 0);
+    assert(x.sent() + x.dropped() == 2 * 100000);
+    assert(x.acked() == x.sent());
+    assert(srv.service.consistent.load());
+    (void)ok;
+  }
+}
+
+// Auto negotiates packed with a current collector; the round trip through
+// the dictionary and delta columns is exact, and cheaper than rows.
+static void test_packed_round_trip() {
+  const SymbolTable syms = make_symbols();
+  uint64_t bytes[2] = {0, 0};
+  for (WireFormat format : {WireFormat::Rows, WireFormat::Auto}) {
+    Server<> srv;
+    ExportOptions opt;
+    opt.streams = 2;
+    opt.format = format;
+
+    GrpcExporter x(srv.target, 2, &syms, opt);
+    assert(x.format() == (format == WireFormat::Rows ? WireFormat::Rows
+                                                     : WireFormat::Packed));
+    produce(x, 2, 20000);
+    const bool ok = x.close();
+    assert(ok);
+    assert(x.sent() == 2 * 20000);
+    assert(x.acked() == x.sent());
+    assert(srv.service.events.load() == x.sent());
+    assert(srv.service.consistent.load());
+    assert((srv.service.packed_streams.load() == 2) ==
+           (x.format() == WireFormat::Packed));
+    bytes[format == WireFormat::Auto] = x.bytes();
+    (void)ok;
+  }
+  assert(bytes[1] * 2 < bytes[0]);
+  (void)bytes;
+}
+
+// Against a rows-only collector Auto falls back to rows; forcing packed is
+// refused at construction.
+static void test_rows_only_collector() {
+  const SymbolTable syms = make_symbols();
+  Server<RowsCollector> srv;
+  {
+    GrpcExporter x(srv.target, 1, &syms);
+    assert(x.format() == WireFormat::Rows);
+    produce(x, 1, 5000);
+    const bool ok = x.close();
+    assert(ok);
+    assert(x.acked() == 5000);
+    assert(srv.service.consistent.load());
+    (void)ok;
+  }
+
+  ExportOptions opt;
+  opt.format = WireFormat::Packed;
+  bool threw = false;
+  try {
+    GrpcExporter x(srv.target, 1, &syms, opt);
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  assert(threw);
+  (void)threw;
+}
+
+// An unreachable collector is reported at construction, not mid-run.
+static void test_unreachable_target_throws() {
+  const SymbolTable syms = make_symbols();
+  bool threw = false;
+  try {
+    Server<> srv;
+    const std::string dead = srv.target;
+    srv.server->Shutdown();
+    srv.server->Wait();
+    GrpcExporter x(dead, 1, &syms);
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  assert(threw);
+  (void)threw;
+}
+
+int main() {
+  test_block_is_lossless();
+  test_lossy_policies_account_for_everything();
+  test_packed_round_trip();
+  test_rows_only_collector();
+  test_unreachable_target_throws();
+  std::cout << "grpc_exporter_test OK\n";
+  return 0;
+}
@@ -0,0 +1,203 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <vector>
+
+#include "msim/ladder_book.hpp"
+#include "msim/order_book.hpp"
+#include "msim/rng.hpp"
+
+static void test_basic_match_and_cancel() {
+  std::vector<std::byte> buf(1 << 16);
+  std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+
+  msim::LadderOrderBook book("X", &mr, /*tick_size=*/1.0, /*ref_price=*/100.0);
+  int32_t tp = 0;
+
+  msim::Order a{1, 101, 10, msim::Side::SELL, 0};
+  assert(book.add_order(a, tp) == 0);
+  assert(book.best_ask().has_value() && *book.best_ask() == 101.0);
+
+  msim::Order b{2, 102, 6, msim::Side::BUY, 0};
+  assert(book.add_order(b, tp) == 6);
+  assert(tp == 101);
+  assert(book.best_ask().has_value() && *book.best_ask() == 101.0);
+
+  assert(book.cancel_order(2) == false);
+  assert(book.cancel_order(1) == true);
+  assert(!book.best_ask().has_value());
+  assert(book.index_size() == 0);
+}
+
+static void test_best_after_sweep() {
+  std::vector<std::byte> buf(1 << 16);
+  std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+
+  msim::LadderOrderBook book("X", &mr, 1.0, 100.0);
+  int32_t tp = 0;
+
+  // Bids at 95, 97, 99 (sparse ladder)
+  assert(book.add_order({1, 95, 5, msim::Side::BUY, 0}, tp) == 0);
+  assert(book.add_order({2, 99, 5, msim::Side::BUY, 0}, tp) == 0);
+  assert(book.add_order({3, 97, 5, msim::Side::BUY, 0}, tp) == 0);
+  assert(*book.best_bid() == 99.0);
+
+  // Sell sweeps 99 and 97 -> next best must be 95
+  assert(book.add_order({4, 96, 10, msim::Side::SELL, 0}, tp) == 10);
+  assert(tp == 97);
+  assert(*book.best_bid() == 95.0);
+  assert(!book.best_ask().has_value());
+
+  // Cancel the last bid -> side empty
+  assert(book.cancel_order(1));
+  assert(!book.best_bid().has_value());
+}
+
+static void test_recentre_and_reject() {
+  std::vector<std::byte> buf(1 << 16);
+  std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+
+  msim::LadderOrderBook book("X", &mr, 1.0, 100.0);
+  int32_t tp = 0;
+  const int32_t w = int32_t(msim::LadderOrderBook::kSlots);
+
+  assert(book.add_order({1, 100, 1, msim::Side::BUY, 0}, tp) == 0);
+
+  // Far above the window but still fits together with the bid at 100
+  const int32_t far = 100 + w - 10;
+  assert(book.add_order({2, far, 1, msim::Side::SELL, 0}, tp) == 0);
+  assert(*book.best_bid() == 100.0);
+  assert(*book.best_ask() == far);
+  assert(book.rejected() == 0);
+
+  // Can't fit together with both resting levels -> rejected, book unchanged
+  const int r = book.add_order({3, 100 + 2 * w, 1, msim::Side::SELL, 0}, tp);
+  assert(msim::is_rejected(r) && msim::filled_qty(r) == 0);
+  assert(book.rejected() == 1);
+  assert(book.index_size() == 2);
+  (void)r;
+
+  // Levels survived the re-centre
+  assert(book.add_order({4, far, 1, msim::Side::BUY, 0}, tp) == 1);
+  assert(tp == far);
+
+  // Trades what it reaches, then the remainder is dropped, not rested
+  book.add_order({5, far, 1, msim::Side::SELL, 0}, tp);
+  const int p = book.add_order({6, 100 - 2 * w, 3, msim::Side::SELL, 0}, tp);
+  assert(msim::is_rejected(p) && msim::filled_qty(p) == 1 && tp == 100);
+  assert(book.rejected() == 2);
+  assert(book.index_size() == 1 && !book.best_bid());
+  (void)p;
+
+  std::vector<msim::Fill> fills;
+  int32_t res = 0;
+  const msim::BookCommand c = msim::BookCommand::add(
+      {7, 100 - 2 * w, 1, msim::Side::BUY, 0});
+  book.apply(&c, 1, fills, &res);
+  assert(msim::is_rejected(res) && fills.empty() && book.rejected() == 3);
+  assert(book.cancel_order(5));
+  assert(book.index_size() == 0);
+}
+
+// Same random flow through both engines must produce identical results.
+static void test_matches_hash_book() {
+  std::vector<std::byte> buf_a(1 << 20), buf_b(1 << 20);
+  std::pmr::monotonic_buffer_resource mr_a(buf_a.data(), buf_a.size());
+  std::pmr::monotonic_buffer_resource mr_b(buf_b.data(), buf_b.size());
+
+  msim::OrderBook hash("X", &mr_a);
+  msim::LadderOrderBook ladder("X", &mr_b);
+
+  Xoroshiro128Plus rng(7);
+  std::vector<uint64_t> live;
+  uint64_t next_id = 1;
+
+  for (int i = 0; i < 200000; ++i) {
+    if (live.empty() || rand_bool(rng, 0.5)) {
+      const msim::Side side =
+          rand_bool(rng, 0.5) ? msim::Side::BUY : msim::Side::SELL;
+      const int32_t tick = 10000 + rand_int(rng, -50, 50);
+      msim::Order o{next_id++, tick, rand_int(rng, 1, 100), side, 0};
+
+      int32_t tp_a = 0, tp_b = 0;
+      const int m_a = hash.add_order(o, tp_a);
+      const int m_b = ladder.add_order(o, tp_b);
+      assert(m_a == m_b);
+      assert(tp_a == tp_b);
+      (void)m_b;
+      if (m_a < o.qty) live.push_back(o.id);
+    } else {
+      const size_t li = rand_index(rng, live.size());
+      const uint64_t victim = live[li];
+      live[li] = live.back();
+      live.pop_back();
+      const bool c_a = hash.cancel_order(victim);
+      const bool c_b = ladder.cancel_order(victim);
+      assert(c_a == c_b);
+      (void)c_a;
+      (void)c_b;
+    }
+    assert(hash.best_bid() == ladder.best_bid());
+    assert(hash.best_ask() == ladder.best_ask());
+    assert(hash.index_size() == ladder.index_size());
+    if (i % 1000 == 0) assert(hash.state_checksum() == ladder.state_checksum());
+  }
+  assert(hash.state_checksum() == ladder.state_checksum());
+}
+
+// Same check with every order type in the flow, including market sweeps.
+static void test_order_types_match_hash_book() {
+  std::vector<std::byte> buf_a(1 << 20), buf_b(1 << 20);
+  std::pmr::monotonic_buffer_resource mr_a(buf_a.data(), buf_a.size());
+  std::pmr::monotonic_buffer_resource mr_b(buf_b.data(), buf_b.size());
+
+  msim::OrderBook hash("X", &mr_a);
+  msim::LadderOrderBook ladder("X", &mr_b);
+
+  Xoroshiro128Plus rng(9);
+  std::vector<uint64_t> live;
+  uint64_t next_id = 1;
+  bool same = true;
+
+  for (int i = 0; i < 200000; ++i) {
+    if (live.empty() || rand_bool(rng, 0.55)) {
+      const msim::Side side =
+          rand_bool(rng, 0.5) ? msim::Side::BUY : msim::Side::SELL;
+      const int32_t tick = 10000 + rand_int(rng, -50, 50);
+      const auto type = msim::OrderType(rand_int(rng, 0, 4));
+      const int qty = type == msim::OrderType::Market ? rand_int(rng, 100, 400)
+                                                      : rand_int(rng, 1, 100);
+      msim::Order o{next_id++, tick, qty, side, 0};
+
+      int32_t tp_a = 0, tp_b = 0;
+      const int m_a = hash.add_order(o, tp_a, type);
+      const int m_b = ladder.add_order(o, tp_b, type);
+      same &= m_a == m_b && tp_a == tp_b;
+      if (m_a < o.qty && msim::rests(type)) live.push_back(o.id);
+    } else {
+      const size_t li = rand_index(rng, live.size());
+      const uint64_t victim = live[li];
+      live[li] = live.back();
+      live.pop_back();
+      same &= hash.cancel_order(victim) == ladder.cancel_order(victim);
+    }
+    same &= hash.best_bid() == ladder.best_bid() &&
+            hash.best_ask() == ladder.best_ask() &&
+            hash.index_size() == ladder.index_size();
+    if (i % 1000 == 0) same &= hash.state_checksum() == ladder.state_checksum();
+  }
+  assert(same);
+  assert(hash.state_checksum() == ladder.state_checksum());
+  (void)same;
+}
+
+int main() {
+  test_basic_match_and_cancel();
+  test_best_after_sweep();
+  test_recentre_and_reject();
+  test_matches_hash_book();
+  test_order_types_match_hash_book();
+  std::cout << "OK: ladder_book\n";
+  return 0;
+}
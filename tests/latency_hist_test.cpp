@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "msim/latency_hist.hpp"
+
+using namespace msim;
+
+// Every value lands in a bucket whose range contains it, buckets are
+// ordered, and a bucket is at most ~1/32 of its value wide.
+static void test_buckets() {
+  using H = LatencyHistogram;
+  std::mt19937_64 rng(7);
+  for (int i = 0; i < 200000; ++i) {
+    const uint64_t v = rng() >> (rng() % 64);
+    const size_t b = H::bucket_of(v);
+    assert(b < H::kBuckets);
+    assert(v <= H::bucket_high(b));
+    assert(b == 0 || v > H::bucket_high(b - 1));
+    assert(H::bucket_high(b) - v <= v / H::kSub);
+    (void)b;
+  }
+  for (uint64_t v = 0; v < H::kSub; ++v)
+    assert(H::bucket_high(H::bucket_of(v)) == v);
+  assert(H::bucket_of(~0ull) == H::kBuckets - 1);
+}
+
+// Quantiles match the sorted sample within bucket precision; merge() of
+// two halves equals recording everything into one.
+static void test_quantiles_and_merge() {
+  auto all = std::make_unique<LatencyHistogram>();
+  auto lo = std::make_unique<LatencyHistogram>();
+  auto hi = std::make_unique<LatencyHistogram>();
+  assert(all->quantile(0.5) == 0 && all->count() == 0);
+
+  std::mt19937_64 rng(11);
+  std::lognormal_distribution<double> dist(4.5, 0.8);  // ~90 median, long tail
+  std::vector<uint64_t> xs;
+  for (int i = 0; i < 100000; ++i) {
+    const uint64_t v = uint64_t(dist(rng));
+    xs.push_back(v);
+    all->record(v);
+    (i % 2 ? lo : hi)->record(v);
+  }
+  lo->merge(*hi);
+  std::sort(xs.begin(), xs.end());
+
+  for (double q : {0.5, 0.9, 0.99, 0.999, 1.0}) {
+    const size_t rank = std::max<size_t>(1, size_t(std::ceil(q * xs.size())));
+    const uint64_t exact = xs[rank - 1];
+    const uint64_t got = all->quantile(q);
+    assert(got >= exact && got - exact <= exact / LatencyHistogram::kSub);
+    assert(lo->quantile(q) == got);
+    (void)exact, (void)got;
+  }
+  assert(all->max() == xs.back() && all->quantile(1.0) == xs.back());
+  assert(lo->count() == all->count() && lo->max() == all->max());
+}
+
+int main() {
+  test_buckets();
+  test_quantiles_and_merge();
+  std::cout << "latency_hist_test OK\n";
+  return 0;
+}
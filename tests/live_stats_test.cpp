@@ -0,0 +1,68 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "msim/live_stats.hpp"
+
+using namespace msim;
+
+// One cache line each, so adjacent workers' counters never share one.
+static void test_layout() {
+  std::vector<LiveStats> v(3);
+  static_assert(alignof(LiveStats) == kCacheLine, "line-aligned");
+  for (const LiveStats& s : v) {
+    const auto addr = reinterpret_cast<std::uintptr_t>(&s);
+    assert(addr % kCacheLine == 0);
+    (void)addr;
+  }
+}
+
+// Workers publish while the monitor samples; totals add up at the end and
+// the monitor prints progress lines on its own.
+static void test_monitor_samples_live() {
+  std::vector<LiveStats> stats(2);
+  std::ostringstream out;
+  const uint64_t kSteps = 2000000;
+  LiveMonitor mon(stats, 2 * kSteps, std::chrono::milliseconds(5), out);
+
+  std::vector<std::thread> th;
+  for (size_t w = 0; w < stats.size(); ++w)
+    th.emplace_back([&, w] {
+      LiveStats::Snapshot s;
+      for (uint64_t i = 1; i <= kSteps; ++i) {
+        s.events = i;
+        s.adds += i & 1;
+        s.cancels += (i & 3) == 2;
+        s.trades += (i & 3) == 0;
+        if ((i & 1023) == 0 || i == kSteps) stats[w].publish(s);
+        if ((i & 0xFFFF) == 0)
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  for (auto& t : th) t.join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  mon.stop();
+  mon.stop();  // idempotent
+
+  const LiveStats::Snapshot t = mon.total();
+  assert(t.events == 2 * kSteps);
+  assert(t.adds == kSteps && t.cancels == kSteps / 2 &&
+         t.trades == kSteps / 2);
+  const std::string log = out.str();
+  assert(log.find("[progress] ") != std::string::npos);
+  assert(log.find("/ 4000000 events (100.0%)") != std::string::npos);
+  (void)t;
+}
+
+int main() {
+  test_layout();
+  test_monitor_samples_live();
+  std::cout << "live_stats_test OK\n";
+  return 0;
+}
@@ -0,0 +1,329 @@
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "msim/lmdb_reader.hpp"
+#include "msim/lmdb_storage.hpp"
+
+using namespace msim;
+namespace fs = std::filesystem;
+
+static const char* kPath = "lmdb_reader_test.mdb";
+
+// 3000 events for one symbol; ts crosses several byte boundaries so a
+// byte-ordered key would not come back in numeric order.
+static void write_fixture() {
+  fs::remove_all(kPath);
+  SymbolTable syms;
+  const uint16_t id = syms.intern("AAA");
+  LMDBStorage store(kPath, 64ull << 20);
+  auto batch = std::make_unique<EventBatch>(&syms);
+  for (uint64_t t = 0; t < 3000; ++t) {
+    batch->push({t * 3, int32_t(10000 + t), 1, id, EventType::ORDER_ADD,
+                 Side::BUY, t + 1});
+    if (batch->full()) {
+      store.write_batch(*batch);
+      batch->clear();
+    }
+  }
+  store.write_batch(*batch);
+  store.flush();
+}
+
+static void test_range_scan() {
+  LMDBReader r(kPath);
+  r.list_symbols();
+  assert(r.count("AAA") == 3000);
+
+  uint64_t prev = 0;
+  size_t n = r.for_each(
+      "AAA",
+      [&](const EventView& v) {
+        assert(v.symbol == "AAA");
+        assert(v.ts_ns >= 300 && v.ts_ns <= 900 && v.ts_ns >= prev);
+        prev = v.ts_ns;
+        return true;
+      },
+      300, 900);
+  assert(n == 201);  // 300, 303, ..., 900
+
+  // seek lands on the first key >= ts_from
+  uint64_t first = 0;
+  r.for_each(
+      "AAA",
+      [&](const EventView& v) {
+        first = v.ts_ns;
+        return false;
+      },
+      301);
+  assert(first == 303);
+
+  // full scan is in numeric order
+  prev = 0;
+  n = r.for_each("AAA", [&](const EventView& v) {
+    assert(v.ts_ns >= prev);
+    prev = v.ts_ns;
+    return true;
+  });
+  assert(n == 3000 && prev == 8997);
+  (void)n;
+}
+
+static void test_batches_stop_early() {
+  LMDBReader r(kPath);
+  r.list_symbols();
+  auto batch = std::make_unique<EventBatch>(&r.symbols());
+
+  size_t calls = 0;
+  const size_t got = r.read_batches("AAA", *batch, [&](const EventBatch& b) {
+    ++calls;
+    assert(b.full() && b.symbol(0) == "AAA" && b.price_tick[0] == 10000);
+    return false;
+  });
+  assert(calls == 1 && got == EventBatch::kCapacity);
+
+  size_t rows = 0;
+  r.read_batches(
+      "AAA", *batch,
+      [&](const EventBatch& b) {
+        rows += b.size();
+        return true;
+      },
+      0, 299);
+  assert(rows == 100);
+  (void)got;
+}
+
+// Out-of-order keys still land (normal put) and are counted; the
+// grouped batch path keeps each symbol's rows in order.
+static void test_append_fallback() {
+  const char* path = "lmdb_append_test.mdb";
+  fs::remove_all(path);
+  SymbolTable syms;
+  const uint16_t a = syms.intern("AAA");
+  const uint16_t b = syms.intern("BBB");
+  {
+    StorageOptions opts;
+    opts.lmdb_durability = LmdbDurability::NoSync;
+    opts.lmdb_map_bytes = 64ull << 20;
+    opts.lmdb_txn_bytes = 256;  // several commits
+    LMDBStorage store(path, opts);
+
+    auto batch = std::make_unique<EventBatch>(&syms);
+    for (uint64_t t = 10; t < 110; ++t)  // interleaved symbols
+      batch->push({t, 100, 1, (t % 2) ? a : b, EventType::ORDER_ADD, Side::BUY, t});
+    store.write_batch(*batch);
+    assert(store.append_fallbacks() == 0);
+
+    batch->clear();
+    batch->push({5, 100, 1, a, EventType::ORDER_ADD, Side::BUY, 5});
+    store.write_batch(*batch);
+    assert(store.append_fallbacks() == 1);
+    store.flush();
+  }
+
+  LMDBReader r(path);
+  r.list_symbols();
+  assert(r.count("AAA") == 51 && r.count("BBB") == 50);
+  uint64_t prev = 0;
+  r.for_each("AAA", [&](const EventView& v) {
+    assert(v.ts_ns > prev || prev == 0);
+    prev = v.ts_ns;
+    return true;
+  });
+  assert(prev == 109);
+  fs::remove_all(path);
+}
+
+// The writer keeps interning into the table it forwards (collector), so an
+// id can show up past the size the storage first saw.
+static void test_growing_table() {
+  const char* path = "lmdb_grow_test.mdb";
+  fs::remove_all(path);
+  SymbolTable syms;
+  const uint16_t a = syms.intern("AAA");
+  {
+    LMDBStorage store(path, 16ull << 20);
+    auto batch = std::make_unique<EventBatch>(&syms);
+    batch->push({1, 100, 1, a, EventType::ORDER_ADD, Side::BUY, 1});
+    store.write_batch(*batch);
+
+    std::vector<uint16_t> ids;
+    for (int k = 0; k < 40; ++k)
+      ids.push_back(syms.intern("S" + std::to_string(k)));
+    batch->clear();
+    for (uint64_t i = 0; i < ids.size(); ++i)
+      batch->push({2 + i, 100, 1, ids[i], EventType::ORDER_ADD, Side::BUY,
+                   2 + i});
+    store.write_batch(*batch);
+    store.flush();
+  }
+
+  LMDBReader r(path);
+  const auto names = r.list_symbols();
+  bool ok = names.size() == 41 && r.count("AAA") == 1;
+  for (int k = 0; k < 40; ++k) ok &= r.count("S" + std::to_string(k)) == 1;
+  assert(ok);
+  (void)ok;
+  fs::remove_all(path);
+}
+
+// Three producers; AAA is written by two of them, so its stream only comes
+// back in ts order if the reader merges the shards.
+static void test_sharded_merge() {
+  const char* path = "lmdb_sharded_test.mdb";
+  fs::remove_all(path);
+  SymbolTable syms;
+  const uint16_t a = syms.intern("AAA");
+  const uint16_t b = syms.intern("BBB");
+  {
+    StorageOptions opts;
+    opts.lmdb_shards = 3;
+    opts.lmdb_map_bytes = 16ull << 20;
+    ShardedLMDBStorage store(path, opts);
+    assert(store.shards() == 3);
+
+    for (uint32_t src = 0; src < 3; ++src) {
+      auto batch = std::make_unique<EventBatch>(&syms, src);
+      for (uint64_t i = 0; i < 100; ++i) {
+        const uint64_t ts = i * 3 + src;  // interleaved across shards
+        batch->push({ts, 100, 1, src == 2 ? b : a, EventType::ORDER_ADD,
+                     Side::BUY, ts + 1});
+      }
+      store.write_batch(*batch);
+      store.flush_source(src);
+    }
+  }
+
+  LMDBReader r(path);
+  assert(r.shards() == 3);
+  const auto names = r.list_symbols();
+  assert(names.size() == 2 && names[0] == "AAA" && names[1] == "BBB");
+  assert(r.count("AAA") == 200 && r.count("BBB") == 100);
+
+  uint64_t prev = 0;
+  size_t n = r.for_each("AAA", [&](const EventView& v) {
+    assert(v.ts_ns % 3 != 2);
+    assert(prev == 0 || v.ts_ns > prev);
+    prev = v.ts_ns;
+    return true;
+  });
+  assert(n == 200);
+
+  // Whole store as one stream, windowed: ts 30..59 from all three shards.
+  std::vector<uint64_t> seen;
+  n = r.for_each_merged(names, [&](const EventView& v) {
+    seen.push_back(v.ts_ns);
+    return true;
+  }, 30, 59);
+  assert(n == 30 && seen.size() == 30);
+  for (size_t i = 0; i < seen.size(); ++i) assert(seen[i] == 30 + i);
+  (void)n;
+  fs::remove_all(path);
+}
+
+// for_each_parallel() hands each symbol to one worker with its own read
+// txns; every symbol's stream matches for_each(), still merged across
+// shards, and the reader's own scans keep working afterwards.
+static void test_parallel_scan() {
+  const char* path = "lmdb_parallel_test.mdb";
+  fs::remove_all(path);
+  SymbolTable syms;
+  std::vector<std::string> names;
+  for (char c = 'A'; c <= 'L'; ++c) {
+    names.push_back(std::string(3, c));
+    syms.intern(names.back());
+  }
+  {
+    StorageOptions opts;
+    opts.lmdb_shards = 3;
+    opts.lmdb_map_bytes = 16ull << 20;
+    ShardedLMDBStorage store(path, opts);
+    for (uint32_t src = 0; src < 3; ++src) {
+      auto batch = std::make_unique<EventBatch>(&syms, src);
+      for (uint64_t i = 0; i < 600; ++i) {
+        const uint64_t ts = i * 3 + src;
+        // 7 and 12 are coprime, so every shard writes every symbol.
+        const uint16_t sym = uint16_t((i * 7 + src) % 12);
+        batch->push({ts, 100, 1, sym, EventType::ORDER_ADD, Side::BUY,
+                     ts + 1});
+        if (batch->full()) {
+          store.write_batch(*batch);
+          batch->clear();
+        }
+      }
+      store.write_batch(*batch);
+      store.flush_source(src);
+    }
+  }
+
+  LMDBReader r(path);
+  std::vector<std::string> got_names = r.list_symbols();
+  bool ok = got_names == names;
+  std::vector<std::vector<uint64_t>> want(names.size());
+  for (size_t s = 0; s < names.size(); ++s)
+    r.for_each(names[s], [&](const EventView& v) {
+      want[s].push_back(v.ts_ns);
+      return true;
+    }, 100, 1500);
+
+  for (size_t threads : {1, 4, 32}) {
+    // Per-symbol slots: only the worker scanning s touches got[s].
+    std::vector<std::vector<uint64_t>> got(names.size());
+    std::vector<char> named(names.size(), 1);
+    const size_t n = r.for_each_parallel(
+        names, threads,
+        [&](size_t s, const EventView& v) {
+          got[s].push_back(v.ts_ns);
+          named[s] &= v.symbol == names[s];
+          return true;
+        },
+        100, 1500);
+    size_t total = 0;
+    for (size_t s = 0; s < names.size(); ++s) {
+      total += want[s].size();
+      ok &= named[s] && !want[s].empty();
+    }
+    ok &= got == want && n == total;
+  }
+
+  // A sink that stops only ends its own symbol.
+  std::vector<size_t> seen(names.size(), 0);
+  r.for_each_parallel(names, 3, [&](size_t s, const EventView&) {
+    return ++seen[s] < 5;
+  });
+  for (size_t s = 0; s < names.size(); ++s) ok &= seen[s] == 5;
+  ok &= r.count("AAA") == r.for_each("AAA", [](const EventView&) {
+    return true;
+  });
+
+  bool threw = false;
+  try {
+    r.for_each_parallel({"AAA", "ZZZ"}, 2,
+                        [](size_t, const EventView&) { return true; });
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  ok &= threw;
+  assert(ok);
+  (void)ok;
+  fs::remove_all(path);
+}
+
+int main() {
+  write_fixture();
+  test_range_scan();
+  test_batches_stop_early();
+  test_append_fallback();
+  test_growing_table();
+  test_sharded_merge();
+  test_parallel_scan();
+  fs::remove_all(kPath);
+  std::cout << "OK: lmdb_reader\n";
+  return 0;
+}
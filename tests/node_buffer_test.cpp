@@ -0,0 +1,61 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "msim/node_buffer.hpp"
+#include "msim/thread_utils.hpp"
+
+using namespace msim;
+
+static bool rejects(const std::string& spec) {
+  try {
+    parse_cpu_list(spec);
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+static void test_cpu_list() {
+  const std::vector<size_t> want{0, 1, 2, 3, 8, 16, 17};
+  assert(parse_cpu_list("0-3,8,16-17") == want);
+  assert(parse_cpu_list("5") == std::vector<size_t>{5});
+  assert(rejects("") && rejects(",") && rejects("3-1") && rejects("a") &&
+         rejects("1-") && rejects("2x") && rejects("1-2-3"));
+
+  assert(worker_cpu({}, 6) == 6);
+  assert(worker_cpu(want, 1) == 1 && worker_cpu(want, 4) == 8);
+  assert(worker_cpu(want, 7) == 0);  // wraps
+  (void)want;
+}
+
+// Every mode yields a zeroed, writable buffer of the requested size; huge
+// modes may degrade (no reserved pages) but never fail.
+static void test_buffers() {
+  const int here = current_numa_node();
+  for (HugePages h :
+       {HugePages::Off, HugePages::Transparent, HugePages::Explicit}) {
+    for (size_t bytes : {size_t(0), size_t(1), size_t(4096 * 3 + 5),
+                         size_t(3) << 20}) {
+      NodeBuffer b(bytes, here, h);
+      assert(b.size() == bytes && b.data() != nullptr);
+      for (size_t i = 0; i < bytes; i += 511) {
+        assert(b.data()[i] == std::byte{0});
+        b.data()[i] = std::byte{0x5a};
+      }
+      if (h == HugePages::Off) assert(b.huge_pages() == HugePages::Off);
+      if (here >= 0 && bytes > 0) assert(b.node() == here);
+    }
+  }
+  (void)here;
+}
+
+int main() {
+  test_cpu_list();
+  test_buffers();
+  std::cout << "node_buffer_test OK\n";
+  return 0;
+}
@@ -1,10 +1,12 @@
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <iostream>
 #include <memory_resource>
 #include <vector>
 
 #include "msim/order_book.hpp"
+#include "msim/rng.hpp"
 
 static void test_basic_match_and_cancel() {
   std::vector<std::byte> buf(1 << 16);
@@ -12,19 +14,19 @@ static void test_basic_match_and_cancel() {
 
   msim::OrderBook book("X", &mr, /*tick_size=*/1.0);
 
-  double tp = 0.0;
+  int32_t tp = 0;
 
   // Resting ask id=1 price=101 qty=10
-  msim::Order a{1, 101.0, 10, msim::Side::SELL, 0};
+  msim::Order a{1, 101, 10, msim::Side::SELL, 0};
   int m0 = book.add_order(a, tp);
   assert(m0 == 0);
   assert(book.best_ask().has_value() && *book.best_ask() == 101.0);
 
   // Incoming buy id=2 price=102 qty=6 -> should trade at 101
-  msim::Order b{2, 102.0, 6, msim::Side::BUY, 0};
+  msim::Order b{2, 102, 6, msim::Side::BUY, 0};
   int m1 = book.add_order(b, tp);
   assert(m1 == 6);
-  assert(tp == 101.0);
+  assert(tp == 101);
 
   // Ask should still exist (remaining 4)
   assert(book.best_ask().has_value() && *book.best_ask() == 101.0);
@@ -42,19 +44,19 @@ static void test_price_time_priority_same_level() {
   std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
 
   msim::OrderBook book("X", &mr, /*tick_size=*/1.0);
-  double tp = 0.0;
+  int32_t tp = 0;
 
   // Two asks at same price level, id1 then id2
-  msim::Order a1{1, 100.0, 5, msim::Side::SELL, 0};
-  msim::Order a2{2, 100.0, 5, msim::Side::SELL, 1};
+  msim::Order a1{1, 100, 5, msim::Side::SELL, 0};
+  msim::Order a2{2, 100, 5, msim::Side::SELL, 1};
   assert(book.add_order(a1, tp) == 0);
   assert(book.add_order(a2, tp) == 0);
   assert(book.index_size() == 2);
 
   // Buy qty=6 at 100: should fully fill id1 (5) then partially fill id2 (1)
-  msim::Order b{3, 100.0, 6, msim::Side::BUY, 2};
+  msim::Order b{3, 100, 6, msim::Side::BUY, 2};
   assert(book.add_order(b, tp) == 6);
-  assert(tp == 100.0);
+  assert(tp == 100);
 
   // id1 must be gone from index; id2 must remain
   assert(book.index_size() == 1);
@@ -64,9 +66,231 @@ static void test_price_time_priority_same_level() {
   assert(!book.best_ask().has_value());
 }
 
+static void test_cancel_middle_keeps_fifo() {
+  std::vector<std::byte> buf(1 << 16);
+  std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+
+  msim::OrderBook book("X", &mr, /*tick_size=*/1.0);
+  int32_t tp = 0;
+
+  // Three asks on one level; cancel the middle one (O(1) unlink)
+  msim::Order a1{1, 100, 5, msim::Side::SELL, 0};
+  msim::Order a2{2, 100, 5, msim::Side::SELL, 1};
+  msim::Order a3{3, 100, 5, msim::Side::SELL, 2};
+  book.add_order(a1, tp);
+  book.add_order(a2, tp);
+  book.add_order(a3, tp);
+
+  const bool c2 = book.cancel_order(2);
+  assert(c2);
+  (void)c2;
+  assert(book.index_size() == 2);
+
+  // Buy 7: fills all of id1 then 2 of id3; id2 must not be touched
+  msim::Order b{4, 100, 7, msim::Side::BUY, 3};
+  const int m = book.add_order(b, tp);
+  assert(m == 7);
+  (void)m;
+  assert(book.index_size() == 1);
+
+  const bool c1 = book.cancel_order(1);
+  const bool c3 = book.cancel_order(3);
+  assert(!c1 && c3);
+  (void)c1;
+  (void)c3;
+  assert(!book.best_ask().has_value());
+
+  // Nodes are recycled: re-adding doesn't require new pool chunks
+  for (uint64_t id = 10; id < 20; ++id) {
+    msim::Order o{id, 100, 1, msim::Side::BUY, 0};
+    book.add_order(o, tp);
+  }
+  for (uint64_t id = 10; id < 20; ++id) book.cancel_order(id);
+  assert(book.index_size() == 0);
+}
+
+// More resting orders and ticks than the tables' initial capacity
+// (kIndexCap / kLevelCap); used to abort, now the tables grow.
+static void test_deep_book_grows() {
+  std::pmr::unsynchronized_pool_resource mr;
+  msim::OrderBook book("X", &mr, /*tick_size=*/1.0);
+
+  int32_t tp = 0;
+  uint64_t id = 1;
+  for (int i = 0; i < 40000; ++i) {
+    const int tick = 1 + (i % 3000);
+    msim::Order bid{id++, tick, 1, msim::Side::BUY, 0};
+    msim::Order ask{id++, 10000 + tick, 1, msim::Side::SELL, 0};
+    assert(book.add_order(bid, tp) == 0);
+    assert(book.add_order(ask, tp) == 0);
+  }
+  assert(book.index_size() == 80000);
+  assert(*book.best_bid() == 3000.0 && *book.best_ask() == 10001.0);
+
+  for (uint64_t k = 1; k < id; k += 2) assert(book.cancel_order(k));
+  assert(book.index_size() == 40000 && !book.best_bid().has_value());
+  (void)tp;
+}
+
+// IOC / FOK / market / post-only on both engines: asks 101 x5, 102 x5,
+// 104 x5 and a bid 99 x5 to trade against.
+static void test_order_types(msim::BookKind kind) {
+  using msim::OrderType;
+  using msim::Side;
+  std::vector<std::byte> buf(1 << 16);
+  std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+  auto book = msim::make_order_book(kind, "X", &mr, /*tick_size=*/1.0);
+  int32_t tp = 0;
+  for (msim::Order o : {msim::Order{1, 101, 5, Side::SELL, 0},
+                        msim::Order{2, 102, 5, Side::SELL, 0},
+                        msim::Order{3, 104, 5, Side::SELL, 0},
+                        msim::Order{4, 99, 5, Side::BUY, 0}})
+    book->add_order(o, tp);
+
+  // IOC fills what crosses (101, 102) and drops the rest.
+  int m = book->add_order({10, 102, 12, Side::BUY, 0}, tp, OrderType::IOC);
+  assert(m == 10 && tp == 102);
+  assert(book->index_size() == 2 && *book->best_bid() == 99.0);
+
+  // FOK: 5 available up to 104 -> killed whole; 5 -> filled.
+  m = book->add_order({11, 104, 6, Side::BUY, 0}, tp, OrderType::FOK);
+  assert(m == 0 && book->index_size() == 2);
+  m = book->add_order({12, 104, 5, Side::BUY, 0}, tp, OrderType::FOK);
+  assert(m == 5 && !book->best_ask().has_value());
+
+  // Post-only rests when passive, does nothing when it would cross.
+  m = book->add_order({13, 103, 5, Side::SELL, 0}, tp, OrderType::PostOnly);
+  assert(m == 0 && *book->best_ask() == 103.0);
+  m = book->add_order({14, 98, 5, Side::SELL, 0}, tp, OrderType::PostOnly);
+  assert(m == 0 && book->index_size() == 2 && *book->best_bid() == 99.0);
+
+  // Market ignores its price, sweeps the side and never rests.
+  m = book->add_order({15, 1, 8, Side::BUY, 0}, tp, OrderType::Market);
+  assert(m == 5 && tp == 103 && !book->best_ask().has_value());
+  m = book->add_order({16, 1000000, 2, Side::SELL, 0}, tp, OrderType::Market);
+  assert(m == 2 && tp == 99 && book->index_size() == 1);
+  (void)m;
+}
+
+// Books match in ticks whatever the tick size; it only scales the
+// displayed best bid / ask.
+static void test_tick_size_display() {
+  for (double tick : {0.01, 0.001, 0.0001, 1.0, 0.05}) {
+    std::pmr::unsynchronized_pool_resource mr;
+    msim::OrderBook book("X", &mr, tick);
+    int32_t tp = 0;
+    book.add_order({1, 10000, 5, msim::Side::BUY, 0}, tp);
+    book.add_order({2, 10003, 5, msim::Side::SELL, 0}, tp);
+    const int m = book.add_order({3, 10003, 2, msim::Side::BUY, 0}, tp);
+    assert(m == 2 && tp == 10003);
+    assert(*book.best_bid() == 10000 * tick);
+    assert(*book.best_ask() == 10003 * tick);
+    (void)m;
+  }
+}
+
+// apply() of a command batch matches one add_order / cancel_order per
+// command: same results, books and best prices, and one Fill per resting
+// order traded, best level first and FIFO (lower id) within a level.
+static void test_apply_matches_single_calls(msim::BookKind kind) {
+  std::pmr::unsynchronized_pool_resource mr;
+  auto single = msim::make_order_book(kind, "X", &mr, 0.01);
+  auto batched = msim::make_order_book(kind, "X", &mr, 0.01);
+
+  Xoroshiro128Plus rng(11);
+  std::vector<uint64_t> live;
+  std::vector<msim::BookCommand> cmds;
+  std::vector<msim::Fill> fills;
+  std::vector<int32_t> results, want, want_tp;
+  uint64_t id = 1;
+  bool ok = true;
+  for (int batch = 0; batch < 400; ++batch) {
+    cmds.clear();
+    fills.clear();
+    want.clear();
+    want_tp.clear();
+    // Runs of cancels hit emptied best levels; the odd miss is kept.
+    const bool cancels = rand_bool(rng, 0.3);
+    const int n = rand_int(rng, 1, 300);
+    for (int k = 0; k < n; ++k) {
+      if (cancels && !live.empty() && !rand_bool(rng, 0.1)) {
+        const std::size_t li = rand_index(rng, live.size());
+        cmds.push_back(msim::BookCommand::cancel(live[li]));
+        live[li] = live.back();
+        live.pop_back();
+      } else if (cancels) {
+        cmds.push_back(msim::BookCommand::cancel(id + 1000000));
+      } else {
+        const msim::Side side =
+            rand_bool(rng, 0.5) ? msim::Side::BUY : msim::Side::SELL;
+        const auto type = msim::OrderType(rand_int(rng, 0, 4));
+        const msim::Order o{id, 10000 + rand_int(rng, -30, 30),
+                            rand_int(rng, 1, 100), side, id};
+        cmds.push_back(msim::BookCommand::add(o, type));
+        live.push_back(id++);
+      }
+    }
+    for (const msim::BookCommand& c : cmds) {
+      int32_t tp = 0;
+      want.push_back(c.op == msim::BookOp::Cancel
+                         ? int32_t(single->cancel_order(c.order.id))
+                         : single->add_order(c.order, tp, c.type));
+      want_tp.push_back(tp);
+    }
+    results.assign(cmds.size(), -1);
+    batched->apply(cmds.data(), cmds.size(), fills, results.data());
+    ok &= results == want;
+    ok &= single->best_bid() == batched->best_bid() &&
+          single->best_ask() == batched->best_ask();
+
+    std::vector<int32_t> qty(cmds.size(), 0), last_tp(cmds.size(), 0);
+    for (std::size_t f = 0; f < fills.size(); ++f) {
+      const msim::Fill& x = fills[f];
+      const msim::BookCommand& c = cmds[x.cmd];
+      ok &= c.op == msim::BookOp::Add && x.taker_id == c.order.id &&
+            x.taker_side == c.order.side && x.qty > 0;
+      if (f > 0 && fills[f - 1].cmd == x.cmd) {
+        const msim::Fill& p = fills[f - 1];
+        ok &= p.tick == x.tick ? p.maker_id < x.maker_id
+                               : (x.taker_side == msim::Side::BUY)
+                                     == (p.tick < x.tick);
+      } else {
+        ok &= f == 0 || fills[f - 1].cmd < x.cmd;
+      }
+      qty[x.cmd] += x.qty;
+      last_tp[x.cmd] = x.tick;
+    }
+    for (std::size_t k = 0; k < cmds.size(); ++k)
+      if (cmds[k].op == msim::BookOp::Add)
+        ok &= qty[k] == want[k] && last_tp[k] == want_tp[k];
+  }
+  ok &= single->state_checksum() == batched->state_checksum();
+  ok &= single->index_size() == batched->index_size();
+  assert(ok);
+  (void)ok;
+}
+
+// round_tick rounds half away from zero, like std::llround.
+static void test_round_tick() {
+  bool ok = true;
+  for (double x : {0.0, 0.5, 1.5, 2.5, -0.5, -1.5, 10000.49999, 10000.5,
+                   -10000.5, 123456.7, -0.4, 2147483000.5})
+    ok &= msim::round_tick(x) == std::llround(x);
+  assert(ok);
+  (void)ok;
+}
+
 int main() {
   test_basic_match_and_cancel();
   test_price_time_priority_same_level();
+  test_cancel_middle_keeps_fifo();
+  test_deep_book_grows();
+  test_order_types(msim::BookKind::Hash);
+  test_order_types(msim::BookKind::Ladder);
+  test_tick_size_display();
+  test_apply_matches_single_calls(msim::BookKind::Hash);
+  test_apply_matches_single_calls(msim::BookKind::Ladder);
+  test_round_tick();
   std::cout << "OK: order_book\n";
   return 0;
 }
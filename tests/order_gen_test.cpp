@@ -0,0 +1,82 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "msim/order_gen.hpp"
+
+using namespace msim;
+
+// Same seed and step range -> identical batches; another seed differs.
+static void test_deterministic() {
+  OrderGenerator a(42, 5, 0.001, 0.5, 1000);
+  OrderGenerator b(42, 5, 0.001, 0.5, 1000);
+  OrderGenerator c(43, 5, 0.001, 0.5, 1000);
+  auto ba = std::make_unique<IntentBatch>();
+  auto bb = std::make_unique<IntentBatch>();
+  auto bc = std::make_unique<IntentBatch>();
+
+  bool differs = false;
+  for (uint64_t step = 0; step < 10000; step += 777) {
+    a.fill(*ba, step, 777);
+    b.fill(*bb, step, 777);
+    c.fill(*bc, step, 777);
+    assert(ba->n == 777);
+    for (size_t i = 0; i < ba->n; ++i) {
+      assert(ba->sym[i] == bb->sym[i] && ba->add[i] == bb->add[i] &&
+             ba->side[i] == bb->side[i] && ba->qty[i] == bb->qty[i] &&
+             ba->move[i] == bb->move[i] && ba->pick[i] == bb->pick[i]);
+      differs |= ba->move[i] != bc->move[i];
+    }
+  }
+  assert(differs);
+  (void)differs;
+}
+
+// Field ranges, ~fair coins and N(0,1) moments / tails for the moves.
+static void test_distributions() {
+  const double sigma = 0.01;
+  OrderGenerator g(7, 3, sigma);
+  auto b = std::make_unique<IntentBatch>();
+
+  const size_t kBatches = 2000;
+  const double n = double(kBatches * IntentBatch::kCapacity);
+  double adds = 0, buys = 0, qty_sum = 0, sum = 0, sum2 = 0, tail = 0;
+  uint64_t per_sym[3] = {0, 0, 0};
+  for (size_t k = 0; k < kBatches; ++k) {
+    g.fill(*b, k * IntentBatch::kCapacity, IntentBatch::kCapacity);
+    for (size_t i = 0; i < b->n; ++i) {
+      assert(b->sym[i] < 3);
+      assert(b->qty[i] >= 1 && b->qty[i] <= 100);
+      assert(b->pick[i] >= 0.0 && b->pick[i] < 1.0);
+      ++per_sym[b->sym[i]];
+      adds += b->add[i];
+      buys += b->side[i] == Side::BUY;
+      qty_sum += b->qty[i];
+      const double z = b->move[i] / sigma;
+      sum += z;
+      sum2 += z * z;
+      tail += std::fabs(z) > 3.0;
+    }
+  }
+  const double mean = sum / n;
+  const double var = sum2 / n - mean * mean;
+  assert(std::fabs(adds / n - 0.5) < 0.01);
+  assert(std::fabs(buys / n - 0.5) < 0.01);
+  assert(std::fabs(qty_sum / n - 50.5) < 0.5);
+  for (uint64_t c : per_sym) assert(std::fabs(c / n - 1.0 / 3) < 0.01);
+  assert(std::fabs(mean) < 0.01);
+  assert(std::fabs(var - 1.0) < 0.01);
+  assert(std::fabs(tail / n - 0.0027) < 0.0005);  // P(|z| > 3)
+  (void)mean;
+  (void)var;
+}
+
+int main() {
+  test_deterministic();
+  test_distributions();
+  std::cout << "order_gen_test OK\n";
+  return 0;
+}
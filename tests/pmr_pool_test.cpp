@@ -0,0 +1,99 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <vector>
+
+#include "msim/order_book.hpp"
+#include "msim/pmr_utils.hpp"
+
+using namespace msim;
+
+static bool aligned(const void* p, size_t a) {
+  return reinterpret_cast<uintptr_t>(p) % a == 0;
+}
+
+// Same class -> the freed block comes back; stats track class-rounded bytes.
+static void test_recycle_and_stats() {
+  std::vector<std::byte> buf(1 << 16);
+  CountingResource up(std::pmr::new_delete_resource());
+  SizeClassPool pool(buf.data(), buf.size(), &up);
+
+  void* a = pool.allocate(24, 8);  // 32-byte class
+  assert(pool.live_bytes() == 32);
+  pool.deallocate(a, 24, 8);
+  assert(pool.live_bytes() == 0 && pool.high_water() == 32);
+  void* b = pool.allocate(20, 4);
+  assert(b == a);
+
+  void* c = pool.allocate(100, 128);
+  void* d = pool.allocate(4000, 64);
+  assert(aligned(c, 128) && aligned(d, 64));
+  assert(pool.live_bytes() == 32 + 128 + 4096);
+  assert(up.bytes_allocated() == 0);  // all from the buffer
+
+  // Past kMaxClass: straight to upstream, still counted as live.
+  const size_t big = SizeClassPool::kMaxClass + 1;
+  void* e = pool.allocate(big, 16);
+  assert(up.bytes_allocated() == big &&
+         pool.live_bytes() == 32 + 128 + 4096 + big);
+  pool.deallocate(e, big, 16);
+  pool.deallocate(b, 20, 4);
+  pool.deallocate(c, 100, 128);
+  pool.deallocate(d, 4000, 64);
+  assert(pool.live_bytes() == 0);
+  (void)a, (void)b, (void)c, (void)d, (void)e;
+}
+
+// Buffer exhausted -> refill chunks come from upstream.
+static void test_spill() {
+  std::vector<std::byte> buf(4096);
+  CountingResource up(std::pmr::new_delete_resource());
+  SizeClassPool pool(buf.data(), buf.size(), &up);
+  std::vector<void*> blocks;
+  for (int i = 0; i < 1000; ++i) blocks.push_back(pool.allocate(64, 16));
+  assert(up.bytes_allocated() >= 1000 * 64 - 4096);
+  for (size_t i = 1; i < blocks.size(); ++i) assert(blocks[i] != blocks[i - 1]);
+  for (void* p : blocks) pool.deallocate(p, 64, 16);
+}
+
+// Books torn down and rebuilt over one resource: a monotonic arena grows
+// every cycle, the pool reuses the first cycle's blocks.
+static size_t churn_upstream(ArenaKind kind, BookKind book_kind, int cycles) {
+  std::vector<std::byte> buf(1 << 20);
+  CountingResource up(std::pmr::new_delete_resource());
+  std::unique_ptr<std::pmr::memory_resource> mr;
+  if (kind == ArenaKind::Pool)
+    mr = std::make_unique<SizeClassPool>(buf.data(), buf.size(), &up);
+  else
+    mr = std::make_unique<std::pmr::monotonic_buffer_resource>(
+        buf.data(), buf.size(), &up);
+
+  for (int c = 0; c < cycles; ++c) {
+    auto book = make_order_book(book_kind, "X", mr.get(), 1.0, 2500.0);
+    int32_t px = 0;
+    for (uint64_t id = 1; id <= 30000; ++id)  // deep resting book, grows maps
+      book->add_order(Order{id, int32_t(1000 + id % 3000), 1, Side::BUY, 0}, px);
+  }
+  return up.bytes_allocated();
+}
+
+static void test_churn_is_flat() {
+  for (BookKind bk : {BookKind::Hash, BookKind::Ladder}) {
+    const size_t pool1 = churn_upstream(ArenaKind::Pool, bk, 1);
+    const size_t pool8 = churn_upstream(ArenaKind::Pool, bk, 8);
+    const size_t mono1 = churn_upstream(ArenaKind::Monotonic, bk, 1);
+    const size_t mono8 = churn_upstream(ArenaKind::Monotonic, bk, 8);
+    assert(pool8 == pool1);
+    assert(mono8 > 4 * mono1);
+    (void)pool1, (void)pool8, (void)mono1, (void)mono8;
+  }
+}
+
+int main() {
+  test_recycle_and_stats();
+  test_spill();
+  test_churn_is_flat();
+  std::cout << "pmr_pool_test OK\n";
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "msim/run_report.hpp"
+#include "msim/simulator.hpp"
+
+using namespace msim;
+
+static bool has(const std::string& s, const std::string& sub) {
+  return s.find(sub) != std::string::npos;
+}
+
+// Strings are escaped, unset optionals and non-finite doubles become null,
+// checksums are hex strings.
+static void test_write_json() {
+  RunReport r;
+  r.mode = "run_mt";
+  r.scenario = "quo\"te\\back\nline";
+  r.n_threads = 2;
+  r.adds = 12345;
+  r.rejected = 77;
+  r.throughput_ev_s = 1.5e6;
+  r.imbalance = std::numeric_limits<double>::infinity();
+  r.threads.push_back(ThreadReport{});
+  r.threads.push_back(ThreadReport{});
+  r.threads[1].thread = 1;
+  r.threads[1].steps = 99;
+  r.threads[1].perf.value[size_t(PerfEvent::Cycles)] = 50;
+  r.threads[1].perf.value[size_t(PerfEvent::Instructions)] = 100;
+  r.threads[1].perf.valid = 1u << unsigned(PerfEvent::Cycles) |
+                            1u << unsigned(PerfEvent::Instructions);
+  r.threads[1].perf.threads = 1;
+  r.latency_ns.push_back({"add", 10, 20, 30, 40, 50});
+  ArenaReport a;
+  a.label = "arena[A]";
+  a.upstream_bytes = 4096;
+  a.high_water = 512;
+  r.arenas.push_back(a);
+  r.books.push_back({"A", 3, 0x00ab00000000cdefull, 66});
+
+  std::ostringstream os;
+  write_json(os, r);
+  const std::string j = os.str();
+  bool ok = has(j, "\"schema\": 1,");
+  ok &= has(j, "\"mode\": \"run_mt\"");
+  ok &= has(j, "\"scenario\": \"quo\\\"te\\\\back\\u000aline\"");
+  ok &= has(j, "\"adds\": 12345");
+  ok &= has(j, "\"throughput_ev_s\": 1500000,");
+  ok &= has(j, "\"imbalance\": null");
+  ok &= has(j, "\"steps\": 99");
+  ok &= has(j, "\"ipc\": 2,") && has(j, "\"instructions\": 100,");
+  ok &= has(j, "\"instructions\": 1.0101010101010102,");  // per event
+  ok &= has(j, "\"l1d_misses\": null,");
+  ok &= has(j, "\"gen_ms\": 0,\n      \"perf\": null\n");  // thread 0
+  ok &= has(j, "\n  \"perf\": null,\n");  // no merged totals set
+  ok &= has(j, "\"add\": {");
+  ok &= has(j, "\"p99.9\": 40");
+  ok &= has(j, "\"live_bytes\": null");
+  ok &= has(j, "\"high_water\": 512");
+  ok &= has(j, "\"checksum\": \"00ab00000000cdef\"");
+  ok &= has(j, "\"rejected\": 77,") && has(j, "\"rejected\": 66\n");
+  ok &= !has(j, ",\n  }") && !has(j, ",\n]");  // no trailing commas
+  ok &= j.front() == '{' && j.substr(j.size() - 2) == "}\n";
+
+  RunReport empty;
+  std::ostringstream eo;
+  write_json(eo, empty);
+  ok &= has(eo.str(), "\"threads\": [],") &&
+        has(eo.str(), "\"latency_ns\": {},");
+  assert(ok);
+  (void)ok;
+}
+
+// --json from a real run(): the books match book_checksums() and the
+// per-thread numbers add up to the totals.
+static void test_simulator_report(const std::string& path) {
+  SimConfig cfg;
+  cfg.total_events = 20000;
+  cfg.symbol_list = {"A", "B", "C"};
+  cfg.json_path = path;
+  Simulator sim(cfg);
+  sim.run();
+
+  std::ifstream in(path);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  const std::string j = ss.str();
+  bool ok = has(j, "\"mode\": \"run\"") && has(j, "\"total_events\": 20000");
+  ok &= has(j, "\"symbols\": 3,") && has(j, "\"thread\": 0,");
+  for (const auto& [sym, sum] : sim.book_checksums()) {
+    char hex[24];
+    std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)sum);
+    ok &= has(j, "\"symbol\": \"" + sym + "\"") &&
+          has(j, std::string("\"checksum\": \"") + hex + "\"");
+  }
+  assert(ok);
+  (void)ok;
+
+  bool threw = false;
+  try {
+    write_json_file("no/such/dir/report.json", RunReport{});
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  assert(threw);
+  (void)threw;
+}
+
+int main() {
+  const std::string path = "run_report_test.json";
+  test_write_json();
+  test_simulator_report(path);
+  std::remove(path.c_str());
+  std::cout << "run_report_test OK\n";
+  return 0;
+}
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "msim/order_gen.hpp"
+#include "msim/scenario.hpp"
+
+using namespace msim;
+
+static const char* kPath = "scenario_test.scn";
+
+static bool throws(const std::string& name_or_path) {
+  try {
+    Scenario::resolve(name_or_path);
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+static void write_file(const std::string& body) {
+  std::ofstream out(kPath);
+  out << body;
+}
+
+// Every preset resolves and validates; "default" is the historic flow.
+static void test_presets() {
+  for (const auto& name : Scenario::presets()) {
+    const Scenario s = Scenario::resolve(name);
+    assert(s.name == name);
+    s.validate();
+  }
+  assert(Scenario::resolve("default").is_default());
+  assert(!Scenario::resolve("sweep").is_default());
+  assert(throws("no-such-preset"));
+}
+
+// key = value files, optionally on top of a preset; errors name the line.
+static void test_load_file() {
+  write_file(
+      "# burstier sweep\n"
+      "preset = sweep\n"
+      "burst_len = 50   # longer bursts\n"
+      "qty_dist = pareto\n"
+      "qty_max = 500\n");
+  const Scenario s = Scenario::resolve(kPath);
+  assert(s.name == "scenario_test");
+  assert(s.burst_every == 2000 && s.burst_len == 50);
+  assert(s.qty_dist == QtyDist::Pareto && s.qty_max == 500);
+  assert(s.cancel_ratio == Scenario::preset("sweep").cancel_ratio);
+  (void)s;
+
+  write_file("cancel_ratio = 0.3\nbogus = 1\n");
+  bool named_line = false;
+  try {
+    Scenario::load(kPath);
+  } catch (const std::runtime_error& e) {
+    named_line = std::string(e.what()).find(":2: unknown key") !=
+                 std::string::npos;
+  }
+  assert(named_line);
+  (void)named_line;
+
+  write_file("ioc = 0.7\nmarket = 0.5\n");  // shares over 1
+  assert(throws(kPath));
+  write_file("qty_min = x\n");
+  assert(throws(kPath));
+  std::remove(kPath);
+}
+
+// The default scenario draws exactly what the generator drew before.
+static void test_default_stream_unchanged() {
+  OrderGenerator a(42, 5, 0.001, 0.5, 1000);
+  OrderGenerator b(42, 5, 0.001, 0.5, 1000, Scenario::preset("default"));
+  auto ba = std::make_unique<IntentBatch>();
+  auto bb = std::make_unique<IntentBatch>();
+  bool same = true;
+  for (uint64_t step = 0; step < 20000; step += IntentBatch::kCapacity) {
+    a.fill(*ba, step, IntentBatch::kCapacity);
+    b.fill(*bb, step, IntentBatch::kCapacity);
+    for (size_t i = 0; i < ba->n; ++i)
+      same &= ba->sym[i] == bb->sym[i] && ba->add[i] == bb->add[i] &&
+              ba->side[i] == bb->side[i] && ba->qty[i] == bb->qty[i] &&
+              ba->move[i] == bb->move[i] && bb->type[i] == OrderType::Limit;
+  }
+  assert(same);
+  (void)same;
+}
+
+// Cancel share, type mix, qty bounds and symbol skew follow the scenario.
+static void test_mix() {
+  Scenario sc;
+  sc.name = "mix";
+  sc.cancel_ratio = 0.3;
+  sc.ioc = 0.2;
+  sc.fok = 0.1;
+  sc.market = 0.05;
+  sc.post_only = 0.15;
+  sc.qty_dist = QtyDist::Pareto;
+  sc.qty_min = 2;
+  sc.qty_max = 5000;
+  sc.qty_alpha = 1.5;
+  sc.symbol_skew = 1.0;
+  OrderGenerator g(7, 4, 0.001, 0.0, 0, sc);
+  auto b = std::make_unique<IntentBatch>();
+
+  const size_t kBatches = 500;
+  const double n = double(kBatches * IntentBatch::kCapacity);
+  double adds = 0, big = 0;
+  double types[5] = {0, 0, 0, 0, 0};
+  double per_sym[4] = {0, 0, 0, 0};
+  bool in_range = true;
+  for (size_t k = 0; k < kBatches; ++k) {
+    g.fill(*b, k * IntentBatch::kCapacity, IntentBatch::kCapacity);
+    for (size_t i = 0; i < b->n; ++i) {
+      adds += b->add[i];
+      types[uint8_t(b->type[i])] += 1;
+      per_sym[b->sym[i]] += 1;
+      in_range &= b->qty[i] >= 2 && b->qty[i] <= 5000 && b->sym[i] < 4;
+      big += b->qty[i] > 20;  // P = (2/20)^1.5 ~ 3.2%
+    }
+  }
+  assert(in_range);
+  assert(std::fabs(adds / n - 0.7) < 0.01);
+  assert(std::fabs(types[1] / n - 0.2) < 0.01);
+  assert(std::fabs(types[2] / n - 0.1) < 0.01);
+  assert(std::fabs(types[3] / n - 0.05) < 0.01);
+  assert(std::fabs(types[4] / n - 0.15) < 0.01);
+  assert(std::fabs(big / n - 0.0316) < 0.005);
+  // Zipf(1) over 4: weights 1, 1/2, 1/3, 1/4 -> 48%, 24%, 16%, 12%.
+  assert(std::fabs(per_sym[0] / n - 0.48) < 0.01);
+  assert(std::fabs(per_sym[3] / n - 0.12) < 0.01);
+  (void)in_range;
+  (void)big;
+}
+
+// Burst steps are one-sided market adds at burst_qty_mult x size.
+static void test_bursts() {
+  Scenario sc = Scenario::preset("sweep");
+  sc.burst_every = 1000;
+  sc.burst_len = 10;
+  OrderGenerator g(3, 2, 0.001, 0.0, 0, sc);
+  auto b = std::make_unique<IntentBatch>();
+
+  bool ok = true;
+  uint64_t in_burst = 0;
+  for (uint64_t step = 0; step < 8000; step += IntentBatch::kCapacity) {
+    g.fill(*b, step, std::min<size_t>(IntentBatch::kCapacity, 8000 - step));
+    for (size_t i = 0; i < b->n; ++i) {
+      const uint64_t s = step + i;
+      if (s % 1000 >= 10) continue;
+      ++in_burst;
+      const Side want = (s / 1000) & 1 ? Side::SELL : Side::BUY;
+      ok &= b->add[i] == 1 && b->side[i] == want &&
+            b->type[i] == OrderType::Market && b->qty[i] >= 25 &&
+            b->qty[i] % 25 == 0;
+    }
+  }
+  assert(ok && in_burst == 80);
+  (void)ok;
+  (void)in_burst;
+}
+
+int main() {
+  test_presets();
+  test_load_file();
+  test_default_stream_unchanged();
+  test_mix();
+  test_bursts();
+  std::cout << "scenario_test OK\n";
+  return 0;
+}
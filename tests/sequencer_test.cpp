@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "msim/rng.hpp"
+#include "msim/sequencer.hpp"
+
+using namespace msim;
+
+// Records every merged row; only the merger thread writes.
+struct CollectStorage : IStorage {
+  std::vector<CompactEvent>* out;
+  explicit CollectStorage(std::vector<CompactEvent>* o) : out(o) {}
+  void write(const Event&) override {}
+  void write_batch(const EventBatch& b) override {
+    for (size_t i = 0; i < b.size(); ++i) out->push_back(b.row(i));
+  }
+  void flush() override {}
+};
+
+struct Sent {
+  uint64_t key;
+  uint32_t producer;
+  uint64_t n;  // producer-local sequence, carried in order_id
+};
+
+// Producers run at uneven paces (and one stops early); the tape is the
+// stable (key, producer) merge with strictly increasing ts.
+static void test_merge_order(size_t n_producers, uint64_t per_producer) {
+  std::vector<CompactEvent> got;
+  uint64_t tapped = 0;
+  std::vector<std::vector<Sent>> sent(n_producers);
+  {
+    Sequencer seq(std::make_unique<CollectStorage>(&got), n_producers,
+                  nullptr, [&](const EventBatch& b) { tapped += b.size(); });
+    std::vector<std::thread> th;
+    for (size_t p = 0; p < n_producers; ++p)
+      th.emplace_back([&, p] {
+        Xoroshiro128Plus rng(100 + p);
+        const uint64_t n_events = p == 0 ? per_producer / 3 : per_producer;
+        uint64_t key = 0;
+        for (uint64_t n = 0; n < n_events; ++n) {
+          key += uint64_t(rand_int(rng, 0, 3));  // repeats and gaps
+          const uint64_t id = (uint64_t(p) << 32) | n;
+          seq.push(p, key, CompactEvent{0, 0, 0, uint16_t(p),
+                                        EventType::ORDER_ADD, Side::BUY, id});
+          sent[p].push_back({key, uint32_t(p), n});
+          if (rand_bool(rng, 0.001)) std::this_thread::yield();
+        }
+        seq.finish(p);
+      });
+    for (auto& t : th) t.join();
+    seq.close();
+    assert(seq.written() == got.size());
+  }
+
+  std::vector<Sent> want;
+  for (auto& v : sent) want.insert(want.end(), v.begin(), v.end());
+  std::stable_sort(want.begin(), want.end(),
+                   [](const Sent& a, const Sent& b) {
+                     return std::tie(a.key, a.producer) <
+                            std::tie(b.key, b.producer);
+                   });
+
+  bool ok = got.size() == want.size() && tapped == got.size();
+  for (size_t i = 0; ok && i < got.size(); ++i) {
+    const uint64_t id = (uint64_t(want[i].producer) << 32) | want[i].n;
+    ok &= got[i].order_id == id;
+    ok &= got[i].ts_ns >= want[i].key;  // the key, bumped to stay unique
+    if (i) ok &= got[i].ts_ns > got[i - 1].ts_ns;
+  }
+  assert(ok);
+  (void)ok;
+}
+
+// A producer that pushes nothing until late holds the tape back (its
+// watermark was never raised), then everything comes out in order.
+static void test_watermark_holds_back() {
+  std::vector<CompactEvent> got;
+  std::mutex mu;  // guards reads of `got` while the merger runs
+  struct LockedCollect : CollectStorage {
+    std::mutex* mu;
+    LockedCollect(std::vector<CompactEvent>* o, std::mutex* m)
+        : CollectStorage(o), mu(m) {}
+    void write_batch(const EventBatch& b) override {
+      std::lock_guard<std::mutex> lk(*mu);
+      CollectStorage::write_batch(b);
+    }
+  };
+
+  Sequencer seq(std::make_unique<LockedCollect>(&got, &mu), 2, nullptr);
+  for (uint64_t k = 10; k < 3000; ++k)  // several output batches' worth
+    seq.push(0, k, CompactEvent{0, 0, 0, 0, EventType::ORDER_ADD, Side::BUY,
+                                k});
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  size_t early = 0;
+  {
+    std::lock_guard<std::mutex> lk(mu);
+    early = got.size();
+  }
+  assert(early == 0);  // producer 1 could still send key 0
+
+  seq.push(1, 5, CompactEvent{0, 0, 0, 1, EventType::ORDER_ADD, Side::SELL,
+                              1});
+  seq.finish(1);
+  seq.finish(0);
+  seq.close();
+  assert(got.size() == 2991 && got[0].order_id == 1 && got[0].ts_ns == 5);
+  assert(got[1].order_id == 10 && got.back().ts_ns == 2999);
+  (void)early;
+}
+
+int main() {
+  test_merge_order(1, 20000);
+  test_merge_order(2, 50000);  // more than a ring's worth each
+  test_merge_order(4, 30000);
+  test_watermark_holds_back();
+  std::cout << "sequencer_test OK\n";
+  return 0;
+}
@@ -65,10 +65,59 @@ static void test_threaded_ordering() {
   for (std::size_t i = 0; i < N; ++i) assert(got[i] == i);
 }
 
+static void test_bulk_pop() {
+  msim::SpscRing<int, 8> q;
+  int out[8] = {};
+
+  assert(q.try_pop_bulk(out, 8) == 0);
+  for (int i = 0; i < 6; ++i) assert(q.try_push(i));
+
+  assert(q.try_pop_bulk(out, 4) == 4);
+  for (int i = 0; i < 4; ++i) assert(out[i] == i);
+
+  // wrap around the end of the buffer
+  for (int i = 6; i < 12; ++i) assert(q.try_push(i));
+  assert(q.full());
+
+  assert(q.try_pop_bulk(out, 8) == 8);
+  for (int i = 0; i < 8; ++i) assert(out[i] == i + 4);
+  assert(q.empty());
+}
+
+static void test_threaded_bulk_ordering() {
+  constexpr std::size_t N = 200000;
+  msim::SpscRing<std::uint64_t, 1024> q;
+
+  std::vector<std::uint64_t> got;
+  got.reserve(N);
+
+  std::thread prod([&] {
+    for (std::uint64_t i = 0; i < N; ++i) {
+      while (!q.try_push(i)) {}
+    }
+  });
+
+  std::thread cons([&] {
+    std::uint64_t buf[64];
+    while (got.size() < N) {
+      const std::size_t n = q.try_pop_bulk(buf, 64);
+      got.insert(got.end(), buf, buf + n);
+    }
+  });
+
+  prod.join();
+  cons.join();
+
+  assert(got.size() == N);
+  for (std::size_t i = 0; i < N; ++i) assert(got[i] == i);
+}
+
 int main() {
   test_basic();
   test_full_empty();
   test_threaded_ordering();
+  test_bulk_pop();
+  test_threaded_bulk_ordering();
   std::cout << "OK: spsc_ring\n";
   return 0;
 }
@@ -0,0 +1,85 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include "msim/rng.hpp"
+#include "msim/swiss_hash.hpp"
+
+using msim::SwissHashMap;
+
+// Random insert/erase/find against std::unordered_map, growing from a tiny
+// table so every rehash path runs.
+static void test_matches_reference() {
+  std::pmr::unsynchronized_pool_resource mr;
+  SwissHashMap<uint64_t, uint64_t> m(&mr, 16, /*allow_grow=*/true);
+  std::unordered_map<uint64_t, uint64_t> ref;
+  Xoroshiro128Plus rng(7);
+
+  for (int i = 0; i < 200000; ++i) {
+    const uint64_t key = rng.next_u64() % 40000;
+    switch (rng.next_u64() % 4) {
+      case 0:
+      case 1: {
+        const bool ins = m.insert(key, key * 3);
+        assert(ins == ref.emplace(key, key * 3).second);
+        (void)ins;
+        break;
+      }
+      case 2: {
+        const bool gone = m.erase(key);
+        assert(gone == (ref.erase(key) == 1));
+        (void)gone;
+        break;
+      }
+      default: {
+        const uint64_t* v = m.find_ptr(key);
+        auto it = ref.find(key);
+        assert((v != nullptr) == (it != ref.end()));
+        assert(!v || *v == it->second);
+        (void)v;
+        (void)it;
+      }
+    }
+    assert(m.size() == ref.size());
+  }
+  assert(m.capacity() > 16);
+
+  size_t seen = 0;
+  m.for_each([&](uint64_t k, uint64_t v) {
+    assert(ref.count(k) == 1 && v == k * 3);
+    (void)k;
+    (void)v;
+    ++seen;
+  });
+  assert(seen == ref.size());
+}
+
+// Fixed-size: churn far more keys than the capacity; tombstones must be
+// recycled in place without growing or aborting.
+static void test_fixed_capacity_churn() {
+  std::pmr::unsynchronized_pool_resource mr;
+  SwissHashMap<int32_t, int> m(&mr, 64, /*allow_grow=*/false);
+  for (int32_t k = 0; k < 100000; ++k) {
+    assert(m.insert(k, k));
+    if (k >= 40) assert(m.erase(k - 40));
+    assert(m.size() <= 41);
+  }
+  assert(m.capacity() == 64);
+  for (int32_t k = 100000 - 40; k < 100000; ++k) assert(m.contains(k));
+
+  int* v = m.find_or_insert(99999, -1);
+  assert(v && *v == 99999);
+  v = m.find_or_insert(-5, -1);
+  assert(v && *v == -1 && m.size() == 41);
+  (void)v;
+}
+
+int main() {
+  test_matches_reference();
+  test_fixed_capacity_churn();
+  std::cout << "swiss_hash_test OK\n";
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "msim/simulator.hpp"
+#include "msim/work_steal.hpp"
+
+using namespace msim;
+
+// Owner pops LIFO from its own deque; thieves take the oldest task from the
+// next non-empty victim.
+static void test_queues() {
+  WorkQueues q(3);
+  for (uint32_t t = 0; t < 4; ++t) q.push(0, t);
+  q.push(2, 7);
+
+  uint32_t task = 0;
+  bool ok = q.pop(0, task);
+  assert(ok && task == 3);
+  ok = q.pop(1, task);
+  assert(!ok);
+  ok = q.steal(1, task);  // scans 2 first
+  assert(ok && task == 7);
+  ok = q.steal(1, task);
+  assert(ok && task == 0);
+  ok = q.steal(0, task);  // never steals from itself
+  assert(!ok);
+  ok = q.pop(0, task);
+  assert(ok && task == 2);
+  ok = q.pop(0, task);
+  assert(ok && task == 1);
+  ok = q.steal(2, task);
+  assert(!ok);
+  (void)ok;
+}
+
+static std::vector<std::pair<std::string, uint64_t>> run_sched(
+    SchedMode mode, int threads, uint64_t quantum) {
+  SimConfig cfg;
+  cfg.total_events = 60000;
+  cfg.symbol_list = {"A", "B", "C", "D", "E", "F", "G"};
+  cfg.num_threads = threads;
+  cfg.sched = mode;
+  cfg.zipf = 1.2;
+  cfg.steal_quantum = quantum;
+  Simulator sim(cfg);
+  sim.run_tasks();
+  return sim.book_checksums();
+}
+
+// A symbol's stream depends only on the seed and its budget, not on which
+// worker runs each slice or how the budget is sliced.
+static void test_schedule_independent() {
+  const auto ref = run_sched(SchedMode::Pinned, 1, 4096);
+  assert(ref.size() == 7 && ref[0].first == "A" && ref[6].first == "G");
+  assert(run_sched(SchedMode::Pinned, 3, 4096) == ref);
+  assert(run_sched(SchedMode::Steal, 3, 100) == ref);
+  assert(run_sched(SchedMode::Steal, 6, 1) == ref);
+
+  SimConfig cfg;
+  cfg.total_events = 60000;
+  cfg.symbol_list = {"A", "B", "C", "D", "E", "F", "G"};
+  cfg.sched = SchedMode::Pinned;
+  cfg.seed = 7;
+  Simulator other(cfg);
+  other.run_tasks();
+  assert(other.book_checksums() != ref);
+  (void)ref;
+}
+
+int main() {
+  test_queues();
+  test_schedule_independent();
+  std::cout << "work_steal_test OK\n";
+  return 0;
+}